@@ -0,0 +1,129 @@
+#include "benchmarkrunner.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QThread>
+#include <QHash>
+#include <QTextStream>
+#include <algorithm>
+
+QJsonObject BenchmarkResult::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["iterations"] = iterations;
+    object["items"] = items;
+    object["minUs"] = minUs;
+    object["medianUs"] = medianUs;
+    object["meanUs"] = meanUs;
+    object["maxUs"] = maxUs;
+    return object;
+}
+
+BenchmarkRunner::BenchmarkRunner(int iterations, const QString& filter)
+    : m_iterations(qMax(1, iterations)), m_filter(filter)
+{
+}
+
+void BenchmarkRunner::run(const QString& name, qint64 items, const std::function<void()>& body,
+                          const std::function<void()>& setup)
+{
+    if (!m_filter.isEmpty() && !name.contains(m_filter)) {
+        return;
+    }
+
+    // Échauffement : caches disque, allocations, expressions régulières statiques
+    if (setup) setup();
+    body();
+
+    QVector<double> samples;
+    samples.reserve(m_iterations);
+    QElapsedTimer timer;
+    for (int i = 0; i < m_iterations; ++i) {
+        if (setup) setup();
+        timer.start();
+        body();
+        samples.append(timer.nsecsElapsed() / 1000.0);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.iterations = m_iterations;
+    result.items = items;
+    result.minUs = samples.first();
+    result.maxUs = samples.last();
+    result.medianUs = samples.size() % 2
+        ? samples.at(samples.size() / 2)
+        : (samples.at(samples.size() / 2 - 1) + samples.at(samples.size() / 2)) / 2.0;
+    double total = 0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    result.meanUs = total / samples.size();
+    m_results.append(result);
+
+    QTextStream(stderr) << QString("%1  médiane %2 µs  (min %3, max %4, %5 éléments)\n")
+                           .arg(name, -40)
+                           .arg(result.medianUs, 0, 'f', 1)
+                           .arg(result.minUs, 0, 'f', 1)
+                           .arg(result.maxUs, 0, 'f', 1)
+                           .arg(items);
+}
+
+QJsonObject BenchmarkRunner::report(const QJsonObject& project) const
+{
+    QJsonObject context;
+    context["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    context["qtVersion"] = QString(qVersion());
+    context["cpu"] = QSysInfo::currentCpuArchitecture();
+    context["os"] = QSysInfo::prettyProductName();
+    context["threads"] = QThread::idealThreadCount();
+#ifdef APP_VERSION
+    context["appVersion"] = QString(APP_VERSION);
+#endif
+
+    QJsonArray results;
+    for (const BenchmarkResult& result : m_results) {
+        results.append(result.toJson());
+    }
+
+    QJsonObject root;
+    root["schema"] = 1;
+    root["context"] = context;
+    root["project"] = project;
+    root["results"] = results;
+    return root;
+}
+
+int BenchmarkRunner::compareWith(const QJsonObject& baseline, double tolerancePercent) const
+{
+    QHash<QString, double> baselineMedians;
+    const QJsonArray baselineResults = baseline.value("results").toArray();
+    for (const QJsonValue& value : baselineResults) {
+        QJsonObject object = value.toObject();
+        baselineMedians.insert(object.value("name").toString(), object.value("medianUs").toDouble());
+    }
+
+    int regressions = 0;
+    QTextStream err(stderr);
+    for (const BenchmarkResult& result : m_results) {
+        if (!baselineMedians.contains(result.name) || baselineMedians.value(result.name) <= 0) {
+            continue;
+        }
+        double previous = baselineMedians.value(result.name);
+        double deltaPercent = (result.medianUs - previous) * 100.0 / previous;
+        bool regression = deltaPercent > tolerancePercent;
+        if (regression) {
+            regressions++;
+        }
+        err << QString("%1  %2%3 %  %4\n")
+               .arg(result.name, -40)
+               .arg(deltaPercent >= 0 ? "+" : "")
+               .arg(deltaPercent, 0, 'f', 1)
+               .arg(regression ? "RÉGRESSION" : "ok");
+    }
+    return regressions;
+}
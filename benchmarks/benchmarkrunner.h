@@ -0,0 +1,45 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <functional>
+
+// Résultat d'un benchmark, en microsecondes par itération
+struct BenchmarkResult {
+    QString name;
+    int iterations = 0;
+    qint64 items = 0;        // Éléments traités par itération (fichiers, nœuds, lignes)
+    double minUs = 0;
+    double medianUs = 0;
+    double meanUs = 0;
+    double maxUs = 0;
+
+    QJsonObject toJson() const;
+};
+
+// Exécute des fonctions chronométrées (une itération d'échauffement, puis
+// N itérations mesurées) et produit un rapport JSON comparable entre versions.
+class BenchmarkRunner
+{
+public:
+    // Benchmarks dont le nom ne contient pas filter sont ignorés
+    BenchmarkRunner(int iterations, const QString& filter);
+
+    // setup est exécuté avant chaque itération, hors mesure
+    void run(const QString& name, qint64 items, const std::function<void()>& body,
+             const std::function<void()>& setup = std::function<void()>());
+
+    const QVector<BenchmarkResult>& results() const { return m_results; }
+
+    // Rapport complet : contexte (machine, Qt, projet) et résultats
+    QJsonObject report(const QJsonObject& project) const;
+
+    // Compare les médianes à un rapport précédent ; retourne le nombre de
+    // benchmarks plus lents que la tolérance (en pourcentage)
+    int compareWith(const QJsonObject& baseline, double tolerancePercent) const;
+
+private:
+    int m_iterations;
+    QString m_filter;
+    QVector<BenchmarkResult> m_results;
+};
@@ -0,0 +1,205 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStringList>
+#include <QRegularExpression>
+#include <QThread>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+
+// Moteur factice remplaçant lualatex pour mesurer l'orchestration sans TeX.
+// Invoqué comme lualatex (options puis fichier pilote), il suit un scénario JSON
+// désigné par la variable FAKELATEX_SCRIPT :
+//
+// {
+//   "durationMs": 200,              durée d'une passe (répartie entre les lignes)
+//   "passDurationsMs": [800, 150],  durée par passe (prioritaire sur durationMs)
+//   "lines": ["..."],               journal à émettre, ou
+//   "logFile": "enregistre.log",    journal enregistré (relatif au scénario)
+//   "stderrLines": ["..."],
+//   "reruns": 1,                    nombre de passes qui demandent une relance
+//   "exitCode": 0,
+//   "writePdf": true,               PDF factice écrit à côté du fichier pilote
+//   "crashOnPass": 0,               abort() pendant cette passe (0 = jamais)
+//   "hangOnPass": 0,                bloque indéfiniment pendant cette passe
+//   "ignoreSigterm": false,         bloqué et sourd à SIGTERM (test de SIGKILL)
+//   "jobs": { "c03": { ... } }      surcharges si le nom du fichier pilote contient la clé
+// }
+//
+// Le numéro de passe est conservé dans le .aux, comme le ferait LaTeX.
+
+namespace {
+
+QJsonObject loadScenario(const QString& texBaseName)
+{
+    QJsonObject scenario;
+    QString scriptPath = qEnvironmentVariable("FAKELATEX_SCRIPT");
+    if (scriptPath.isEmpty()) {
+        return scenario;
+    }
+
+    QFile scriptFile(scriptPath);
+    if (!scriptFile.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "fakelatex: scénario illisible: %s\n", qPrintable(scriptPath));
+        return scenario;
+    }
+    scenario = QJsonDocument::fromJson(scriptFile.readAll()).object();
+    scenario["scriptDir"] = QFileInfo(scriptPath).absolutePath();
+
+    // Surcharges propres à certains fichiers pilotes (un chapitre lent, un autre qui plante...)
+    const QJsonObject jobs = scenario.value("jobs").toObject();
+    for (auto it = jobs.constBegin(); it != jobs.constEnd(); ++it) {
+        if (texBaseName.contains(it.key())) {
+            const QJsonObject overrides = it.value().toObject();
+            for (auto field = overrides.constBegin(); field != overrides.constEnd(); ++field) {
+                scenario[field.key()] = field.value();
+            }
+        }
+    }
+    return scenario;
+}
+
+QStringList logLines(const QJsonObject& scenario)
+{
+    QStringList lines;
+    if (scenario.contains("logFile")) {
+        QString logPath = QDir(scenario.value("scriptDir").toString()).filePath(scenario.value("logFile").toString());
+        QFile logFile(logPath);
+        if (logFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            lines = QString::fromUtf8(logFile.readAll()).split('\n');
+        }
+    }
+    const QJsonArray scriptedLines = scenario.value("lines").toArray();
+    for (const QJsonValue& line : scriptedLines) {
+        lines << line.toString();
+    }
+    return lines;
+}
+
+int previousPass(const QString& auxPath)
+{
+    QFile auxFile(auxPath);
+    if (!auxFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return 0;
+    }
+    static const QRegularExpression passRe(R"(\\fakelatex@pass\{(\d+)\})");
+    QRegularExpressionMatch match = passRe.match(QString::fromUtf8(auxFile.readAll()));
+    return match.hasMatch() ? match.captured(1).toInt() : 0;
+}
+
+void writeOutput(const QString& path, const QByteArray& content)
+{
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(content);
+    }
+}
+
+QByteArray dummyPdf(const QString& title)
+{
+    QByteArray pdf = "%PDF-1.4\n";
+    QByteArray objects[] = {
+        "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n",
+        "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n",
+        "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 595 842] >>\nendobj\n",
+        "4 0 obj\n<< /Title (" + title.toLatin1() + ") /Producer (fakelatex) >>\nendobj\n"
+    };
+    QList<int> offsets;
+    for (const QByteArray& object : objects) {
+        offsets << pdf.size();
+        pdf += object;
+    }
+    int xrefOffset = pdf.size();
+    pdf += "xref\n0 5\n0000000000 65535 f \n";
+    for (int offset : offsets) {
+        pdf += QByteArray::number(offset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    pdf += "trailer\n<< /Size 5 /Root 1 0 R /Info 4 0 R >>\nstartxref\n" + QByteArray::number(xrefOffset) + "\n%%EOF\n";
+    return pdf;
+}
+
+void printLine(FILE* stream, const QString& line)
+{
+    std::fprintf(stream, "%s\n", line.toUtf8().constData());
+    std::fflush(stream);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // Le fichier pilote est le dernier argument qui n'est pas une option
+    QString texFile;
+    for (int i = argc - 1; i > 0; --i) {
+        QString arg = QString::fromLocal8Bit(argv[i]);
+        if (!arg.startsWith('-')) {
+            texFile = arg;
+            break;
+        }
+    }
+    if (texFile.isEmpty()) {
+        printLine(stderr, "fakelatex: aucun fichier pilote");
+        return 1;
+    }
+
+    QFileInfo texInfo(texFile);
+    const QString baseName = texInfo.completeBaseName();
+    const QString basePath = texInfo.absolutePath() + "/" + baseName;
+    const QJsonObject scenario = loadScenario(baseName);
+
+    const int pass = previousPass(basePath + ".aux") + 1;
+    const QJsonArray passDurations = scenario.value("passDurationsMs").toArray();
+    const int durationMs = pass <= passDurations.size()
+        ? passDurations.at(pass - 1).toInt()
+        : scenario.value("durationMs").toInt(0);
+
+    printLine(stdout, "This is fakelatex (stand-in for LuaHBTeX), pass " + QString::number(pass));
+    printLine(stdout, "(" + texFile);
+
+    // Journal réparti sur la durée de la passe
+    const QStringList lines = logLines(scenario);
+    const int pause = lines.isEmpty() ? durationMs : durationMs / (lines.size() + 1);
+    for (const QString& line : lines) {
+        QThread::msleep(pause);
+        printLine(stdout, line);
+    }
+    const QJsonArray stderrLines = scenario.value("stderrLines").toArray();
+    for (const QJsonValue& line : stderrLines) {
+        printLine(stderr, line.toString());
+    }
+
+    writeOutput(basePath + ".aux", "\\relax\n\\fakelatex@pass{" + QByteArray::number(pass) + "}\n");
+
+    if (pass == scenario.value("crashOnPass").toInt(0)) {
+        printLine(stdout, "fakelatex: plantage simulé");
+        std::abort();
+    }
+
+    if (pass == scenario.value("hangOnPass").toInt(0)) {
+        printLine(stdout, "fakelatex: blocage simulé");
+        if (scenario.value("ignoreSigterm").toBool(false)) {
+            std::signal(SIGTERM, SIG_IGN);
+        }
+        for (;;) {
+            QThread::sleep(1);
+        }
+    }
+
+    QThread::msleep(pause);
+
+    if (pass <= scenario.value("reruns").toInt(0)) {
+        printLine(stdout, "LaTeX Warning: Label(s) may have changed. Rerun to get cross-references right.");
+    }
+
+    if (scenario.value("writePdf").toBool(true)) {
+        writeOutput(basePath + ".pdf", dummyPdf(baseName));
+        printLine(stdout, "Output written on " + baseName + ".pdf (1 page).");
+    }
+    printLine(stdout, ")");
+
+    return scenario.value("exitCode").toInt(0);
+}
@@ -0,0 +1,259 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFile>
+#include <QTextStream>
+#include <QEventLoop>
+#include <QTimer>
+#include <QDebug>
+#include <functional>
+#include "projectgenerator.h"
+#include "benchmarkrunner.h"
+#include "latexparser.h"
+#include "latexmodel.h"
+#include "latexassembler.h"
+#include "logclassifier.h"
+
+// Benchmarks du cœur (analyse, modèle, assemblage, classification du journal)
+// sur un projet de cours synthétique. Le rapport JSON est écrit sur la sortie
+// standard ou dans --output ; --baseline compare les médianes à un rapport
+// précédent et retourne 1 en cas de régression.
+
+namespace {
+
+bool s_verbose = false;
+
+// Les traces qDebug des classes mesurées sont formatées mais pas affichées
+void benchmarkMessageHandler(QtMsgType type, const QMessageLogContext&, const QString& message)
+{
+    if (type == QtDebugMsg && !s_verbose) {
+        return;
+    }
+    QTextStream(stderr) << message << '\n';
+}
+
+void checkAll(LatexModel& model, Qt::CheckState state)
+{
+    for (int i = 0; i < model.rowCount(QModelIndex()); ++i) {
+        model.setData(model.index(i, 0, QModelIndex()), state, Qt::CheckStateRole);
+    }
+}
+
+// Parcourt tout le modèle via index()/parent() et retourne le nombre de nœuds
+int traverse(const LatexModel& model, const QModelIndex& parent)
+{
+    int count = 0;
+    for (int i = 0; i < model.rowCount(parent); ++i) {
+        QModelIndex index = model.index(i, 0, parent);
+        if (model.parent(index) != parent) {
+            qWarning() << "Parent incohérent pour" << model.data(index, Qt::DisplayRole).toString();
+        }
+        count += 1 + traverse(model, index);
+    }
+    return count;
+}
+
+// Lance une compilation et attend la fin de toutes les cibles
+void runBuild(LatexAssembler& assembler, const std::function<void()>& start)
+{
+    QEventLoop loop;
+    QObject::connect(&assembler, &LatexAssembler::buildFinished, &loop, &QEventLoop::quit);
+    QTimer::singleShot(120000, &loop, &QEventLoop::quit);
+    start();
+    if (assembler.isBusy()) {
+        loop.exec();
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("CompilationSelective-benchmarks");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks de CompilationSelective sur un projet synthétique");
+    parser.addHelpOption();
+    QCommandLineOption chaptersOption("chapters", "Nombre de chapitres.", "N", "8");
+    QCommandLineOption depthOption("depth", "Profondeur des \\import sous chaque chapitre.", "N", "3");
+    QCommandLineOption widthOption("width", "Fichiers importés par nœud.", "N", "4");
+    QCommandLineOption linesOption("lines", "Lignes de contenu par fichier.", "N", "40");
+    QCommandLineOption iterationsOption("iterations", "Itérations mesurées par benchmark.", "N", "10");
+    QCommandLineOption filterOption("filter", "Ne lance que les benchmarks dont le nom contient ce texte.", "texte");
+    QCommandLineOption outputOption("output", "Fichier du rapport JSON (sortie standard par défaut).", "fichier.json");
+    QCommandLineOption baselineOption("baseline", "Rapport JSON de référence à comparer.", "fichier.json");
+    QCommandLineOption toleranceOption("tolerance", "Ralentissement toléré avant régression, en %.", "pourcentage", "10");
+    QCommandLineOption verboseOption("verbose", "Affiche les traces qDebug des classes mesurées.");
+    parser.addOptions({ chaptersOption, depthOption, widthOption, linesOption, iterationsOption,
+                        filterOption, outputOption, baselineOption, toleranceOption, verboseOption });
+    parser.process(app);
+
+    s_verbose = parser.isSet(verboseOption);
+    qInstallMessageHandler(benchmarkMessageHandler);
+
+    SyntheticProjectSpec spec;
+    spec.chapters = parser.value(chaptersOption).toInt();
+    spec.depth = parser.value(depthOption).toInt();
+    spec.width = parser.value(widthOption).toInt();
+    spec.linesPerFile = parser.value(linesOption).toInt();
+
+    QTemporaryDir projectDir;
+    ProjectGenerator generator(spec);
+    if (!projectDir.isValid() || !generator.generate(projectDir.path())) {
+        qCritical() << "Impossible de générer le projet synthétique";
+        return 2;
+    }
+    const QString mainFile = generator.mainFile();
+    QTextStream(stderr) << "Projet synthétique : " << generator.fileCount() << " fichiers dans "
+                        << projectDir.path() << "\n";
+
+    BenchmarkRunner runner(parser.value(iterationsOption).toInt(), parser.value(filterOption));
+
+    // --- Analyse et modèle ---
+    runner.run("parser/parse", generator.fileCount(), [&]() {
+        LatexParser::parse(mainFile);
+    });
+
+    LatexModel model;
+    runner.run("model/loadFromFile", generator.fileCount(), [&]() {
+        model.loadFromFile(mainFile);
+    });
+    model.loadFromFile(mainFile);
+
+    int nodeCount = traverse(model, QModelIndex());
+    runner.run("model/index_parent", nodeCount, [&]() {
+        traverse(model, QModelIndex());
+    });
+
+    runner.run("model/setData_propagation", model.rowCount(QModelIndex()), [&]() {
+        checkAll(model, Qt::Checked);
+        checkAll(model, Qt::Unchecked);
+    });
+
+    checkAll(model, Qt::Checked);
+    QJsonObject state = model.saveCheckState();
+    runner.run("model/saveCheckState", nodeCount, [&]() {
+        model.saveCheckState();
+    });
+    runner.run("model/restoreCheckState", nodeCount, [&]() {
+        model.restoreCheckState(state);
+    }, [&]() {
+        checkAll(model, Qt::Unchecked);
+    });
+
+    // --- Assemblage (tout est coché) ---
+    checkAll(model, Qt::Checked);
+    LatexAssembler assembler;
+    assembler.setMainFilePath(mainFile);
+
+    runner.run("assembler/extractPreamble", 1, [&]() {
+        assembler.extractPreamble(mainFile);
+    });
+    runner.run("assembler/planBuild", nodeCount, [&]() {
+        assembler.planBuild(&model);
+    });
+
+    const QString preamble = assembler.extractPreamble(mainFile);
+    const BuildPlan plan = assembler.planBuild(&model);
+    const auto& chapters = plan.chapters;
+    const auto& documentFiles = plan.documentFiles;
+
+    runner.run("assembler/createPartialDocument", generator.fileCount(), [&]() {
+        assembler.createPartialDocument(mainFile, &model);
+    });
+    runner.run("assembler/createChapterTempFiles", chapters.size(), [&]() {
+        for (const auto& chapter : chapters) {
+            assembler.createChapterTempFile(preamble, chapter);
+        }
+    });
+    runner.run("assembler/createFullDocumentTempFile", documentFiles.size(), [&]() {
+        assembler.createFullDocumentTempFile(preamble, documentFiles);
+    });
+
+    // --- Classification du journal ---
+    const QStringList log = ProjectGenerator::syntheticLog(20000);
+    runner.run("logclassifier/classify", log.size(), [&]() {
+        int errors = 0;
+        for (const QString& line : log) {
+            if (LogClassifier::classify(line) == LogClassifier::LineKind::Error) {
+                errors++;
+            }
+        }
+        Q_UNUSED(errors);
+    });
+
+    // --- Orchestration avec le moteur factice (files, relances, parallélisme) ---
+#ifdef FAKELATEX_PATH
+    QJsonObject scenario;
+    scenario["durationMs"] = 20;
+    scenario["reruns"] = 1;
+    QJsonArray scenarioLines;
+    for (const QString& line : ProjectGenerator::syntheticLog(200)) {
+        scenarioLines.append(line);
+    }
+    scenario["lines"] = scenarioLines;
+    const QString scenarioPath = projectDir.filePath("fakelatex.json");
+    QFile scenarioFile(scenarioPath);
+    if (scenarioFile.open(QIODevice::WriteOnly)) {
+        scenarioFile.write(QJsonDocument(scenario).toJson());
+        scenarioFile.close();
+    }
+    qputenv("FAKELATEX_SCRIPT", scenarioPath.toLocal8Bit());
+
+    LatexAssembler orchestrator;
+    orchestrator.setEngineProgram(FAKELATEX_PATH);
+    orchestrator.setMainFilePath(mainFile);
+
+    runner.run("orchestration/partial", 1, [&]() {
+        runBuild(orchestrator, [&]() {
+            QString tempFilePath = orchestrator.createPartialDocument(mainFile, &model);
+            orchestrator.compilePartialDocument(tempFilePath, false, false);
+        });
+    });
+    for (int jobs : { 1, 4 }) {
+        runner.run(QString("orchestration/chapters_jobs%1").arg(jobs), chapters.size(), [&]() {
+            runBuild(orchestrator, [&]() {
+                orchestrator.compileChapters(&model);
+            });
+        }, [&]() {
+            orchestrator.setMaxParallelJobs(jobs);
+        });
+    }
+#endif
+
+    // --- Rapport ---
+    QJsonObject project = spec.toJson();
+    project["files"] = generator.fileCount();
+    project["nodes"] = nodeCount;
+    QByteArray json = QJsonDocument(runner.report(project)).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Impossible d'écrire" << output.fileName();
+            return 2;
+        }
+        output.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    if (parser.isSet(baselineOption)) {
+        QFile baselineFile(parser.value(baselineOption));
+        if (!baselineFile.open(QIODevice::ReadOnly)) {
+            qCritical() << "Rapport de référence illisible :" << baselineFile.fileName();
+            return 2;
+        }
+        QJsonObject baseline = QJsonDocument::fromJson(baselineFile.readAll()).object();
+        int regressions = runner.compareWith(baseline, parser.value(toleranceOption).toDouble());
+        if (regressions > 0) {
+            QTextStream(stderr) << regressions << " régression(s) détectée(s)\n";
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "projectgenerator.h"
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+
+QJsonObject SyntheticProjectSpec::toJson() const
+{
+    QJsonObject object;
+    object["chapters"] = chapters;
+    object["depth"] = depth;
+    object["width"] = width;
+    object["linesPerFile"] = linesPerFile;
+    return object;
+}
+
+ProjectGenerator::ProjectGenerator(const SyntheticProjectSpec& spec)
+    : m_spec(spec)
+{
+}
+
+bool ProjectGenerator::generate(const QString& rootDir)
+{
+    m_files.clear();
+    QDir root(rootDir);
+    if (!root.mkpath(".")) {
+        return false;
+    }
+
+    // Fichier principal : préambule proche des vrais cours, puis un \import par chapitre
+    QString content;
+    QTextStream out(&content);
+    out << "\\documentclass[11pt,a4paper]{article}\n"
+        << "\\usepackage{fontspec}\n"
+        << "\\usepackage{amsmath,amssymb}\n"
+        << "\\usepackage{graphicx}\n"
+        << "\\usepackage{import}\n"
+        << "\\usepackage{fancyhdr}\n"
+        << "\\usepackage{xcolor}\n"
+        << "\\usepackage{setspace}\n"
+        << "\\usepackage{hyperref}\n"
+        << "\\definecolor{gris50}{gray}{0.5}\n"
+        << "\\newcommand{\\monetablissement}{Lycée}\n"
+        << "\\newcommand{\\maclasse}{Seconde}\n"
+        << "\\begin{document}\n";
+    for (int chapter = 1; chapter <= m_spec.chapters; ++chapter) {
+        QString name = QString("c%1_cours").arg(chapter, 2, 10, QChar('0'));
+        QString dirName = QString("c%1").arg(chapter, 2, 10, QChar('0'));
+        out << "\\import{" << dirName << "/}{" << name << "}\n";
+        if (!writeNode(root.filePath(dirName), name, 0)) {
+            return false;
+        }
+    }
+    out << "\\end{document}\n";
+    out.flush();
+
+    m_mainFile = root.filePath("cours.tex");
+    if (!writeFile(m_mainFile, content)) {
+        return false;
+    }
+    m_files.prepend(m_mainFile);
+    return true;
+}
+
+bool ProjectGenerator::writeNode(const QString& dirPath, const QString& name, int level)
+{
+    if (!QDir().mkpath(dirPath)) {
+        return false;
+    }
+
+    QString content = fillerContent(name);
+
+    // Les enfants d'un fichier _cours portent le préfixe du chapitre, les autres celui du parent
+    QString prefix = name;
+    prefix.remove("_cours");
+
+    if (level < m_spec.depth) {
+        static const char* kinds[] = { "sec", "peda", "doc", "eval" };
+        for (int i = 0; i < m_spec.width; ++i) {
+            QString childName = QString("%1_%2_%3").arg(prefix, QLatin1String(kinds[i % 4])).arg(i + 1, 2, 10, QChar('0'));
+            content += QString("\\import{%1/}{%1}\n").arg(childName);
+            if (!writeNode(QDir(dirPath).filePath(childName), childName, level + 1)) {
+                return false;
+            }
+        }
+    }
+
+    // Une ligne commentée, ignorée par l'analyseur
+    content += "% \\import{ancien/}{ancien}\n";
+
+    QString filePath = QDir(dirPath).filePath(name + ".tex");
+    m_files.append(filePath);
+    return writeFile(filePath, content);
+}
+
+bool ProjectGenerator::writeFile(const QString& filePath, const QString& content)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    file.write(content.toUtf8());
+    return true;
+}
+
+QString ProjectGenerator::fillerContent(const QString& name) const
+{
+    QString content;
+    QString label = QString(name).replace('_', '-');
+    content += QString("\\section*{%1}\\label{sec:%2}\n").arg(QString(name).replace('_', ' '), label);
+    for (int line = 0; line < m_spec.linesPerFile; ++line) {
+        switch (line % 4) {
+            case 0:
+                content += QString("Soit $f(x) = %1x^2 + \\frac{%2}{x}$ définie sur $]0;+\\infty[$.\n").arg(line + 1).arg(line + 2);
+                break;
+            case 1:
+                content += "Déterminer les variations de la fonction et justifier chaque étape du raisonnement.\n";
+                break;
+            case 2:
+                content += QString("\\begin{equation}\\label{eq:%1-%2} u_{n+1} = \\sqrt{u_n + %2} \\end{equation}\n").arg(label).arg(line);
+                break;
+            default:
+                content += "\\medskip\n";
+                break;
+        }
+    }
+    return content;
+}
+
+QStringList ProjectGenerator::syntheticLog(int lineCount)
+{
+    // Lignes représentatives d'un journal LuaLaTeX en mode -file-line-error
+    static const QStringList samples = {
+        "This is LuaHBTeX, Version 1.17.0 (TeX Live 2023)",
+        "(./temp_partial_20240101_120000.tex",
+        "LaTeX2e <2023-11-01> patch level 1",
+        "(/usr/share/texlive/texmf-dist/tex/latex/base/article.cls",
+        "Overfull \\hbox (12.3456pt too wide) in paragraph at lines 120--124",
+        "Underfull \\vbox (badness 10000) has occurred while \\output is active [12]",
+        "LaTeX Warning: Reference `eq:c01-sec-01-2' on page 3 undefined on input line 87.",
+        "Package hyperref Warning: Token not allowed in a PDF string (Unicode):",
+        "./temp_partial_20240101_120000.tex:214: Undefined control sequence.",
+        "! Missing $ inserted.",
+        "l.214 Soit $f(x) = 3x^2",
+        "[1{/usr/share/texlive/texmf-var/fonts/map/pdftex/updmap/pdftex.map}] [2] [3]",
+        "Output written on temp_partial_20240101_120000.pdf (42 pages, 812345 bytes).",
+        "LaTeX Warning: Label(s) may have changed. Rerun to get cross-references right.",
+        "",
+        ")"
+    };
+
+    QStringList lines;
+    lines.reserve(lineCount);
+    for (int i = 0; i < lineCount; ++i) {
+        lines << samples.at(i % samples.size());
+    }
+    return lines;
+}
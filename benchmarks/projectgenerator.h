@@ -0,0 +1,42 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+
+// Paramètres d'un projet de cours synthétique
+struct SyntheticProjectSpec {
+    int chapters = 8;        // Chapitres importés par le fichier principal
+    int depth = 3;           // Niveaux d'\import sous chaque fichier _cours
+    int width = 4;           // Fichiers importés par chaque nœud intermédiaire
+    int linesPerFile = 40;   // Lignes de contenu par fichier
+
+    QJsonObject toJson() const;
+};
+
+// Génère une arborescence de cours réaliste : un fichier principal avec son
+// préambule, un {chapitre}_cours.tex par chapitre, puis des \import imbriqués
+// vers des fichiers _peda_, _doc_, _eval_ et des sections intermédiaires.
+class ProjectGenerator
+{
+public:
+    explicit ProjectGenerator(const SyntheticProjectSpec& spec);
+
+    // Écrit le projet dans rootDir ; retourne false en cas d'erreur d'écriture
+    bool generate(const QString& rootDir);
+
+    QString mainFile() const { return m_mainFile; }
+    int fileCount() const { return m_files.size(); }
+    const QStringList& files() const { return m_files; }
+
+    // Journal LuaLaTeX synthétique (avertissements, erreurs, boîtes pleines...)
+    static QStringList syntheticLog(int lineCount);
+
+private:
+    SyntheticProjectSpec m_spec;
+    QString m_mainFile;
+    QStringList m_files;
+
+    bool writeNode(const QString& dirPath, const QString& name, int level);
+    bool writeFile(const QString& filePath, const QString& content);
+    QString fillerContent(const QString& name) const;
+};
@@ -23,6 +23,10 @@
 #include "lastfilehelper.h"
 #include "processrunner.h"
 #include "latexassembler.h"
+#include "outputconsole.h"
+#include "clibuilder.h"
+#include "buildwatcher.h"
+#include "tracer.h"
 
 // Forward declaration - ajoutée pour résoudre l'erreur de compilation
 bool hasCheckedNodesRecursive(QAbstractItemModel* model, const QModelIndex& parent);
@@ -83,6 +87,14 @@ bool hasCheckedNodesRecursive(QAbstractItemModel* model, const QModelIndex& pare
 
 int main(int argc, char *argv[])
 {
+    // Trace des compilations (--trace fichier.json ou COMPILATION_SELECTIVE_TRACE)
+    Tracer::configureFromArguments(argc, argv);
+
+    // Mode sans interface (--build) : aucun widget n'est créé
+    if (CliBuilder::isRequested(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return CliBuilder::run(app);
+    }
 
     QApplication app(argc, argv);
     
@@ -175,6 +187,83 @@ int main(int argc, char *argv[])
     compileDocumentCheckbox->setChecked(savedCompileDocument); // Non coché par défaut
     optionsLayout->addWidget(compileDocumentCheckbox);
 
+    // Un PDF par fichier coché des groupes PEDA/DOCS/EVALS (évaluations, fiches)
+    QCheckBox* exercisePdfsCheckbox = new QCheckBox("Un PDF par exercice", rightWidget);
+    exercisePdfsCheckbox->setToolTip("Compile en parallèle chaque fichier coché des groupes PEDA, DOCS et EVALS "
+                                     "comme un document à part, nommé d'après son nœud");
+    exercisePdfsCheckbox->setChecked(lastFileHelper.loadExercisePdfs());
+    optionsLayout->addWidget(exercisePdfsCheckbox);
+
+    // Surveillance des sources : recompilation automatique après enregistrement
+    QCheckBox* watchCheckbox = new QCheckBox("Surveiller les modifications", rightWidget);
+    watchCheckbox->setToolTip("Recompile le partiel puis les chapitres concernés à chaque enregistrement");
+    optionsLayout->addWidget(watchCheckbox);
+
+    // Partiel et chapitres avec la numérotation du dernier document complet
+    QCheckBox* includeOnlyCheckbox = new QCheckBox("Numérotation du document", rightWidget);
+    includeOnlyCheckbox->setToolTip("Compile le document complet en unités \\include puis le partiel et les "
+                                    "chapitres avec \\includeonly : numéros, références et table des matières "
+                                    "du document complet en une seule passe");
+    includeOnlyCheckbox->setChecked(lastFileHelper.loadIncludeOnlyMode());
+    optionsLayout->addWidget(includeOnlyCheckbox);
+
+    // Chapitres découpés dans le PDF du document complet (une seule compilation)
+    QCheckBox* chaptersFromDocumentCheckbox = new QCheckBox("Chapitres extraits du document", rightWidget);
+    chaptersFromDocumentCheckbox->setToolTip("Quand chapitres et document sont demandés, compile uniquement le "
+                                             "document complet puis en extrait les pages de chaque chapitre "
+                                             "(chaque chapitre commence alors sur une nouvelle page)");
+    chaptersFromDocumentCheckbox->setChecked(lastFileHelper.loadChaptersFromDocument());
+    optionsLayout->addWidget(chaptersFromDocumentCheckbox);
+
+    // Document complet compilé chapitre par chapitre en parallèle puis fusionné
+    QCheckBox* shardedDocumentCheckbox = new QCheckBox("Document en tronçons parallèles", rightWidget);
+    shardedDocumentCheckbox->setToolTip("Compile chaque chapitre du document complet séparément, en parallèle, "
+                                        "avec les numéros de la compilation précédente, puis fusionne les PDF");
+    shardedDocumentCheckbox->setChecked(lastFileHelper.loadShardedDocument());
+    optionsLayout->addWidget(shardedDocumentCheckbox);
+
+    // Chapitres trop longs compilés en tronçons parallèles puis fusionnés
+    // (fichiers par tronçon dans chapterShardFiles de config.json, 20 par défaut)
+    int savedChapterShardFiles = lastFileHelper.loadChapterShardFiles();
+    QCheckBox* chapterShardsCheckbox = new QCheckBox("Chapitres longs en tronçons", rightWidget);
+    chapterShardsCheckbox->setToolTip("Découpe les chapitres de nombreux fichiers en tronçons compilés en "
+                                      "parallèle, coupés entre les sections ou groupes PEDA/DOCS/EVALS, "
+                                      "puis fusionne les PDF en un seul par chapitre");
+    chapterShardsCheckbox->setChecked(savedChapterShardFiles > 0);
+    optionsLayout->addWidget(chapterShardsCheckbox);
+
+    // Figures TikZ composées une fois puis reprises du cache par toutes les cibles
+    QCheckBox* tikzFigureCacheCheckbox = new QCheckBox("Cache des figures TikZ", rightWidget);
+    tikzFigureCacheCheckbox->setToolTip("Remplace chaque tikzpicture par son PDF mis en cache ; les figures "
+                                        "nouvelles ou modifiées sont générées en parallèle avant la compilation");
+    tikzFigureCacheCheckbox->setChecked(lastFileHelper.loadTikzFigureCache());
+    optionsLayout->addWidget(tikzFigureCacheCheckbox);
+
+    // Chapitres et document dont aucune dépendance n'a changé repris tels quels, sauf si forcé
+    QCheckBox* forceRebuildCheckbox = new QCheckBox("Forcer la recompilation", rightWidget);
+    forceRebuildCheckbox->setToolTip("Recompile les chapitres et le document même si ni leurs sources ni "
+                                     "les fichiers qu'ils lisent (images, bibliographie...) n'ont changé");
+    forceRebuildCheckbox->setChecked(lastFileHelper.loadForceRebuild());
+    optionsLayout->addWidget(forceRebuildCheckbox);
+
+    // Sources vérifiées avant de lancer le moteur : une erreur évidente fait échouer la cible aussitôt
+    QCheckBox* preflightChecksCheckbox = new QCheckBox("Vérifications préalables", rightWidget);
+    preflightChecksCheckbox->setToolTip("Avant chaque compilation, vérifie les fichiers (présence, encodage UTF-8, "
+                                        "accolades, environnements, imports, étiquettes en double) et signale "
+                                        "les problèmes avec leur ligne sans lancer LuaLaTeX");
+    preflightChecksCheckbox->setChecked(lastFileHelper.loadPreflightChecks());
+    optionsLayout->addWidget(preflightChecksCheckbox);
+
+    // Partiel composé par un processus LuaLaTeX lancé d'avance sur le préambule
+    // (nombre de processus dans warmWorkers de config.json, 1 par défaut)
+    int savedWarmWorkers = lastFileHelper.loadWarmWorkers();
+    QCheckBox* warmWorkersCheckbox = new QCheckBox("Partiel préchauffé", rightWidget);
+    warmWorkersCheckbox->setToolTip("Garde un processus LuaLaTeX prêt, préambule déjà chargé : le partiel "
+                                    "suivant ne compose plus que les fichiers sélectionnés "
+                                    "(profil en une passe)");
+    warmWorkersCheckbox->setChecked(savedWarmWorkers > 0);
+    optionsLayout->addWidget(warmWorkersCheckbox);
+
     // Bouton pour ouvrir le PDF (désactivé par défaut)
     QPushButton* openPdfButton = new QPushButton("Ouvrir PDF", rightWidget);
     openPdfButton->setEnabled(false);
@@ -187,6 +276,14 @@ int main(int argc, char *argv[])
     cancelButton->setEnabled(false); // Désactivé au démarrage
     optionsLayout->addWidget(cancelButton);
 
+    // Bouton pour chercher le fichier qui fait échouer le partiel (ou le document complet)
+    QPushButton* findCulpritButton = new QPushButton("Trouver le fichier en cause", rightWidget);
+    findCulpritButton->setIcon(QIcon::fromTheme("edit-find"));
+    findCulpritButton->setToolTip("Compile en parallèle chaque fichier seul, puis des débuts de liste, "
+                                  "pour désigner le fichier qui fait échouer le partiel (onglet Document : "
+                                  "le document complet)");
+    optionsLayout->addWidget(findCulpritButton);
+
     // Ajouter les options au layout
     rightLayout->addLayout(optionsLayout);
     rightLayout->addSpacing(10);
@@ -229,6 +326,64 @@ int main(int argc, char *argv[])
 
     // Créer notre assembleur LaTeX
     LatexAssembler *latexAssembler = new LatexAssembler(&window);
+    latexAssembler->setProcessLimits(lastFileHelper.loadProcessLimits());
+    latexAssembler->setPublishPolicy(lastFileHelper.loadPublishPolicy());
+    latexAssembler->selectProfiles(lastFileHelper.loadCompileProfiles(), lastFileHelper.loadTargetProfiles());
+    latexAssembler->setIncludeOnlyMode(includeOnlyCheckbox->isChecked());
+    latexAssembler->setChaptersFromDocument(chaptersFromDocumentCheckbox->isChecked());
+    latexAssembler->setShardedDocument(shardedDocumentCheckbox->isChecked());
+    latexAssembler->setChapterShardFiles(savedChapterShardFiles);
+    latexAssembler->setWarmWorkers(savedWarmWorkers);
+    latexAssembler->setTikzFigureCache(tikzFigureCacheCheckbox->isChecked());
+    latexAssembler->setForceRebuild(forceRebuildCheckbox->isChecked());
+    latexAssembler->setPreflightChecks(preflightChecksCheckbox->isChecked());
+
+    // Les onglets sont des consommateurs de la sortie de l'assembleur
+    OutputConsole* partialConsole = new OutputConsole(partialOutputText, &window);
+    OutputConsole* chapterConsole = new OutputConsole(chapterOutputText, &window);
+    OutputConsole* documentConsole = new OutputConsole(documentOutputText, &window);
+
+    auto consoleForTarget = [=](LatexAssembler::BuildTarget target) {
+        switch (target) {
+            case LatexAssembler::BuildTarget::Chapter:
+                return chapterConsole;
+            case LatexAssembler::BuildTarget::Document:
+                return documentConsole;
+            case LatexAssembler::BuildTarget::Partial:
+            default:
+                return partialConsole;
+        }
+    };
+
+    QObject::connect(latexAssembler, &LatexAssembler::outputLines,
+                     [consoleForTarget](LatexAssembler::BuildTarget target, const QStringList& lines) {
+        consoleForTarget(target)->appendLines(lines);
+    });
+    QObject::connect(latexAssembler, &LatexAssembler::outputMessage,
+                     [consoleForTarget](LatexAssembler::BuildTarget target, const QString& message) {
+        consoleForTarget(target)->appendMessage(message);
+    });
+
+    // Bilan des ressources affiché dans l'onglet courant à la fin de la compilation
+    QObject::connect(latexAssembler, &LatexAssembler::buildStatsReady,
+                     [outputTabWidget, partialConsole, chapterConsole, documentConsole](const QString& summary) {
+        OutputConsole* consoles[] = { partialConsole, chapterConsole, documentConsole };
+        int index = qBound(0, outputTabWidget->currentIndex(), 2);
+        consoles[index]->appendMessage("\n" + summary);
+    });
+
+    // Surveillance des fichiers de l'arborescence, en pause pendant les compilations
+    BuildWatcher* buildWatcher = new BuildWatcher(&window);
+    QObject::connect(latexAssembler, &LatexAssembler::buildStarted, [buildWatcher]() {
+        buildWatcher->setPaused(true);
+    });
+    QObject::connect(latexAssembler, &LatexAssembler::buildFinished, [buildWatcher, latexAssembler]() {
+        // Images, bibliographies... lues par les compilations qui viennent de réussir
+        if (buildWatcher->isWatching()) {
+            buildWatcher->addFiles(latexAssembler->dependencyFiles());
+        }
+        buildWatcher->setPaused(false);
+    });
 
     // Fonction de sauvegarde des options
     auto saveOptions = [&]() {
@@ -252,6 +407,52 @@ int main(int argc, char *argv[])
         );
     });
     
+    QObject::connect(exercisePdfsCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        lastFileHelper.saveExercisePdfs(checked);
+    });
+    
+    QObject::connect(includeOnlyCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        latexAssembler->setIncludeOnlyMode(checked);
+        lastFileHelper.saveIncludeOnlyMode(checked);
+    });
+    
+    QObject::connect(chaptersFromDocumentCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        latexAssembler->setChaptersFromDocument(checked);
+        lastFileHelper.saveChaptersFromDocument(checked);
+    });
+    
+    QObject::connect(shardedDocumentCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        latexAssembler->setShardedDocument(checked);
+        lastFileHelper.saveShardedDocument(checked);
+    });
+    
+    QObject::connect(chapterShardsCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        int files = checked ? (savedChapterShardFiles > 0 ? savedChapterShardFiles : 20) : 0;
+        latexAssembler->setChapterShardFiles(files);
+        lastFileHelper.saveChapterShardFiles(files);
+    });
+    
+    QObject::connect(tikzFigureCacheCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        latexAssembler->setTikzFigureCache(checked);
+        lastFileHelper.saveTikzFigureCache(checked);
+    });
+    
+    QObject::connect(forceRebuildCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        latexAssembler->setForceRebuild(checked);
+        lastFileHelper.saveForceRebuild(checked);
+    });
+    
+    QObject::connect(preflightChecksCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        latexAssembler->setPreflightChecks(checked);
+        lastFileHelper.savePreflightChecks(checked);
+    });
+    
+    QObject::connect(warmWorkersCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        int count = checked ? qMax(1, savedWarmWorkers) : 0;
+        latexAssembler->setWarmWorkers(count);
+        lastFileHelper.saveWarmWorkers(count);
+    });
+    
     // Variable pour stocker le chemin du dernier PDF
     QString lastPdfPath;
 
@@ -266,9 +467,26 @@ int main(int argc, char *argv[])
     QObject::connect(cancelButton, &QPushButton::clicked, [&]() {
         latexAssembler->stopCompilation();
         compileButton->setEnabled(true);
+        findCulpritButton->setEnabled(true);
         cancelButton->setEnabled(false);
     });
 
+    // Recherche du fichier en cause : cible de l'onglet affiché (partiel par défaut)
+    QObject::connect(findCulpritButton, &QPushButton::clicked, [&]() {
+        bool documentTab = outputTabWidget->currentWidget() == documentOutputText;
+        LatexAssembler::BuildTarget target = documentTab ? LatexAssembler::BuildTarget::Document
+                                                         : LatexAssembler::BuildTarget::Partial;
+        if (!documentTab) {
+            outputTabWidget->setCurrentWidget(partialOutputText);
+        }
+        latexAssembler->setMainFilePath(filePathEdit->text());
+        findCulpritButton->setEnabled(!latexAssembler->findCulprit(&model, target));
+    });
+    
+    QObject::connect(latexAssembler, &LatexAssembler::culpritSearchFinished, findCulpritButton, [findCulpritButton]() {
+        findCulpritButton->setEnabled(true);
+    });
+
     // Fonction de chargement de fichier modifiée
     auto loadFile = [&](const QString& filePath) {
         if (!filePath.isEmpty() && QFileInfo(filePath).exists() && filePath.endsWith(".tex")) {
@@ -306,6 +524,7 @@ int main(int argc, char *argv[])
             
             filePathEdit->setText(filePath);
             model.loadFromFile(filePath);
+            latexAssembler->setBuildRoot(lastFileHelper.loadBuildRoot(filePath));
             
             // Restaurer l'état précédent
             QJsonObject savedState = lastFileHelper.loadCheckState();
@@ -316,6 +535,11 @@ int main(int argc, char *argv[])
             treeView->collapseAll(); 
             expandCheckedNodes(treeView);
             lastFileHelper.saveLastFilePath(filePath);
+            
+            // Suivre la nouvelle arborescence
+            if (watchCheckbox->isChecked()) {
+                buildWatcher->watch(filePath, &model);
+            }
         }
     };
     
@@ -353,46 +577,90 @@ int main(int argc, char *argv[])
         // Désactiver le bouton "Ouvrir PDF" pendant la nouvelle compilation
         openPdfButton->setEnabled(false);
         
-        // Arrêter toute compilation en cours
+        // Arrêter toute compilation en cours (et la recherche du fichier en cause)
         latexAssembler->stopCompilation();
+        findCulpritButton->setEnabled(true);
         
         // Vider les onglets de sortie
         partialOutputText->clear();
         chapterOutputText->clear();
         documentOutputText->clear();
         
-        // Créer le document partiel
-        QString tempFilePath = latexAssembler->createPartialDocument(filePathEdit->text(), &model);
+        // Assembler le document partiel en arrière-plan, puis le compiler
+        bool partialStarted = latexAssembler->buildPartialDocument(
+            filePathEdit->text(),
+            &model,
+            compileChapterCheckbox->isChecked(),
+            compileDocumentCheckbox->isChecked()
+        );
         
-        if (!tempFilePath.isEmpty()) {
+        if (partialStarted) {
             // Toujours utiliser l'onglet "Partiel" pour la sortie partielle
             outputTabWidget->setCurrentIndex(0);
             
-            // Lancer la compilation partielle
-            latexAssembler->compilePartialDocument(
-                tempFilePath,
-                partialOutputText,
-                compileChapterCheckbox->isChecked(),
-                compileDocumentCheckbox->isChecked()
-            );
-            
+            // Chapitres et document ensemble : l'assembleur peut découper le document
+            if (compileChapterCheckbox->isChecked() && compileDocumentCheckbox->isChecked()) {
+                outputTabWidget->setCurrentIndex(2);
+                latexAssembler->compileChaptersAndDocument(&model);
+            }
             // Si l'option de compilation des chapitres est activée
-            if (compileChapterCheckbox->isChecked()) {
+            else if (compileChapterCheckbox->isChecked()) {
                 // Lancer la compilation des chapitres en parallèle
-                latexAssembler->compileChapters(&model, chapterOutputText);
+                latexAssembler->compileChapters(&model);
             }
             
             // Si l'option de compilation du document complet est activée
-            if (compileDocumentCheckbox->isChecked()) {
+            else if (compileDocumentCheckbox->isChecked()) {
                 // Utiliser l'onglet "Document" pour la sortie
                 outputTabWidget->setCurrentIndex(2);
                 
                 // Lancer la compilation du document complet
-                latexAssembler->compileFullDocument(&model, documentOutputText);
+                latexAssembler->compileFullDocument(&model);
+            }
+            
+            // Exercices séparés, dans la file des chapitres
+            if (exercisePdfsCheckbox->isChecked()) {
+                latexAssembler->compileExercises(&model);
             }
         }
     });
 
+    QObject::connect(watchCheckbox, &QCheckBox::toggled, [&](bool checked) {
+        if (checked && model.hasData()) {
+            buildWatcher->watch(filePathEdit->text(), &model);
+            buildWatcher->addFiles(latexAssembler->dependencyFiles());
+        } else {
+            buildWatcher->stop();
+        }
+    });
+    
+    // Recompilation incrémentale après une rafale d'enregistrements
+    QObject::connect(buildWatcher, &BuildWatcher::changesReady, [&](const QStringList& changedFiles) {
+        QString mainFilePath = QFileInfo(filePathEdit->text()).absoluteFilePath();
+        
+        // Le fichier principal a changé : recharger l'arborescence en gardant la sélection
+        if (changedFiles.contains(mainFilePath)) {
+            QJsonObject state = model.saveCheckState();
+            model.loadFromFile(mainFilePath);
+            model.restoreCheckState(state);
+            treeView->collapseAll();
+            expandCheckedNodes(treeView);
+            buildWatcher->watch(mainFilePath, &model);
+            buildWatcher->addFiles(latexAssembler->dependencyFiles());
+        }
+        
+        partialOutputText->clear();
+        chapterOutputText->clear();
+        documentOutputText->clear();
+        outputTabWidget->setCurrentIndex(0);
+        
+        latexAssembler->setMainFilePath(mainFilePath);
+        latexAssembler->compileChangedTargets(&model, changedFiles, true,
+                                              compileChapterCheckbox->isChecked(),
+                                              compileDocumentCheckbox->isChecked());
+        cancelButton->setEnabled(latexAssembler->isBusy());
+    });
+
     // Ajouter les connexions pour les nouveaux signaux
     QObject::connect(latexAssembler, &LatexAssembler::fullDocumentCompilationStarted, [&]() {
         // On pourrait ajouter une indication visuelle si nécessaire
@@ -483,5 +751,12 @@ int main(int argc, char *argv[])
     
     window.setCentralWidget(centralWidget);
     window.show();
-    return app.exec();
+    int exitCode = app.exec();
+    
+    // Fenêtre fermée en pleine compilation : les groupes de processus, hors du
+    // groupe du terminal, ne s'arrêteraient pas d'eux-mêmes
+    latexAssembler->stopCompilation();
+    ProcessRunner::killAllProcessGroups();
+    Tracer::instance().write();
+    return exitCode;
 }
\ No newline at end of file
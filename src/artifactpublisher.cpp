@@ -0,0 +1,158 @@
+#include "artifactpublisher.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+QString ArtifactPublisher::latestPath(const QString& directory, const QString& baseName)
+{
+    return directory + "/" + baseName + "_latest.pdf";
+}
+
+QByteArray ArtifactPublisher::normalizedHash(const QString& pdfPath)
+{
+    QFile file(pdfPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    // Seuls les champs qui changent à chaque compilation sont écartés (longueur
+    // fixe : les positions de la table xref restent comparables)
+    static const QRegularExpression volatileFields(
+        "/(?:CreationDate|ModDate)\\s*\\([^)]*\\)|/ID\\s*\\[\\s*<[0-9A-Fa-f]*>\\s*<[0-9A-Fa-f]*>\\s*\\]");
+    QString content = QString::fromLatin1(file.readAll());
+    content.remove(volatileFields);
+    return QCryptographicHash::hash(content.toLatin1(), QCryptographicHash::Sha1);
+}
+
+QStringList ArtifactPublisher::publishedVersions(const QString& directory, const QString& baseName)
+{
+    QRegularExpression versionName("^" + QRegularExpression::escape(baseName) +
+                                   "_\\d{4}_\\d{2}_\\d{2}_\\d{2}_\\d{2}_\\d{2}(_\\d+)?\\.pdf$");
+    QStringList versions;
+    const QStringList candidates = QDir(directory).entryList({ baseName + "_*.pdf" }, QDir::Files, QDir::Name);
+    for (const QString& fileName : candidates) {
+        if (versionName.match(fileName).hasMatch()) {
+            versions.prepend(directory + "/" + fileName);
+        }
+    }
+    return versions;
+}
+
+bool ArtifactPublisher::replaceFile(const QString& source, const QString& target)
+{
+#ifdef Q_OS_UNIX
+    return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#else
+    QFile::remove(target);
+    return QFile::rename(source, target);
+#endif
+}
+
+bool ArtifactPublisher::moveInto(const QString& source, const QString& target)
+{
+    if (replaceFile(source, target)) {
+        return true;
+    }
+
+    // Autre système de fichiers : copie à côté de la cible, puis renommage
+    QString staging = target + ".part";
+    QFile::remove(staging);
+    if (!QFile::copy(source, staging) || !replaceFile(staging, target)) {
+        QFile::remove(staging);
+        return false;
+    }
+    QFile::remove(source);
+    return true;
+}
+
+bool ArtifactPublisher::updateLatest(const QString& published, const QString& latest)
+{
+    QString staging = latest + ".part";
+    QFile::remove(staging);
+
+#ifdef Q_OS_UNIX
+    // Lien physique : aucun octet copié
+    bool linked = ::link(QFile::encodeName(published).constData(), QFile::encodeName(staging).constData()) == 0;
+#else
+    bool linked = false;
+#endif
+    if (!linked && !QFile::copy(published, staging)) {
+        return false;
+    }
+    if (!replaceFile(staging, latest)) {
+        QFile::remove(staging);
+        return false;
+    }
+    return true;
+}
+
+QString ArtifactPublisher::publish(const QString& pdfPath, const QString& directory, const QString& baseName,
+                                   bool* unchanged) const
+{
+    if (unchanged) {
+        *unchanged = false;
+    }
+    if (!QFile::exists(pdfPath)) {
+        qDebug() << "PDF à publier introuvable:" << pdfPath;
+        return QString();
+    }
+
+    QString latest = latestPath(directory, baseName);
+    QStringList versions = publishedVersions(directory, baseName);
+
+    // Même contenu que la dernière version : rien à publier
+    if (!versions.isEmpty() && normalizedHash(pdfPath) == normalizedHash(versions.first())) {
+        QFile::remove(pdfPath);
+        if (!QFile::exists(latest)) {
+            updateLatest(versions.first(), latest);
+        }
+        if (unchanged) {
+            *unchanged = true;
+        }
+        return versions.first();
+    }
+
+    QString timestamp = QDateTime::currentDateTime().toString("yyyy_MM_dd_HH_mm_ss");
+    QString published = directory + "/" + baseName + "_" + timestamp + ".pdf";
+    for (int suffix = 2; QFile::exists(published); ++suffix) {
+        published = directory + "/" + baseName + "_" + timestamp + "_" + QString::number(suffix) + ".pdf";
+    }
+
+    if (!moveInto(pdfPath, published)) {
+        qWarning() << "Échec de la publication de" << pdfPath << "vers" << published;
+        return QString();
+    }
+    if (!updateLatest(published, latest)) {
+        qWarning() << "Impossible de mettre à jour" << latest;
+    }
+
+    applyRetention(directory, baseName);
+    return published;
+}
+
+void ArtifactPublisher::applyRetention(const QString& directory, const QString& baseName) const
+{
+    const QStringList versions = publishedVersions(directory, baseName);
+    qint64 maxBytes = qint64(m_policy.keepMegabytes) * 1024 * 1024;
+    qint64 keptBytes = 0;
+
+    // La version la plus récente est toujours gardée
+    for (int i = 0; i < versions.size(); ++i) {
+        keptBytes += QFileInfo(versions.at(i)).size();
+        bool overCount = m_policy.keepCount > 0 && i >= m_policy.keepCount;
+        bool overSize = maxBytes > 0 && keptBytes > maxBytes;
+        if (i > 0 && (overCount || overSize)) {
+            qDebug() << "Ancienne version supprimée:" << versions.at(i);
+            QFile::remove(versions.at(i));
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+// Conservation des PDF publiés, par cible (0 : sans limite)
+struct PublishPolicy {
+    int keepCount = 5;          // Nombre de PDF horodatés conservés
+    int keepMegabytes = 0;      // Taille cumulée maximale des PDF conservés
+};
+
+// Publication des PDF compilés dans le répertoire des sources : déplacement
+// par renommage (copie puis renommage si le répertoire de compilation est sur
+// un autre système de fichiers), jamais de PDF incomplet visible. Chaque cible
+// a un nom stable <base>_latest.pdf (lien physique vers la dernière version)
+// à côté de ses versions horodatées, dont seules les plus récentes sont gardées.
+// Un PDF identique au dernier publié, aux dates et à l'identifiant près, n'est
+// pas publié une seconde fois.
+class ArtifactPublisher
+{
+public:
+    explicit ArtifactPublisher(const PublishPolicy& policy = PublishPolicy()) : m_policy(policy) {}
+
+    void setPolicy(const PublishPolicy& policy) { m_policy = policy; }
+    PublishPolicy policy() const { return m_policy; }
+
+    // Publie pdfPath (consommé) sous directory/<baseName>_<horodatage>.pdf ;
+    // retourne le PDF publié, le précédent s'il est identique (unchanged), ou
+    // vide en cas d'échec
+    QString publish(const QString& pdfPath, const QString& directory, const QString& baseName,
+                    bool* unchanged = nullptr) const;
+
+    // Nom stable de la dernière version d'une cible
+    static QString latestPath(const QString& directory, const QString& baseName);
+
+    // Empreinte d'un PDF sans ses dates de création et de modification ni son /ID
+    static QByteArray normalizedHash(const QString& pdfPath);
+
+private:
+    PublishPolicy m_policy;
+
+    // Versions horodatées d'une cible, de la plus récente à la plus ancienne
+    static QStringList publishedVersions(const QString& directory, const QString& baseName);
+
+    // Remplacement atomique de target par source (même système de fichiers)
+    static bool replaceFile(const QString& source, const QString& target);
+    static bool moveInto(const QString& source, const QString& target);
+    static bool updateLatest(const QString& published, const QString& latest);
+
+    void applyRetention(const QString& directory, const QString& baseName) const;
+};
@@ -0,0 +1,220 @@
+#include "auxiliarytools.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QDebug>
+
+AuxiliaryTools::AuxiliaryTools(const QString& texFile, const QString& targetId,
+                               const QString& sourceDir, const QString& indexTool)
+    : m_sourceDir(sourceDir), m_indexTool(indexTool)
+{
+    QFileInfo texInfo(texFile);
+    m_workingDir = texInfo.absolutePath();
+    m_baseName = texInfo.completeBaseName();
+
+    static const QRegularExpression invalidChars("[^A-Za-z0-9_-]");
+    m_stateDir = m_workingDir + "/outils/" + QString(targetId).replace(invalidChars, "_");
+}
+
+QString AuxiliaryTools::jobFile(const QString& extension) const
+{
+    return m_workingDir + "/" + m_baseName + extension;
+}
+
+QString AuxiliaryTools::resolveSource(const QString& fileName) const
+{
+    if (QFileInfo(fileName).isAbsolute()) {
+        return fileName;
+    }
+    for (const QString& dir : { m_workingDir, m_sourceDir }) {
+        if (!dir.isEmpty() && QFile::exists(dir + "/" + fileName)) {
+            return dir + "/" + fileName;
+        }
+    }
+    // Fichier de la distribution (trouvé par kpsewhich) : seul son nom compte
+    return QString();
+}
+
+QByteArray AuxiliaryTools::hashFiles(const Step& step, const QStringList& files) const
+{
+    // Le pilote change de nom à chaque compilation (horodatage) : remplacé par un
+    // nom fixe, seuls l'outil et le contenu de son entrée comptent
+    static const QString jobToken = "@job@";
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(step.program.toUtf8());
+    hash.addData(QStringList(step.arguments).replaceInStrings(m_baseName, jobToken).join('\n').toUtf8());
+    for (const QString& filePath : files) {
+        hash.addData(QString(filePath).replace(m_baseName, jobToken).toUtf8());
+        QFile file(filePath);
+        if (file.open(QIODevice::ReadOnly)) {
+            hash.addData(file.readAll().replace(m_baseName.toUtf8(), jobToken.toUtf8()));
+        }
+    }
+    return hash.result().toHex();
+}
+
+AuxiliaryTools::Step AuxiliaryTools::bibliographyStep() const
+{
+    Step step;
+    if (!QFile::exists(jobFile(".bcf"))) {
+        return step;
+    }
+    step.name = "bibliographie";
+    step.tool = "biber";
+    step.program = "biber";
+    if (!m_sourceDir.isEmpty()) {
+        step.arguments << "--input-directory" << m_sourceDir;
+    }
+    step.arguments << m_baseName;
+    step.outputs << ".bbl";
+
+    // Les .bib déclarés dans le .bcf font partie de l'entrée de biber
+    step.hash = hashFiles(step, QStringList{ jobFile(".bcf") } + bibliographySources());
+    return step;
+}
+
+QStringList AuxiliaryTools::bibliographySources() const
+{
+    QStringList files;
+    QFile bcf(jobFile(".bcf"));
+    if (!bcf.open(QIODevice::ReadOnly)) {
+        return files;
+    }
+
+    static const QRegularExpression datasource("<bcf:datasource[^>]*>([^<]+)</bcf:datasource>");
+    auto matches = datasource.globalMatch(QString::fromUtf8(bcf.readAll()));
+    while (matches.hasNext()) {
+        QString source = resolveSource(matches.next().captured(1).trimmed());
+        if (!source.isEmpty() && !files.contains(source)) {
+            files << source;
+        }
+    }
+    return files;
+}
+
+AuxiliaryTools::Step AuxiliaryTools::indexStep() const
+{
+    Step step;
+    if (!QFile::exists(jobFile(".idx"))) {
+        return step;
+    }
+
+    step.name = "index";
+    if (m_indexTool == "xindy") {
+        step.tool = "xindy";
+        step.program = "texindy";
+        step.arguments << "-o" << m_baseName + ".ind" << m_baseName + ".idx";
+    } else {
+        step.tool = "makeindex";
+        step.program = "makeindex";
+        step.arguments << m_baseName + ".idx";
+    }
+    step.outputs << ".ind";
+    step.hash = hashFiles(step, { jobFile(".idx") });
+    return step;
+}
+
+AuxiliaryTools::Step AuxiliaryTools::glossaryStep() const
+{
+    Step step;
+    if (!QFile::exists(jobFile(".glo"))) {
+        return step;
+    }
+
+    // \makeglossaries écrit le style attendu : .xdy pour xindy, .ist pour makeindex
+    QString style;
+    if (QFile::exists(jobFile(".xdy"))) {
+        style = jobFile(".xdy");
+        step.tool = "xindy";
+        step.program = "xindy";
+        step.arguments << "-M" << m_baseName;
+
+        // Langue et codage choisis par glossaries, notés dans le .aux
+        QFile aux(jobFile(".aux"));
+        if (aux.open(QIODevice::ReadOnly)) {
+            QString auxContent = QString::fromUtf8(aux.readAll());
+            static const QRegularExpression language("\\\\@xdylanguage\\{main\\}\\{([^}]+)\\}");
+            static const QRegularExpression codepage("\\\\@gls@codepage\\{main\\}\\{([^}]+)\\}");
+            QRegularExpressionMatch match = language.match(auxContent);
+            if (match.hasMatch()) {
+                step.arguments << "-L" << match.captured(1);
+            }
+            match = codepage.match(auxContent);
+            if (match.hasMatch()) {
+                step.arguments << "-C" << match.captured(1);
+            }
+        }
+    } else if (QFile::exists(jobFile(".ist"))) {
+        style = jobFile(".ist");
+        step.tool = "makeindex";
+        step.program = "makeindex";
+        step.arguments << "-s" << m_baseName + ".ist";
+    } else {
+        return step;
+    }
+
+    step.name = "glossaire";
+    step.arguments << "-t" << m_baseName + ".glg" << "-o" << m_baseName + ".gls" << m_baseName + ".glo";
+    step.outputs << ".gls";
+    step.hash = hashFiles(step, { jobFile(".glo"), style });
+    return step;
+}
+
+void AuxiliaryTools::restoreOutputs() const
+{
+    const QStringList names = { "bibliographie", "index", "glossaire" };
+    const QStringList extensions = { ".bbl", ".ind", ".gls" };
+    for (int i = 0; i < names.size(); ++i) {
+        QString saved = m_stateDir + "/" + names.at(i) + extensions.at(i);
+        QString target = jobFile(extensions.at(i));
+        if (QFile::exists(saved) && !QFile::exists(target)) {
+            QFile::copy(saved, target);
+        }
+    }
+}
+
+QVector<AuxiliaryTools::Step> AuxiliaryTools::pendingSteps() const
+{
+    QVector<Step> steps;
+    for (const Step& step : { bibliographyStep(), indexStep(), glossaryStep() }) {
+        if (step.name.isEmpty()) {
+            continue;
+        }
+
+        // Même entrée que la dernière exécution, résultat déjà en place
+        QFile state(m_stateDir + "/" + step.name + ".sha1");
+        bool outputsPresent = true;
+        for (const QString& extension : step.outputs) {
+            outputsPresent = outputsPresent && QFile::exists(jobFile(extension));
+        }
+        if (outputsPresent && state.open(QIODevice::ReadOnly) && state.readAll().trimmed() == step.hash) {
+            continue;
+        }
+        steps.append(step);
+    }
+    return steps;
+}
+
+void AuxiliaryTools::markDone(const Step& step) const
+{
+    if (!QDir().mkpath(m_stateDir)) {
+        qWarning() << "Impossible de créer le répertoire des outils" << m_stateDir;
+        return;
+    }
+
+    for (const QString& extension : step.outputs) {
+        QString saved = m_stateDir + "/" + step.name + extension;
+        QFile::remove(saved);
+        if (!QFile::copy(jobFile(extension), saved)) {
+            qWarning() << "Impossible de conserver" << jobFile(extension);
+            return;
+        }
+    }
+
+    QFile state(m_stateDir + "/" + step.name + ".sha1");
+    if (state.open(QIODevice::WriteOnly)) {
+        state.write(step.hash);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+
+// Outils lancés entre deux passes du moteur : biber (.bcf), makeindex ou xindy
+// (index .idx, glossaire .glo). Une étape n'est lancée que si l'empreinte de
+// son entrée (avec les .bib ou le style utilisés) a changé depuis sa dernière
+// exécution pour la même cible. Ses résultats (.bbl, .ind, .gls) sont conservés
+// par cible et remis en place avant la première passe de la compilation
+// suivante, dont le pilote porte un autre nom.
+class AuxiliaryTools
+{
+public:
+    struct Step {
+        QString name;           // "bibliographie", "index" ou "glossaire" (état conservé)
+        QString tool;           // "biber", "makeindex" ou "xindy"
+        QString program;
+        QStringList arguments;
+        QStringList outputs;    // Extensions des fichiers produits (".bbl"...)
+        QByteArray hash;        // Empreinte de l'entrée au lancement
+    };
+
+    // indexTool : "makeindex" ou "xindy" pour l'index ; sourceDir : répertoire
+    // du fichier principal, où sont cherchés les .bib relatifs
+    AuxiliaryTools(const QString& texFile, const QString& targetId,
+                   const QString& sourceDir, const QString& indexTool);
+
+    // Répertoire de la compilation (les outils y sont lancés)
+    QString workingDir() const { return m_workingDir; }
+
+    // Remet en place les résultats de la dernière exécution pour cette cible
+    void restoreOutputs() const;
+
+    // Étapes dont l'entrée existe et a changé depuis leur dernière exécution
+    QVector<Step> pendingSteps() const;
+
+    // Conserve l'empreinte et les résultats d'une étape réussie
+    void markDone(const Step& step) const;
+
+    // Fichiers .bib déclarés dans le .bcf (lus par biber, absents du .fls du moteur)
+    QStringList bibliographySources() const;
+
+private:
+    QString m_workingDir;
+    QString m_baseName;
+    QString m_stateDir;
+    QString m_sourceDir;
+    QString m_indexTool;
+
+    QString jobFile(const QString& extension) const;
+    QString resolveSource(const QString& fileName) const;
+    QByteArray hashFiles(const Step& step, const QStringList& files) const;
+
+    Step bibliographyStep() const;
+    Step indexStep() const;
+    Step glossaryStep() const;
+};
@@ -0,0 +1,143 @@
+#include "buildplanner.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <algorithm>
+#include "tracer.h"
+
+bool BuildPlanner::isSpecialFolder(const QString& name)
+{
+    return name == "PEDA" || name == "DOCS" || name == "EVALS";
+}
+
+QString BuildPlanner::sectionOf(const LatexNode* node)
+{
+    // Remonter jusqu'au nœud dont le parent est le chapitre (grand-parent : la racine)
+    const LatexNode* section = node;
+    for (const LatexNode* current = node; current->parent && current->parent->parent; current = current->parent) {
+        if (isSpecialFolder(current->name)) {
+            return current->parent->name + "/" + current->name;
+        }
+        section = current;
+    }
+    return section->name;
+}
+
+bool BuildPlanner::isTexFile(const QString& path)
+{
+    return !path.isEmpty() && path.endsWith(".tex") && m_stats.exists(path);
+}
+
+BuildPlan BuildPlanner::plan(const LatexNode* root)
+{
+    TraceScope trace("assemblage", "planification");
+
+    m_plan = BuildPlan();
+    m_chapterSelected.clear();
+    m_chapterIndex.clear();
+    m_exerciseOwners.clear();
+    if (!root) {
+        return m_plan;
+    }
+
+    for (const auto& child : root->children) {
+        const LatexNode* node = child.get();
+        // Dossiers PEDA, DOCS et EVALS de premier niveau : ni chapitre ni document complet
+        if (isSpecialFolder(node->name)) {
+            visit(node, -1, true, true, false, -1);
+            continue;
+        }
+        // Chapitres homonymes (même nom de premier niveau) : fusionnés en un seul
+        int chapter = m_chapterIndex.value(node->name, -1);
+        if (chapter < 0) {
+            m_plan.chapters.append(BuildPlan::Chapter{ node->name, node->path, {} });
+            m_chapterSelected.append(false);
+            chapter = m_plan.chapters.size() - 1;
+            m_chapterIndex.insert(node->name, chapter);
+        }
+        visit(node, chapter, true, true, true, -1);
+    }
+
+    // Chapitres retenus : au moins un fichier coché et un fichier à compiler
+    QVector<BuildPlan::Chapter> chapters;
+    for (int i = 0; i < m_plan.chapters.size(); ++i) {
+        if (m_chapterSelected.at(i) && !m_plan.chapters.at(i).files.isEmpty()) {
+            chapters.append(m_plan.chapters.at(i));
+        }
+    }
+    std::sort(chapters.begin(), chapters.end(),
+              [](const BuildPlan::Chapter& a, const BuildPlan::Chapter& b) { return a.name < b.name; });
+    m_plan.chapters = chapters;
+    
+    // Exercices préfixés pour ne pas croiser un chapitre dans la file ; ceux de même
+    // nom dans des chapitres différents prennent aussi le nom du parent du groupe
+    QHash<QString, int> nameCounts;
+    for (const BuildPlan::Chapter& exercise : m_plan.exercises) {
+        ++nameCounts[exercise.name];
+    }
+    for (int i = 0; i < m_plan.exercises.size(); ++i) {
+        BuildPlan::Chapter& exercise = m_plan.exercises[i];
+        if (nameCounts.value(exercise.name) > 1) {
+            exercise.name = m_exerciseOwners.at(i) + "_" + exercise.name;
+        }
+        exercise.name = "exercice_" + exercise.name;
+    }
+
+    trace.setArg("fichiers", m_stats.size());
+    qDebug() << "Planification :" << m_plan.partialFiles.size() << "fichier(s) pour le partiel,"
+             << m_plan.chapters.size() << "chapitre(s)," << m_plan.documentFiles.size()
+             << "fichier(s) pour le document complet," << m_plan.exercises.size() << "exercice(s) séparé(s)";
+    return m_plan;
+}
+
+void BuildPlanner::visit(const LatexNode* node, int chapter, bool topLevel, bool inPartial, bool inDocument,
+                         int exercise)
+{
+    const QString& path = node->path;
+    bool texFile = isTexFile(path);
+
+    // Partiel : nœuds cochés ou partiellement cochés dont tous les ancêtres le sont
+    inPartial = inPartial && node->checkState != Qt::Unchecked;
+    if (inPartial && texFile && !path.endsWith("_cours.tex")) {
+        m_plan.partialFiles.append(qMakePair(node->name, path));
+        
+        // Exercice séparé : fichier d'un groupe PEDA/DOCS/EVALS, avec ses descendants cochés
+        if (exercise < 0 && node->parent && isSpecialFolder(node->parent->name)) {
+            const LatexNode* group = node->parent;
+            m_plan.exercises.append(BuildPlan::Chapter{ node->name, path, {} });
+            m_exerciseOwners.append(group->parent && group->parent->parent ? group->parent->name : group->name);
+            exercise = m_plan.exercises.size() - 1;
+        }
+        if (exercise >= 0) {
+            m_plan.exercises[exercise].files.append(qMakePair(node->name, path));
+        }
+    }
+
+    // Chapitre : un fichier coché suffit à le retenir ; les fichiers _cours sont exclus
+    if (chapter >= 0 && !topLevel) {
+        if (!path.isEmpty()) {
+            m_plan.chapterByFile.insert(QFileInfo(path).absoluteFilePath(), m_plan.chapters.at(chapter).name);
+        }
+        if (node->checkState == Qt::Checked) {
+            m_chapterSelected[chapter] = true;
+        }
+        if (texFile && !path.mid(path.lastIndexOf('/') + 1).contains("_cours")) {
+            m_plan.chapters[chapter].files.append(qMakePair(node->name, path));
+            m_plan.chapters[chapter].sections.append(sectionOf(node));
+        }
+    }
+
+    // Document complet : un fichier retenu inclut déjà ses enfants, seuls les
+    // dossiers et les fichiers _cours sont explorés
+    if (inDocument && !isSpecialFolder(node->name) && texFile && !path.contains("_cours")) {
+        m_plan.documentFiles.append(qMakePair(node->name, path));
+        inDocument = false;
+    }
+
+    if (!inPartial && chapter < 0 && !inDocument) {
+        return;
+    }
+    for (const auto& child : node->children) {
+        visit(child.get(), chapter, false, inPartial, inDocument, exercise);
+    }
+}
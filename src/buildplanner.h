@@ -0,0 +1,63 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include "latexparser.h"
+#include "filestatcache.h"
+
+// Fichiers de chaque cible d'une compilation
+struct BuildPlan {
+    struct Chapter {
+        QString name;
+        QString path;
+        QVector<QPair<QString, QString>> files;   // (nom, chemin)
+        QStringList sections;                     // Section de chaque fichier (découpage en tronçons)
+    };
+
+    // Fichiers cochés, hors *_cours.tex
+    QVector<QPair<QString, QString>> partialFiles;
+    // Chapitres ayant au moins un fichier coché (tous leurs fichiers hors _cours), par nom
+    QVector<Chapter> chapters;
+    // Chapitre (nœud de premier niveau) de chaque nœud de chapitre, coché ou non, par chemin absolu
+    QHash<QString, QString> chapterByFile;
+    // Tous les fichiers hors _cours et hors dossiers PEDA/DOCS/EVALS de premier niveau
+    QVector<QPair<QString, QString>> documentFiles;
+    // Exercices séparés : chaque fichier coché d'un groupe PEDA/DOCS/EVALS (avec
+    // ses descendants cochés), nommé exercice_<nœud>, dans l'ordre de l'arbre
+    QVector<Chapter> exercises;
+};
+
+// Planifie le partiel, les chapitres et le document complet en un seul parcours
+// de l'arbre LatexNode, en appliquant ensemble les règles de sélection des trois
+// cibles : la planification est linéaire en la taille de l'arbre et chaque
+// fichier n'est interrogé qu'une fois, via l'instantané partagé.
+class BuildPlanner
+{
+public:
+    explicit BuildPlanner(FileStatCache& stats) : m_stats(stats) {}
+
+    BuildPlan plan(const LatexNode* root);
+
+    // Dossiers de premier niveau qui ne sont pas des chapitres
+    static bool isSpecialFolder(const QString& name);
+
+    // Section d'un fichier de chapitre : groupe PEDA/DOCS/EVALS le plus proche,
+    // sinon nœud de premier niveau du chapitre qui le contient
+    static QString sectionOf(const LatexNode* node);
+
+private:
+    FileStatCache& m_stats;
+    BuildPlan m_plan;
+    QVector<bool> m_chapterSelected;
+    QHash<QString, int> m_chapterIndex;   // Indice de chaque chapitre par nom (homonymes fusionnés)
+    QStringList m_exerciseOwners;         // Parent du groupe PEDA/DOCS/EVALS de chaque exercice
+
+    bool isTexFile(const QString& path);
+
+    // chapter : indice du chapitre du nœud (-1 hors chapitre) ; inPartial : tous
+    // les ancêtres sont cochés ; inDocument : le nœud est exploré pour le
+    // document ; exercise : indice de l'exercice séparé du nœud (-1 hors exercice)
+    void visit(const LatexNode* node, int chapter, bool topLevel, bool inPartial, bool inDocument, int exercise);
+};
@@ -0,0 +1,180 @@
+#include "buildroot.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDirIterator>
+#include <QStorageInfo>
+#include <QDebug>
+
+namespace {
+
+const QString s_ramRoot = QStringLiteral("/dev/shm");
+
+// Marge laissée libre sur tmpfs, partagé avec le reste du système
+const qint64 s_ramHeadroomBytes = 64LL * 1024 * 1024;
+
+} // namespace
+
+BuildRootSettings::Mode BuildRootSettings::modeFromName(const QString& name)
+{
+    if (name == "ram") {
+        return Mode::Ram;
+    }
+    if (name == "disk") {
+        return Mode::Disk;
+    }
+    return Mode::Temp;
+}
+
+QString BuildRootSettings::modeName(Mode mode)
+{
+    switch (mode) {
+    case Mode::Ram:
+        return "ram";
+    case Mode::Disk:
+        return "disk";
+    default:
+        return "temp";
+    }
+}
+
+BuildRoot& BuildRoot::instance()
+{
+    static BuildRoot root;
+    return root;
+}
+
+void BuildRoot::configure(const BuildRootSettings& settings)
+{
+    QString previousRoot = m_rootPath;
+    m_settings = settings;
+    m_spilled = false;
+    updateRootPath();
+    if (m_rootPath != previousRoot) {
+        reset();
+    }
+}
+
+void BuildRoot::updateRootPath()
+{
+    // Répertoire du mode disque créé ici une fois, pas à chaque consultation
+    m_rootPath = QDir::tempPath();
+    if (m_settings.mode == BuildRootSettings::Mode::Ram && !m_spilled) {
+        QFileInfo ramInfo(s_ramRoot);
+        if (ramInfo.isDir() && ramInfo.isWritable()) {
+            m_rootPath = s_ramRoot;
+        }
+    } else if (m_settings.mode == BuildRootSettings::Mode::Disk && !m_settings.path.isEmpty()) {
+        if (QDir().mkpath(m_settings.path)) {
+            m_rootPath = QDir(m_settings.path).absolutePath();
+        } else {
+            qWarning() << "Impossible de créer la racine de compilation" << m_settings.path;
+        }
+    }
+}
+
+bool BuildRoot::isRamBacked() const
+{
+    return m_rootPath == s_ramRoot;
+}
+
+QTemporaryDir& BuildRoot::dir(Area area)
+{
+    static const char* const prefixes[AreaCount] = { "qt_partiel_temp", "qt_chapter_temp", "qt_doc_temp" };
+
+    if (!m_dirs[area]) {
+        m_dirs[area].reset(new QTemporaryDir(rootPath() + "/" + prefixes[area] + "-XXXXXX"));
+        if (!m_dirs[area]->isValid()) {
+            qWarning() << "Impossible de créer le répertoire temporaire" << prefixes[area] << "sous" << rootPath();
+        } else {
+            qDebug() << "Répertoire temporaire créé:" << m_dirs[area]->path();
+        }
+    }
+    return *m_dirs[area];
+}
+
+qint64 BuildRoot::usedBytes() const
+{
+    qint64 total = 0;
+    for (const auto& dir : m_dirs) {
+        if (!dir || !dir->isValid()) {
+            continue;
+        }
+        QDirIterator it(dir->path(), QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            it.next();
+            total += it.fileInfo().size();
+        }
+    }
+    return total;
+}
+
+bool BuildRoot::exceedsCap() const
+{
+    if (m_spilled || !isRamBacked()) {
+        return false;
+    }
+
+    qint64 used = usedBytes();
+    qint64 cap = qint64(m_settings.ramMegabytes) * 1024 * 1024;
+    qint64 available = QStorageInfo(s_ramRoot).bytesAvailable();
+    if (used <= cap && available >= s_ramHeadroomBytes) {
+        return false;
+    }
+
+    qWarning().noquote() << QString("Fichiers intermédiaires en RAM : %1 Mo (plafond %2 Mo, %3 Mo libres) ; "
+                                    "bascule sur %4")
+                                .arg(used / (1024 * 1024)).arg(m_settings.ramMegabytes)
+                                .arg(available / (1024 * 1024)).arg(QDir::tempPath());
+    return true;
+}
+
+bool BuildRoot::enforceCap(bool* retiredReleased)
+{
+    // Répertoires laissés en RAM par une bascule en cours de compilation
+    if (retiredReleased) {
+        *retiredReleased = !m_retiredDirs.empty();
+    }
+    m_retiredDirs.clear();
+
+    // Après une bascule, retour en RAM dès que les fichiers intermédiaires (sur
+    // disque pour l'instant) tiennent de nouveau sous le plafond et sur tmpfs
+    if (m_spilled && m_settings.mode == BuildRootSettings::Mode::Ram) {
+        qint64 used = usedBytes();
+        if (used <= qint64(m_settings.ramMegabytes) * 1024 * 1024 &&
+            QStorageInfo(s_ramRoot).bytesAvailable() >= used + s_ramHeadroomBytes) {
+            m_spilled = false;
+            updateRootPath();
+            reset();
+        }
+    }
+
+    if (!exceedsCap()) {
+        return false;
+    }
+    m_spilled = true;
+    updateRootPath();
+    reset();
+    return true;
+}
+
+bool BuildRoot::spillNewWork()
+{
+    if (!exceedsCap()) {
+        return false;
+    }
+    m_spilled = true;
+    updateRootPath();
+    for (auto& dir : m_dirs) {
+        if (dir) {
+            m_retiredDirs.push_back(std::move(dir));
+        }
+    }
+    return true;
+}
+
+void BuildRoot::reset()
+{
+    for (auto& dir : m_dirs) {
+        dir.reset();
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <QString>
+#include <QTemporaryDir>
+#include <QDir>
+#include <memory>
+#include <vector>
+
+// Emplacement des fichiers intermédiaires (pilotes, .aux, .log, PDF avant publication)
+struct BuildRootSettings {
+    enum class Mode {
+        Temp,   // Répertoire temporaire du système
+        Disk,   // Répertoire choisi (disque local rapide...)
+        Ram     // tmpfs (/dev/shm), avec bascule sur disque au-delà du plafond
+    };
+
+    Mode mode = Mode::Temp;
+    QString path;               // Mode Disk : répertoire racine
+    int ramMegabytes = 1024;    // Mode Ram : taille maximale des fichiers intermédiaires
+
+    static Mode modeFromName(const QString& name);
+    static QString modeName(Mode mode);
+};
+
+// Racine de compilation commune aux assembleurs du processus : un répertoire
+// temporaire par catégorie de cible, créé à la première utilisation sous la
+// racine configurée et supprimé avec elle. En mode RAM, les passes écrivent
+// sur tmpfs (pas de fsync ni d'E/S disque) ; si les fichiers intermédiaires
+// dépassent le plafond ou que tmpfs est presque plein, la suite repart sur le
+// répertoire temporaire du système : entre deux compilations (enforceCap) ou
+// pendant une compilation, avant chaque chapitre ou tronçon (spillNewWork), les
+// fichiers en cours restant alors en RAM jusqu'à la fin de la compilation. Une
+// compilation suivante repart en RAM quand ils tiennent de nouveau sous le plafond.
+// Seuls les PDF finaux sont publiés dans l'arborescence des sources.
+class BuildRoot
+{
+public:
+    enum Area {
+        Partial,
+        Chapter,
+        Document,
+        AreaCount
+    };
+
+    static BuildRoot& instance();
+
+    // Nouvelle configuration : les répertoires existants sont supprimés si la
+    // racine change (à appeler hors compilation)
+    void configure(const BuildRootSettings& settings);
+    BuildRootSettings settings() const { return m_settings; }
+
+    // Répertoire d'une catégorie, créé au besoin
+    QTemporaryDir& dir(Area area);
+
+    // Racine effective (après une éventuelle bascule sur disque), établie par
+    // configure() et à chaque bascule
+    QString rootPath() const { return m_rootPath; }
+    bool isRamBacked() const;
+
+    // Taille des fichiers intermédiaires sous la racine
+    qint64 usedBytes() const;
+
+    // Mode RAM, au début d'une compilation : retour en RAM après une bascule si
+    // les fichiers intermédiaires tiennent de nouveau sous le plafond, bascule sur
+    // disque s'ils le dépassent ; vrai seulement dans ce dernier cas. retiredReleased :
+    // répertoires gardés par une bascule en cours de compilation supprimés
+    bool enforceCap(bool* retiredReleased = nullptr);
+
+    // Mode RAM, pendant une compilation : si le plafond est dépassé, les
+    // répertoires suivants sont créés sur disque et les actuels gardés jusqu'au
+    // prochain enforceCap ; vrai en cas de bascule
+    bool spillNewWork();
+
+private:
+    BuildRoot() = default;
+
+    BuildRootSettings m_settings;
+    bool m_spilled = false;
+    QString m_rootPath = QDir::tempPath();
+    std::unique_ptr<QTemporaryDir> m_dirs[AreaCount];
+    std::vector<std::unique_ptr<QTemporaryDir>> m_retiredDirs;   // Encore utilisés par la compilation en cours
+
+    bool exceedsCap() const;
+    void updateRootPath();
+
+    void reset();
+};
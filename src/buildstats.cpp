@@ -0,0 +1,215 @@
+#include "buildstats.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+
+namespace {
+
+QString formatBytes(qint64 bytes)
+{
+    if (bytes >= 1024 * 1024) {
+        return QString("%1 Mo").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    return QString("%1 Ko").arg(bytes / 1024.0, 0, 'f', 1);
+}
+
+QString formatSeconds(qint64 ms)
+{
+    return QString("%1 s").arg(ms / 1000.0, 0, 'f', 2);
+}
+
+const char* const csvHeader =
+    "build,main_file,target,label,pass,started_at,exit_code,wall_ms,"
+    "user_cpu_ms,system_cpu_ms,peak_rss_kb,bytes_read,bytes_written,profile,usage_age_ms";
+
+QString csvField(QString value)
+{
+    if (value.contains(',') || value.contains('"')) {
+        value.replace("\"", "\"\"");
+        return "\"" + value + "\"";
+    }
+    return value;
+}
+
+} // namespace
+
+void BuildStats::clear()
+{
+    m_records.clear();
+    m_buildStartedAt = QDateTime::currentDateTime();
+}
+
+void BuildStats::record(const PassRecord& record)
+{
+    if (m_records.isEmpty() && !m_buildStartedAt.isValid()) {
+        m_buildStartedAt = record.startedAt;
+    }
+    m_records.append(record);
+}
+
+QString BuildStats::summary() const
+{
+    if (m_records.isEmpty()) {
+        return QString();
+    }
+
+    // Regrouper par cible (et chapitre) en conservant l'ordre d'apparition
+    QStringList order;
+    QMap<QString, QVector<PassRecord>> groups;
+    for (const PassRecord& record : m_records) {
+        QString key = record.label.isEmpty() ? record.target : record.target + " " + record.label;
+        if (!groups.contains(key)) {
+            order.append(key);
+        }
+        groups[key].append(record);
+    }
+
+    QString text;
+    QTextStream out(&text);
+    out << "=== BILAN DES RESSOURCES ===\n";
+
+    qint64 totalWall = 0;
+    qint64 totalCpu = 0;
+    for (const QString& key : order) {
+        qint64 wall = 0;
+        qint64 cpu = 0;
+        qint64 peakRss = 0;
+        qint64 read = 0;
+        qint64 written = 0;
+
+        const QString& profile = groups[key].first().profile;
+        out << "\n" << key << (profile.isEmpty() ? QString() : QString(" [%1]").arg(profile)) << " :\n";
+        for (const PassRecord& record : groups[key]) {
+            const ProcessUsage& usage = record.result.usage;
+            out << QString("  passe %1 : mur %2, CPU %3 (util. %4 / sys. %5), RSS max %6, lu %7, écrit %8\n")
+                       .arg(record.pass)
+                       .arg(formatSeconds(record.result.wallTimeMs))
+                       .arg(formatSeconds(usage.userCpuMs + usage.systemCpuMs))
+                       .arg(formatSeconds(usage.userCpuMs))
+                       .arg(formatSeconds(usage.systemCpuMs))
+                       .arg(formatBytes(usage.peakRssKb * 1024))
+                       .arg(formatBytes(usage.bytesRead))
+                       .arg(formatBytes(usage.bytesWritten));
+
+            wall += record.result.wallTimeMs;
+            cpu += usage.userCpuMs + usage.systemCpuMs;
+            peakRss = qMax(peakRss, usage.peakRssKb);
+            read += usage.bytesRead;
+            written += usage.bytesWritten;
+        }
+
+        out << QString("  total : %1 passe(s), mur %2, CPU %3, RSS max %4, lu %5, écrit %6\n")
+                   .arg(groups[key].size())
+                   .arg(formatSeconds(wall))
+                   .arg(formatSeconds(cpu))
+                   .arg(formatBytes(peakRss * 1024))
+                   .arg(formatBytes(read))
+                   .arg(formatBytes(written));
+
+        totalWall += wall;
+        totalCpu += cpu;
+    }
+
+    out << QString("\nCumul : %1 passe(s), mur %2, CPU %3\n")
+               .arg(m_records.size())
+               .arg(formatSeconds(totalWall))
+               .arg(formatSeconds(totalCpu));
+
+    return text;
+}
+
+bool BuildStats::appendCsv(const QString& filePath, const QString& mainFilePath) const
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QFile file(filePath);
+
+    // Fichier d'une version précédente (colonnes différentes) : mis de côté
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QString header = QString::fromUtf8(file.readLine()).trimmed();
+        file.close();
+        if (!header.isEmpty() && header != csvHeader) {
+            QFile::remove(filePath + ".old");
+            QFile::rename(filePath, filePath + ".old");
+        }
+    }
+
+    bool writeHeader = !file.exists() || file.size() == 0;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    if (writeHeader) {
+        out << csvHeader << '\n';
+    }
+
+    QString buildId = m_buildStartedAt.toString(Qt::ISODate);
+    for (const PassRecord& record : m_records) {
+        const ProcessUsage& usage = record.result.usage;
+        out << csvField(buildId) << ','
+            << csvField(mainFilePath) << ','
+            << record.target << ','
+            << csvField(record.label) << ','
+            << record.pass << ','
+            << record.startedAt.toString(Qt::ISODate) << ','
+            << record.result.exitCode << ','
+            << record.result.wallTimeMs << ','
+            << usage.userCpuMs << ','
+            << usage.systemCpuMs << ','
+            << usage.peakRssKb << ','
+            << usage.bytesRead << ','
+            << usage.bytesWritten << ','
+            << csvField(record.profile) << ','
+            << usage.sampleAgeMs << '\n';
+    }
+
+    file.close();
+    return true;
+}
+
+bool BuildStats::writeJson(const QString& filePath, const QString& mainFilePath) const
+{
+    QJsonArray passes;
+    for (const PassRecord& record : m_records) {
+        const ProcessUsage& usage = record.result.usage;
+        QJsonObject pass;
+        pass["target"] = record.target;
+        pass["label"] = record.label;
+        pass["pass"] = record.pass;
+        pass["profile"] = record.profile;
+        pass["startedAt"] = record.startedAt.toString(Qt::ISODate);
+        pass["exitCode"] = record.result.exitCode;
+        pass["wallMs"] = record.result.wallTimeMs;
+        pass["userCpuMs"] = usage.userCpuMs;
+        pass["systemCpuMs"] = usage.systemCpuMs;
+        pass["peakRssKb"] = usage.peakRssKb;
+        pass["bytesRead"] = usage.bytesRead;
+        pass["bytesWritten"] = usage.bytesWritten;
+        pass["usageAvailable"] = usage.valid;
+        // Relevés /proc toutes les 100 ms : la fin de la passe n'est pas comptée
+        pass["usageApproximate"] = true;
+        pass["usageAgeMs"] = usage.sampleAgeMs;
+        passes.append(pass);
+    }
+
+    QJsonObject root;
+    root["build"] = m_buildStartedAt.toString(Qt::ISODate);
+    root["mainFile"] = mainFilePath;
+    root["passes"] = passes;
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+    return true;
+}
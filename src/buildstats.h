@@ -0,0 +1,37 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+#include "processrunner.h"
+
+// Mesure d'une passe de compilation (un processus lancé par l'assembleur)
+struct PassRecord {
+    QString target;     // "partiel", "chapitre" ou "document"
+    QString label;      // Nom du chapitre, vide sinon
+    int pass = 0;       // Numéro de la passe (1 à 5)
+    QString profile;    // Profil de compilation utilisé
+    QDateTime startedAt;
+    ProcessResult result;
+};
+
+// Agrège les mesures de toutes les passes d'une compilation
+class BuildStats
+{
+public:
+    void clear();
+    void record(const PassRecord& record);
+
+    bool isEmpty() const { return m_records.isEmpty(); }
+    const QVector<PassRecord>& records() const { return m_records; }
+
+    // Bilan lisible par cible et par passe
+    QString summary() const;
+
+    // Export pour le suivi des tendances : le CSV est complété build après build
+    bool appendCsv(const QString& filePath, const QString& mainFilePath) const;
+    bool writeJson(const QString& filePath, const QString& mainFilePath) const;
+
+private:
+    QVector<PassRecord> m_records;
+    QDateTime m_buildStartedAt;
+};
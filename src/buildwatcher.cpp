@@ -0,0 +1,194 @@
+#include "buildwatcher.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include <functional>
+
+BuildWatcher::BuildWatcher(QObject* parent)
+    : QObject(parent),
+      m_watcher(new QFileSystemWatcher(this)),
+      m_debounceTimer(new QTimer(this))
+{
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(500);
+
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &BuildWatcher::onFileChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &BuildWatcher::onDirectoryChanged);
+    connect(m_debounceTimer, &QTimer::timeout, this, &BuildWatcher::publishChanges);
+}
+
+void BuildWatcher::watch(const QString& mainFilePath, LatexModel* model)
+{
+    stop();
+
+    QStringList files = modelFiles(model);
+    QString mainFile = QFileInfo(mainFilePath).absoluteFilePath();
+    if (!files.contains(mainFile)) {
+        files.prepend(mainFile);
+    }
+
+    QSet<QString> directories;
+    for (const QString& filePath : files) {
+        if (!QFile::exists(filePath)) {
+            continue;
+        }
+        m_signatures.insert(filePath, signatureOf(filePath));
+        directories.insert(QFileInfo(filePath).absolutePath());
+    }
+
+    m_watcher->addPaths(m_signatures.keys());
+    m_watcher->addPaths(QStringList(directories.begin(), directories.end()));
+
+    qDebug() << "Surveillance de" << m_signatures.size() << "fichiers dans" << directories.size() << "répertoires";
+}
+
+void BuildWatcher::addFiles(const QStringList& filePaths)
+{
+    QStringList newFiles;
+    QSet<QString> directories;
+    for (const QString& filePath : filePaths) {
+        QString absolutePath = QFileInfo(filePath).absoluteFilePath();
+        if (m_signatures.contains(absolutePath) || !QFile::exists(absolutePath)) {
+            continue;
+        }
+        m_signatures.insert(absolutePath, signatureOf(absolutePath));
+        newFiles.append(absolutePath);
+        directories.insert(QFileInfo(absolutePath).absolutePath());
+    }
+    if (newFiles.isEmpty()) {
+        return;
+    }
+
+    m_watcher->addPaths(newFiles);
+    for (const QString& directory : directories) {
+        if (!m_watcher->directories().contains(directory)) {
+            m_watcher->addPath(directory);
+        }
+    }
+
+    qDebug() << "Surveillance de" << newFiles.size() << "dépendances supplémentaires";
+}
+
+void BuildWatcher::stop()
+{
+    m_debounceTimer->stop();
+    m_pendingChanges.clear();
+    m_signatures.clear();
+
+    if (!m_watcher->files().isEmpty()) {
+        m_watcher->removePaths(m_watcher->files());
+    }
+    if (!m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+}
+
+void BuildWatcher::setPaused(bool paused)
+{
+    m_paused = paused;
+
+    // Publier ce qui s'est accumulé pendant la pause (après le délai habituel)
+    if (!m_paused && !m_pendingChanges.isEmpty()) {
+        m_debounceTimer->start();
+    }
+}
+
+BuildWatcher::FileSignature BuildWatcher::signatureOf(const QString& filePath)
+{
+    QFileInfo info(filePath);
+    FileSignature signature;
+    if (info.exists()) {
+        signature.lastModified = info.lastModified();
+        signature.size = info.size();
+    }
+    return signature;
+}
+
+QStringList BuildWatcher::modelFiles(LatexModel* model)
+{
+    QStringList files;
+    if (!model) {
+        return files;
+    }
+
+    // Les groupes PEDA/DOCS/EVALS portent le chemin de leur parent : dédoublonner
+    std::function<void(const QModelIndex&)> collect = [&](const QModelIndex& parent) {
+        for (int i = 0; i < model->rowCount(parent); ++i) {
+            QModelIndex index = model->index(i, 0, parent);
+            QString nodePath = model->data(index, Qt::ToolTipRole).toString();
+            if (nodePath.endsWith(".tex")) {
+                QString absolutePath = QFileInfo(nodePath).absoluteFilePath();
+                if (!files.contains(absolutePath)) {
+                    files.append(absolutePath);
+                }
+            }
+            if (model->hasChildren(index)) {
+                collect(index);
+            }
+        }
+    };
+    collect(QModelIndex());
+
+    return files;
+}
+
+void BuildWatcher::onFileChanged(const QString& path)
+{
+    checkFile(path);
+}
+
+void BuildWatcher::onDirectoryChanged(const QString& path)
+{
+    // Un enregistrement par renommage remplace le fichier : le nouveau fichier
+    // n'est plus surveillé et ne se signale qu'à travers son répertoire
+    QDir directory(path);
+    for (auto it = m_signatures.constBegin(); it != m_signatures.constEnd(); ++it) {
+        if (QFileInfo(it.key()).absolutePath() == directory.absolutePath()) {
+            checkFile(it.key());
+        }
+    }
+}
+
+void BuildWatcher::checkFile(const QString& filePath)
+{
+    if (!m_signatures.contains(filePath)) {
+        return;
+    }
+
+    // Fichier momentanément absent (entre suppression et renommage) : le
+    // répertoire signalera sa réapparition
+    if (!QFile::exists(filePath)) {
+        return;
+    }
+
+    if (!m_watcher->files().contains(filePath)) {
+        m_watcher->addPath(filePath);
+    }
+
+    FileSignature signature = signatureOf(filePath);
+    if (signature == m_signatures.value(filePath)) {
+        return;
+    }
+
+    m_signatures.insert(filePath, signature);
+    m_pendingChanges.insert(filePath);
+
+    // Chaque nouvelle modification repousse la publication
+    if (!m_paused) {
+        m_debounceTimer->start();
+    }
+}
+
+void BuildWatcher::publishChanges()
+{
+    if (m_paused || m_pendingChanges.isEmpty()) {
+        return;
+    }
+
+    QStringList changedFiles(m_pendingChanges.begin(), m_pendingChanges.end());
+    changedFiles.sort();
+    m_pendingChanges.clear();
+
+    qDebug() << "Fichiers modifiés:" << changedFiles;
+    emit changesReady(changedFiles);
+}
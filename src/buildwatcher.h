@@ -0,0 +1,72 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QHash>
+#include <QDateTime>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include "latexmodel.h"
+
+// Surveille le fichier principal (préambule) et tous les fichiers de
+// l'arborescence, puis regroupe les rafales d'enregistrements : changesReady()
+// n'est émis qu'après debounceMs sans nouvelle modification.
+// Les éditeurs qui enregistrent par renommage (fichier remplacé) sont gérés
+// en surveillant aussi les répertoires et en réinscrivant les fichiers.
+class BuildWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BuildWatcher(QObject* parent = nullptr);
+
+    // Remplace l'ensemble surveillé par le fichier principal et les nœuds du modèle
+    void watch(const QString& mainFilePath, LatexModel* model);
+
+    // Ajoute des fichiers hors de l'arborescence (images, .bib... lus par les
+    // compilations) ; ceux déjà surveillés gardent leur signature
+    void addFiles(const QStringList& filePaths);
+
+    // Arrête la surveillance et oublie les modifications en attente
+    void stop();
+
+    bool isWatching() const { return !m_signatures.isEmpty(); }
+    QStringList watchedFiles() const { return m_signatures.keys(); }
+
+    // Délai de regroupement des modifications
+    void setDebounceInterval(int ms) { m_debounceTimer->setInterval(ms); }
+    int debounceInterval() const { return m_debounceTimer->interval(); }
+
+    // Pendant une compilation, les modifications sont conservées et ne sont
+    // publiées qu'à la reprise
+    void setPaused(bool paused);
+
+signals:
+    // Fichiers réellement modifiés (contenu ou date) depuis la dernière publication
+    void changesReady(const QStringList& changedFiles);
+
+private:
+    // Date et taille d'un fichier : filtre les notifications sans changement réel
+    struct FileSignature {
+        QDateTime lastModified;
+        qint64 size = -1;
+        bool operator==(const FileSignature& other) const {
+            return lastModified == other.lastModified && size == other.size;
+        }
+    };
+
+    QFileSystemWatcher* m_watcher;
+    QTimer* m_debounceTimer;
+    QHash<QString, FileSignature> m_signatures;
+    QSet<QString> m_pendingChanges;
+    bool m_paused = false;
+
+    static FileSignature signatureOf(const QString& filePath);
+    static QStringList modelFiles(LatexModel* model);
+
+    void onFileChanged(const QString& path);
+    void onDirectoryChanged(const QString& path);
+    void checkFile(const QString& filePath);
+    void publishChanges();
+};
@@ -0,0 +1,584 @@
+#include "clibuilder.h"
+#include "lastfilehelper.h"
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDebug>
+#include <QTimer>
+#include "tracer.h"
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_UNIX
+// Tube du gestionnaire de signaux : seul write() y est sûr, le reste se fait
+// dans la boucle d'événements
+int s_signalPipe[2] = { -1, -1 };
+
+void relaySignal(int)
+{
+    char byte = 1;
+    ssize_t written = ::write(s_signalPipe[1], &byte, 1);
+    Q_UNUSED(written);
+}
+#endif
+
+QTextStream& standardOutput()
+{
+    static QTextStream out(stdout);
+    return out;
+}
+
+QTextStream& standardError()
+{
+    static QTextStream err(stderr);
+    return err;
+}
+
+QString targetPrefix(LatexAssembler::BuildTarget target)
+{
+    switch (target) {
+        case LatexAssembler::BuildTarget::Chapter:
+            return "[chapitre] ";
+        case LatexAssembler::BuildTarget::Document:
+            return "[document] ";
+        case LatexAssembler::BuildTarget::Partial:
+        default:
+            return "[partiel] ";
+    }
+}
+
+} // namespace
+
+CliBuilder::CliBuilder(QObject* parent)
+    : QObject(parent), m_assembler(new LatexAssembler(this))
+{
+}
+
+bool CliBuilder::isRequested(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--build" || arg.startsWith("--build=")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int CliBuilder::run(QCoreApplication& app)
+{
+    app.setApplicationVersion(APP_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compilation LaTeX sélective, mode ligne de commande");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption buildOption("build", "Fichier LaTeX principal à compiler.", "fichier.tex");
+    QCommandLineOption selectOption("select",
+        "Sélection : \"saved\" (état enregistré par l'interface), \"all\", "
+        "ou liste de chemins/noms de nœuds séparés par des virgules.", "sélection", "saved");
+    QCommandLineOption targetsOption("targets",
+        "Cibles séparées par des virgules : partial, chapters, document, exercises "
+        "(un PDF par fichier coché des groupes PEDA/DOCS/EVALS).", "cibles", "partial");
+    QCommandLineOption jobsOption("jobs", "Nombre de chapitres compilés en parallèle (par défaut : un, "
+                                  "un par cœur pour les tronçons et les exercices).", "N");
+    QCommandLineOption engineOption("engine",
+        "Programme utilisé à la place du moteur des profils (moteur factice, autre installation).", "programme");
+    QCommandLineOption profileOption("profile",
+        "Profil de compilation (apercu, complet, pdflatex, xelatex, lualatex ou profil de config.json), "
+        "pour toutes les cibles ou pour une seule avec cible=profil. Répétable.", "profil");
+    QCommandLineOption includeOnlyOption("includeonly",
+        "Document complet en unités \\include ; partiel et chapitres avec \\includeonly "
+        "et la numérotation de la dernière compilation complète.");
+    QCommandLineOption splitChaptersOption("split-chapters",
+        "Avec les cibles chapters et document : une seule compilation du document complet, "
+        "puis extraction des pages de chaque chapitre.");
+    QCommandLineOption shardedOption("sharded",
+        "Document complet compilé par chapitre en parallèle (compteurs de la compilation précédente), "
+        "puis PDF fusionnés.");
+    QCommandLineOption chapterShardsOption("chapter-shards",
+        "Chapitres de plus de N fichiers compilés en tronçons parallèles d'au plus N fichiers, "
+        "puis PDF fusionnés.", "N", "0");
+    QCommandLineOption tikzCacheOption("tikz-cache",
+        "Figures TikZ reprises d'un cache commun aux cibles ; figures manquantes générées en parallèle.");
+    QCommandLineOption forceOption("force",
+        "Recompile les chapitres et le document même si aucune de leurs dépendances n'a changé.");
+    QCommandLineOption noPreflightOption("no-preflight",
+        "Sans vérification préalable des sources (fichiers, encodage, accolades, environnements, étiquettes).");
+    QCommandLineOption findCulpritOption("find-culprit",
+        "Au lieu de compiler, cherche le fichier qui fait échouer la cible partial ou document "
+        "(compilations d'essai en parallèle).");
+    QCommandLineOption buildRootOption("build-root",
+        "Racine des fichiers intermédiaires : temp, ram (tmpfs /dev/shm, plafond de config.json) "
+        "ou un répertoire.", "racine");
+    QCommandLineOption saveBuildRootOption("save-build-root",
+        "Avec --build-root : enregistre cette racine pour ce fichier principal dans config.json.");
+    QCommandLineOption warmWorkersOption("warm-workers",
+        "Avec --watch : nombre de processus LuaLaTeX préchauffés sur le préambule du partiel.", "N", "0");
+    QCommandLineOption watchOption("watch",
+        "Reste actif et recompile les cibles concernées à chaque modification des sources.");
+
+    parser.addOption(buildOption);
+    parser.addOption(selectOption);
+    parser.addOption(targetsOption);
+    parser.addOption(jobsOption);
+    parser.addOption(watchOption);
+    parser.addOption(engineOption);
+    parser.addOption(profileOption);
+    parser.addOption(includeOnlyOption);
+    parser.addOption(splitChaptersOption);
+    parser.addOption(shardedOption);
+    parser.addOption(chapterShardsOption);
+    parser.addOption(tikzCacheOption);
+    parser.addOption(forceOption);
+    parser.addOption(noPreflightOption);
+    parser.addOption(findCulpritOption);
+    parser.addOption(buildRootOption);
+    parser.addOption(saveBuildRootOption);
+    parser.addOption(warmWorkersOption);
+
+    // Déjà pris en compte par Tracer::configureFromArguments
+    QCommandLineOption traceOption("trace", "Écrit une trace Chrome (chrome://tracing, Perfetto) de la compilation.",
+                                   "trace.json");
+    parser.addOption(traceOption);
+    parser.process(app);
+
+    Options options;
+    options.mainFile = QFileInfo(parser.value(buildOption)).absoluteFilePath();
+    options.selection = parser.value(selectOption);
+    options.targets = parser.value(targetsOption).split(',', Qt::SkipEmptyParts);
+    options.watch = parser.isSet(watchOption);
+    options.includeOnly = parser.isSet(includeOnlyOption);
+    options.splitChapters = parser.isSet(splitChaptersOption);
+    options.sharded = parser.isSet(shardedOption);
+    options.tikzCache = parser.isSet(tikzCacheOption);
+    options.force = parser.isSet(forceOption);
+    options.preflight = !parser.isSet(noPreflightOption);
+    options.findCulprit = parser.isSet(findCulpritOption);
+    options.buildRoot = parser.value(buildRootOption);
+    options.saveBuildRoot = parser.isSet(saveBuildRootOption);
+    if (options.saveBuildRoot && options.buildRoot.isEmpty()) {
+        standardError() << "--save-build-root demande --build-root" << Qt::endl;
+        return UsageError;
+    }
+    options.engine = parser.value(engineOption);
+
+    if (parser.isSet(jobsOption)) {
+        bool jobsOk = false;
+        options.jobs = parser.value(jobsOption).toInt(&jobsOk);
+        if (!jobsOk || options.jobs < 1) {
+            standardError() << "Nombre de tâches invalide : " << parser.value(jobsOption) << Qt::endl;
+            return UsageError;
+        }
+    }
+
+    bool chapterShardsOk = false;
+    options.chapterShards = parser.value(chapterShardsOption).toInt(&chapterShardsOk);
+    if (!chapterShardsOk || options.chapterShards < 0) {
+        standardError() << "Nombre de fichiers par tronçon invalide : " << parser.value(chapterShardsOption) << Qt::endl;
+        return UsageError;
+    }
+
+    bool warmOk = false;
+    options.warmWorkers = parser.value(warmWorkersOption).toInt(&warmOk);
+    if (!warmOk || options.warmWorkers < 0) {
+        standardError() << "Nombre de processus préchauffés invalide : " << parser.value(warmWorkersOption) << Qt::endl;
+        return UsageError;
+    }
+
+    // Noms des cibles en ligne de commande -> noms utilisés par les profils
+    static const QMap<QString, QString> profileTargets = {
+        { "partial", "partiel" }, { "chapters", "chapitre" }, { "document", "document" }
+    };
+    for (const QString& value : parser.values(profileOption)) {
+        int separator = value.indexOf('=');
+        if (separator < 0) {
+            for (const QString& target : profileTargets) {
+                options.profiles[target] = value.trimmed();
+            }
+            continue;
+        }
+        QString target = value.left(separator).trimmed();
+        if (!profileTargets.contains(target)) {
+            standardError() << "Cible inconnue pour --profile : " << target << Qt::endl;
+            return UsageError;
+        }
+        options.profiles[profileTargets.value(target)] = value.mid(separator + 1).trimmed();
+    }
+
+    static const QStringList knownTargets = { "partial", "chapters", "document", "exercises" };
+    for (QString& target : options.targets) {
+        target = target.trimmed();
+        if (!knownTargets.contains(target)) {
+            standardError() << "Cible inconnue : " << target << Qt::endl;
+            return UsageError;
+        }
+    }
+    if (options.targets.isEmpty()) {
+        standardError() << "Aucune cible demandée" << Qt::endl;
+        return UsageError;
+    }
+    if (options.findCulprit && (options.watch || options.targets.size() != 1 ||
+                                (options.targets.first() != "partial" && options.targets.first() != "document"))) {
+        standardError() << "--find-culprit : une seule cible, partial ou document, sans --watch" << Qt::endl;
+        return UsageError;
+    }
+
+    CliBuilder builder;
+    int earlyExit = builder.start(options);
+    if (earlyExit >= 0) {
+        return earlyExit;
+    }
+
+    int exitCode = app.exec();
+    ProcessRunner::killAllProcessGroups();
+    Tracer::instance().write();
+    return exitCode;
+}
+
+int CliBuilder::start(const Options& options)
+{
+    m_options = options;
+
+    QFileInfo mainFileInfo(options.mainFile);
+    if (!mainFileInfo.exists() || mainFileInfo.suffix() != "tex") {
+        standardError() << "Fichier LaTeX introuvable : " << options.mainFile << Qt::endl;
+        return LoadError;
+    }
+
+    m_model.loadFromFile(options.mainFile);
+    if (!m_model.hasData()) {
+        standardError() << "Impossible d'analyser le fichier : " << options.mainFile << Qt::endl;
+        return LoadError;
+    }
+
+    if (!applySelection(options.selection, options.mainFile)) {
+        return LoadError;
+    }
+
+    LastFileHelper lastFileHelper;
+    m_assembler->setProcessLimits(lastFileHelper.loadProcessLimits());
+    m_assembler->setPublishPolicy(lastFileHelper.loadPublishPolicy());
+    if (options.jobs > 0) {
+        m_assembler->setMaxParallelJobs(options.jobs);
+    }
+    m_assembler->setMainFilePath(options.mainFile);
+
+    // Racine du projet dans config.json, sauf si --build-root l'impose
+    BuildRootSettings buildRoot = lastFileHelper.loadBuildRoot(options.mainFile);
+    if (options.buildRoot == "temp" || options.buildRoot == "ram") {
+        buildRoot.mode = BuildRootSettings::modeFromName(options.buildRoot);
+    } else if (!options.buildRoot.isEmpty()) {
+        buildRoot.mode = BuildRootSettings::Mode::Disk;
+        buildRoot.path = QFileInfo(options.buildRoot).absoluteFilePath();
+    }
+    if (options.saveBuildRoot) {
+        lastFileHelper.saveBuildRoot(buildRoot, options.mainFile);
+        standardError() << "Racine de compilation enregistrée pour " << options.mainFile << Qt::endl;
+    }
+    m_assembler->setBuildRoot(buildRoot);
+
+    // Profils de config.json, puis ceux imposés par --profile
+    QVector<CompileProfile> profiles = lastFileHelper.loadCompileProfiles();
+    m_assembler->selectProfiles(profiles, lastFileHelper.loadTargetProfiles());
+    if (!m_assembler->selectProfiles(profiles, options.profiles)) {
+        standardError() << "Profil de compilation inconnu" << Qt::endl;
+        return UsageError;
+    }
+    m_assembler->setIncludeOnlyMode(options.includeOnly);
+    m_assembler->setChaptersFromDocument(options.splitChapters);
+    m_assembler->setShardedDocument(options.sharded);
+    m_assembler->setChapterShardFiles(options.chapterShards);
+    m_assembler->setTikzFigureCache(options.tikzCache);
+    m_assembler->setForceRebuild(options.force);
+    m_assembler->setPreflightChecks(options.preflight);
+    // Sans --watch, le programme se termine avant qu'un processus préchauffé serve
+    m_assembler->setWarmWorkers(options.watch ? options.warmWorkers : 0);
+    if (!options.engine.isEmpty()) {
+        m_assembler->setEngineProgram(options.engine);
+    }
+    connectOutput();
+    m_killGraceMs = lastFileHelper.loadProcessLimits().killGraceMs;
+    installSignalHandlers();
+
+    // Recherche du fichier en cause : la sortie donne les fichiers, le code de
+    // sortie dit seulement si la recherche a pu se faire
+    if (options.findCulprit) {
+        connect(m_assembler, &LatexAssembler::culpritSearchFinished, this, [this]() {
+            if (!m_interrupted) {
+                QCoreApplication::exit(Success);
+            }
+        });
+        LatexAssembler::BuildTarget target = options.targets.first() == "document"
+                                             ? LatexAssembler::BuildTarget::Document
+                                             : LatexAssembler::BuildTarget::Partial;
+        return m_assembler->findCulprit(&m_model, target) ? -1 : BuildFailed;
+    }
+
+    if (options.targets.contains("partial")) {
+        m_assembler->buildPartialDocument(options.mainFile, &m_model, false, false);
+    }
+
+    if (options.targets.contains("chapters") && options.targets.contains("document")) {
+        m_assembler->compileChaptersAndDocument(&m_model);
+    } else if (options.targets.contains("chapters")) {
+        m_assembler->compileChapters(&m_model);
+    } else if (options.targets.contains("document")) {
+        m_assembler->compileFullDocument(&m_model);
+    }
+
+    if (options.targets.contains("exercises")) {
+        m_assembler->compileExercises(&m_model);
+    }
+
+    if (options.watch) {
+        m_watcher = new BuildWatcher(this);
+        connect(m_assembler, &LatexAssembler::buildStarted, m_watcher, [this]() { m_watcher->setPaused(true); });
+        connect(m_assembler, &LatexAssembler::buildFinished, m_watcher, [this]() {
+            // Arrêt par signal : la surveillance reste en pause jusqu'à la sortie
+            if (m_interrupted) {
+                return;
+            }
+            m_watcher->addFiles(m_assembler->dependencyFiles());
+            m_watcher->setPaused(false);
+        });
+        connect(m_watcher, &BuildWatcher::changesReady, this, &CliBuilder::onChangesReady);
+        m_watcher->setPaused(m_assembler->isBusy());
+        m_watcher->watch(options.mainFile, &m_model);
+        m_watcher->addFiles(m_assembler->dependencyFiles());
+        standardError() << "Surveillance de " << m_watcher->watchedFiles().size()
+                        << " fichiers (Ctrl+C pour arrêter)" << Qt::endl;
+        return -1;
+    }
+
+    // Aucune cible n'a pu démarrer (sélection vide, préambule illisible...), ou
+    // toutes étaient déjà à jour
+    if (!m_assembler->isBusy()) {
+        if (!m_failed && m_assembler->upToDateTargets() > 0) {
+            standardError() << "Toutes les cibles sont à jour" << Qt::endl;
+            return Success;
+        }
+        return BuildFailed;
+    }
+
+    return -1;
+}
+
+bool CliBuilder::applySelection(const QString& selection, const QString& mainFile)
+{
+    if (selection == "saved") {
+        LastFileHelper lastFileHelper;
+        QJsonObject savedState = lastFileHelper.loadCheckState();
+        if (savedState.isEmpty()) {
+            standardError() << "Aucune sélection enregistrée ; utilisez --select all ou une liste de nœuds" << Qt::endl;
+            return false;
+        }
+        m_model.restoreCheckState(savedState);
+        return true;
+    }
+
+    if (selection == "all") {
+        for (int i = 0; i < m_model.rowCount(QModelIndex()); ++i) {
+            m_model.setData(m_model.index(i, 0, QModelIndex()), Qt::Checked, Qt::CheckStateRole);
+        }
+        return true;
+    }
+
+    // Liste de chemins (absolus ou relatifs au fichier principal) ou de noms de nœuds
+    QString mainDir = QFileInfo(mainFile).absolutePath();
+    const QStringList tokens = selection.split(',', Qt::SkipEmptyParts);
+    for (const QString& rawToken : tokens) {
+        QString token = rawToken.trimmed();
+        QModelIndex index = findNode(token, mainDir, QModelIndex());
+        if (!index.isValid()) {
+            standardError() << "Nœud introuvable dans l'arborescence : " << token << Qt::endl;
+            return false;
+        }
+        m_model.setData(index, Qt::Checked, Qt::CheckStateRole);
+    }
+    return !tokens.isEmpty();
+}
+
+QModelIndex CliBuilder::findNode(const QString& token, const QString& mainDir, const QModelIndex& parent) const
+{
+    QString tokenPath = QFileInfo(QDir(mainDir), token).absoluteFilePath();
+    if (!tokenPath.endsWith(".tex")) {
+        tokenPath += ".tex";
+    }
+
+    for (int i = 0; i < m_model.rowCount(parent); ++i) {
+        QModelIndex index = m_model.index(i, 0, parent);
+        QString nodeName = m_model.data(index, Qt::DisplayRole).toString();
+        QString nodePath = m_model.data(index, Qt::ToolTipRole).toString();
+
+        // Les groupes PEDA/DOCS/EVALS partagent le chemin de leur parent : seul le nom compte
+        bool isGroup = (nodeName == "PEDA" || nodeName == "DOCS" || nodeName == "EVALS");
+        if (nodeName == token || (!isGroup && QFileInfo(nodePath).absoluteFilePath() == tokenPath)) {
+            return index;
+        }
+
+        if (m_model.hasChildren(index)) {
+            QModelIndex found = findNode(token, mainDir, index);
+            if (found.isValid()) {
+                return found;
+            }
+        }
+    }
+    return QModelIndex();
+}
+
+void CliBuilder::connectOutput()
+{
+    connect(m_assembler, &LatexAssembler::outputLines, this,
+            [](LatexAssembler::BuildTarget target, const QStringList& lines) {
+        QString prefix = targetPrefix(target);
+        for (const QString& line : lines) {
+            standardOutput() << prefix << line << '\n';
+        }
+        standardOutput().flush();
+    });
+    connect(m_assembler, &LatexAssembler::outputMessage, this,
+            [](LatexAssembler::BuildTarget target, const QString& message) {
+        standardOutput() << targetPrefix(target) << message << Qt::endl;
+    });
+
+    connect(m_assembler, &LatexAssembler::compilationError, this, [this](const QString& errorMessage) {
+        m_failed = true;
+        standardError() << "Erreur : " << errorMessage << Qt::endl;
+    });
+    connect(m_assembler, &LatexAssembler::compilationFinished, this, [this](bool success, const QString& pdfPath) {
+        if (success) {
+            standardError() << "PDF partiel : " << pdfPath << Qt::endl;
+        } else {
+            m_failed = true;
+        }
+    });
+    connect(m_assembler, &LatexAssembler::chapterCompilationFinished, this,
+            [this](const QString& chapterName, bool success, const QString& pdfPath) {
+        if (success) {
+            standardError() << "PDF du chapitre " << chapterName << " : " << pdfPath << Qt::endl;
+        } else {
+            m_failed = true;
+            standardError() << "Échec du chapitre " << chapterName << Qt::endl;
+        }
+    });
+    connect(m_assembler, &LatexAssembler::fullDocumentCompilationFinished, this,
+            [this](bool success, const QString& pdfPath) {
+        if (success) {
+            standardError() << "PDF du document complet : " << pdfPath << Qt::endl;
+        } else {
+            m_failed = true;
+        }
+    });
+
+    connect(m_assembler, &LatexAssembler::buildFinished, this, &CliBuilder::finish);
+}
+
+void CliBuilder::installSignalHandlers()
+{
+#ifdef Q_OS_UNIX
+    if (s_signalPipe[0] >= 0 || ::pipe(s_signalPipe) != 0) {
+        return;
+    }
+    m_signalNotifier = new QSocketNotifier(s_signalPipe[0], QSocketNotifier::Read, this);
+    connect(m_signalNotifier, &QSocketNotifier::activated, this, &CliBuilder::onSignalReceived);
+
+    struct sigaction action = {};
+    action.sa_handler = relaySignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+#endif
+}
+
+void CliBuilder::onSignalReceived()
+{
+#ifdef Q_OS_UNIX
+    char byte;
+    ssize_t received = ::read(s_signalPipe[0], &byte, 1);
+    Q_UNUSED(received);
+#endif
+
+    // Second signal : plus d'attente
+    if (m_interrupted) {
+        ProcessRunner::killAllProcessGroups();
+        QCoreApplication::exit(Interrupted);
+        return;
+    }
+
+    m_interrupted = true;
+    m_interruptClock.start();
+    standardError() << "Arrêt demandé : arrêt des compilations en cours..." << Qt::endl;
+    if (m_watcher) {
+        m_watcher->setPaused(true);
+    }
+    m_assembler->stopCompilation();
+    waitForProcessGroups();
+}
+
+void CliBuilder::waitForProcessGroups()
+{
+    // SIGTERM envoyé par stopCompilation, SIGKILL après le délai de grâce ; au-delà,
+    // les groupes restants sont tués ici
+    if (ProcessRunner::liveProcessGroupCount() > 0 && m_interruptClock.elapsed() < m_killGraceMs + 1000) {
+        QTimer::singleShot(100, this, &CliBuilder::waitForProcessGroups);
+        return;
+    }
+    ProcessRunner::killAllProcessGroups();
+    QCoreApplication::exit(Interrupted);
+}
+
+void CliBuilder::finish()
+{
+    // Arrêt par signal : le code de sortie est celui de l'interruption
+    if (m_interrupted) {
+        return;
+    }
+    QString summary = m_assembler->buildStats().summary();
+    if (!summary.isEmpty()) {
+        standardError() << summary << Qt::endl;
+    } else if (!m_failed && m_assembler->upToDateTargets() > 0) {
+        standardError() << "Toutes les cibles sont à jour" << Qt::endl;
+    }
+
+    // En mode surveillance, attendre la prochaine modification
+    if (m_watcher) {
+        standardError() << (m_failed ? "Compilation en échec" : "Compilation réussie")
+                        << " ; en attente de modifications..." << Qt::endl;
+        m_failed = false;
+        return;
+    }
+
+    QCoreApplication::exit(m_failed ? BuildFailed : Success);
+}
+
+void CliBuilder::onChangesReady(const QStringList& changedFiles)
+{
+    // Le fichier principal a changé : de nouveaux \input ont pu apparaître
+    if (changedFiles.contains(m_options.mainFile)) {
+        m_model.loadFromFile(m_options.mainFile);
+        if (!m_model.hasData() || !applySelection(m_options.selection, m_options.mainFile)) {
+            standardError() << "Arborescence illisible après modification ; en attente d'une correction" << Qt::endl;
+            return;
+        }
+        m_watcher->watch(m_options.mainFile, &m_model);
+        m_watcher->addFiles(m_assembler->dependencyFiles());
+    }
+
+    m_assembler->compileChangedTargets(&m_model, changedFiles,
+                                       m_options.targets.contains("partial"),
+                                       m_options.targets.contains("chapters"),
+                                       m_options.targets.contains("document"));
+    if (!m_assembler->isBusy()) {
+        standardError() << "Aucune cible concernée ; en attente de modifications..." << Qt::endl;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QElapsedTimer>
+#include "latexmodel.h"
+#include "latexassembler.h"
+#include "buildwatcher.h"
+
+// Compilation sans interface graphique, pilotée par la ligne de commande :
+//   CompilationSelective --build cours.tex --select saved|all|<chemins,noms>
+//                        --targets partial,chapters,document --jobs N [--watch]
+// Réutilise LatexParser, LatexModel et LatexAssembler sans créer de widget.
+// Avec --watch, le processus reste actif et recompile les cibles concernées
+// à chaque modification des sources (arrêt par Ctrl+C).
+class CliBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Codes de sortie du mode ligne de commande
+    enum ExitCode {
+        Success = 0,        // Toutes les cibles demandées ont produit leur PDF
+        BuildFailed = 1,    // Au moins une cible a échoué
+        UsageError = 2,     // Options invalides
+        LoadError = 3,      // Fichier principal illisible ou sélection introuvable
+        Interrupted = 130   // Arrêté par SIGINT (Ctrl+C) ou SIGTERM
+    };
+
+    explicit CliBuilder(QObject* parent = nullptr);
+
+    // Vrai si la ligne de commande demande une compilation sans interface
+    static bool isRequested(int argc, char* argv[]);
+
+    // Analyse les options, compile et retourne le code de sortie du processus
+    static int run(QCoreApplication& app);
+
+private:
+    struct Options {
+        QString mainFile;
+        QString selection = "saved";
+        QStringList targets = { "partial" };
+        int jobs = 0;   // 0 : --jobs absent
+        bool watch = false;
+        bool includeOnly = false;
+        bool splitChapters = false;
+        bool sharded = false;
+        int chapterShards = 0;             // Fichiers par tronçon de chapitre (0 : chapitres entiers)
+        int warmWorkers = 0;
+        bool tikzCache = false;
+        bool force = false;
+        bool preflight = true;
+        bool findCulprit = false;
+        QString buildRoot;                 // "temp", "ram" ou répertoire (vide : config.json)
+        bool saveBuildRoot = false;        // Racine enregistrée pour le projet
+        QString engine;
+        QMap<QString, QString> profiles;   // Profil imposé par cible ("partiel", "chapitre", "document")
+    };
+
+    Options m_options;
+    LatexModel m_model;
+    LatexAssembler* m_assembler;
+    BuildWatcher* m_watcher = nullptr;
+    bool m_failed = false;
+
+    // SIGINT/SIGTERM : relayés par un tube vers la boucle d'événements, puis
+    // compilations arrêtées et groupes de processus attendus avant de quitter
+    QSocketNotifier* m_signalNotifier = nullptr;
+    bool m_interrupted = false;
+    QElapsedTimer m_interruptClock;
+    int m_killGraceMs = 0;
+    void installSignalHandlers();
+    void onSignalReceived();
+    void waitForProcessGroups();
+
+    // Démarre les cibles ; retourne un code de sortie si rien n'a pu être lancé
+    int start(const Options& options);
+
+    bool applySelection(const QString& selection, const QString& mainFile);
+    QModelIndex findNode(const QString& token, const QString& mainDir, const QModelIndex& parent) const;
+
+    void connectOutput();
+    void finish();
+
+    // Mode surveillance : recharge l'arborescence si besoin et recompile
+    void onChangesReady(const QStringList& changedFiles);
+};
@@ -0,0 +1,204 @@
+#include "compilejob.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include "tracer.h"
+
+CompileJob::CompileJob(const CompileJobSpec& spec, QObject* parent)
+    : QObject(parent), m_spec(spec), m_runner(new ProcessRunner(this)),
+      m_tools(spec.texFile, spec.id, spec.sourceDir, spec.indexTool)
+{
+    m_runner->setEnvironment(m_spec.environment);
+    connect(m_runner, &ProcessRunner::outputLines, this, &CompileJob::outputLines);
+    connect(m_runner, &ProcessRunner::processResultReady, this, [this](const ProcessResult& result) {
+        Tracer& tracer = Tracer::instance();
+        if (tracer.isEnabled()) {
+            QJsonObject args;
+            args["code"] = result.exitCode;
+            args["cpuMs"] = result.usage.userCpuMs + result.usage.systemCpuMs;
+            args["peakRssKb"] = result.usage.peakRssKb;
+            args["timedOut"] = result.timedOut;
+            args["brouillon"] = m_draftPass;
+            tracer.complete("lualatex", QString("passe %1").arg(m_pass), m_spec.id,
+                            m_passStartUs, tracer.now() - m_passStartUs, args);
+        }
+        emit passFinished(m_pass, result);
+    });
+    connect(m_runner, &ProcessRunner::processFinished, this, &CompileJob::onProcessFinished,
+            Qt::QueuedConnection);
+}
+
+bool CompileJob::start()
+{
+    m_pass = 0;
+    m_stopped = false;
+    m_running = true;
+    m_toolPassUsed = false;
+
+    // .bbl, .ind, .gls de la compilation précédente de cette cible : sans
+    // changement de leur entrée, aucun outil ni aucune relance
+    m_tools.restoreOutputs();
+
+    // Une passe brouillon n'a de sens que si une passe finale peut suivre
+    if (!runPass(!m_spec.draftArguments.isEmpty() && m_spec.maxPasses > 1)) {
+        m_running = false;
+        return false;
+    }
+    return true;
+}
+
+void CompileJob::stop()
+{
+    m_stopped = true;
+    m_runner->stopProcess();
+    for (ProcessRunner* runner : m_toolRunners) {
+        runner->stopProcess();
+    }
+}
+
+QString CompileJob::pdfPath() const
+{
+    QFileInfo texInfo(m_spec.texFile);
+    return texInfo.absolutePath() + "/" + texInfo.completeBaseName() + ".pdf";
+}
+
+bool CompileJob::runPass(bool draft)
+{
+    m_pass++;
+    m_draftPass = draft;
+    m_passStartUs = Tracer::instance().now();
+    emit passStarted(m_pass);
+
+    QStringList args = m_spec.arguments;
+    if (draft) {
+        args << m_spec.draftArguments;
+    }
+    args << m_spec.texFile;
+
+    return m_runner->runCommand(m_spec.program, args, QFileInfo(m_spec.texFile).absolutePath());
+}
+
+void CompileJob::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    Q_UNUSED(exitStatus);
+
+    if (!m_running) return;
+
+    // Arrêt demandé ou erreur LaTeX : fin de la compilation
+    if (m_stopped || exitCode != 0) {
+        qDebug() << "Compilation" << m_spec.id << "terminée en erreur (code" << exitCode << ")";
+        m_running = false;
+        emit finished(false);
+        return;
+    }
+
+    // Relancer tant que LaTeX le demande, dans la limite des passes autorisées
+    bool needsRerun = m_runner->needsRerun(m_runner->fullOutput());
+    qDebug() << "Compilation" << m_spec.id << ": besoin de recompiler =" << needsRerun
+             << "(passe" << m_pass << "sur" << m_spec.maxPasses << ")";
+    Tracer::instance().instant("relance", needsRerun ? "relance demandée" : "pas de relance", m_spec.id,
+                               QJsonObject{ { "passe", m_pass }, { "maxPasses", m_spec.maxPasses } });
+
+    // Bibliographie, index, glossaire dont l'entrée a changé : outils d'abord
+    QVector<AuxiliaryTools::Step> steps = m_tools.pendingSteps();
+    if (!steps.isEmpty()) {
+        m_rerunRequested = needsRerun;
+        runTools(steps);
+        return;
+    }
+
+    continueAfterPass(needsRerun);
+}
+
+void CompileJob::runTools(const QVector<AuxiliaryTools::Step>& steps)
+{
+    m_toolsRan = false;
+    for (const AuxiliaryTools::Step& step : steps) {
+        ProcessRunner* runner = new ProcessRunner(this);
+        runner->setEnvironment(m_spec.environment);
+        runner->setLimits(m_runner->limits());
+        connect(runner, &ProcessRunner::outputLines, this, &CompileJob::outputLines);
+
+        qint64 startUs = Tracer::instance().now();
+        connect(runner, &ProcessRunner::processResultReady, this, [this, step, startUs](const ProcessResult& result) {
+            Tracer& tracer = Tracer::instance();
+            tracer.complete("outil", step.tool + " (" + step.name + ")", m_spec.id, startUs, tracer.now() - startUs,
+                            QJsonObject{ { "passe", m_pass }, { "code", result.exitCode } });
+            emit toolFinished(step.tool, m_pass, result);
+        });
+        connect(runner, &ProcessRunner::processFinished, this,
+                [this, runner, step](int exitCode, QProcess::ExitStatus exitStatus) {
+            onToolFinished(runner, step, exitStatus == QProcess::NormalExit && exitCode == 0);
+        }, Qt::QueuedConnection);
+
+        qDebug() << "Compilation" << m_spec.id << ":" << step.tool << step.arguments;
+        emit outputLines({ QString("=== %1 : %2 ===").arg(step.tool, step.name) });
+        if (!runner->runCommand(step.program, step.arguments, m_tools.workingDir())) {
+            emit outputLines({ QString("Lancement impossible de %1 : %2 non mis à jour").arg(step.program, step.name) });
+            runner->deleteLater();
+            continue;
+        }
+        m_toolRunners.append(runner);
+    }
+
+    if (m_toolRunners.isEmpty()) {
+        continueAfterPass(m_rerunRequested);
+    }
+}
+
+void CompileJob::onToolFinished(ProcessRunner* runner, const AuxiliaryTools::Step& step, bool success)
+{
+    m_toolRunners.removeOne(runner);
+    runner->deleteLater();
+
+    // Un outil en échec n'empêche pas la passe suivante (références manquantes)
+    if (success) {
+        m_tools.markDone(step);
+        m_toolsRan = true;
+    } else if (!m_stopped) {
+        emit outputLines({ QString("%1 en échec : %2 non mis à jour").arg(step.tool, step.name) });
+    }
+
+    if (!m_toolRunners.isEmpty() || !m_running) {
+        return;
+    }
+
+    if (m_stopped) {
+        m_running = false;
+        emit finished(false);
+        return;
+    }
+
+    // Nouveau résultat d'un outil après la dernière passe autorisée : une passe
+    // de plus (une seule), sans quoi le PDF publié n'aurait ni bibliographie ni index
+    if (m_toolsRan && m_pass >= m_spec.maxPasses && !m_draftPass && !m_toolPassUsed) {
+        m_toolPassUsed = true;
+        emit outputLines({ "=== Passe supplémentaire pour le résultat des outils ===" });
+        if (!runPass(false)) {
+            m_running = false;
+            emit finished(false);
+        }
+        return;
+    }
+
+    // Nouveau résultat d'un outil : une passe de plus pour le lire
+    continueAfterPass(m_rerunRequested || m_toolsRan);
+}
+
+void CompileJob::continueAfterPass(bool needsRerun)
+{
+    // Relance (encore en brouillon si une passe finale reste possible), ou passe
+    // finale après un brouillon dont les références sont stables
+    bool nextPass = (needsRerun && m_pass < m_spec.maxPasses) || m_draftPass;
+    if (nextPass) {
+        bool draft = m_draftPass && needsRerun && m_pass + 1 < m_spec.maxPasses;
+        if (!runPass(draft)) {
+            m_running = false;
+            emit finished(false);
+        }
+        return;
+    }
+
+    m_running = false;
+    emit finished(QFile::exists(pdfPath()));
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QVector>
+#include "processrunner.h"
+#include "auxiliarytools.h"
+
+// Description d'une compilation : un fichier pilote et la commande du moteur
+struct CompileJobSpec {
+    QString id;              // Identifiant unique dans un JobPool (nom du chapitre...)
+    QString texFile;         // Fichier pilote à compiler
+    QString program = "lualatex";
+    QStringList arguments;   // Arguments du moteur, sans le fichier pilote
+    int maxPasses = 5;       // Nombre maximal de passes (relances comprises)
+    QStringList draftArguments;          // Passes intermédiaires sans PDF (vide : désactivé)
+    QMap<QString, QString> environment;  // Variables ajoutées à l'environnement
+    QString sourceDir;       // Répertoire du fichier principal (.bib relatifs)
+    QString indexTool = "makeindex";     // Index .idx : "makeindex" ou "xindy"
+};
+
+// Compile un fichier pilote : lance les passes successives tant que le
+// journal demande une relance, puis signale la fin avec le chemin du PDF.
+// En mode brouillon, les passes intermédiaires n'écrivent pas de PDF et une
+// dernière passe normale est lancée dès que les références sont stables.
+// Entre deux passes, biber, makeindex ou xindy sont lancés en parallèle si
+// leur entrée (.bcf, .idx, .glo) a changé, ce qui demande alors une relance.
+class CompileJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CompileJob(const CompileJobSpec& spec, QObject* parent = nullptr);
+
+    const CompileJobSpec& spec() const { return m_spec; }
+    void setLimits(const ProcessLimits& limits) { m_runner->setLimits(limits); }
+
+    // Lance la première passe ; retourne false si le moteur n'a pas démarré
+    bool start();
+
+    // Arrête la passe en cours (et tout son groupe de processus)
+    void stop();
+
+    bool isRunning() const { return m_running; }
+    int pass() const { return m_pass; }
+
+    // Code de sortie de la dernière passe
+    int exitCode() const { return m_runner->exitCode(); }
+
+    // PDF produit à côté du fichier pilote
+    QString pdfPath() const;
+
+signals:
+    void outputLines(const QStringList& lines);
+    void passStarted(int pass);
+    void passFinished(int pass, const ProcessResult& result);
+    void toolFinished(const QString& tool, int pass, const ProcessResult& result);
+    void finished(bool success);
+
+private slots:
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    CompileJobSpec m_spec;
+    ProcessRunner* m_runner;
+    int m_pass = 0;
+    qint64 m_passStartUs = 0;   // Début de la passe en cours (trace)
+    bool m_running = false;
+    bool m_stopped = false;
+    bool m_draftPass = false;   // La passe en cours est une passe brouillon
+
+    // Outils de la passe en cours et relance déjà demandée par le moteur
+    AuxiliaryTools m_tools;
+    QVector<ProcessRunner*> m_toolRunners;
+    bool m_rerunRequested = false;
+    bool m_toolsRan = false;
+    bool m_toolPassUsed = false;   // Passe au-delà de maxPasses déjà accordée aux outils
+
+    bool runPass(bool draft);
+    void runTools(const QVector<AuxiliaryTools::Step>& steps);
+    void onToolFinished(ProcessRunner* runner, const AuxiliaryTools::Step& step, bool success);
+    void continueAfterPass(bool needsRerun);
+};
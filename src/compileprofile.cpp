@@ -0,0 +1,103 @@
+#include "compileprofile.h"
+#include <QJsonArray>
+
+QStringList CompileProfile::arguments() const
+{
+    QStringList args;
+    if (synctex) {
+        args << "-synctex=1";
+    }
+    args << (shellEscape ? "-shell-escape" : "-no-shell-escape");
+    args << "-interaction=nonstopmode"
+         << "-file-line-error";
+
+    // Lignes de journal non coupées : LuaTeX l'accepte directement, les autres via texmf.cnf
+    if (engine.endsWith("lualatex")) {
+        args << "-max-print-line=10000";
+    } else {
+        args << "-cnf-line=max_print_line=10000";
+    }
+
+    args << extraArguments;
+    return args;
+}
+
+QStringList CompileProfile::draftArguments() const
+{
+    if (!draftMode) {
+        return QStringList();
+    }
+    // XeTeX n'a pas de -draftmode : -no-pdf s'arrête au .xdv
+    return QStringList() << (engine.endsWith("xelatex") ? "-no-pdf" : "-draftmode");
+}
+
+QJsonObject CompileProfile::toJson() const
+{
+    QJsonObject object;
+    object["name"] = name;
+    object["engine"] = engine;
+    object["synctex"] = synctex;
+    object["shellEscape"] = shellEscape;
+    object["draftMode"] = draftMode;
+    object["maxPasses"] = maxPasses;
+    object["extraArguments"] = QJsonArray::fromStringList(extraArguments);
+    object["indexTool"] = indexTool;
+
+    QJsonObject env;
+    for (auto it = environment.constBegin(); it != environment.constEnd(); ++it) {
+        env[it.key()] = it.value();
+    }
+    object["environment"] = env;
+    return object;
+}
+
+CompileProfile CompileProfile::fromJson(const QJsonObject& object)
+{
+    // Les champs absents gardent les valeurs du profil complet
+    CompileProfile profile;
+    profile.name = object.value("name").toString(profile.name);
+    profile.engine = object.value("engine").toString(profile.engine);
+    profile.synctex = object.value("synctex").toBool(profile.synctex);
+    profile.shellEscape = object.value("shellEscape").toBool(profile.shellEscape);
+    profile.draftMode = object.value("draftMode").toBool(profile.draftMode);
+    profile.maxPasses = qMax(1, object.value("maxPasses").toInt(profile.maxPasses));
+    profile.indexTool = object.value("indexTool").toString(profile.indexTool);
+
+    const QJsonArray extra = object.value("extraArguments").toArray();
+    for (const QJsonValue& value : extra) {
+        profile.extraArguments << value.toString();
+    }
+
+    const QJsonObject env = object.value("environment").toObject();
+    for (auto it = env.constBegin(); it != env.constEnd(); ++it) {
+        profile.environment.insert(it.key(), it.value().toString());
+    }
+    return profile;
+}
+
+CompileProfile CompileProfile::full()
+{
+    return CompileProfile();
+}
+
+CompileProfile CompileProfile::fastPreview()
+{
+    CompileProfile profile;
+    profile.name = "apercu";
+    profile.synctex = false;
+    profile.maxPasses = 1;
+    return profile;
+}
+
+QVector<CompileProfile> CompileProfile::builtins()
+{
+    QVector<CompileProfile> profiles = { full(), fastPreview() };
+
+    for (const QString& engine : { QString("pdflatex"), QString("xelatex"), QString("lualatex") }) {
+        CompileProfile profile;
+        profile.name = engine;
+        profile.engine = engine;
+        profiles << profile;
+    }
+    return profiles;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QVector>
+#include <QJsonObject>
+
+// Profil de compilation : moteur, options et environnement d'une cible.
+// Les profils intégrés peuvent être complétés ou remplacés (même nom) par
+// ceux de config.json, clé "compileProfiles".
+struct CompileProfile {
+    QString name = "complet";
+    QString engine = "lualatex";
+    bool synctex = true;
+    bool shellEscape = true;
+    bool draftMode = false;         // Passes intermédiaires sans PDF (-draftmode / -no-pdf)
+    int maxPasses = 5;
+    QStringList extraArguments;     // Ajoutés avant le fichier pilote
+    QString indexTool = "makeindex";    // Index (.idx) : "makeindex" ou "xindy"
+    QMap<QString, QString> environment;
+
+    // Arguments du moteur (sans le fichier pilote)
+    QStringList arguments() const;
+
+    // Arguments ajoutés aux passes intermédiaires en mode brouillon
+    QStringList draftArguments() const;
+
+    QJsonObject toJson() const;
+    static CompileProfile fromJson(const QJsonObject& object);
+
+    // Profil complet : SyncTeX, -shell-escape, jusqu'à 5 passes
+    static CompileProfile full();
+
+    // Aperçu rapide : une seule passe, sans SyncTeX
+    static CompileProfile fastPreview();
+
+    // Profils intégrés : complet, apercu, et un profil par moteur pour les comparer
+    static QVector<CompileProfile> builtins();
+};
@@ -0,0 +1,200 @@
+#include "culpritfinder.h"
+#include <QDir>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include "driverwriter.h"
+
+CulpritFinder::CulpritFinder(QObject* parent)
+    : QObject(parent), m_pool(new JobPool(this))
+{
+    m_pool->setMaxParallelJobs(QThread::idealThreadCount());
+    connect(m_pool, &JobPool::jobFinished, this,
+            [this](const QString& id, bool success, int exitCode, const QString&) {
+        onJobFinished(id, success, exitCode);
+    });
+}
+
+bool CulpritFinder::start(const QString& workDir, const QString& mainFilePath, const QString& preamble,
+                          const QVector<QPair<QString, QString>>& files, const SpecFactory& specFor)
+{
+    stop();
+    if (files.isEmpty() || !QDir().mkpath(workDir)) {
+        return false;
+    }
+
+    ++m_generation;
+    m_running = true;
+    m_workDir = workDir;
+    m_mainFilePath = mainFilePath;
+    m_preamble = preamble;
+    m_files = files;
+    m_specFor = specFor;
+    m_trialCount = 0;
+    m_passingPrefix = 0;
+    m_failingPrefix = 0;
+    m_clock.start();
+
+    emit progress(QString("=== Recherche du fichier en cause parmi %1 fichier(s), %2 compilation(s) simultanée(s) ===")
+                  .arg(files.size()).arg(m_pool->maxParallelJobs()));
+    startSingleFiles();
+    return true;
+}
+
+void CulpritFinder::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    ++m_generation;
+    m_trials.clear();
+    m_pool->stop();
+}
+
+void CulpritFinder::startSingleFiles()
+{
+    m_phase = Phase::SingleFiles;
+    m_results.clear();
+    emit progress("Chaque fichier compilé seul avec le préambule...");
+    for (int i = 0; i < m_files.size(); ++i) {
+        startTrial(QString("fichier_%1").arg(i + 1), i, { m_files.at(i) });
+    }
+}
+
+void CulpritFinder::startPrefixRound()
+{
+    m_results.clear();
+
+    // La liste complète est essayée au premier tour : l'échec doit se reproduire
+    int high = m_failingPrefix > 0 ? m_failingPrefix : m_files.size();
+    QList<int> cuts;
+    if (m_failingPrefix == 0) {
+        cuts.append(high);
+    }
+
+    // Coupes réparties entre le plus long début qui compile et le plus court en échec
+    int slots = qMax(1, m_pool->maxParallelJobs() - int(cuts.size()));
+    int span = high - m_passingPrefix;
+    for (int j = 1; j <= slots; ++j) {
+        int cut = m_passingPrefix + (span * j) / (slots + 1);
+        if (cut > m_passingPrefix && cut < high && !cuts.contains(cut)) {
+            cuts.append(cut);
+        }
+    }
+    std::sort(cuts.begin(), cuts.end());
+
+    QStringList lengths;
+    for (int cut : cuts) {
+        lengths.append(QString::number(cut));
+    }
+    emit progress("Débuts de liste essayés (nombre de fichiers) : " + lengths.join(", "));
+    for (int cut : cuts) {
+        startTrial(QString("debut_%1").arg(cut), cut, m_files.mid(0, cut));
+    }
+}
+
+void CulpritFinder::startTrial(const QString& name, int key, const QVector<QPair<QString, QString>>& files)
+{
+    // Les sources ont déjà passé les vérifications préalables de la cible : seule
+    // l'erreur du moteur est cherchée ici
+    DriverRequest request;
+    request.id = QString("coupable_%1_%2").arg(m_generation).arg(name);
+    request.label = "de l'essai " + name;
+    request.path = m_workDir + "/" + request.id + ".tex";
+    request.preamble = m_preamble;
+    request.mainFilePath = m_mainFilePath;
+    request.files = files;
+    request.preflight = false;
+
+    m_trials.insert(request.id, key);
+    ++m_trialCount;
+
+    // Pilote écrit en arrière-plan, compilé dès qu'il est prêt
+    int generation = m_generation;
+    QString id = request.id;
+    QtConcurrent::run(&DriverWriter::write, request).then(this, [this, generation, id](const DriverResult& result) {
+        if (generation != m_generation) {
+            return;
+        }
+        if (result.path.isEmpty()) {
+            stop();
+            emit finished(QStringList(), result.error);
+            return;
+        }
+        m_pool->enqueue(m_specFor(id, result.path));
+    });
+}
+
+void CulpritFinder::onJobFinished(const QString& id, bool success, int exitCode)
+{
+    if (!m_running || !m_trials.contains(id)) {
+        return;
+    }
+
+    bool passed = success && exitCode == 0;
+    int key = m_trials.take(id);
+    m_results.insert(key, passed);
+    if (!passed && m_phase == Phase::SingleFiles) {
+        emit progress("  échec seul : " + m_files.at(key).second);
+    }
+
+    if (m_trials.isEmpty()) {
+        finishRound();
+    }
+}
+
+void CulpritFinder::finishRound()
+{
+    if (m_phase == Phase::SingleFiles) {
+        QStringList culprits;
+        for (auto it = m_results.constBegin(); it != m_results.constEnd(); ++it) {
+            if (!it.value()) {
+                culprits.append(m_files.at(it.key()).second);
+            }
+        }
+        if (!culprits.isEmpty()) {
+            finish(culprits, QString("%1 fichier(s) en échec, compilé(s) seul(s)").arg(culprits.size()));
+            return;
+        }
+
+        // Chaque fichier compile seul : l'erreur vient d'un enchaînement
+        emit progress("Chaque fichier compile seul : recherche du plus court début de liste en échec...");
+        m_phase = Phase::Prefixes;
+        m_passingPrefix = 1;
+        startPrefixRound();
+        return;
+    }
+
+    for (auto it = m_results.constBegin(); it != m_results.constEnd(); ++it) {
+        if (!it.value() && (m_failingPrefix == 0 || it.key() < m_failingPrefix)) {
+            m_failingPrefix = it.key();
+        }
+    }
+    if (m_failingPrefix == 0) {
+        finish(QStringList(), "La liste complète compile sans erreur : échec non reproduit");
+        return;
+    }
+    for (auto it = m_results.constBegin(); it != m_results.constEnd(); ++it) {
+        if (it.value() && it.key() < m_failingPrefix) {
+            m_passingPrefix = qMax(m_passingPrefix, it.key());
+        }
+    }
+
+    if (m_failingPrefix - m_passingPrefix <= 1) {
+        finish({ m_files.at(m_failingPrefix - 1).second },
+               QString("Premier fichier en échec : compile seul, échoue après les %1 fichier(s) qui le précèdent")
+               .arg(m_failingPrefix - 1));
+        return;
+    }
+    startPrefixRound();
+}
+
+void CulpritFinder::finish(const QStringList& culprits, const QString& summary)
+{
+    m_running = false;
+    m_trials.clear();
+    emit progress(QString("%1 compilation(s) d'essai en %2 s").arg(m_trialCount)
+                  .arg(m_clock.elapsed() / 1000.0, 0, 'f', 1));
+    emit finished(culprits, summary);
+}
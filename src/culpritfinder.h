@@ -0,0 +1,85 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include <QMap>
+#include <QElapsedTimer>
+#include <functional>
+#include "jobpool.h"
+
+// Recherche du fichier qui fait échouer une cible. Chaque fichier de la cible
+// est d'abord compilé seul avec le préambule commun, toutes les compilations en
+// parallèle. Si aucun n'échoue seul (erreur due à ce qui le précède), le plus
+// court début de liste en échec est cherché par découpage : à chaque tour,
+// autant de débuts de liste que de compilations simultanées sont essayés, et
+// l'intervalle se resserre jusqu'au premier fichier fautif.
+class CulpritFinder : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Compilation d'un pilote d'essai (moteur, options et environnement)
+    using SpecFactory = std::function<CompileJobSpec(const QString& id, const QString& texFile)>;
+
+    explicit CulpritFinder(QObject* parent = nullptr);
+
+    // Compilations d'essai simultanées (une par cœur par défaut)
+    void setMaxParallelJobs(int count) { m_pool->setMaxParallelJobs(count); }
+    int maxParallelJobs() const { return m_pool->maxParallelJobs(); }
+
+    void setLimits(const ProcessLimits& limits) { m_pool->setLimits(limits); }
+
+    // Lance la recherche parmi les fichiers (nom, chemin) d'une cible, pilotes
+    // d'essai écrits dans workDir ; faux si rien n'est lancé
+    bool start(const QString& workDir, const QString& mainFilePath, const QString& preamble,
+               const QVector<QPair<QString, QString>>& files, const SpecFactory& specFor);
+
+    // Abandonne la recherche en cours (finished n'est pas émis)
+    void stop();
+
+    bool isRunning() const { return m_running; }
+
+signals:
+    void progress(const QString& message);
+
+    // Fichiers en cause (vide : échec non reproduit) et bilan lisible
+    void finished(const QStringList& culprits, const QString& summary);
+
+private:
+    enum class Phase {
+        SingleFiles,    // Chaque fichier seul
+        Prefixes        // Débuts de liste
+    };
+
+    JobPool* m_pool;
+    bool m_running = false;
+    int m_generation = 0;       // Identifiants et résultats des recherches abandonnées écartés
+    Phase m_phase = Phase::SingleFiles;
+    QString m_workDir;
+    QString m_mainFilePath;
+    QString m_preamble;
+    QVector<QPair<QString, QString>> m_files;
+    SpecFactory m_specFor;
+    QElapsedTimer m_clock;
+    int m_trialCount = 0;
+
+    // Essais du tour en cours (identifiant -> indice du fichier ou longueur du
+    // début de liste) et résultats du tour
+    QHash<QString, int> m_trials;
+    QMap<int, bool> m_results;
+
+    // Découpage : plus long début de liste qui compile, plus court en échec
+    // (0 : liste complète encore à essayer)
+    int m_passingPrefix = 0;
+    int m_failingPrefix = 0;
+
+    void startSingleFiles();
+    void startPrefixRound();
+    void startTrial(const QString& name, int key, const QVector<QPair<QString, QString>>& files);
+    void onJobFinished(const QString& id, bool success, int exitCode);
+    void finishRound();
+    void finish(const QStringList& culprits, const QString& summary);
+};
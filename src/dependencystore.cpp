@@ -0,0 +1,236 @@
+#include "dependencystore.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QDebug>
+
+namespace {
+
+// Taille et date : suffisant pour repérer une modification, sans relire le fichier
+QJsonObject signatureOf(const FileStatCache::Entry& info)
+{
+    if (!info.exists) {
+        return QJsonObject();
+    }
+    return QJsonObject{
+        { "size", double(info.size) },
+        { "modified", info.modified.toMSecsSinceEpoch() / 1000.0 }
+    };
+}
+
+QJsonObject signatureOf(const QString& filePath, FileStatCache* stats = nullptr)
+{
+    return signatureOf(stats ? stats->stat(filePath) : FileStatCache::read(filePath));
+}
+
+// Signature qui ne correspond à aucun fichier : la cible sera recompilée
+const QJsonObject s_staleSignature{ { "size", -1 } };
+
+} // namespace
+
+DependencyStore::DependencyStore(const QString& mainFilePath)
+    : m_mainFilePath(mainFilePath)
+{
+}
+
+void DependencyStore::setMainFilePath(const QString& mainFilePath)
+{
+    if (mainFilePath != m_mainFilePath) {
+        m_mainFilePath = mainFilePath;
+        m_targets = QJsonObject();
+        m_loaded = false;
+    }
+}
+
+QString DependencyStore::storePath() const
+{
+    QByteArray key = QFileInfo(m_mainFilePath).absoluteFilePath().toUtf8();
+    QString hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/dependances/" + hash + ".json";
+}
+
+QStringList DependencyStore::readRecorder(const QString& flsPath)
+{
+    QStringList files;
+    QFile file(flsPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Journal -recorder absent:" << flsPath;
+        return files;
+    }
+
+    // Le répertoire de compilation (pilote, .aux...) et les caches de l'application
+    // (polices, figures identifiées par leur contenu) ne sont pas des dépendances
+    QString jobDir = QFileInfo(flsPath).absolutePath();
+    QString appCache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir workingDir(jobDir);
+
+    QSet<QString> seen;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        if (line.startsWith("PWD ")) {
+            workingDir = QDir(line.mid(4));
+            continue;
+        }
+        if (!line.startsWith("INPUT ")) {
+            continue;
+        }
+
+        QString path = QDir::cleanPath(workingDir.absoluteFilePath(line.mid(6)));
+        if (seen.contains(path)) {
+            continue;
+        }
+        seen.insert(path);
+
+        if (path.startsWith(jobDir + "/") || path.startsWith(appCache + "/") || path.contains("/texmf")) {
+            continue;
+        }
+        if (QFileInfo(path).isFile()) {
+            files.append(path);
+        }
+    }
+    return files;
+}
+
+QByteArray DependencyStore::driverHash(const QString& driverPath)
+{
+    QFile file(driverPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&file);
+    return hash.result().toHex();
+}
+
+void DependencyStore::load()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    QFile file(storePath());
+    if (file.open(QIODevice::ReadOnly)) {
+        m_targets = QJsonDocument::fromJson(file.readAll()).object().value("targets").toObject();
+    }
+}
+
+void DependencyStore::save() const
+{
+    QString path = storePath();
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        qWarning() << "Impossible de créer le répertoire des dépendances" << path;
+        return;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Impossible d'écrire les dépendances" << path;
+        return;
+    }
+    QJsonObject root;
+    root["mainFile"] = QFileInfo(m_mainFilePath).absoluteFilePath();
+    root["targets"] = m_targets;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+void DependencyStore::record(const QString& target, const QByteArray& driverHash, const QStringList& files,
+                             const QString& pdfPath, const FileStatCache& stats, const QDateTime& startedAt)
+{
+    load();
+
+    QJsonObject signatures;
+    for (const QString& filePath : files) {
+        QString absolutePath = QFileInfo(filePath).absoluteFilePath();
+        QJsonObject signature;
+        if (stats.contains(absolutePath)) {
+            signature = signatureOf(stats.cached(absolutePath));
+        } else {
+            FileStatCache::Entry info = FileStatCache::read(absolutePath);
+            signature = info.exists && info.modified >= startedAt ? s_staleSignature : signatureOf(info);
+        }
+        if (!signature.isEmpty()) {
+            signatures.insert(absolutePath, signature);
+        }
+    }
+
+    QJsonObject entry;
+    entry["driver"] = QString::fromLatin1(driverHash);
+    entry["pdf"] = pdfPath;
+    entry["files"] = signatures;
+    m_targets.insert(target, entry);
+    save();
+}
+
+bool DependencyStore::isUpToDate(const QString& target, const QByteArray& driverHash, QString* pdfPath,
+                                 FileStatCache* stats)
+{
+    load();
+
+    QJsonObject entry = m_targets.value(target).toObject();
+    if (entry.isEmpty() || driverHash.isEmpty() || entry.value("driver").toString().toLatin1() != driverHash) {
+        return false;
+    }
+
+    QString publishedPdf = entry.value("pdf").toString();
+    if (publishedPdf.isEmpty() || !QFile::exists(publishedPdf)) {
+        return false;
+    }
+
+    const QJsonObject files = entry.value("files").toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        if (signatureOf(it.key(), stats) != it.value().toObject()) {
+            return false;
+        }
+    }
+
+    if (pdfPath) {
+        *pdfPath = publishedPdf;
+    }
+    return true;
+}
+
+QStringList DependencyStore::filesOf(const QString& target)
+{
+    load();
+    return m_targets.value(target).toObject().value("files").toObject().keys();
+}
+
+QSet<QString> DependencyStore::targetsUsing(const QSet<QString>& files)
+{
+    load();
+
+    QSet<QString> targets;
+    for (auto it = m_targets.constBegin(); it != m_targets.constEnd(); ++it) {
+        const QJsonObject dependencies = it.value().toObject().value("files").toObject();
+        for (const QString& filePath : files) {
+            if (dependencies.contains(filePath)) {
+                targets.insert(it.key());
+                break;
+            }
+        }
+    }
+    return targets;
+}
+
+QStringList DependencyStore::allFiles()
+{
+    load();
+
+    QSet<QString> files;
+    for (auto it = m_targets.constBegin(); it != m_targets.constEnd(); ++it) {
+        const QStringList keys = it.value().toObject().value("files").toObject().keys();
+        for (const QString& filePath : keys) {
+            files.insert(filePath);
+        }
+    }
+    return QStringList(files.begin(), files.end());
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QDateTime>
+#include "filestatcache.h"
+
+// Dépendances réelles de chaque cible, persistées entre les sessions : sources
+// assemblées dans le pilote et fichiers lus par le moteur d'après le journal
+// -recorder (.fls) : images, .bib, modules Lua, données... Une cible est à jour
+// si son pilote est identique et qu'aucun de ces fichiers n'a changé depuis sa
+// dernière compilation réussie.
+// Cibles : "partiel", "document" et "chapitre/<nom>".
+class DependencyStore
+{
+public:
+    explicit DependencyStore(const QString& mainFilePath = QString());
+
+    void setMainFilePath(const QString& mainFilePath);
+
+    // Fichier JSON des dépendances du fichier principal courant
+    QString storePath() const;
+
+    // Fichiers lus par une compilation (lignes INPUT du .fls), hors répertoire de
+    // compilation et arborescences TeX (texmf*)
+    static QStringList readRecorder(const QString& flsPath);
+
+    // Empreinte du contenu d'un fichier pilote
+    static QByteArray driverHash(const QString& driverPath);
+
+    // Enregistre les dépendances d'une compilation réussie et le PDF publié.
+    // Les signatures viennent de stats, l'instantané pris avant le lancement :
+    // un fichier modifié pendant la compilation reste vu comme modifié. Un
+    // fichier absent de l'instantané (nouvelle dépendance) et modifié depuis
+    // startedAt est enregistré comme périmé
+    void record(const QString& target, const QByteArray& driverHash, const QStringList& files,
+                const QString& pdfPath, const FileStatCache& stats, const QDateTime& startedAt);
+
+    // Dépendances enregistrées d'une cible
+    QStringList filesOf(const QString& target);
+
+    // Vrai si la cible a été compilée avec ce pilote, qu'aucune dépendance n'a
+    // changé depuis et que son PDF publié existe encore (retourné dans pdfPath) ;
+    // les fichiers sont lus dans l'instantané stats s'il est fourni
+    bool isUpToDate(const QString& target, const QByteArray& driverHash, QString* pdfPath = nullptr,
+                    FileStatCache* stats = nullptr);
+
+    // Cibles dont les dépendances contiennent l'un de ces fichiers (chemins absolus)
+    QSet<QString> targetsUsing(const QSet<QString>& files);
+
+    // Toutes les dépendances enregistrées (à surveiller en plus des sources)
+    QStringList allFiles();
+
+private:
+    QString m_mainFilePath;
+    QJsonObject m_targets;
+    bool m_loaded = false;
+
+    void load();
+    void save() const;
+};
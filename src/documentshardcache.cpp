@@ -0,0 +1,135 @@
+#include "documentshardcache.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QDebug>
+
+namespace {
+
+// Groupes {...} consécutifs à partir de position (accolades imbriquées comprises)
+QStringList braceGroups(const QString& text, int position)
+{
+    QStringList groups;
+    while (position < text.size() && text.at(position) == '{') {
+        int start = position + 1;
+        int depth = 0;
+        for (; position < text.size(); ++position) {
+            QChar c = text.at(position);
+            if (c == '\\') {
+                ++position;
+            } else if (c == '{') {
+                ++depth;
+            } else if (c == '}' && --depth == 0) {
+                break;
+            }
+        }
+        if (position >= text.size()) {
+            break;
+        }
+        groups << text.mid(start, position - start);
+        ++position;
+    }
+    return groups;
+}
+
+QStringList readLabelLines(const QString& auxPath)
+{
+    QStringList lines;
+    QFile file(auxPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return lines;
+    }
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        if (line.startsWith("\\newlabel{")) {
+            lines << line;
+        }
+    }
+    return lines;
+}
+
+} // namespace
+
+DocumentShardCache::DocumentShardCache(const QString& mainFilePath)
+    : m_mainFilePath(mainFilePath)
+{
+}
+
+QString DocumentShardCache::cacheDir() const
+{
+    QByteArray key = QFileInfo(m_mainFilePath).absoluteFilePath().toUtf8();
+    QString hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/troncons/" + hash;
+}
+
+QString DocumentShardCache::entryPath(const QString& shardName, const QString& extension) const
+{
+    static const QRegularExpression invalidChars("[^A-Za-z0-9]");
+    return cacheDir() + "/" + QString(shardName).replace(invalidChars, "_") + "." + extension;
+}
+
+QString DocumentShardCache::counters(const QString& shardName) const
+{
+    QFile file(entryPath(shardName, "compteurs"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QString();
+    }
+    return QString::fromUtf8(file.readAll());
+}
+
+QStringList DocumentShardCache::labels(const QString& shardName) const
+{
+    QFile file(entryPath(shardName, "labels"));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return QStringList();
+    }
+    return QString::fromUtf8(file.readAll()).split('\n', Qt::SkipEmptyParts);
+}
+
+bool DocumentShardCache::store(const QString& shardName, const QString& jobDir) const
+{
+    if (!QDir().mkpath(cacheDir())) {
+        qWarning() << "Impossible de créer le cache des tronçons" << cacheDir();
+        return false;
+    }
+
+    QString countersPath = entryPath(shardName, "compteurs");
+    QFile::remove(countersPath);
+    if (!QFile::copy(jobDir + "/" + driverBaseName() + ".compteurs", countersPath)) {
+        qWarning() << "Compteurs de fin absents pour le tronçon" << shardName;
+        return false;
+    }
+
+    QFile labelsFile(entryPath(shardName, "labels"));
+    if (!labelsFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    const QStringList lines = readLabelLines(jobDir + "/" + driverBaseName() + ".aux");
+    for (const QString& line : lines) {
+        labelsFile.write(line.toUtf8() + "\n");
+    }
+    return true;
+}
+
+QSet<QByteArray> DocumentShardCache::anchorsFromAux(const QString& auxPath)
+{
+    // hyperref : \newlabel{clé}{{numéro}{page}{titre}{ancre}{}}
+    QSet<QByteArray> anchors;
+    const QStringList lines = readLabelLines(auxPath);
+    for (const QString& line : lines) {
+        QStringList groups = braceGroups(line, int(qstrlen("\\newlabel")));
+        if (groups.size() < 2) {
+            continue;
+        }
+        QStringList fields = braceGroups(groups.at(1), 0);
+        if (fields.size() >= 4 && !fields.at(3).isEmpty()) {
+            anchors.insert(fields.at(3).toUtf8());
+        }
+    }
+    return anchors;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QByteArray>
+
+// Cache persistant des tronçons du document complet (un tronçon par chapitre).
+// Chaque tronçon est compilé seul, en parallèle des autres ; ses compteurs de
+// départ (page, chapitre, exercices...) sont ceux de la fin du tronçon précédent
+// et ses références vers les autres tronçons leurs \newlabel, relevés lors de la
+// dernière compilation en tronçons.
+class DocumentShardCache
+{
+public:
+    explicit DocumentShardCache(const QString& mainFilePath = QString());
+
+    void setMainFilePath(const QString& mainFilePath) { m_mainFilePath = mainFilePath; }
+
+    // Fichiers écrits dans le répertoire de chaque tronçon
+    static QString driverBaseName() { return "troncon"; }
+    static QString seedFileName() { return "amorce.compteurs"; }
+    static QString referencesFileName() { return "references.tex"; }
+
+    // Répertoire du cache pour le fichier principal courant
+    QString cacheDir() const;
+
+    // Compteurs (\setcounter) à la fin du tronçon lors de la dernière compilation ;
+    // vide si le tronçon n'a jamais été compilé
+    QString counters(const QString& shardName) const;
+
+    // Lignes \newlabel du tronçon lors de la dernière compilation
+    QStringList labels(const QString& shardName) const;
+
+    // Enregistre les compteurs de fin et les \newlabel d'un tronçon compilé
+    bool store(const QString& shardName, const QString& jobDir) const;
+
+    // Ancres hyperref (destinations nommées) des \newlabel d'un .aux
+    static QSet<QByteArray> anchorsFromAux(const QString& auxPath);
+
+private:
+    QString m_mainFilePath;
+
+    QString entryPath(const QString& shardName, const QString& extension) const;
+};
@@ -0,0 +1,144 @@
+#include "driverwriter.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include "tracer.h"
+
+DriverResult DriverWriter::write(const DriverRequest& request)
+{
+    TraceScope trace("assemblage", "assemblage " + request.label, request.id);
+    trace.setArg("fichiers", request.files.size());
+    
+    DriverResult result;
+    
+    // Sources lues en parallèle et vérifiées avant tout : une erreur relevée ici
+    // évite une passe complète du moteur
+    QVector<PreflightIssue> issues;
+    QVector<PreflightChecker::Source> sources;
+    {
+        TraceScope preflight("assemblage", "lecture et vérification des sources", request.id);
+        sources = PreflightChecker::readSources(request.files, QFileInfo(request.mainFilePath).absolutePath(),
+                                                request.preflight ? &issues : nullptr);
+        preflight.setArg("problemes", issues.size());
+    }
+    if (!issues.isEmpty()) {
+        result.error = QString("Vérification préalable %1 en échec : %2 problème(s)")
+                           .arg(request.label).arg(issues.size());
+        result.issues = issues;
+        return result;
+    }
+    
+    QFile driverFile(request.path);
+    if (!driverFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        result.error = "Impossible de créer le fichier temporaire pour " + request.label;
+        return result;
+    }
+    
+    // Préambule, chemins d'images, en-têtes et pieds de page, début du document
+    // (gardés à part pour le partiel : c'est la partie exécutée d'avance par un
+    // processus préchauffé)
+    QString setup;
+    QTextStream setupOut(&setup);
+    setupOut << request.preamble;
+    bool chapterMarkers = !request.chapterByFile.isEmpty();
+    if (chapterMarkers) {
+        writeChapterMarkerSetup(setupOut);
+    }
+    writeDocumentSetup(setupOut, request.mainFilePath);
+    setupOut.flush();
+    
+    // Chaque figure manquante est relevée ici, puis reprise par l'assembleur
+    TikzFigureCache figures;
+    figures.setPreamble(request.preamble);
+    
+    QString body;
+    QTextStream bodyOut(&body);
+    QString currentChapter;
+    int filesRead = 0;
+    for (const PreflightChecker::Source& source : sources) {
+        if (!source.readable) {
+            qDebug() << "⚠️ Impossible d'ouvrir le fichier:" << source.path;
+            continue;
+        }
+        if (chapterMarkers) {
+            writeChapterMarker(bodyOut, source.path, request.chapterByFile, &currentChapter, &result.chapterOrder);
+        }
+        bodyOut << "% Contenu du fichier: " << source.path << "\n";
+        bodyOut << (request.tikzFigures ? figures.substitute(source.content) : source.content) << "\n\n";
+        ++filesRead;
+    }
+    bodyOut.flush();
+    
+    QTextStream out(&driverFile);
+    out << setup << body;
+    out << "\\end{document}\n";
+    out.flush();
+    driverFile.close();
+    trace.setArg("fichiers_lus", filesRead);
+    
+    result.path = request.path;
+    result.missingFigures = figures.takeMissingFigures();
+    if (request.keepParts) {
+        result.setup = setup;
+        result.body = body;
+    }
+    return result;
+}
+
+void DriverWriter::writeDocumentSetup(QTextStream& out, const QString& mainFilePath)
+{
+    // Obtenir le chemin absolu du dossier contenant le fichier principal
+    QFileInfo mainFileInfo(mainFilePath);
+    QString mainDirPath = mainFileInfo.absolutePath();
+    
+    // Ajouter la configuration des chemins d'images
+    out << "% Configuration des chemins d'images pour le document temporaire\n";
+    out << "\\graphicspath{{"
+        << QDir::toNativeSeparators(mainDirPath + "/images/").replace("\\", "/") << "}{"
+        << QDir::toNativeSeparators(mainDirPath + "/../images/").replace("\\", "/") << "}}\n\n";
+    
+    // Ajouter la configuration des en-têtes et pieds de page
+    out << "% Configuration des en-têtes et pieds de page\n";
+    out << "\\lhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\monetablissement}}}} %haut de page gauche\n";
+    out << "\\chead{} %haut de page centre\n";
+    out << "\\rhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\maclasse}}}} %haut de page droit\n";
+    out << "\\lfoot{} %pied de page gauche\n";
+    out << "\\cfoot{\\textcolor{gris50}{\\small\\textit{page \\thepage}}} % pied de page centré\n";
+    out << "\\rfoot{} %On personnalisera cette en-tête\n";
+    out << "\\def\\headrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
+    out << "\\def\\footrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
+    out << "\\pagestyle{empty}\n\n";
+    
+    // Début du document
+    out << "\\begin{document}\n\n";
+    
+    // Ajouter la configuration de l'espacement
+    out << "\\singlespacing\\setlength{\\parindent}{0pt}\n\n";
+}
+
+void DriverWriter::writeChapterMarkerSetup(QTextStream& out)
+{
+    // Le marqueur vide la page courante puis, à l'envoi de la page suivante (la première
+    // du chapitre), écrit son numéro absolu dans le .aux ; relu, il ne produit rien
+    out << "% Début de chaque chapitre, noté dans le .aux pour le découpage du PDF\n";
+    out << "\\makeatletter\n";
+    out << "\\providecommand\\CompilationSelectiveChapitre[2]{}\n";
+    out << "\\newcommand\\CompilationSelectiveDebutChapitre[1]{\\clearpage\\AddToHookNext{shipout/after}"
+           "{\\immediate\\write\\@auxout{\\string\\CompilationSelectiveChapitre{#1}{\\the\\c@abspage}}}}\n";
+    out << "\\makeatother\n\n";
+}
+
+void DriverWriter::writeChapterMarker(QTextStream& out, const QString& sourcePath,
+                                      const QHash<QString, QString>& chapterByFile,
+                                      QString* currentChapter, QStringList* chapterOrder)
+{
+    QString chapter = chapterByFile.value(QFileInfo(sourcePath).absoluteFilePath());
+    if (chapter.isEmpty() || chapter == *currentChapter) {
+        return;
+    }
+    
+    *currentChapter = chapter;
+    out << "\\CompilationSelectiveDebutChapitre{" << chapterOrder->size() << "}\n";
+    chapterOrder->append(chapter);
+}
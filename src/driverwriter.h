@@ -0,0 +1,57 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QHash>
+#include <QTextStream>
+#include "tikzfigurecache.h"
+#include "preflightchecker.h"
+
+// Fichier pilote à écrire : tout ce qu'il faut est copié dans la demande, qui
+// peut donc être traitée hors du thread principal
+struct DriverRequest {
+    QString id;                               // Cible (ligne de la trace)
+    QString label;                            // « le chapitre X »... (messages d'erreur)
+    QString path;                             // Fichier pilote
+    QString preamble;
+    QString mainFilePath;
+    QVector<QPair<QString, QString>> files;   // (nom, chemin) dans l'ordre du document
+    QHash<QString, QString> chapterByFile;    // Mode découpage : chapitre de chaque source
+    bool tikzFigures = false;                 // Figures remplacées par leur PDF du cache
+    bool keepParts = false;                   // Garder mise en place et corps (partiel préchauffé)
+    bool preflight = true;                    // Vérifications préalables des sources
+};
+
+struct DriverResult {
+    QString path;                             // Vide si le pilote n'a pas pu être écrit
+    QString error;
+    QString setup;                            // Jusqu'à \begin{document} compris (keepParts)
+    QString body;                             // Contenu des sources (keepParts)
+    QStringList chapterOrder;                 // Chapitres dans l'ordre de leurs marqueurs
+    QVector<TikzFigureCache::Figure> missingFigures;
+    QVector<PreflightIssue> issues;           // Vérifications préalables en échec (pilote non écrit)
+};
+
+// Écriture des fichiers pilotes : préambule, mise en place du document puis
+// contenu des sources. Sans état partagé, write() s'exécute dans un thread de
+// QtConcurrent : les sources sont lues en parallèle et vérifiées, puis le
+// pilote écrit sans bloquer l'interface, et les figures manquantes sont
+// rendues avec le résultat. Une source en défaut empêche l'écriture du pilote :
+// la cible échoue avant que le moteur ne soit lancé.
+class DriverWriter
+{
+public:
+    static DriverResult write(const DriverRequest& request);
+
+    // Chemins d'images, en-têtes et pieds de page, \begin{document}
+    static void writeDocumentSetup(QTextStream& out, const QString& mainFilePath);
+
+    // Mode découpage : commande qui note le début de chaque chapitre dans le .aux
+    static void writeChapterMarkerSetup(QTextStream& out);
+
+    // Marqueur du chapitre de sourcePath s'il en change (chapterOrder complété)
+    static void writeChapterMarker(QTextStream& out, const QString& sourcePath,
+                                   const QHash<QString, QString>& chapterByFile,
+                                   QString* currentChapter, QStringList* chapterOrder);
+};
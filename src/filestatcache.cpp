@@ -0,0 +1,25 @@
+#include "filestatcache.h"
+#include <QFileInfo>
+
+FileStatCache::Entry FileStatCache::stat(const QString& filePath)
+{
+    auto it = m_entries.constFind(filePath);
+    if (it != m_entries.constEnd()) {
+        return it.value();
+    }
+    Entry entry = read(filePath);
+    m_entries.insert(filePath, entry);
+    return entry;
+}
+
+FileStatCache::Entry FileStatCache::read(const QString& filePath)
+{
+    Entry entry;
+    QFileInfo info(filePath);
+    entry.exists = info.exists();
+    if (entry.exists) {
+        entry.size = info.size();
+        entry.modified = info.lastModified();
+    }
+    return entry;
+}
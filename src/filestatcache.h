@@ -0,0 +1,35 @@
+#pragma once
+#include <QString>
+#include <QHash>
+#include <QDateTime>
+
+// Instantané des métadonnées des fichiers (existence, taille, date) pris pendant
+// la préparation d'une compilation : chaque fichier n'est interrogé qu'une fois
+// sur le disque, que ce soit par le planificateur ou par le contrôle des
+// dépendances. Vidé au début de chaque compilation.
+class FileStatCache
+{
+public:
+    struct Entry {
+        bool exists = false;
+        qint64 size = 0;
+        QDateTime modified;
+    };
+
+    // Métadonnées lues sur le disque au premier appel pour ce chemin
+    Entry stat(const QString& filePath);
+    bool exists(const QString& filePath) { return stat(filePath).exists; }
+
+    // Vrai si le fichier figure déjà dans l'instantané, et sa valeur sans accès disque
+    bool contains(const QString& filePath) const { return m_entries.contains(filePath); }
+    Entry cached(const QString& filePath) const { return m_entries.value(filePath); }
+
+    // Lecture directe, sans passer par l'instantané
+    static Entry read(const QString& filePath);
+
+    void clear() { m_entries.clear(); }
+    int size() const { return m_entries.size(); }
+
+private:
+    QHash<QString, Entry> m_entries;
+};
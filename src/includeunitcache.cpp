@@ -0,0 +1,178 @@
+#include "includeunitcache.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+namespace {
+
+const char* const unitListFile = "unites.json";
+
+} // namespace
+
+IncludeUnitCache::IncludeUnitCache(const QString& mainFilePath)
+    : m_mainFilePath(mainFilePath)
+{
+}
+
+QString IncludeUnitCache::unitName(const QString& mainDirPath, const QString& sourcePath)
+{
+    static const QRegularExpression invalidChars("[^A-Za-z0-9]");
+
+    QString relative = QDir(mainDirPath).relativeFilePath(QFileInfo(sourcePath).absoluteFilePath());
+    if (relative.endsWith(".tex")) {
+        relative.chop(4);
+    }
+    return "u_" + relative.replace(invalidChars, "_");
+}
+
+QVector<IncludeUnit> IncludeUnitCache::unitsFor(const QString& mainDirPath,
+                                                const QVector<QPair<QString, QString>>& files)
+{
+    QVector<IncludeUnit> units;
+    QSet<QString> usedNames;
+    for (const auto& file : files) {
+        IncludeUnit unit;
+        unit.sourcePath = QFileInfo(file.second).absoluteFilePath();
+        unit.name = unitName(mainDirPath, unit.sourcePath);
+
+        // Deux chemins peuvent donner le même nom une fois nettoyés
+        QString baseName = unit.name;
+        for (int suffix = 2; usedNames.contains(unit.name); ++suffix) {
+            unit.name = baseName + "_" + QString::number(suffix);
+        }
+        usedNames.insert(unit.name);
+        units.append(unit);
+    }
+    return units;
+}
+
+QString IncludeUnitCache::cacheDir() const
+{
+    QByteArray key = QFileInfo(m_mainFilePath).absoluteFilePath().toUtf8();
+    QString hash = QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/includeonly/" + hash;
+}
+
+bool IncludeUnitCache::isReady() const
+{
+    if (m_mainFilePath.isEmpty()) {
+        return false;
+    }
+    QDir dir(cacheDir());
+    return dir.exists(driverBaseName() + ".aux") && dir.exists(unitListFile);
+}
+
+QVector<IncludeUnit> IncludeUnitCache::units() const
+{
+    QVector<IncludeUnit> units;
+
+    QFile file(cacheDir() + "/" + unitListFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return units;
+    }
+
+    const QJsonArray array = QJsonDocument::fromJson(file.readAll()).array();
+    for (const QJsonValue& value : array) {
+        QJsonObject object = value.toObject();
+        IncludeUnit unit;
+        unit.name = object.value("name").toString();
+        unit.sourcePath = object.value("source").toString();
+        units.append(unit);
+    }
+    return units;
+}
+
+bool IncludeUnitCache::prepareJobDir(const QString& jobDir, const QVector<IncludeUnit>& units,
+                                     const QStringList& includedUnits, bool copyAux,
+                                     const std::function<QString(const QString&)>& transform) const
+{
+    // Repartir d'un répertoire vide : un .aux périmé fausserait la numérotation
+    QDir dir(jobDir);
+    if (dir.exists() && !dir.removeRecursively()) {
+        qWarning() << "Impossible de vider le répertoire de compilation" << jobDir;
+        return false;
+    }
+    if (!QDir().mkpath(jobDir)) {
+        qWarning() << "Impossible de créer le répertoire de compilation" << jobDir;
+        return false;
+    }
+
+    const QSet<QString> included(includedUnits.begin(), includedUnits.end());
+    for (const IncludeUnit& unit : units) {
+        if (copyAux) {
+            QString cachedAux = cacheDir() + "/" + unit.name + ".aux";
+            if (QFile::exists(cachedAux)) {
+                QFile::copy(cachedAux, jobDir + "/" + unit.name + ".aux");
+            }
+        }
+
+        if (!included.contains(unit.name)) {
+            continue;
+        }
+
+        QFile source(unit.sourcePath);
+        QFile target(jobDir + "/" + unit.name + ".tex");
+        if (!source.open(QIODevice::ReadOnly | QIODevice::Text) ||
+            !target.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning() << "Impossible de préparer l'unité" << unit.name << "depuis" << unit.sourcePath;
+            return false;
+        }
+        target.write("% Contenu du fichier: " + unit.sourcePath.toUtf8() + "\n");
+        if (transform) {
+            target.write(transform(QString::fromUtf8(source.readAll())).toUtf8());
+        } else {
+            target.write(source.readAll());
+        }
+        target.write("\n");
+    }
+
+    if (copyAux) {
+        QString mainAux = driverBaseName() + ".aux";
+        if (!QFile::copy(cacheDir() + "/" + mainAux, jobDir + "/" + mainAux)) {
+            qWarning() << "Impossible de copier le .aux de la compilation complète";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IncludeUnitCache::store(const QString& jobDir, const QVector<IncludeUnit>& units) const
+{
+    QString targetDir = cacheDir();
+    QDir(targetDir).removeRecursively();
+    if (!QDir().mkpath(targetDir)) {
+        qWarning() << "Impossible de créer le cache des unités" << targetDir;
+        return false;
+    }
+
+    QJsonArray array;
+    for (const IncludeUnit& unit : units) {
+        QString aux = unit.name + ".aux";
+        if (QFile::exists(jobDir + "/" + aux)) {
+            QFile::copy(jobDir + "/" + aux, targetDir + "/" + aux);
+        }
+        QJsonObject object;
+        object["name"] = unit.name;
+        object["source"] = unit.sourcePath;
+        array.append(object);
+    }
+
+    // Le .aux principal en dernier : sa présence signale un cache complet
+    QFile listFile(targetDir + "/" + unitListFile);
+    if (!listFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    listFile.write(QJsonDocument(array).toJson());
+    listFile.close();
+
+    QString mainAux = driverBaseName() + ".aux";
+    return QFile::copy(jobDir + "/" + mainAux, targetDir + "/" + mainAux);
+}
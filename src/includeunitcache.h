@@ -0,0 +1,53 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <functional>
+
+// Unité \include : un fichier source du document complet, sous un nom stable
+struct IncludeUnit {
+    QString name;        // Nom passé à \include (sans extension ni espace)
+    QString sourcePath;  // Fichier source recopié dans l'unité
+};
+
+// Cache persistant des .aux de la dernière compilation complète en unités.
+// Le partiel et les chapitres se compilent ensuite avec \includeonly contre ces
+// .aux : numérotation, références et table des matières sont celles du document
+// complet dès la première passe, seules les unités choisies sont composées.
+class IncludeUnitCache
+{
+public:
+    explicit IncludeUnitCache(const QString& mainFilePath = QString());
+
+    void setMainFilePath(const QString& mainFilePath) { m_mainFilePath = mainFilePath; }
+
+    // Nom du fichier pilote (et donc du .aux principal) dans chaque répertoire de compilation
+    static QString driverBaseName() { return "unites"; }
+
+    // Nom d'unité stable dérivé du chemin relatif au fichier principal
+    static QString unitName(const QString& mainDirPath, const QString& sourcePath);
+    static QVector<IncludeUnit> unitsFor(const QString& mainDirPath,
+                                         const QVector<QPair<QString, QString>>& files);
+
+    // Répertoire du cache pour le fichier principal courant
+    QString cacheDir() const;
+
+    // Vrai si une compilation complète en unités a été enregistrée
+    bool isReady() const;
+
+    // Unités (dans l'ordre du document) de la compilation enregistrée
+    QVector<IncludeUnit> units() const;
+
+    // Prépare un répertoire de compilation vide : copie des unités compilées
+    // (passées par transform si elle est fournie) et, si demandé, des .aux enregistrés
+    bool prepareJobDir(const QString& jobDir, const QVector<IncludeUnit>& units,
+                       const QStringList& includedUnits, bool copyAux,
+                       const std::function<QString(const QString&)>& transform = nullptr) const;
+
+    // Enregistre les .aux produits par une compilation complète réussie
+    bool store(const QString& jobDir, const QVector<IncludeUnit>& units) const;
+
+private:
+    QString m_mainFilePath;
+};
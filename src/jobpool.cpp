@@ -0,0 +1,108 @@
+#include "jobpool.h"
+#include <QDebug>
+#include "tracer.h"
+
+JobPool::JobPool(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void JobPool::setMaxParallelJobs(int count)
+{
+    m_maxParallelJobs = qMax(1, count);
+    startPendingJobs();
+}
+
+void JobPool::enqueue(const CompileJobSpec& spec)
+{
+    m_queue.enqueue(spec);
+    m_enqueuedAtUs.insert(spec.id, Tracer::instance().now());
+    startPendingJobs();
+}
+
+void JobPool::stop()
+{
+    m_queue.clear();
+    m_enqueuedAtUs.clear();
+
+    // Copie : stop() peut provoquer la fin (différée) des compilations
+    const QList<CompileJob*> running = m_running.values();
+    for (CompileJob* job : running) {
+        job->stop();
+    }
+}
+
+void JobPool::setHeld(bool held)
+{
+    m_held = held;
+    startPendingJobs();
+}
+
+void JobPool::startPendingJobs()
+{
+    if (m_held) return;
+
+    while (!m_queue.isEmpty() && m_running.size() < m_maxParallelJobs) {
+        CompileJobSpec spec = m_queue.dequeue();
+
+        CompileJob* job = new CompileJob(spec, this);
+        job->setLimits(m_limits);
+
+        const QString id = spec.id;
+        connect(job, &CompileJob::outputLines, this, [this, id](const QStringList& lines) {
+            emit jobOutput(id, lines);
+        });
+        connect(job, &CompileJob::passStarted, this, [this, id](int pass) {
+            emit jobPassStarted(id, pass);
+        });
+        connect(job, &CompileJob::passFinished, this, [this, id](int pass, const ProcessResult& result) {
+            emit jobPassFinished(id, pass, result);
+        });
+        connect(job, &CompileJob::toolFinished, this,
+                [this, id](const QString& tool, int pass, const ProcessResult& result) {
+            emit jobToolFinished(id, tool, pass, result);
+        });
+        connect(job, &CompileJob::finished, this, [this, job](bool success) {
+            onJobFinished(job, success);
+        });
+
+        m_running.insert(id, job);
+
+        // Temps passé dans la file : visible comme un temps mort sur la ligne du job
+        Tracer& tracer = Tracer::instance();
+        qint64 startedAt = tracer.now();
+        qint64 enqueuedAt = m_enqueuedAtUs.take(id);
+        if (startedAt > enqueuedAt) {
+            tracer.complete("file", "attente", id, enqueuedAt, startedAt - enqueuedAt);
+        }
+        m_startedAtUs.insert(id, startedAt);
+
+        emit jobStarted(id);
+
+        if (!job->start()) {
+            qWarning() << "Échec du lancement de la compilation" << id;
+            onJobFinished(job, false);
+        }
+    }
+}
+
+void JobPool::onJobFinished(CompileJob* job, bool success)
+{
+    const QString id = job->spec().id;
+    m_running.remove(id);
+
+    Tracer& tracer = Tracer::instance();
+    qint64 startedAt = m_startedAtUs.take(id);
+    tracer.complete("compilation", success ? "compilation" : "compilation (échec)", id,
+                    startedAt, tracer.now() - startedAt,
+                    QJsonObject{ { "passes", job->pass() }, { "code", job->exitCode() } });
+
+    emit jobFinished(id, success, job->exitCode(), job->pdfPath());
+    job->deleteLater();
+
+    startPendingJobs();
+
+    if (m_queue.isEmpty() && m_running.isEmpty()) {
+        emit allJobsFinished();
+    }
+}
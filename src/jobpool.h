@@ -0,0 +1,59 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QQueue>
+#include <QHash>
+#include "compilejob.h"
+
+// File de compilations exécutées en parallèle, dans la limite de
+// maxParallelJobs processus simultanés.
+class JobPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobPool(QObject* parent = nullptr);
+
+    void setMaxParallelJobs(int count);
+    int maxParallelJobs() const { return m_maxParallelJobs; }
+
+    void setLimits(const ProcessLimits& limits) { m_limits = limits; }
+
+    // Ajoute une compilation à la file et la démarre dès qu'un emplacement est libre
+    void enqueue(const CompileJobSpec& spec);
+
+    // Vide la file et arrête les compilations en cours
+    void stop();
+
+    // Retient les compilations en file sans les démarrer (préparation commune en cours)
+    void setHeld(bool held);
+    bool isHeld() const { return m_held; }
+
+    bool isBusy() const { return !m_queue.isEmpty() || !m_running.isEmpty(); }
+    int runningCount() const { return m_running.size(); }
+    int pendingCount() const { return m_queue.size(); }
+
+signals:
+    void jobStarted(const QString& id);
+    void jobOutput(const QString& id, const QStringList& lines);
+    void jobPassStarted(const QString& id, int pass);
+    void jobPassFinished(const QString& id, int pass, const ProcessResult& result);
+    void jobToolFinished(const QString& id, const QString& tool, int pass, const ProcessResult& result);
+    void jobFinished(const QString& id, bool success, int exitCode, const QString& pdfPath);
+    void allJobsFinished();
+
+private:
+    int m_maxParallelJobs = 1;
+    bool m_held = false;
+    ProcessLimits m_limits;
+    QQueue<CompileJobSpec> m_queue;
+    QHash<QString, CompileJob*> m_running;
+
+    // Instants de mise en file et de démarrage, pour la trace (attente, durée totale)
+    QHash<QString, qint64> m_enqueuedAtUs;
+    QHash<QString, qint64> m_startedAtUs;
+
+    void startPendingJobs();
+    void onJobFinished(CompileJob* job, bool success);
+};
@@ -5,6 +5,7 @@
 #include <QJsonArray>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
 #include <QDateTime>
 
 LastFileHelper::LastFileHelper(QObject *parent)
@@ -16,35 +17,23 @@ LastFileHelper::LastFileHelper(QObject *parent)
     m_configPath = configDir + "/config.json";
 }
 
-QString LastFileHelper::loadLastFilePath()
+QJsonObject LastFileHelper::readConfig() const
 {
     QFile file(m_configPath);
     if (!file.open(QIODevice::ReadOnly)) {
-        return QString();
+        return QJsonObject();
     }
     
     QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
     file.close();
-    
-    QJsonObject obj = doc.object();
-    return obj.value("lastFile").toString();
+    return doc.object();
 }
 
-void LastFileHelper::saveLastFilePath(const QString &path)
+void LastFileHelper::updateConfig(const std::function<void(QJsonObject&)>& update)
 {
-    QJsonObject config;
-    
-    // Charger la config existante d'abord
-    QFile readFile(m_configPath);
-    if (readFile.open(QIODevice::ReadOnly)) {
-        QJsonDocument doc = QJsonDocument::fromJson(readFile.readAll());
-        readFile.close();
-        config = doc.object();
-    }
-    
-    // Mettre à jour le chemin du dernier fichier
-    config["lastFile"] = path;
-    config["lastUpdated"] = QDateTime::currentDateTime().toString();
+    // Charger la config existante d'abord : seules les clés modifiées changent
+    QJsonObject config = readConfig();
+    update(config);
     
     // Écrire le fichier de configuration
     QFile writeFile(m_configPath);
@@ -54,70 +43,53 @@ void LastFileHelper::saveLastFilePath(const QString &path)
     }
 }
 
+void LastFileHelper::saveValue(const QString& key, const QJsonValue& value)
+{
+    updateConfig([&](QJsonObject& config) {
+        config[key] = value;
+    });
+}
+
+QJsonValue LastFileHelper::loadValue(const QString& key) const
+{
+    return readConfig().value(key);
+}
+
+QString LastFileHelper::loadLastFilePath()
+{
+    return loadValue("lastFile").toString();
+}
+
+void LastFileHelper::saveLastFilePath(const QString &path)
+{
+    updateConfig([&](QJsonObject& config) {
+        // Mettre à jour le chemin du dernier fichier
+        config["lastFile"] = path;
+        config["lastUpdated"] = QDateTime::currentDateTime().toString();
+    });
+}
+
 QJsonObject LastFileHelper::loadCheckState()
 {
-    QFile file(m_configPath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return QJsonObject();
-    }
-    
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
-    
-    QJsonObject obj = doc.object();
-    return obj.value("checkStates").toObject();
+    return loadValue("checkStates").toObject();
 }
 
 void LastFileHelper::saveCheckState(const QJsonObject& state)
 {
-    QJsonObject config;
-    
-    // Charger la config existante d'abord
-    QFile readFile(m_configPath);
-    if (readFile.open(QIODevice::ReadOnly)) {
-        QJsonDocument doc = QJsonDocument::fromJson(readFile.readAll());
-        readFile.close();
-        config = doc.object();
-    }
-    
-    // Mettre à jour l'état des cases à cocher
-    config["checkStates"] = state;
-    config["stateUpdated"] = QDateTime::currentDateTime().toString();
-    
-    // Écrire le fichier de configuration
-    QFile writeFile(m_configPath);
-    if (writeFile.open(QIODevice::WriteOnly)) {
-        writeFile.write(QJsonDocument(config).toJson());
-        writeFile.close();
-    }
+    updateConfig([&](QJsonObject& config) {
+        // Mettre à jour l'état des cases à cocher
+        config["checkStates"] = state;
+        config["stateUpdated"] = QDateTime::currentDateTime().toString();
+    });
 }
 
 void LastFileHelper::saveCompilationOptions(bool compileChapter, bool compileDocument)
 {
-    QJsonObject config;
-    
-    // Charger la config existante d'abord
-    QFile readFile(m_configPath);
-    if (readFile.open(QIODevice::ReadOnly)) {
-        QJsonDocument doc = QJsonDocument::fromJson(readFile.readAll());
-        readFile.close();
-        config = doc.object();
-    }
-    
     // Créer un sous-objet pour les options de compilation
     QJsonObject compileOptions;
     compileOptions["compileChapter"] = compileChapter;
     compileOptions["compileDocument"] = compileDocument;
-    
-    // Mettre à jour les options de compilation
-    config["compilationOptions"] = compileOptions;
-    
-    // Écrire le fichier de configuration
-    QFile writeFile(m_configPath);
-    if (writeFile.open(QIODevice::WriteOnly)) {
-        writeFile.write(QJsonDocument(config).toJson());
-        writeFile.close();
-    }
+    saveValue("compilationOptions", compileOptions);
 }
 
 std::tuple<bool, bool> LastFileHelper::loadCompilationOptions()
@@ -126,25 +98,228 @@ std::tuple<bool, bool> LastFileHelper::loadCompilationOptions()
     bool compileChapter = true;
     bool compileDocument = false;
     
-    QFile file(m_configPath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        // Retourner les valeurs par défaut si le fichier n'existe pas
-        return std::make_tuple(compileChapter, compileDocument);
+    QJsonObject options = loadValue("compilationOptions").toObject();
+    if (options.contains("compileChapter"))
+        compileChapter = options["compileChapter"].toBool();
+        
+    if (options.contains("compileDocument"))
+        compileDocument = options["compileDocument"].toBool();
+    
+    return std::make_tuple(compileChapter, compileDocument);
+}
+
+void LastFileHelper::saveIncludeOnlyMode(bool enabled)
+{
+    saveValue("includeOnlyMode", enabled);
+}
+
+bool LastFileHelper::loadIncludeOnlyMode()
+{
+    return loadValue("includeOnlyMode").toBool(false);
+}
+
+void LastFileHelper::saveChaptersFromDocument(bool enabled)
+{
+    saveValue("chaptersFromDocument", enabled);
+}
+
+bool LastFileHelper::loadChaptersFromDocument()
+{
+    return loadValue("chaptersFromDocument").toBool(false);
+}
+
+void LastFileHelper::saveShardedDocument(bool enabled)
+{
+    saveValue("shardedDocument", enabled);
+}
+
+bool LastFileHelper::loadShardedDocument()
+{
+    return loadValue("shardedDocument").toBool(false);
+}
+
+void LastFileHelper::saveChapterShardFiles(int files)
+{
+    saveValue("chapterShardFiles", files);
+}
+
+int LastFileHelper::loadChapterShardFiles()
+{
+    return qMax(0, loadValue("chapterShardFiles").toInt(0));
+}
+
+void LastFileHelper::saveTikzFigureCache(bool enabled)
+{
+    saveValue("tikzFigureCache", enabled);
+}
+
+bool LastFileHelper::loadTikzFigureCache()
+{
+    return loadValue("tikzFigureCache").toBool(false);
+}
+
+void LastFileHelper::saveForceRebuild(bool enabled)
+{
+    saveValue("forceRebuild", enabled);
+}
+
+bool LastFileHelper::loadForceRebuild()
+{
+    return loadValue("forceRebuild").toBool(false);
+}
+
+void LastFileHelper::saveExercisePdfs(bool enabled)
+{
+    saveValue("exercisePdfs", enabled);
+}
+
+bool LastFileHelper::loadExercisePdfs()
+{
+    return loadValue("exercisePdfs").toBool(false);
+}
+
+void LastFileHelper::savePreflightChecks(bool enabled)
+{
+    saveValue("preflightChecks", enabled);
+}
+
+bool LastFileHelper::loadPreflightChecks()
+{
+    return loadValue("preflightChecks").toBool(true);
+}
+
+void LastFileHelper::saveWarmWorkers(int count)
+{
+    saveValue("warmWorkers", count);
+}
+
+int LastFileHelper::loadWarmWorkers()
+{
+    return qMax(0, loadValue("warmWorkers").toInt(0));
+}
+
+ProcessLimits LastFileHelper::loadProcessLimits()
+{
+    // Valeurs par défaut
+    ProcessLimits limits;
+    
+    QJsonObject options = loadValue("processLimits").toObject();
+    if (options.contains("wallTimeoutSec"))
+        limits.wallTimeoutSec = options["wallTimeoutSec"].toInt();
+    if (options.contains("idleTimeoutSec"))
+        limits.idleTimeoutSec = options["idleTimeoutSec"].toInt();
+    if (options.contains("killGraceMs"))
+        limits.killGraceMs = options["killGraceMs"].toInt();
+    
+    return limits;
+}
+
+PublishPolicy LastFileHelper::loadPublishPolicy()
+{
+    // Valeurs par défaut
+    PublishPolicy policy;
+    
+    QJsonObject options = loadValue("publishPolicy").toObject();
+    if (options.contains("keepCount"))
+        policy.keepCount = options["keepCount"].toInt();
+    if (options.contains("keepMegabytes"))
+        policy.keepMegabytes = options["keepMegabytes"].toInt();
+    
+    return policy;
+}
+
+namespace {
+
+QJsonObject buildRootToJson(const BuildRootSettings& settings)
+{
+    QJsonObject object;
+    object["mode"] = BuildRootSettings::modeName(settings.mode);
+    object["path"] = settings.path;
+    object["ramMegabytes"] = settings.ramMegabytes;
+    return object;
+}
+
+// Les champs absents gardent les valeurs de base
+BuildRootSettings buildRootFromJson(const QJsonObject& object, BuildRootSettings settings)
+{
+    if (object.contains("mode"))
+        settings.mode = BuildRootSettings::modeFromName(object["mode"].toString());
+    if (object.contains("path"))
+        settings.path = object["path"].toString();
+    if (object.contains("ramMegabytes"))
+        settings.ramMegabytes = object["ramMegabytes"].toInt();
+    return settings;
+}
+
+} // namespace
+
+void LastFileHelper::saveBuildRoot(const BuildRootSettings& settings, const QString& mainFilePath)
+{
+    updateConfig([&](QJsonObject& config) {
+        QJsonObject rootObject = config.value("buildRoot").toObject();
+        QJsonObject projects = rootObject.value("projects").toObject();
+        if (mainFilePath.isEmpty()) {
+            rootObject = buildRootToJson(settings);
+        } else {
+            projects[QFileInfo(mainFilePath).absoluteFilePath()] = buildRootToJson(settings);
+        }
+        if (!projects.isEmpty()) {
+            rootObject["projects"] = projects;
+        }
+        config["buildRoot"] = rootObject;
+    });
+}
+
+BuildRootSettings LastFileHelper::loadBuildRoot(const QString& mainFilePath)
+{
+    QJsonObject rootObject = loadValue("buildRoot").toObject();
+    BuildRootSettings settings = buildRootFromJson(rootObject, BuildRootSettings());
+    if (!mainFilePath.isEmpty()) {
+        QJsonObject project = rootObject.value("projects").toObject()
+                                  .value(QFileInfo(mainFilePath).absoluteFilePath()).toObject();
+        settings = buildRootFromJson(project, settings);
     }
+    return settings;
+}
+
+QVector<CompileProfile> LastFileHelper::loadCompileProfiles()
+{
+    QVector<CompileProfile> profiles = CompileProfile::builtins();
     
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
+    const QJsonArray custom = loadValue("compileProfiles").toObject().value("profiles").toArray();
+    for (const QJsonValue& value : custom) {
+        CompileProfile profile = CompileProfile::fromJson(value.toObject());
+        
+        // Un profil personnalisé remplace le profil intégré de même nom
+        bool replaced = false;
+        for (CompileProfile& existing : profiles) {
+            if (existing.name == profile.name) {
+                existing = profile;
+                replaced = true;
+            }
+        }
+        if (!replaced) {
+            profiles.append(profile);
+        }
+    }
     
-    QJsonObject obj = doc.object();
-    if (obj.contains("compilationOptions")) {
-        QJsonObject options = obj["compilationOptions"].toObject();
-            
-        if (options.contains("compileChapter"))
-            compileChapter = options["compileChapter"].toBool();
-            
-        if (options.contains("compileDocument"))
-            compileDocument = options["compileDocument"].toBool();
+    return profiles;
+}
+
+QMap<QString, QString> LastFileHelper::loadTargetProfiles()
+{
+    // Valeurs par défaut
+    QMap<QString, QString> targets;
+    targets["partiel"] = CompileProfile::fastPreview().name;
+    targets["chapitre"] = CompileProfile::full().name;
+    targets["document"] = CompileProfile::full().name;
+    
+    const QJsonObject saved = loadValue("compileProfiles").toObject().value("targets").toObject();
+    for (auto it = saved.constBegin(); it != saved.constEnd(); ++it) {
+        if (targets.contains(it.key())) {
+            targets[it.key()] = it.value().toString();
+        }
     }
     
-    return std::make_tuple(compileChapter, compileDocument);
-}
\ No newline at end of file
+    return targets;
+}
@@ -3,7 +3,12 @@
 #include <QString>
 #include <QJsonObject>
 #include <tuple>
+#include <functional>
 #include "latexparser.h"
+#include "processrunner.h"
+#include "compileprofile.h"
+#include "artifactpublisher.h"
+#include "buildroot.h"
 
 class LastFileHelper : public QObject
 {
@@ -20,7 +25,70 @@ public:
     // Nouvelles méthodes pour les options de compilation
     void saveCompilationOptions(bool compileChapter, bool compileDocument);
     std::tuple<bool, bool> loadCompilationOptions();
+
+    // Mode \includeonly (numérotation du dernier document complet)
+    void saveIncludeOnlyMode(bool enabled);
+    bool loadIncludeOnlyMode();
+
+    // Chapitres extraits du PDF du document complet
+    void saveChaptersFromDocument(bool enabled);
+    bool loadChaptersFromDocument();
+
+    // Document complet en tronçons parallèles
+    void saveShardedDocument(bool enabled);
+    bool loadShardedDocument();
+
+    // Chapitres en tronçons : nombre maximal de fichiers par tronçon (0 : désactivé)
+    void saveChapterShardFiles(int files);
+    int loadChapterShardFiles();
+
+    // Cache des figures TikZ
+    void saveTikzFigureCache(bool enabled);
+    bool loadTikzFigureCache();
+
+    // Recompilation des cibles même à jour d'après leurs dépendances
+    void saveForceRebuild(bool enabled);
+    bool loadForceRebuild();
+
+    // Un PDF par exercice des groupes PEDA/DOCS/EVALS
+    void saveExercisePdfs(bool enabled);
+    bool loadExercisePdfs();
+
+    // Vérifications préalables des sources (activées par défaut)
+    void savePreflightChecks(bool enabled);
+    bool loadPreflightChecks();
+
+    // Nombre de processus préchauffés pour le partiel (0 : désactivé)
+    void saveWarmWorkers(int count);
+    int loadWarmWorkers();
+
+    // Limites de supervision des processus (délais, grâce avant SIGKILL),
+    // réglées à la main dans config.json
+    ProcessLimits loadProcessLimits();
+
+    // Conservation des PDF publiés (nombre et taille par cible), réglée à la main
+    PublishPolicy loadPublishPolicy();
+
+    // Racine des fichiers intermédiaires : réglage général, ou propre au projet
+    // de ce fichier principal s'il en a un
+    void saveBuildRoot(const BuildRootSettings& settings, const QString& mainFilePath = QString());
+    BuildRootSettings loadBuildRoot(const QString& mainFilePath = QString());
+
+    // Profils de compilation (compileProfiles, réglé à la main dans config.json) :
+    // profils personnalisés (ajoutés aux profils intégrés, ou les remplaçant à nom
+    // égal) et profil choisi par cible ("partiel", "chapitre", "document")
+    QVector<CompileProfile> loadCompileProfiles();
+    QMap<QString, QString> loadTargetProfiles();
     
 private:
     QString m_configPath;
+
+    // config.json entier (objet vide s'il est absent ou illisible)
+    QJsonObject readConfig() const;
+
+    // Relit config.json, applique la modification et le réécrit : les clés des
+    // autres options sont conservées
+    void updateConfig(const std::function<void(QJsonObject&)>& update);
+    void saveValue(const QString& key, const QJsonValue& value);
+    QJsonValue loadValue(const QString& key) const;
 };
\ No newline at end of file
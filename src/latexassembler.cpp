@@ -5,259 +5,220 @@
 #include <QDateTime>
 #include <QRegularExpression>
 #include <QTemporaryDir>
-#include <QThreadPool>
-#include <QRunnable>
+#include <QStandardPaths>
+#include <QThread>
+#include <QtConcurrent>
+#include "pdfpages.h"
+#include "tracer.h"
 
-// Initialisation des trois répertoires temporaires
-QTemporaryDir LatexAssembler::s_partielTempDir(QDir::tempPath() + "/qt_partiel_temp-XXXXXX");
-QTemporaryDir LatexAssembler::s_chapterTempDir(QDir::tempPath() + "/qt_chapter_temp-XXXXXX");
-QTemporaryDir LatexAssembler::s_documentTempDir(QDir::tempPath() + "/qt_doc_temp-XXXXXX");
+namespace {
 
-LatexAssembler::LatexAssembler(QObject* parent) : QObject(parent), m_isCompiling(false), m_isCompilingChapters(false), 
-                                                m_isCompilingFullDocument(false), m_compilationCount(0), 
-                                                m_chapterCompilationCount(0), m_fullDocumentCompilationCount(0),
-                                                m_partialOutputWidget(nullptr), m_chapterOutputWidget(nullptr),
-                                                m_fullDocumentOutputWidget(nullptr),
-                                                m_processRunner(new ProcessRunner(this)),
-                                                m_chapterProcessRunner(new ProcessRunner(this)),
-                                                m_fullDocumentProcessRunner(new ProcessRunner(this))
-{
-    // S'assurer que les trois répertoires temporaires sont créés correctement
-    if (!s_partielTempDir.isValid()) {
-        qWarning() << "Impossible de créer le répertoire temporaire pour les documents partiels";
-    } else {
-        qDebug() << "Répertoire temporaire pour les documents partiels créé:" << s_partielTempDir.path();
-    }
-    
-    if (!s_chapterTempDir.isValid()) {
-        qWarning() << "Impossible de créer le répertoire temporaire pour les chapitres";
-    } else {
-        qDebug() << "Répertoire temporaire pour les chapitres créé:" << s_chapterTempDir.path();
-    }
-    
-    if (!s_documentTempDir.isValid()) {
-        qWarning() << "Impossible de créer le répertoire temporaire pour le document complet";
-    } else {
-        qDebug() << "Répertoire temporaire pour le document complet créé:" << s_documentTempDir.path();
+// Vrai si l'un des fichiers (nom, chemin) figure parmi les chemins absolus donnés
+bool containsAnyFile(const QVector<QPair<QString, QString>>& files, const QSet<QString>& absolutePaths)
+{
+    for (const auto& file : files) {
+        if (absolutePaths.contains(QFileInfo(file.second).absoluteFilePath())) {
+            return true;
+        }
     }
+    return false;
+}
 
-    // Connecteur UNIQUEMENT pour le processus de document partiel
-    connect(m_processRunner, &ProcessRunner::processFinished, this, [this](int exitCode, QProcess::ExitStatus exitStatus)
-    {
-        qDebug() << "Processus PARTIEL terminé avec code:" << exitCode;
-        
-        // Si le processus s'est terminé avec une erreur
-        if (exitCode != 0) {
-            m_isCompiling = false;
-            emit compilationError("Erreur LaTeX détectée dans le document partiel. Code de sortie: " + QString::number(exitCode));
-            emit compilationFinished(false, "");
-            return;
+// Compteurs de départ d'un tronçon : ceux de la fin du précédent, sauf les
+// compteurs absolus du noyau (pages envoyées) propres à chaque compilation
+QString seedCounters(const QString& counters)
+{
+    QStringList lines;
+    const QStringList allLines = counters.split('\n', Qt::SkipEmptyParts);
+    for (const QString& line : allLines) {
+        if (!line.startsWith("\\setcounter{abspage}") && !line.startsWith("\\setcounter{totalpages}")) {
+            lines << line;
         }
-        
-        // Vérification explicite du document partiel
-        QString fullOutput = m_processRunner->fullOutput();
-        bool needsRerun = m_processRunner->needsRerun(fullOutput);
-        qDebug() << "Document partiel: besoin de recompiler =" << needsRerun << "(compilation" << m_compilationCount << "sur 5)";
-        
-        // Si le processus s'est terminé normalement mais nécessite une recompilation
-        if (m_compilationCount < 5 && needsRerun) {
-            m_compilationCount++;
-            
-            // Ajouter un séparateur entre les compilations
-            if (m_partialOutputWidget) {
-                m_partialOutputWidget->append("\n\n***********************************************");
-                m_partialOutputWidget->append(QString("************* %1-ième compilation du document partiel *************").arg(m_compilationCount));
-                m_partialOutputWidget->append("***********************************************\n\n");
+    }
+    return lines.isEmpty() ? QString() : lines.join('\n') + '\n';
+}
+
+} // namespace
+
+LatexAssembler::LatexAssembler(QObject* parent) : QObject(parent), m_isCompiling(false), m_isCompilingChapters(false), 
+                                                m_isCompilingFullDocument(false),
+                                                m_partialPool(new JobPool(this)),
+                                                m_chapterPool(new JobPool(this)),
+                                                m_documentPool(new JobPool(this)),
+                                                m_warmPool(new WarmWorkerPool(this)),
+                                                m_texCache(new TexCacheManager(this)),
+                                                m_figurePool(new JobPool(this)),
+                                                m_culpritFinder(new CulpritFinder(this))
+{
+    // Aperçu rapide pour le partiel, profil complet pour les chapitres et le document
+    m_profiles.insert(BuildTarget::Partial, CompileProfile::fastPreview());
+    m_profiles.insert(BuildTarget::Chapter, CompileProfile::full());
+    m_profiles.insert(BuildTarget::Document, CompileProfile::full());
+
+    // Moteur imposé à tous les profils (moteur factice des benchmarks, autre installation TeX...)
+    m_engineProgram = qEnvironmentVariable("COMPILATION_SELECTIVE_ENGINE");
+
+    // Relayer la sortie de chaque compilation vers le flux de sa cible
+    connect(m_partialPool, &JobPool::jobOutput, this, [this](const QString&, const QStringList& lines) {
+        emit outputLines(BuildTarget::Partial, lines);
+    });
+    connect(m_warmPool, &WarmWorkerPool::jobOutput, this, [this](const QString&, const QStringList& lines) {
+        emit outputLines(BuildTarget::Partial, lines);
+    });
+    connect(m_chapterPool, &JobPool::jobOutput, this, [this](const QString& chapterName, const QStringList& lines) {
+        // Avec plusieurs chapitres simultanés, préfixer chaque ligne par son chapitre
+        if (m_chapterPool->maxParallelJobs() > 1) {
+            QStringList taggedLines;
+            for (const QString& line : lines) {
+                taggedLines << QString("[%1] %2").arg(chapterName, line);
             }
-            
-            // Relancer la compilation du document partiel
-            QFileInfo tempFileInfo(m_currentTempFile);
-            QStringList args;
-            args << "-synctex=1"
-                 << "-shell-escape"
-                 << "-interaction=nonstopmode"
-                 << "-file-line-error"
-                 << m_currentTempFile;
-            
-            m_processRunner->runCommand("lualatex", args, m_partialOutputWidget, tempFileInfo.absolutePath());
-            emit compilationProgress(m_compilationCount, 5);
+            emit outputLines(BuildTarget::Chapter, taggedLines);
+        } else {
+            emit outputLines(BuildTarget::Chapter, lines);
         }
-        else {
-            m_isCompiling = false;
-            
-            if (exitCode == 0) {
-                // Renommer le fichier PDF final
-                QFileInfo tempFileInfo(m_currentTempFile);
-                QString baseName = tempFileInfo.completeBaseName();
-                QString pdfPath = tempFileInfo.absolutePath() + "/" + baseName + ".pdf";
-                
-                if (QFile::exists(pdfPath)) {
-                    QString finalPdfName = renameFinalPdf(m_currentTempFile, m_mainFilePath);
-                    if (!finalPdfName.isEmpty()) {
-                        emit compilationFinished(true, finalPdfName);
-                        emit pdfAvailable(finalPdfName);
-                    } else {
-                        emit compilationError("Erreur lors du renommage du PDF");
-                    }
-                }
-                else {
-                    emit compilationError("Le fichier PDF n'a pas été généré");
-                }
-            }
-            else {
-                emit compilationFinished(false, "");
+    });
+    connect(m_documentPool, &JobPool::jobOutput, this, [this](const QString& shardName, const QStringList& lines) {
+        // Tronçons simultanés : préfixer chaque ligne par son tronçon
+        if (!m_documentShards.isEmpty()) {
+            QStringList taggedLines;
+            for (const QString& line : lines) {
+                taggedLines << QString("[%1] %2").arg(shardName, line);
             }
+            emit outputLines(BuildTarget::Document, taggedLines);
+        } else {
+            emit outputLines(BuildTarget::Document, lines);
         }
-    }, Qt::QueuedConnection);
-    
-    // Connecteur UNIQUEMENT pour le processus de chapitres - complètement séparé
-    connect(m_chapterProcessRunner, &ProcessRunner::processFinished, this, [this](int exitCode, QProcess::ExitStatus exitStatus)
-    {
-        qDebug() << "Processus CHAPITRE terminé avec code:" << exitCode;
-        
-        // Si le processus s'est terminé avec une erreur
-        if (exitCode != 0) {
-            if (m_chapterOutputWidget) {
-                m_chapterOutputWidget->append("\n\n*** ERREUR dans la compilation du chapitre " + 
-                                         m_currentChapterName + " (code " + QString::number(exitCode) + ") ***\n");
-            }
-            emit chapterCompilationFinished(m_currentChapterName, false, "");
-            
-            // Passer au chapitre suivant MÊME EN CAS D'ERREUR
-            QMetaObject::invokeMethod(this, "processNextChapter", Qt::QueuedConnection);
-            return;
+    });
+
+    // Enregistrer les ressources consommées par chaque passe
+    connect(m_partialPool, &JobPool::jobPassFinished, this, [this](const QString&, int pass, const ProcessResult& result) {
+        recordPass("partiel", QString(), m_profiles.value(BuildTarget::Partial).name, pass, result);
+    });
+    connect(m_warmPool, &WarmWorkerPool::jobPassFinished, this, [this](const QString&, int pass, const ProcessResult& result) {
+        recordPass("partiel", "préchauffé", m_profiles.value(BuildTarget::Partial).name, pass, result);
+    });
+    connect(m_chapterPool, &JobPool::jobPassFinished, this, [this](const QString& chapterName, int pass, const ProcessResult& result) {
+        recordPass("chapitre", chapterName, m_profiles.value(BuildTarget::Chapter).name, pass, result);
+    });
+    connect(m_documentPool, &JobPool::jobPassFinished, this, [this](const QString& shardName, int pass, const ProcessResult& result) {
+        recordPass("document", m_documentShards.isEmpty() ? QString() : shardName,
+                   m_profiles.value(BuildTarget::Document).name, pass, result);
+    });
+
+    // Biber, makeindex et xindy lancés entre les passes (mesurés comme des passes)
+    const QVector<QPair<JobPool*, BuildTarget>> toolPools = {
+        { m_partialPool, BuildTarget::Partial },
+        { m_chapterPool, BuildTarget::Chapter },
+        { m_documentPool, BuildTarget::Document }
+    };
+    for (const auto& toolPool : toolPools) {
+        BuildTarget target = toolPool.second;
+        connect(toolPool.first, &JobPool::jobToolFinished, this,
+                [this, target](const QString& id, const QString& tool, int pass, const ProcessResult& result) {
+            recordPass("outil", QString("%1 (%2)").arg(tool, id), m_profiles.value(target).name, pass, result);
+        });
+    }
+
+    // Séparateurs et progression à chaque nouvelle passe
+    connect(m_partialPool, &JobPool::jobPassStarted, this, [this](const QString&, int pass) {
+        if (pass > 1) {
+            emit outputMessage(BuildTarget::Partial, "\n\n***********************************************");
+            emit outputMessage(BuildTarget::Partial, QString("************* %1-ième compilation du document partiel *************").arg(pass));
+            emit outputMessage(BuildTarget::Partial, "***********************************************\n\n");
         }
-        
-        // Vérification de recompilation du chapitre
-        QString fullOutput = m_chapterProcessRunner->fullOutput();
-        bool needsRerun = m_chapterProcessRunner->needsRerun(fullOutput);
-        qDebug() << "Chapitre" << m_currentChapterName << ": besoin de recompiler =" << needsRerun;
-        
-        if (exitCode == 0 && m_chapterCompilationCount < 5 && needsRerun) {
-            m_chapterCompilationCount++;
-            
-            // Ajouter un séparateur entre les compilations
-            if (m_chapterOutputWidget) {
-                m_chapterOutputWidget->append("\n\n***********************************************");
-                m_chapterOutputWidget->append(QString("************* %1-ième compilation de %2 *************")
-                                         .arg(m_chapterCompilationCount).arg(m_currentChapterName));
-                m_chapterOutputWidget->append("***********************************************\n\n");
-            }
-            
-            // Relancer la compilation du chapitre
-            QFileInfo tempFileInfo(m_currentChapterTempFile);
-            QStringList args;
-            args << "-synctex=1"
-                 << "-shell-escape"
-                 << "-interaction=nonstopmode"
-                 << "-file-line-error"
-                 << "-max-print-line=10000" // Ajouter cette option
-                 << m_currentChapterTempFile;
-
-            m_chapterProcessRunner->runCommand("lualatex", args, m_chapterOutputWidget, tempFileInfo.absolutePath());
-        }
-        else {
-            // Fin de la compilation pour ce chapitre
-            bool success = (exitCode == 0);
-            
-            if (success) {
-                // Renommer le PDF généré
-                QFileInfo tempFileInfo(m_currentChapterTempFile);
-                QString baseName = tempFileInfo.completeBaseName();
-                QString pdfPath = tempFileInfo.absolutePath() + "/" + baseName + ".pdf";
-                
-                if (QFile::exists(pdfPath)) {
-                    QString finalPdfName = renameChapterPdf(m_currentChapterTempFile, m_currentChapterName);
-                    if (!finalPdfName.isEmpty()) {
-                        emit chapterCompilationFinished(m_currentChapterName, true, finalPdfName);
-                        qDebug() << "Compilation du chapitre" << m_currentChapterName << "terminée avec succès";
-                    } else {
-                        emit chapterCompilationFinished(m_currentChapterName, false, "");
-                        qDebug() << "Erreur lors du renommage du PDF du chapitre" << m_currentChapterName;
-                    }
-                } else {
-                    emit chapterCompilationFinished(m_currentChapterName, false, "");
-                    qDebug() << "Le fichier PDF n'a pas été généré pour le chapitre" << m_currentChapterName;
-                }
-            }
-            else {
-                emit chapterCompilationFinished(m_currentChapterName, false, "");
-            }
-            
-            // Passer au chapitre suivant
-            QMetaObject::invokeMethod(this, "processNextChapter", Qt::QueuedConnection);
+        emit compilationProgress(pass, 5);
+    });
+    connect(m_chapterPool, &JobPool::jobPassStarted, this, [this](const QString& chapterName, int pass) {
+        if (pass > 1) {
+            emit outputMessage(BuildTarget::Chapter, "\n\n***********************************************");
+            emit outputMessage(BuildTarget::Chapter, QString("************* %1-ième compilation de %2 *************")
+                                                     .arg(pass).arg(chapterName));
+            emit outputMessage(BuildTarget::Chapter, "***********************************************\n\n");
+        }
+    });
+    connect(m_documentPool, &JobPool::jobPassStarted, this, [this](const QString& shardName, int pass) {
+        if (pass > 1) {
+            QString subject = m_documentShards.isEmpty() ? QString("du document complet") : "du tronçon " + shardName;
+            emit outputMessage(BuildTarget::Document, "\n\n***********************************************");
+            emit outputMessage(BuildTarget::Document, QString("************* %1-ième compilation %2 *************").arg(pass).arg(subject));
+            emit outputMessage(BuildTarget::Document, "***********************************************\n\n");
+            emit fullDocumentCompilationProgress(pass, 5);
         }
-    }, Qt::QueuedConnection);
+    });
 
-    // Connecteur UNIQUEMENT pour le processus de document complet
-    connect(m_fullDocumentProcessRunner, &ProcessRunner::processFinished, this, [this](int exitCode, QProcess::ExitStatus exitStatus)
-    {
-        qDebug() << "Processus DOCUMENT COMPLET terminé avec code:" << exitCode;
-        
-        // Si le processus s'est terminé avec une erreur
-        if (exitCode != 0) {
-            m_isCompilingFullDocument = false;
-            emit compilationError("Erreur LaTeX détectée dans le document complet. Code de sortie: " + QString::number(exitCode));
-            emit fullDocumentCompilationFinished(false, "");
+    // Début de la compilation d'un chapitre
+    connect(m_chapterPool, &JobPool::jobStarted, this, [this](const QString& chapterName) {
+        // Tronçon d'un chapitre : le chapitre a été annoncé à sa mise en file
+        if (m_chapterOfShard.contains(chapterName)) {
+            emit outputMessage(BuildTarget::Chapter, QString("\n\n***********   TRONÇON : %1       **************\n\n")
+                                                     .arg(chapterName));
             return;
         }
-        
-        // Vérification de recompilation
-        QString fullOutput = m_fullDocumentProcessRunner->fullOutput();
-        bool needsRerun = m_fullDocumentProcessRunner->needsRerun(fullOutput);
-        qDebug() << "Document complet: besoin de recompiler =" << needsRerun << "(compilation" << m_fullDocumentCompilationCount << "sur 5)";
-        
-        if (m_fullDocumentCompilationCount < 5 && needsRerun) {
-            m_fullDocumentCompilationCount++;
-            
-            // Ajouter un séparateur entre les compilations
-            if (m_fullDocumentOutputWidget) {
-                m_fullDocumentOutputWidget->append("\n\n***********************************************");
-                m_fullDocumentOutputWidget->append(QString("************* %1-ième compilation du document complet *************").arg(m_fullDocumentCompilationCount));
-                m_fullDocumentOutputWidget->append("***********************************************\n\n");
-            }
-            
-            // Relancer la compilation du document complet
-            QFileInfo tempFileInfo(m_fullDocumentTempFile);
-            QStringList args;
-            args << "-synctex=1"
-                 << "-shell-escape"
-                 << "-interaction=nonstopmode"
-                 << "-file-line-error"
-                 << "-max-print-line=10000" // Ajouter cette option
-                 << m_fullDocumentTempFile;
-
-            m_fullDocumentProcessRunner->runCommand("lualatex", args, m_fullDocumentOutputWidget, tempFileInfo.absolutePath());
-            emit fullDocumentCompilationProgress(m_fullDocumentCompilationCount, 5);
-        }
-        else {
-            m_isCompilingFullDocument = false;
-            
-            if (exitCode == 0) {
-                // Renommer le fichier PDF final
-                QFileInfo tempFileInfo(m_fullDocumentTempFile);
-                QString baseName = tempFileInfo.completeBaseName();
-                QString pdfPath = tempFileInfo.absolutePath() + "/" + baseName + ".pdf";
-                
-                if (QFile::exists(pdfPath)) {
-                    QString finalPdfName = renameFullDocumentPdf(m_fullDocumentTempFile);
-                    if (!finalPdfName.isEmpty()) {
-                        emit fullDocumentCompilationFinished(true, finalPdfName);
-                        emit pdfAvailable(finalPdfName);
-                    } else {
-                        emit fullDocumentCompilationFinished(false, "");
-                    }
-                }
-                else {
-                    emit compilationError("Le fichier PDF n'a pas été généré pour le document complet");
-                    emit fullDocumentCompilationFinished(false, "");
-                }
-            }
-            else {
-                emit fullDocumentCompilationFinished(false, "");
-            }
+        qDebug() << "Traitement du chapitre:" << chapterName;
+
+        // Afficher un séparateur pour ce chapitre
+        emit outputMessage(BuildTarget::Chapter, "\n\n*******************************************************");
+        emit outputMessage(BuildTarget::Chapter, QString("***********   CHAPITRE : %1       **************").arg(chapterName));
+        emit outputMessage(BuildTarget::Chapter, "*******************************************************\n\n");
+
+        emit chapterCompilationStarted(chapterName);
+    });
+
+    // Figures TikZ manquantes : une par cœur, les cibles attendent la fin de la génération
+    m_figurePool->setMaxParallelJobs(QThread::idealThreadCount());
+    connect(m_figurePool, &JobPool::jobPassFinished, this, [this](const QString& id, int pass, const ProcessResult& result) {
+        recordPass("figure", id.mid(int(qstrlen("figure_"))), m_profiles.value(BuildTarget::Document).name, pass, result);
+    });
+    connect(m_figurePool, &JobPool::jobFinished, this, &LatexAssembler::onFigureJobFinished);
+    connect(m_figurePool, &JobPool::allJobsFinished, this, [this]() {
+        emitToWaitingTargets(QString("Figures TikZ : %1 générée(s), %2 en échec, en %3 s\n")
+                             .arg(m_figuresGenerated).arg(m_figureFailures)
+                             .arg(m_figureClock.elapsed() / 1000.0, 0, 'f', 1));
+        releasePools();
+    });
+
+    // Compilations retenues pendant la mise à jour du cache des polices
+    connect(m_texCache, &TexCacheManager::warmUpFinished, this, &LatexAssembler::onTexCacheWarmUpFinished);
+
+    // Fin des compilations, par cible
+    connect(m_partialPool, &JobPool::jobFinished, this,
+            [this](const QString&, bool success, int exitCode, const QString& pdfPath) {
+        onPartialJobFinished(success, exitCode, pdfPath);
+    });
+    connect(m_warmPool, &WarmWorkerPool::jobFinished, this,
+            [this](const QString&, bool success, int exitCode, const QString& pdfPath) {
+        onPartialJobFinished(success, exitCode, pdfPath);
+    });
+    connect(m_chapterPool, &JobPool::jobFinished, this, &LatexAssembler::onChapterJobFinished);
+    connect(m_chapterPool, &JobPool::allJobsFinished, this, [this]() {
+        // D'autres pilotes de chapitres sont encore en cours d'écriture
+        if (m_chapterAssemblies > 0) {
+            return;
+        }
+        m_isCompilingChapters = false;
+        emit allChaptersCompiled();
+        finishBuildIfIdle();
+    });
+    // Recherche du fichier en cause : bilan dans le flux de la cible examinée
+    connect(m_culpritFinder, &CulpritFinder::progress, this, [this](const QString& message) {
+        emit outputMessage(m_culpritTarget, message);
+    });
+    connect(m_culpritFinder, &CulpritFinder::finished, this,
+            [this](const QStringList& culprits, const QString& summary) {
+        emit outputMessage(m_culpritTarget, "=== " + summary + " ===");
+        for (const QString& culprit : culprits) {
+            emit outputMessage(m_culpritTarget, "  " + culprit);
+        }
+        emit culpritSearchFinished(m_culpritTarget, culprits, summary);
+    });
+    connect(m_documentPool, &JobPool::jobFinished, this,
+            [this](const QString& id, bool success, int exitCode, const QString& pdfPath) {
+        if (!m_documentShards.isEmpty()) {
+            onShardJobFinished(id, success, exitCode, pdfPath);
+        } else {
+            onDocumentJobFinished(success, exitCode, pdfPath);
         }
-    }, Qt::QueuedConnection);
+    });
 }
 
 LatexAssembler::~LatexAssembler()
@@ -305,11 +266,13 @@ LatexAssembler::~LatexAssembler()
     }
     
     // Les répertoires temporaires seront nettoyés automatiquement
-    // par les destructeurs de s_partielTempDir, s_chapterTempDir et s_documentTempDir
+    // avec la racine de compilation (BuildRoot)
 }
 
 QString LatexAssembler::extractPreamble(const QString& filePath)
 {
+    TraceScope trace("assemblage", "extraction du préambule");
+    
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         return QString();
@@ -332,234 +295,536 @@ QString LatexAssembler::extractPreamble(const QString& filePath)
     return preamble;
 }
 
-QVector<QPair<QString, QString>> LatexAssembler::collectSelectedFiles(LatexModel* model)
+QString LatexAssembler::createUnitDriver(const QString& jobDir, const QString& preamble,
+                                         const QVector<IncludeUnit>& units, const QStringList& includeOnly)
 {
-    QVector<QPair<QString, QString>> selectedFiles;
+    TraceScope trace("assemblage", "pilote \\include");
+    trace.setArg("unites", units.size());
+    trace.setArg("incluses", includeOnly.isEmpty() ? units.size() : includeOnly.size());
+    
+    QString driverPath = jobDir + "/" + IncludeUnitCache::driverBaseName() + ".tex";
+    QFile driverFile(driverPath);
+    if (!driverFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        emit compilationError("Impossible de créer le fichier pilote " + driverPath);
+        return QString();
+    }
     
-    // Fonction récursive simple
-    std::function<void(const QModelIndex&)> collectFiles = [&](const QModelIndex& parent) {
-        for (int i = 0; i < model->rowCount(parent); ++i) {
-            QModelIndex index = model->index(i, 0, parent);
-            Qt::CheckState state = static_cast<Qt::CheckState>(model->data(index, Qt::CheckStateRole).toInt());
-            
-            QString nodeName = model->data(index, Qt::DisplayRole).toString();
-            QString nodePath = model->data(index, Qt::ToolTipRole).toString();
-            
-            // Si le nœud est coché ou partiellement coché
-            if (state == Qt::Checked || state == Qt::PartiallyChecked) {
-                
-                // Si c'est un fichier .tex qui existe
-                if (!nodePath.isEmpty() && QFile::exists(nodePath) && nodePath.endsWith(".tex")) {
-                    
-                    // RÈGLE SIMPLE: Exclure UNIQUEMENT les fichiers qui se terminent par "_cours.tex"
-                    if (nodePath.endsWith("_cours.tex")) {
-                        qDebug() << "Fichier _cours exclu de la compilation partielle:" << nodePath;
-                    } else {
-                        // Ajouter tous les autres fichiers .tex
-                        selectedFiles.append(qMakePair(nodeName, nodePath));
-                        qDebug() << "Fichier ajouté à la compilation partielle:" << nodePath;
-                    }
-                }
-                
-                // Explorer récursivement les enfants dans tous les cas (dossiers ou fichiers _cours)
-                if (model->hasChildren(index)) {
-                    collectFiles(index);
-                }
+    QTextStream out(&driverFile);
+    out << preamble;
+    
+    // Toutes les unités restent listées : les autres gardent leurs compteurs via leur .aux
+    if (!includeOnly.isEmpty()) {
+        out << "\\includeonly{" << includeOnly.join(",") << "}\n\n";
+    }
+    
+    // Document complet en mode découpage : début de chaque chapitre noté dans les .aux
+    bool chapterMarkers = includeOnly.isEmpty() && !m_documentChapterByFile.isEmpty();
+    if (chapterMarkers) {
+        DriverWriter::writeChapterMarkerSetup(out);
+    }
+    
+    // Chemins d'images, en-têtes et pieds de page, début du document
+    DriverWriter::writeDocumentSetup(out, m_mainFilePath);
+    
+    QString currentChapter;
+    for (const IncludeUnit& unit : units) {
+        if (chapterMarkers) {
+            DriverWriter::writeChapterMarker(out, unit.sourcePath, m_documentChapterByFile,
+                                             &currentChapter, &m_documentChapterOrder);
+        }
+        out << "\\include{" << unit.name << "}\n";
+    }
+    
+    out << "\n\\end{document}\n";
+    driverFile.close();
+    
+    qDebug() << "Fichier pilote \\include créé:" << driverPath;
+    return driverPath;
+}
+
+QString LatexAssembler::createIncludeOnlyDocument(const QString& jobDir, const QString& preamble,
+                                                  const QVector<QPair<QString, QString>>& files, BuildTarget target)
+{
+    IncludeUnitCache cache(m_mainFilePath);
+    if (!cache.isReady()) {
+        emit outputMessage(target, "Mode \\includeonly : aucun document complet compilé en unités, "
+                                   "assemblage classique.");
+        return QString();
+    }
+    
+    // Chaque fichier choisi doit être une unité du dernier document complet
+    QHash<QString, QString> unitBySource;
+    const QVector<IncludeUnit> units = cache.units();
+    for (const IncludeUnit& unit : units) {
+        unitBySource.insert(unit.sourcePath, unit.name);
+    }
+    
+    QStringList includedUnits;
+    for (const auto& file : files) {
+        QString sourcePath = QFileInfo(file.second).absoluteFilePath();
+        if (!unitBySource.contains(sourcePath)) {
+            emit outputMessage(target, "Mode \\includeonly : " + sourcePath +
+                                       " absent du dernier document complet, assemblage classique.");
+            return QString();
+        }
+        includedUnits.append(unitBySource.value(sourcePath));
+    }
+    
+    auto figures = [this, &preamble](const QString& content) { return substituteFigures(content, preamble); };
+    if (!cache.prepareJobDir(jobDir, units, includedUnits, true, figures)) {
+        emit outputMessage(target, "Mode \\includeonly : préparation impossible, assemblage classique.");
+        return QString();
+    }
+    
+    return createUnitDriver(jobDir, preamble, units, includedUnits);
+}
+
+BuildPlan LatexAssembler::planBuild(LatexModel* model)
+{
+    if (model != m_planModel) {
+        if (m_planModel) {
+            disconnect(m_planModel, nullptr, this, nullptr);
+        }
+        // Cases cochées ou arbre rechargé : le plan est à refaire
+        connect(model, &QAbstractItemModel::dataChanged, this, &LatexAssembler::invalidateBuildPlan);
+        connect(model, &QAbstractItemModel::modelReset, this, &LatexAssembler::invalidateBuildPlan);
+        connect(model, &QObject::destroyed, this, [this]() {
+            m_planModel = nullptr;
+            invalidateBuildPlan();
+        });
+        m_planModel = model;
+    }
+    
+    m_fileStats.clear();
+    m_buildPlan = BuildPlanner(m_fileStats).plan(model->rootNode());
+    m_buildPlanValid = true;
+    return m_buildPlan;
+}
+
+const BuildPlan& LatexAssembler::buildPlan(LatexModel* model)
+{
+    if (!m_buildPlanValid || model != m_planModel) {
+        planBuild(model);
+    }
+    return m_buildPlan;
+}
+
+void LatexAssembler::invalidateBuildPlan()
+{
+    m_buildPlanValid = false;
+}
+
+bool LatexAssembler::findCulprit(LatexModel* model, BuildTarget target, const QString& chapterName)
+{
+    if (m_mainFilePath.isEmpty()) {
+        emit compilationError("Aucun fichier principal pour la recherche du fichier en cause");
+        return false;
+    }
+    prepareBuildRoot();
+    
+    // Fichiers de la cible, tels que la compilation les assemble
+    const BuildPlan& plan = buildPlan(model);
+    QVector<QPair<QString, QString>> files;
+    switch (target) {
+    case BuildTarget::Partial:
+        files = plan.partialFiles;
+        break;
+    case BuildTarget::Chapter:
+        for (const ChapterInfo& chapter : plan.chapters) {
+            if (chapter.name == chapterName) {
+                files = chapter.files;
             }
         }
-    };
+        break;
+    case BuildTarget::Document:
+        files = plan.documentFiles;
+        break;
+    }
+    if (files.isEmpty()) {
+        emit compilationError("Aucun fichier à examiner pour la recherche du fichier en cause");
+        return false;
+    }
     
-    // Commencer la collecte depuis la racine
-    collectFiles(QModelIndex());
+    QString preamble = extractPreamble(m_mainFilePath);
+    if (preamble.isEmpty()) {
+        emit compilationError("Impossible de lire le préambule du document");
+        return false;
+    }
     
-    qDebug() << "=== RÉSUMÉ COMPILATION PARTIELLE ===";
-    qDebug() << "Total des fichiers collectés:" << selectedFiles.size();
-    for (const auto& file : selectedFiles) {
-        qDebug() << "Fichier à inclure:" << file.first << "-" << file.second;
+    QTemporaryDir& tempDir = target == BuildTarget::Partial ? partielTempDir()
+                           : target == BuildTarget::Chapter ? chapterTempDir() : documentTempDir();
+    if (!tempDir.isValid()) {
+        emit compilationError("Impossible de créer un répertoire temporaire");
+        return false;
     }
     
-    return selectedFiles;
+    // Passes de la cible : une erreur qui n'apparaît qu'à une relance (.aux, index)
+    // est cherchée comme le reste
+    auto specFor = [this, target](const QString& id, const QString& texFile) {
+        return jobSpec(target, id, texFile);
+    };
+    m_culpritTarget = target;
+    return m_culpritFinder->start(tempDir.path() + "/coupable", m_mainFilePath, preamble, files, specFor);
 }
 
 QString LatexAssembler::createPartialDocument(const QString& filePath, LatexModel* model)
 {
     // Stockez le chemin du fichier principal pour référence future
     m_mainFilePath = filePath;
+    prepareBuildRoot();
     
+    // Nouvelle compilation : arbre et fichiers relus une seule fois pour toutes les cibles
+    planBuild(model);
+    
+    DriverRequest request;
+    QString driver;
+    if (!preparePartialDriver(model, &request, &driver) || !driver.isEmpty()) {
+        return driver;
+    }
+    
+    DriverResult result = DriverWriter::write(request);
+    driver = adoptDriver(BuildTarget::Partial, result);
+    if (!driver.isEmpty()) {
+        writeWarmPartialBody(driver, result.setup, result.body);
+    }
+    return driver;
+}
+
+bool LatexAssembler::buildPartialDocument(const QString& filePath, LatexModel* model,
+                                          bool compileChapter, bool compileDocument)
+{
+    m_mainFilePath = filePath;
+    prepareBuildRoot();
+    planBuild(model);
+    return startPartialDocument(model, compileChapter, compileDocument);
+}
+
+bool LatexAssembler::preparePartialDriver(LatexModel* model, DriverRequest* request, QString* readyDriver)
+{
     // Extraire le préambule
-    QString preamble = extractPreamble(filePath);
+    QString preamble = extractPreamble(m_mainFilePath);
     if (preamble.isEmpty()) {
         emit compilationError("Impossible de lire le préambule du document");
-        return QString();
+        return false;
     }
     
     // Collecter les nœuds sélectionnés
-    QVector<QPair<QString, QString>> selectedFiles = collectSelectedFiles(model);
+    QVector<QPair<QString, QString>> selectedFiles = buildPlan(model).partialFiles;
     if (selectedFiles.isEmpty()) {
         emit compilationError("Aucun fichier sélectionné");
-        return QString();
+        return false;
     }
     
     // Créer un fichier temporaire dans le répertoire des documents partiels
-    if (!s_partielTempDir.isValid()) {
+    if (!partielTempDir().isValid()) {
         emit compilationError("Impossible de créer un répertoire temporaire");
-        return QString();
+        return false;
     }
     
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-    QString tempFileName = s_partielTempDir.path() + "/temp_partial_" + timestamp + ".tex";
+    trackDependencies("partiel", selectedFiles);
     
-    // Créer le fichier et écrire son contenu
-    QFile tempFile(tempFileName);
-    if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        emit compilationError("Impossible de créer le fichier temporaire");
-        return QString();
+    // Mode \includeonly : numérotation du dernier document complet
+    if (m_includeOnlyMode) {
+        if (!passesPreflight(BuildTarget::Partial, "du partiel", selectedFiles)) {
+            return false;
+        }
+        *readyDriver = createIncludeOnlyDocument(partielTempDir().path() + "/unites", preamble,
+                                                 selectedFiles, BuildTarget::Partial);
+        if (!readyDriver->isEmpty()) {
+            return true;
+        }
     }
     
-    QTextStream out(&tempFile);
-    
-    // Écrire le préambule
-    out << preamble;
+    *request = driverRequest(BuildTarget::Partial, "partiel", preamble, selectedFiles);
+    return true;
+}
+
+bool LatexAssembler::startPartialDocument(LatexModel* model, bool compileChapter, bool compileDocument)
+{
+    DriverRequest request;
+    QString driver;
+    if (!preparePartialDriver(model, &request, &driver)) {
+        return false;
+    }
+    if (!driver.isEmpty()) {
+        compilePartialDocument(driver, compileChapter, compileDocument);
+        return true;
+    }
     
-    // Obtenir le chemin absolu du dossier contenant le fichier principal
-    QFileInfo mainFileInfo(filePath);
-    QString mainDirPath = mainFileInfo.absolutePath();
-    
-    // Ajouter la configuration des chemins d'images
-    out << "% Configuration des chemins d'images pour le document temporaire\n";
-    out << "\\graphicspath{{"
-        << QDir::toNativeSeparators(mainDirPath + "/images/").replace("\\", "/") << "}{"
-        << QDir::toNativeSeparators(mainDirPath + "/../images/").replace("\\", "/") << "}}\n\n";
-    
-    // Ajouter la configuration des en-têtes et pieds de page
-    out << "% Configuration des en-têtes et pieds de page\n";
-    out << "\\lhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\monetablissement}}}} %haut de page gauche\n";
-    out << "\\chead{} %haut de page centre\n";
-    out << "\\rhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\maclasse}}}} %haut de page droit\n";
-    out << "\\lfoot{} %pied de page gauche\n";
-    out << "\\cfoot{\\textcolor{gris50}{\\small\\textit{page \\thepage}}} % pied de page centré\n";
-    out << "\\rfoot{} %On personnalisera cette en-tête\n";
-    out << "\\def\\headrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
-    out << "\\def\\footrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
-    out << "\\pagestyle{empty}\n\n";
-    
-    // Début du document
-    out << "\\begin{document}\n\n";
-    
-    // Ajouter la configuration de l'espacement
-    out << "\\singlespacing\\setlength{\\parindent}{0pt}\n\n";
-    
-    // Ajouter le contenu des fichiers sélectionnés
-    for (const auto& file : selectedFiles) {
-        QFile inputFile(file.second);
-        if (inputFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            out << "% Contenu du fichier: " << file.second << "\n";
-            out << inputFile.readAll() << "\n\n";
-            inputFile.close();
+    // Le partiel est actif dès l'assemblage : il peut être arrêté, et la
+    // compilation ne se termine pas avant son lancement
+    markBuildStarted();
+    m_isCompiling = true;
+    assembleInBackground(request, [this, compileChapter, compileDocument](const DriverResult& result) {
+        m_isCompiling = false;
+        QString driver = adoptDriver(BuildTarget::Partial, result);
+        if (driver.isEmpty()) {
+            m_deferredTargets = DeferredTargets();
+            finishBuildIfIdle();
+            return;
         }
+        writeWarmPartialBody(driver, result.setup, result.body);
+        compilePartialDocument(driver, compileChapter, compileDocument);
+    });
+    return true;
+}
+
+DriverRequest LatexAssembler::driverRequest(BuildTarget target, const QString& id, const QString& preamble,
+                                            const QVector<QPair<QString, QString>>& files)
+{
+    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+    
+    DriverRequest request;
+    request.id = id;
+    request.preamble = preamble;
+    request.mainFilePath = m_mainFilePath;
+    request.files = files;
+    switch (target) {
+    case BuildTarget::Partial:
+        request.label = "du partiel";
+        request.path = partielTempDir().path() + "/temp_partial_" + timestamp + ".tex";
+        request.keepParts = true;
+        break;
+    case BuildTarget::Chapter:
+        request.label = "du chapitre " + id;
+        request.path = chapterTempDir().path() + "/temp_" + id + "_" + timestamp + ".tex";
+        break;
+    case BuildTarget::Document:
+        request.label = "du document complet";
+        request.path = documentTempDir().path() + "/temp_full_document_" + timestamp + ".tex";
+        request.chapterByFile = m_documentChapterByFile;
+        break;
     }
     
-    // Fin du document
-    out << "\\end{document}\n";
+    request.preflight = m_preflightChecks;
     
-    tempFile.close();
+    // Les figures relevées seront générées avec ce préambule
+    request.tikzFigures = m_tikzFigureCache;
+    if (m_tikzFigureCache) {
+        m_figureCache.setPreamble(preamble);
+    }
+    return request;
+}
+
+void LatexAssembler::assembleInBackground(const DriverRequest& request,
+                                          const std::function<void(const DriverResult&)>& done)
+{
+    int generation = m_assemblyGeneration;
+    QtConcurrent::run(&DriverWriter::write, request).then(this, [this, generation, done](const DriverResult& result) {
+        // Compilation arrêtée pendant l'écriture : pilote abandonné
+        if (generation != m_assemblyGeneration) {
+            return;
+        }
+        done(result);
+    });
+}
+
+QString LatexAssembler::adoptDriver(BuildTarget target, const DriverResult& result)
+{
+    if (result.path.isEmpty()) {
+        reportPreflightIssues(target, result.error, result.issues);
+        emit compilationError(result.error);
+        return QString();
+    }
     
-    qDebug() << "Fichier temporaire partiel créé:" << tempFileName;
+    m_figureCache.addMissingFigures(result.missingFigures);
+    
+    // Fichiers temporaires à nettoyer, par cible
+    switch (target) {
+    case BuildTarget::Partial:
+        m_partielTempFiles.append(result.path);
+        break;
+    case BuildTarget::Chapter:
+        m_chapterTempFiles.append(result.path);
+        break;
+    case BuildTarget::Document:
+        m_documentTempFiles.append(result.path);
+        m_documentChapterOrder = result.chapterOrder;
+        break;
+    }
+    return result.path;
+}
+
+void LatexAssembler::reportPreflightIssues(BuildTarget target, const QString& error,
+                                           const QVector<PreflightIssue>& issues)
+{
+    if (issues.isEmpty()) {
+        return;
+    }
     
-    // Ajouter à la liste des fichiers temporaires partiels
-    m_partielTempFiles.append(tempFileName);
+    // Les premiers problèmes suffisent : un oubli en entraîne souvent d'autres
+    const int maxIssues = 50;
+    emit outputMessage(target, "=== " + error + " ===");
+    for (int i = 0; i < issues.size() && i < maxIssues; ++i) {
+        emit outputMessage(target, issues.at(i).toString());
+    }
+    if (issues.size() > maxIssues) {
+        emit outputMessage(target, QString("... et %1 autre(s)").arg(issues.size() - maxIssues));
+    }
+}
+
+bool LatexAssembler::passesPreflight(BuildTarget target, const QString& label,
+                                     const QVector<QPair<QString, QString>>& files)
+{
+    if (!m_preflightChecks) {
+        return true;
+    }
     
-    return tempFileName;
+    TraceScope trace("assemblage", "vérification préalable " + label);
+    QVector<PreflightIssue> issues = PreflightChecker::check(files, QFileInfo(m_mainFilePath).absolutePath());
+    trace.setArg("problemes", issues.size());
+    if (issues.isEmpty()) {
+        return true;
+    }
+    
+    QString error = QString("Vérification préalable %1 en échec : %2 problème(s)").arg(label).arg(issues.size());
+    reportPreflightIssues(target, error, issues);
+    emit compilationError(error);
+    return false;
 }
 
-void LatexAssembler::compilePartialDocument(const QString& tempFilePath, QTextEdit* outputWidget, 
-                                           bool compileChapter, bool compileDocument)
+void LatexAssembler::compilePartialDocument(const QString& tempFilePath, bool compileChapter, bool compileDocument)
 {
     // Mettre à jour l'état et les variables
+    markBuildStarted();
     m_isCompiling = true;
     m_currentTempFile = tempFilePath;
-    m_compilationCount = 1;
-    
-    // IMPORTANT: Garder une référence explicite au widget de sortie pour éviter le mélange
-    m_partialOutputWidget = outputWidget;
     
     emit compilationStarted();
-    emit compilationProgress(m_compilationCount, 5);
     
-    // Configuration des arguments pour LuaLaTeX
-    QStringList args;
-    args << "-synctex=1"
-         << "-shell-escape"
-         << "-interaction=nonstopmode"
-         << "-file-line-error"
-         << "-max-print-line=10000" // Ajouter cette option
-         << tempFilePath;
-
-    QFileInfo tempFileInfo(tempFilePath);
+    // Lancer la compilation (les relances sont gérées par CompileJob)
+    CompileJobSpec spec = jobSpec(BuildTarget::Partial, "partiel", tempFilePath);
+    
+    startFigureGeneration(BuildTarget::Partial);
+    
+    // Processus préchauffé sur ce préambule : il ne reste que le corps à composer
+    // (sauf si les cibles attendent le cache des polices ou des figures)
+    if (!m_warmPartial.bodyFile.isEmpty() && m_warmPartial.tempFile == tempFilePath && m_poolHolds == 0) {
+        QString warmDriver = m_warmPool->dispatch(spec, m_warmPartial.setup, m_warmPartial.bodyFile);
+        if (!warmDriver.isEmpty()) {
+            emit outputMessage(BuildTarget::Partial, "Composition dans un processus préchauffé (préambule déjà chargé)\n");
+            emit compilationProgress(1, 5);
+            m_currentTempFile = warmDriver;
+            return;
+        }
+    }
     
-    // Lancer le processus
-    m_processRunner->runCommand("lualatex", args, m_partialOutputWidget, tempFileInfo.absolutePath());
+    m_partialPool->enqueue(spec);
+}
+
+void LatexAssembler::setWarmWorkers(int count)
+{
+    m_warmPool->setSize(count);
+    if (count <= 0) {
+        m_warmPartial = WarmPartial();
+    }
+}
+
+bool LatexAssembler::canUseWarmWorkers() const
+{
+    // Une seule passe : un processus préchauffé ne peut pas relancer la composition
+    CompileJobSpec spec = jobSpec(BuildTarget::Partial, "partiel", QString());
+    return m_warmPool->size() > 0 && spec.maxPasses == 1 && WarmWorkerPool::supportsEngine(spec.program);
+}
+
+void LatexAssembler::writeWarmPartialBody(const QString& tempFileName, const QString& setup, const QString& body)
+{
+    m_warmPartial = WarmPartial();
+    if (!canUseWarmWorkers()) {
+        return;
+    }
+
+    QString warmDir = partielTempDir().path() + "/chauds";
+    if (!QDir().mkpath(warmDir)) {
+        qWarning() << "Impossible de créer le répertoire des processus préchauffés" << warmDir;
+        return;
+    }
+
+    QString bodyFileName = warmDir + "/corps_" + QFileInfo(tempFileName).completeBaseName() + ".tex";
+    QFile bodyFile(bodyFileName);
+    if (!bodyFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Impossible de créer le corps du partiel" << bodyFileName;
+        return;
+    }
+    bodyFile.write(body.toUtf8());
+    bodyFile.close();
+    m_partielTempFiles.append(bodyFileName);
+
+    m_warmPartial.tempFile = tempFileName;
+    m_warmPartial.setup = setup;
+    m_warmPartial.bodyFile = bodyFileName;
+}
+
+void LatexAssembler::prepareWarmWorkers()
+{
+    if (m_warmPartial.setup.isEmpty() || !canUseWarmWorkers()) {
+        return;
+    }
+    m_warmPool->prepare(jobSpec(BuildTarget::Partial, "partiel", QString()), m_warmPartial.setup,
+                        partielTempDir().path() + "/chauds");
 }
 
 QString LatexAssembler::renameFinalPdf(const QString& tempFilePath, const QString& mainFilePath)
 {
-    // Obtenir les informations sur les fichiers
-    QFileInfo tempFileInfo(tempFilePath);
-    QFileInfo mainFileInfo(mainFilePath);
+    TraceScope trace("publication", "publication du partiel", "partiel");
     
     // S'assurer qu'on utilise le vrai chemin du document principal
+    QFileInfo mainFileInfo(mainFilePath);
     if (mainFilePath.isEmpty() || !mainFileInfo.exists()) {
         return QString(); // Impossible de renommer sans chemin valide
     }
     
-    // Récupérer le nom de fichier principal (sans extension)
-    QString baseName = mainFileInfo.completeBaseName();
-    
-    // Générer un timestamp formaté
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy_MM_dd_HH_mm_ss");
-    
-    // Chemin du nouveau fichier PDF dans le même répertoire que le document principal
-    QString newPdfName = mainFileInfo.absolutePath() + "/" + baseName + "_partiel_" + timestamp + ".pdf";
-    
-    // Chemin du PDF original généré
-    QString originalPdf = tempFileInfo.absolutePath() + "/" + tempFileInfo.completeBaseName() + ".pdf";
-    
-    if (QFile::exists(originalPdf)) {
-        // Copier le fichier vers sa destination finale
-        if (QFile::copy(originalPdf, newPdfName)) {
-            // Supprimer l'original si la copie a réussi
-            QFile::remove(originalPdf);
-            
-            // Stocker le chemin du dernier PDF généré
-            m_lastPdfPath = newPdfName;
-            
-            return newPdfName;
-        }
+    QString newPdfName = publishPdf(tempFilePath, mainFileInfo.completeBaseName() + "_partiel", BuildTarget::Partial);
+    if (!newPdfName.isEmpty()) {
+        // Stocker le chemin du dernier PDF généré
+        m_lastPdfPath = newPdfName;
     }
-    
-    return QString(); // Retourner une chaîne vide en cas d'échec
+    return newPdfName;
 }
 
 void LatexAssembler::stopCompilation()
 {
+    m_deferredTargets = DeferredTargets();
+    
+    // Pilotes en cours d'écriture : abandonnés à la fin de leur tâche
+    ++m_assemblyGeneration;
+    m_chapterAssemblies = 0;
+    m_culpritFinder->stop();
+    
+    // Figures encore en file : plus de fin de génération pour libérer les cibles
+    bool figuresPending = m_figurePool->isBusy();
+    m_figurePool->stop();
+    if (figuresPending && m_figurePool->runningCount() == 0) {
+        m_figuresInProgress.clear();
+        releasePools();
+    }
+
     if (m_isCompiling) {
-        m_processRunner->stopProcess();
+        m_partialPool->stop();
+        m_warmPool->stop();
         m_isCompiling = false;
     }
     
+    // Vide aussi la file d'attente des chapitres
     if (m_isCompilingChapters) {
-        m_chapterProcessRunner->stopProcess();
+        m_chapterPool->stop();
         m_isCompilingChapters = false;
     }
     
     if (m_isCompilingFullDocument) {
-        m_fullDocumentProcessRunner->stopProcess();
+        m_documentPool->stop();
+        m_documentShards.clear();
         m_isCompilingFullDocument = false;
     }
     
-    // Vider la file d'attente
-    QMutexLocker locker(&m_mutex);
-    m_chapterQueue.clear();
+    // Chapitres attendus du document et tronçons de chapitres : plus aucun résultat à fusionner
+    m_pendingChapterExtracts.clear();
+    m_documentChapterOrder.clear();
+    m_chapterShards.clear();
+    m_chapterOfShard.clear();
+    
+    // Les tâches abandonnées ne rappelleront pas finishBuildIfIdle : clore la compilation ici
+    finishBuildIfIdle();
 }
 
 bool LatexAssembler::isCompiling() const
@@ -567,324 +832,790 @@ bool LatexAssembler::isCompiling() const
     return m_isCompiling;
 }
 
-QVector<LatexAssembler::ChapterInfo> LatexAssembler::identifyChaptersToCompile(LatexModel* model)
+void LatexAssembler::setProfile(BuildTarget target, const CompileProfile& profile)
 {
-    QVector<ChapterInfo> chapters;
-    QMap<QString, ChapterInfo> chapterMap; // Pour regrouper les fichiers par chapitre
-    QSet<QString> chaptersToCompile; // Pour marquer les chapitres qui doivent être compilés
-    
-    // Première passe : identifier les chapitres qui ont des fichiers cochés
-    std::function<void(const QModelIndex&, const QString&)> identifySelectedChapters = 
-    [&](const QModelIndex& parent, const QString& currentChapter) {
-        for (int i = 0; i < model->rowCount(parent); ++i) {
-            QModelIndex index = model->index(i, 0, parent);
-            Qt::CheckState state = static_cast<Qt::CheckState>(model->data(index, Qt::CheckStateRole).toInt());
-            
-            QString nodeName = model->data(index, Qt::DisplayRole).toString();
-            
-            // Si c'est un nœud de premier niveau (chapitre)
-            if (parent == QModelIndex() && nodeName != "PEDA" && nodeName != "DOCS" && nodeName != "EVALS") {
-                // Passer en paramètre le nom du chapitre
-                identifySelectedChapters(index, nodeName);
-            }
-            else if (parent != QModelIndex()) {
-                // Si c'est un fichier coché (pas un dossier)
-                if (state == Qt::Checked && !currentChapter.isEmpty()) {
-                    // Marquer ce chapitre pour compilation
-                    chaptersToCompile.insert(currentChapter);
-                    qDebug() << "Chapitre marqué pour compilation:" << currentChapter;
-                }
-                
-                // Explorer récursivement
-                if (model->hasChildren(index)) {
-                    identifySelectedChapters(index, currentChapter);
-                }
+    m_profiles.insert(target, profile);
+}
+
+CompileProfile LatexAssembler::profile(BuildTarget target) const
+{
+    return m_profiles.value(target, CompileProfile::full());
+}
+
+bool LatexAssembler::selectProfiles(const QVector<CompileProfile>& available, const QMap<QString, QString>& targets)
+{
+    static const QMap<QString, BuildTarget> targetNames = {
+        { "partiel", BuildTarget::Partial },
+        { "chapitre", BuildTarget::Chapter },
+        { "document", BuildTarget::Document }
+    };
+
+    bool ok = true;
+    for (auto it = targets.constBegin(); it != targets.constEnd(); ++it) {
+        if (!targetNames.contains(it.key())) {
+            qWarning() << "Cible inconnue pour un profil de compilation:" << it.key();
+            ok = false;
+            continue;
+        }
+
+        bool found = false;
+        for (const CompileProfile& candidate : available) {
+            if (candidate.name == it.value()) {
+                setProfile(targetNames.value(it.key()), candidate);
+                found = true;
+                break;
             }
         }
-    };
+        if (!found) {
+            qWarning() << "Profil de compilation inconnu:" << it.value();
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+CompileJobSpec LatexAssembler::jobSpec(BuildTarget target, const QString& id, const QString& texFile) const
+{
+    CompileProfile targetProfile = profile(target);
+    if (!m_engineProgram.isEmpty()) {
+        targetProfile.engine = m_engineProgram;
+    }
+
+    CompileJobSpec spec;
+    spec.id = id;
+    spec.texFile = texFile;
+    spec.program = targetProfile.engine;
+    spec.arguments = targetProfile.arguments();
+    spec.draftArguments = targetProfile.draftArguments();
+    spec.maxPasses = targetProfile.maxPasses;
+    spec.indexTool = targetProfile.indexTool;
+    if (!m_mainFilePath.isEmpty()) {
+        spec.sourceDir = QFileInfo(m_mainFilePath).absolutePath();
+    }
+
+    // Journal des fichiers lus (.fls) : dépendances réelles de la cible
+    if (!spec.arguments.contains("-recorder")) {
+        spec.arguments << "-recorder";
+    }
+
+    // Cache TeX de l'application, sauf TEXMFVAR/TEXMFCACHE imposés par le profil
+    spec.environment = TexCacheManager::environment();
+    for (auto it = targetProfile.environment.constBegin(); it != targetProfile.environment.constEnd(); ++it) {
+        spec.environment.insert(it.key(), it.value());
+    }
+    return spec;
+}
+
+void LatexAssembler::onPartialJobFinished(bool success, int exitCode, const QString& pdfPath)
+{
+    qDebug() << "Processus PARTIEL terminé avec code:" << exitCode;
+    m_isCompiling = false;
+
+    // Si le processus s'est terminé avec une erreur
+    if (exitCode != 0) {
+        emit compilationError("Erreur LaTeX détectée dans le document partiel. Code de sortie: " + QString::number(exitCode));
+        emit compilationFinished(false, "");
+    }
+    else if (success && QFile::exists(pdfPath)) {
+        // Renommer le fichier PDF final
+        QString finalPdfName = renameFinalPdf(m_currentTempFile, m_mainFilePath);
+        if (!finalPdfName.isEmpty()) {
+            recordDependencies("partiel", m_currentTempFile, finalPdfName);
+            emit compilationFinished(true, finalPdfName);
+            emit pdfAvailable(finalPdfName);
+        } else {
+            emit compilationError("Erreur lors du renommage du PDF");
+        }
+    }
+    else {
+        emit compilationError("Le fichier PDF n'a pas été généré");
+    }
+
+    // Mode surveillance : chapitres et document attendaient le résultat du partiel
+    if (m_deferredTargets.model) {
+        DeferredTargets deferred = m_deferredTargets;
+        m_deferredTargets = DeferredTargets();
+        if (exitCode == 0) {
+            compileDeferredTargets(deferred);
+        } else {
+            emit outputMessage(BuildTarget::Partial, "\nChapitres et document non recompilés : "
+                                                     "le document partiel contient des erreurs.");
+        }
+    }
+
+    // Préchauffer le prochain partiel sur le même préambule
+    prepareWarmWorkers();
+
+    finishBuildIfIdle();
+}
+
+void LatexAssembler::onChapterJobFinished(const QString& chapterName, bool success, int exitCode, const QString& pdfPath)
+{
+    if (m_chapterOfShard.contains(chapterName)) {
+        onChapterShardFinished(chapterName, success, exitCode, pdfPath);
+        return;
+    }
     
-    // Seconde passe : collecter TOUS les fichiers des chapitres à compiler
-    std::function<void(const QModelIndex&)> collectAllChapterFiles = 
-    [&](const QModelIndex& parent) {
-        for (int i = 0; i < model->rowCount(parent); ++i) {
-            QModelIndex index = model->index(i, 0, parent);
-            QString nodeName = model->data(index, Qt::DisplayRole).toString();
-            QString nodePath = model->data(index, Qt::ToolTipRole).toString();
-            
-            // Si c'est un nœud de premier niveau (chapitre)
-            if (parent == QModelIndex()) {
-                if (nodeName != "PEDA" && nodeName != "DOCS" && nodeName != "EVALS") {
-                    // Si ce chapitre doit être compilé
-                    if (chaptersToCompile.contains(nodeName)) {
-                        // Créer une entrée pour ce chapitre
-                        ChapterInfo chapter;
-                        chapter.name = nodeName;
-                        chapter.path = nodePath;
-                        chapterMap[nodeName] = chapter;
-                        
-                        // Collecter tous les fichiers du chapitre
-                        collectAllChapterFiles(index);
-                    }
-                }
-            }
-            else {
-                // Déterminer à quel chapitre ce nœud appartient
-                QModelIndex parentIdx = parent;
-                QString chapterName;
-                
-                // Remonter jusqu'à trouver un nœud de premier niveau
-                while (parentIdx.parent().isValid()) {
-                    parentIdx = parentIdx.parent();
-                }
-                
-                // Si on est remonté à un chapitre
-                if (!parentIdx.parent().isValid()) {
-                    chapterName = model->data(parentIdx, Qt::DisplayRole).toString();
-                    
-                    // Pour chaque fichier sélectionné
-                    QFileInfo fileInfo(nodePath);
-                    QString fileName = fileInfo.fileName();
-                    
-                    // Exclure UNIQUEMENT les fichiers qui se nomment exactement {chapitre}_cours.tex
-                    // mais continuer à explorer récursivement leurs enfants
-                    bool isCoursFile = fileName.contains("_cours");
-                    if (isCoursFile) {
-                        qDebug() << "Fichier de cours exclu:" << nodePath;
-                        
-                        // Explorer récursivement les enfants même si on a exclu le fichier cours
-                        if (model->hasChildren(index)) {
-                            collectAllChapterFiles(index);
-                        }
-                        
-                        continue;  // Ne pas ajouter ce fichier spécifique
-                    }
-                    
-                    // Si ce chapitre doit être compilé et que c'est un fichier .tex
-                    if (chaptersToCompile.contains(chapterName) && 
-                        !nodePath.isEmpty() && QFile::exists(nodePath) && nodePath.endsWith(".tex")) {
-                        
-                        // Ajouter ce fichier au chapitre
-                        chapterMap[chapterName].files.append(qMakePair(nodeName, nodePath));
-                        qDebug() << "Ajout du fichier" << nodePath << "au chapitre" << chapterName;
-                    }
-                }
-                
-                // Explorer récursivement - On laisse ce code ici pour ne pas perturber la logique existante
-                // qui gère d'autres cas comme les nœuds sans fichiers
-                if (model->hasChildren(index)) {
-                    collectAllChapterFiles(index);
-                }
+    qDebug() << "Processus CHAPITRE" << chapterName << "terminé avec code:" << exitCode;
+    QString tempFilePath = m_chapterTempFilesByName.take(chapterName);
+    QString target = "chapitre/" + chapterName;
+
+    // Si le processus s'est terminé avec une erreur
+    if (exitCode != 0) {
+        m_pendingDependencies.remove(target);
+        emit outputMessage(BuildTarget::Chapter, "\n\n*** ERREUR dans la compilation du chapitre " +
+                           chapterName + " (code " + QString::number(exitCode) + ") ***\n");
+        emit chapterCompilationFinished(chapterName, false, "");
+        return;
+    }
+
+    if (success && QFile::exists(pdfPath)) {
+        // Renommer le PDF généré
+        QString finalPdfName = renameChapterPdf(tempFilePath, chapterName);
+        if (!finalPdfName.isEmpty()) {
+            recordDependencies(target, tempFilePath, finalPdfName);
+            emit chapterCompilationFinished(chapterName, true, finalPdfName);
+            qDebug() << "Compilation du chapitre" << chapterName << "terminée avec succès";
+        } else {
+            emit chapterCompilationFinished(chapterName, false, "");
+            qDebug() << "Erreur lors du renommage du PDF du chapitre" << chapterName;
+        }
+    } else {
+        emit chapterCompilationFinished(chapterName, false, "");
+        qDebug() << "Le fichier PDF n'a pas été généré pour le chapitre" << chapterName;
+    }
+}
+
+void LatexAssembler::onDocumentJobFinished(bool success, int exitCode, const QString& pdfPath)
+{
+    qDebug() << "Processus DOCUMENT COMPLET terminé avec code:" << exitCode;
+    m_isCompilingFullDocument = false;
+    QString documentPdf;
+
+    // Si le processus s'est terminé avec une erreur
+    if (exitCode != 0) {
+        emit compilationError("Erreur LaTeX détectée dans le document complet. Code de sortie: " + QString::number(exitCode));
+        emit fullDocumentCompilationFinished(false, "");
+    }
+    else if (success && QFile::exists(pdfPath)) {
+        // Enregistrer les .aux des unités pour les compilations \includeonly suivantes
+        if (!m_fullDocumentUnits.isEmpty()) {
+            IncludeUnitCache cache(m_mainFilePath);
+            if (cache.store(QFileInfo(m_fullDocumentTempFile).absolutePath(), m_fullDocumentUnits)) {
+                emit outputMessage(BuildTarget::Document, "\nNumérotation enregistrée pour les compilations \\includeonly.");
+            } else {
+                qWarning() << "Impossible d'enregistrer les .aux des unités dans" << cache.cacheDir();
             }
         }
+        
+        // Renommer le fichier PDF final
+        QString finalPdfName = renameFullDocumentPdf(m_fullDocumentTempFile);
+        if (!finalPdfName.isEmpty()) {
+            recordDependencies("document", m_fullDocumentTempFile, finalPdfName);
+            documentPdf = finalPdfName;
+            emit fullDocumentCompilationFinished(true, finalPdfName);
+            emit pdfAvailable(finalPdfName);
+        } else {
+            emit fullDocumentCompilationFinished(false, "");
+        }
+    }
+    else {
+        emit compilationError("Le fichier PDF n'a pas été généré pour le document complet");
+        emit fullDocumentCompilationFinished(false, "");
+    }
+
+    // Mode découpage : les chapitres attendaient le PDF du document complet
+    extractChaptersFromDocument(documentPdf);
+
+    finishBuildIfIdle();
+}
+
+void LatexAssembler::setProcessLimits(const ProcessLimits& limits)
+{
+    m_partialPool->setLimits(limits);
+    m_chapterPool->setLimits(limits);
+    m_documentPool->setLimits(limits);
+    m_warmPool->setLimits(limits);
+    m_figurePool->setLimits(limits);
+    m_culpritFinder->setLimits(limits);
+}
+
+void LatexAssembler::setMaxParallelJobs(int count)
+{
+    m_chapterJobs = qMax(0, count);
+    m_chapterPool->setMaxParallelJobs(qMax(1, m_chapterJobs));
+}
+
+void LatexAssembler::widenChapterPool()
+{
+    // Le nombre de compilations simultanées demandé, sinon une par cœur (comme
+    // les tronçons du document complet), jusqu'au prochain lot de chapitres
+    if (m_chapterJobs == 0) {
+        m_chapterPool->setMaxParallelJobs(QThread::idealThreadCount());
+    }
+}
+
+void LatexAssembler::markBuildStarted()
+{
+    // Une nouvelle compilation commence lorsque aucune cible n'est active
+    if (!m_buildInProgress) {
+        m_buildInProgress = true;
+        m_buildStats.clear();
+        emit buildStarted();
+        startTexCacheWarmUp();
+    }
+}
+
+void LatexAssembler::setBuildRoot(const BuildRootSettings& settings)
+{
+    m_pendingBuildRoot = settings;
+    m_buildRootPending = true;
+    prepareBuildRoot();
+}
+
+void LatexAssembler::prepareBuildRoot()
+{
+    // Les fichiers de la compilation en cours restent où ils sont
+    if (m_buildInProgress) {
+        return;
+    }
+
+    BuildRoot& root = BuildRoot::instance();
+    QString previousRoot = root.rootPath();
+    if (m_buildRootPending) {
+        m_buildRootPending = false;
+        root.configure(m_pendingBuildRoot);
+    }
+    bool retiredReleased = false;
+    bool spilled = root.enforceCap(&retiredReleased);
+    if (!spilled && !retiredReleased && root.rootPath() == previousRoot) {
+        return;
+    }
+
+    // Les processus préchauffés attendaient dans l'ancien répertoire du partiel
+    m_warmPool->stop();
+    m_warmPartial = WarmPartial();
+    if (spilled) {
+        emit outputMessage(BuildTarget::Partial, "Plafond des fichiers intermédiaires en RAM atteint : "
+                                                 "compilations sur " + root.rootPath());
+    }
+    qDebug() << "Racine de compilation:" << root.rootPath();
+}
+
+void LatexAssembler::checkBuildRootCap(BuildTarget target)
+{
+    BuildRoot& root = BuildRoot::instance();
+    if (root.spillNewWork()) {
+        emit outputMessage(target, "Plafond des fichiers intermédiaires en RAM atteint : suite de la "
+                                   "compilation sur " + root.rootPath());
+    }
+}
+
+void LatexAssembler::startTexCacheWarmUp()
+{
+    // Premier moteur LuaTeX des cibles : son installation fournit luaotfload-tool
+    QString luaEngine;
+    for (BuildTarget target : { BuildTarget::Partial, BuildTarget::Chapter, BuildTarget::Document }) {
+        QString engine = m_engineProgram.isEmpty() ? profile(target).engine : m_engineProgram;
+        if (TexCacheManager::usesLuaotfload(engine)) {
+            luaEngine = engine;
+            break;
+        }
+    }
+    if (luaEngine.isEmpty() || !m_texCache->warmUp(luaEngine)) {
+        return;
+    }
+
+    // Les figures TikZ sont elles aussi composées par LuaLaTeX
+    holdPools();
+    m_figurePool->setHeld(true);
+}
+
+void LatexAssembler::onTexCacheWarmUpFinished(bool success, const QString& summary, const ProcessResult& result)
+{
+    recordPass("cache", "luaotfload", QString(), 1, result);
+    emitToWaitingTargets(summary + "\n");
+    if (!success) {
+        qWarning() << "Préchauffage du cache des polices en échec, les compilations reconstruiront la base";
+    }
+
+    m_figurePool->setHeld(false);
+    releasePools();
+}
+
+void LatexAssembler::holdPools()
+{
+    if (m_poolHolds++ == 0) {
+        m_partialPool->setHeld(true);
+        m_chapterPool->setHeld(true);
+        m_documentPool->setHeld(true);
+    }
+}
+
+void LatexAssembler::releasePools()
+{
+    if (m_poolHolds > 0 && --m_poolHolds == 0) {
+        m_partialPool->setHeld(false);
+        m_chapterPool->setHeld(false);
+        m_documentPool->setHeld(false);
+    }
+}
+
+void LatexAssembler::emitToWaitingTargets(const QString& message)
+{
+    // Message dans l'onglet de chaque cible en attente
+    const QList<QPair<BuildTarget, JobPool*>> pools = {
+        { BuildTarget::Partial, m_partialPool },
+        { BuildTarget::Chapter, m_chapterPool },
+        { BuildTarget::Document, m_documentPool }
     };
-    
-    // Exécuter les deux passes
-    identifySelectedChapters(QModelIndex(), "");
-    collectAllChapterFiles(QModelIndex());
-    
-    // Convertir la map en vecteur
-    for (const auto& chapterName : chapterMap.keys()) {
-        if (!chapterMap[chapterName].files.isEmpty()) {
-            chapters.append(chapterMap[chapterName]);
-            qDebug() << "Chapitre" << chapterName << "ajouté avec" << chapterMap[chapterName].files.size() << "fichiers";
+    for (const auto& pool : pools) {
+        if (pool.second->isBusy()) {
+            emit outputMessage(pool.first, message);
         }
     }
+}
+
+QString LatexAssembler::substituteFigures(const QString& content, const QString& preamble)
+{
+    if (!m_tikzFigureCache) {
+        return content;
+    }
+    m_figureCache.setPreamble(preamble);
+    return m_figureCache.substitute(content);
+}
+
+QString LatexAssembler::createFigureTempFile(const TikzFigureCache::Figure& figure)
+{
+    QString jobDir = documentTempDir().path() + "/figures/" + figure.key;
+    if (!documentTempDir().isValid() || !QDir().mkpath(jobDir)) {
+        qWarning() << "Impossible de créer le répertoire de la figure" << jobDir;
+        return QString();
+    }
+
+    QString texFile = jobDir + "/figure.tex";
+    QFile file(texFile);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Impossible de créer le pilote de la figure" << texFile;
+        return QString();
+    }
+
+    // Préambule du document, page recadrée sur la figure (preview), externalisation
+    // TikZ du document désactivée : la figure est composée une seule fois, ici
+    QTextStream out(&file);
+    out << m_figureCache.preamble();
+    out << "% Figure TikZ seule, page recadrée sur la figure\n";
+    out << "\\makeatletter\n";
+    out << "\\@ifpackageloaded{preview}{}{\\usepackage[active,tightpage]{preview}}\n";
+    out << "\\makeatother\n";
+    out << "\\PreviewEnvironment{tikzpicture}\n";
+    out << "\\setlength\\PreviewBorder{0pt}\n";
+    DriverWriter::writeDocumentSetup(out, m_mainFilePath);
+    out << "\\makeatletter\\@ifundefined{tikzexternaldisable}{}{\\tikzexternaldisable}\\makeatother\n";
+    out << figure.source << "\n";
+    out << "\\end{document}\n";
+    file.close();
+
+    return texFile;
+}
+
+void LatexAssembler::startFigureGeneration(BuildTarget target)
+{
+    if (!m_tikzFigureCache) {
+        return;
+    }
+
+    const QVector<TikzFigureCache::Figure> figures = m_figureCache.takeMissingFigures();
+    int queued = 0;
+    for (const TikzFigureCache::Figure& figure : figures) {
+        if (m_figuresInProgress.contains(figure.key)) {
+            continue;
+        }
+        QString texFile = createFigureTempFile(figure);
+        if (texFile.isEmpty()) {
+            continue;
+        }
+
+        // Première figure : les cibles attendent la fin de la génération
+        if (!m_figurePool->isBusy()) {
+            holdPools();
+            m_figureClock.start();
+            m_figuresGenerated = 0;
+            m_figureFailures = 0;
+        }
+
+        // Une seule passe, sans brouillon : une figure externalisable ne dépend d'aucune référence
+        CompileJobSpec spec = jobSpec(BuildTarget::Document, "figure_" + figure.key, texFile);
+        spec.maxPasses = 1;
+        spec.draftArguments.clear();
+        m_figuresInProgress.insert(figure.key);
+        m_figurePool->enqueue(spec);
+        ++queued;
+    }
+
+    if (queued > 0) {
+        emit outputMessage(target, QString("Figures TikZ absentes du cache : %1 générée(s) en parallèle "
+                                           "avant la compilation\n").arg(queued));
+    }
+}
+
+void LatexAssembler::onFigureJobFinished(const QString& id, bool success, int exitCode, const QString& pdfPath)
+{
+    QString key = id.mid(int(qstrlen("figure_")));
+    m_figuresInProgress.remove(key);
+
+    if (success && exitCode == 0 && QFile::exists(pdfPath) && TikzFigureCache::store(key, pdfPath)) {
+        ++m_figuresGenerated;
+        return;
+    }
+
+    ++m_figureFailures;
+    emitToWaitingTargets(QString("Figure TikZ %1 : génération en échec (code %2), figure composée "
+                                 "dans le document. Pilote : %3\n")
+                         .arg(key).arg(exitCode).arg(QFileInfo(pdfPath).absolutePath() + "/figure.tex"));
+}
+
+DependencyStore& LatexAssembler::dependencies()
+{
+    m_dependencies.setMainFilePath(m_mainFilePath);
+    return m_dependencies;
+}
+
+QStringList LatexAssembler::dependencyFiles()
+{
+    return dependencies().allFiles();
+}
+
+void LatexAssembler::trackDependencies(const QString& target, const QVector<QPair<QString, QString>>& files)
+{
+    // Heure prise avant l'instantané : ce qui change ensuite est daté après elle
+    PendingDependencies pending;
+    pending.startedAt = QDateTime::currentDateTime();
     
-    qDebug() << "Chapitres à compiler trouvés:" << chapters.size();
+    // Instantané d'avant le lancement : sources et dépendances déjà connues de la
+    // cible, dont les signatures seront enregistrées après la compilation
+    for (const auto& file : files) {
+        pending.sources.append(QFileInfo(file.second).absoluteFilePath());
+        m_fileStats.stat(pending.sources.last());
+    }
+    const QStringList knownFiles = dependencies().filesOf(target);
+    for (const QString& filePath : knownFiles) {
+        m_fileStats.stat(filePath);
+    }
+    m_pendingDependencies.insert(target, pending);
+}
+
+void LatexAssembler::recordDependencies(const QString& target, const QString& driverPath, const QString& pdfPath)
+{
+    // Les sources sont recopiées dans le pilote (ou ses unités) : le .fls n'en
+    // garde pas trace, contrairement aux images, .bib et autres fichiers lus
+    QFileInfo driverInfo(driverPath);
+    PendingDependencies pending = m_pendingDependencies.take(target);
+    if (!pending.startedAt.isValid()) {
+        pending.startedAt = QDateTime::currentDateTime();
+    }
+    QStringList files = pending.sources;
+    files += DependencyStore::readRecorder(driverInfo.absolutePath() + "/" + driverInfo.completeBaseName() + ".fls");
+    files += AuxiliaryTools(driverPath, target, QFileInfo(m_mainFilePath).absolutePath(), QString()).bibliographySources();
+
+    dependencies().record(target, DependencyStore::driverHash(driverPath), files, pdfPath,
+                          m_fileStats, pending.startedAt);
+}
+
+bool LatexAssembler::isUpToDate(const QString& target, const QString& driverPath, QString* pdfPath)
+{
+    if (m_forceRebuild) {
+        return false;
+    }
+    return dependencies().isUpToDate(target, DependencyStore::driverHash(driverPath), pdfPath, &m_fileStats);
+}
+
+void LatexAssembler::recordPass(const QString& target, const QString& label, const QString& profile,
+                                int pass, const ProcessResult& result)
+{
+    PassRecord record;
+    record.target = target;
+    record.label = label;
+    record.pass = pass;
+    record.profile = profile;
+    record.startedAt = QDateTime::currentDateTime().addMSecs(-result.wallTimeMs);
+    record.result = result;
+    m_buildStats.record(record);
+}
+
+void LatexAssembler::finishBuildIfIdle()
+{
+    if (!m_buildInProgress || m_isCompiling || m_isCompilingChapters || m_isCompilingFullDocument) {
+        return;
+    }
+
+    m_buildInProgress = false;
+    invalidateBuildPlan();
+    if (m_buildStats.isEmpty()) {
+        emit buildFinished();
+        Tracer::instance().write();
+        return;
+    }
+
+    // Exporter les mesures pour le suivi des tendances
+    QString statsDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    if (!m_buildStats.appendCsv(statsDir + "/build_stats.csv", m_mainFilePath)) {
+        qWarning() << "Impossible d'écrire les statistiques CSV dans" << statsDir;
+    }
+    if (!m_buildStats.writeJson(statsDir + "/last_build_stats.json", m_mainFilePath)) {
+        qWarning() << "Impossible d'écrire les statistiques JSON dans" << statsDir;
+    }
+
+    emit buildStatsReady(m_buildStats.summary());
+    emit buildFinished();
     
-    return chapters;
+    // La trace est réécrite à chaque fin de compilation (utile en mode surveillance)
+    Tracer::instance().write();
 }
 
 QString LatexAssembler::createChapterTempFile(const QString& preamble, const ChapterInfo& chapter)
 {
     // Vérifier que le répertoire temporaire pour les chapitres existe
-    if (!s_chapterTempDir.isValid()) {
+    if (!chapterTempDir().isValid()) {
         emit compilationError("Impossible de créer un répertoire temporaire pour les chapitres");
         return QString();
     }
     
-    // Générer un nom unique pour le fichier temporaire
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-    QString tempFileName = s_chapterTempDir.path() + "/temp_" + chapter.name + "_" + timestamp + ".tex";
-    
-    qDebug() << "Création du fichier temporaire pour chapitre:" << chapter.name << "avec" << chapter.files.size() << "fichiers";
-    
-    QFile tempFile(tempFileName);
-    if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        emit compilationError("Impossible de créer le fichier temporaire pour le chapitre " + chapter.name);
-        return QString();
-    }
-    
-    QTextStream out(&tempFile);
-    
-    // Écrire le préambule
-    out << preamble;
-    
-    // Obtenir le chemin absolu du dossier contenant le fichier principal
-    QFileInfo mainFileInfo(m_mainFilePath);
-    QString mainDirPath = mainFileInfo.absolutePath();
-    
-    // Ajouter la configuration des chemins d'images
-    out << "% Configuration des chemins d'images pour le document temporaire\n";
-    out << "\\graphicspath{{"
-        << QDir::toNativeSeparators(mainDirPath + "/images/").replace("\\", "/") << "}{"
-        << QDir::toNativeSeparators(mainDirPath + "/../images/").replace("\\", "/") << "}}\n\n";
-    
-    // Ajouter la configuration des en-têtes et pieds de page
-    out << "% Configuration des en-têtes et pieds de page\n";
-    out << "\\lhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\monetablissement}}}} %haut de page gauche\n";
-    out << "\\chead{} %haut de page centre\n";
-    out << "\\rhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\maclasse}}}} %haut de page droit\n";
-    out << "\\lfoot{} %pied de page gauche\n";
-    out << "\\cfoot{\\textcolor{gris50}{\\small\\textit{page \\thepage}}} % pied de page centré\n";
-    out << "\\rfoot{} %On personnalisera cette en-tête\n";
-    out << "\\def\\headrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
-    out << "\\def\\footrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
-    out << "\\pagestyle{empty}\n\n";
-    
-    // Début du document
-    out << "\\begin{document}\n\n";
-    
-    // Ajouter la configuration de l'espacement
-    out << "\\singlespacing\\setlength{\\parindent}{0pt}\n\n";
-    
-    // Ajouter le contenu des fichiers du chapitre
-    for (const auto& file : chapter.files) {
-        QFile inputFile(file.second);
-        if (inputFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            out << "% Contenu du fichier: " << file.second << "\n";
-            out << inputFile.readAll() << "\n\n";
-            inputFile.close();
+    // Mode \includeonly : pages et numéros du chapitre dans le dernier document complet
+    if (m_includeOnlyMode) {
+        if (!passesPreflight(BuildTarget::Chapter, "du chapitre " + chapter.name, chapter.files)) {
+            return QString();
+        }
+        static const QRegularExpression invalidChars("[^A-Za-z0-9]");
+        QString jobDir = chapterTempDir().path() + "/unites_" + QString(chapter.name).replace(invalidChars, "_");
+        QString driverPath = createIncludeOnlyDocument(jobDir, preamble, chapter.files, BuildTarget::Chapter);
+        if (!driverPath.isEmpty()) {
+            return driverPath;
         }
     }
     
-    // Fin du document
-    out << "\\end{document}\n";
+    DriverRequest request = driverRequest(BuildTarget::Chapter, chapter.name, preamble, chapter.files);
+    return adoptDriver(BuildTarget::Chapter, DriverWriter::write(request));
+}
+
+void LatexAssembler::compileChapters(LatexModel* model, const QSet<QString>& changedFiles)
+{
+    // Annoncer le début dans le flux des chapitres
+    emit outputMessage(BuildTarget::Chapter, "=== DÉBUT DE LA COMPILATION DES CHAPITRES ===\n");
+    prepareBuildRoot();
     
-    tempFile.close();
+    // Identifier les chapitres à compiler
+    QVector<ChapterInfo> chapters = buildPlan(model).chapters;
+    qDebug() << "Chapitres identifiés:" << chapters.size();
     
-    qDebug() << "Fichier temporaire créé:" << tempFileName;
+    if (chapters.isEmpty()) {
+        emit outputMessage(BuildTarget::Chapter, "Aucun chapitre à compiler. Vérifiez qu'au moins un fichier est coché.");
+        emit compilationError("Aucun chapitre à compiler");
+        return;
+    }
     
-    // Ajouter à la liste des fichiers temporaires de chapitres
-    m_chapterTempFiles.append(tempFileName);
+    // Mode surveillance : ne garder que les chapitres contenant ou lisant un fichier modifié
+    if (!changedFiles.isEmpty()) {
+        QSet<QString> dependents = dependencies().targetsUsing(changedFiles);
+        QVector<ChapterInfo> affectedChapters;
+        for (const ChapterInfo& chapter : chapters) {
+            if (containsAnyFile(chapter.files, changedFiles) || dependents.contains("chapitre/" + chapter.name)) {
+                affectedChapters.append(chapter);
+            }
+        }
+        chapters = affectedChapters;
+        
+        if (chapters.isEmpty()) {
+            emit outputMessage(BuildTarget::Chapter, "Aucun chapitre concerné par les modifications.");
+            return;
+        }
+    }
     
-    return tempFileName;
+    startChapters(chapters);
 }
 
-void LatexAssembler::compileChapters(LatexModel* model, QTextEdit* outputWidget)
+void LatexAssembler::compileExercises(LatexModel* model)
 {
-    // Utiliser une variable de comptage de compilation SÉPARÉE pour les chapitres
-    m_chapterCompilationCount = 1; // Nouveau membre à ajouter au header
+    emit outputMessage(BuildTarget::Chapter, "=== DÉBUT DE LA COMPILATION DES EXERCICES SÉPARÉS ===\n");
+    prepareBuildRoot();
+    
+    QVector<ChapterInfo> exercises = buildPlan(model).exercises;
+    if (exercises.isEmpty()) {
+        emit outputMessage(BuildTarget::Chapter, "Aucun exercice à compiler. Cochez au moins un fichier "
+                                                 "d'un groupe PEDA, DOCS ou EVALS.");
+        emit compilationError("Aucun exercice à compiler");
+        return;
+    }
+    emit outputMessage(BuildTarget::Chapter, QString("%1 exercice(s), un PDF chacun\n").arg(exercises.size()));
     
-    // Nettoyer la file d'attente existante
-    {
-        QMutexLocker locker(&m_mutex);
-        m_chapterQueue.clear();
+    // Chaque exercice est un document à part, compilé comme un chapitre
+    startChapters(exercises, true);
+}
+
+void LatexAssembler::startChapters(const QVector<ChapterInfo>& chapters, bool parallel)
+{
+    // Extraire le préambule du document principal (une seule fois pour tous les chapitres)
+    QString preamble = extractPreamble(m_mainFilePath);
+    if (preamble.isEmpty()) {
+        emit compilationError("Impossible de lire le préambule pour les chapitres");
+        return;
     }
     
-    // Configurer la sortie avant tout
-    m_chapterOutputWidget = outputWidget;
-    m_chapterOutputWidget->clear();
-    m_chapterOutputWidget->append("=== DÉBUT DE LA COMPILATION DES CHAPITRES ===\n");
+    if (!chapterTempDir().isValid()) {
+        emit compilationError("Impossible de créer un répertoire temporaire pour les chapitres");
+        return;
+    }
     
-    // Identifier les chapitres à compiler
-    QVector<ChapterInfo> chapters = identifyChaptersToCompile(model);
-    qDebug() << "Chapitres identifiés:" << chapters.size();
+    // Chapitres et exercices séparés peuvent partager la file
+    if (!m_isCompilingChapters) {
+        m_chapterTempFilesByName.clear();
+        m_chapterShards.clear();
+        m_chapterOfShard.clear();
+        m_chapterPool->setMaxParallelJobs(qMax(1, m_chapterJobs));
+    }
     
-    if (chapters.isEmpty()) {
-        m_chapterOutputWidget->append("Aucun chapitre à compiler. Vérifiez qu'au moins un fichier est coché.");
-        emit compilationError("Aucun chapitre à compiler");
-        return;
+    if (parallel) {
+        widenChapterPool();
     }
+    markBuildStarted();
+    m_isCompilingChapters = true;
     
-    // Démarrer le processus de compilation
-    {
-        QMutexLocker locker(&m_mutex);
-        // Ajouter les chapitres à la file d'attente
-        for (const ChapterInfo& chapter : chapters) {
-            m_chapterQueue.enqueue(chapter);
+    // Pilotes écrits en parallèle, en arrière-plan : chaque chapitre est mis en
+    // file dès que le sien est prêt. En mode \includeonly, les unités sont
+    // préparées ici
+    m_chapterAssemblies += chapters.size();
+    for (const ChapterInfo& chapter : chapters) {
+        checkBuildRootCap(BuildTarget::Chapter);
+        if (m_includeOnlyMode) {
+            QString tempFilePath = createChapterTempFile(preamble, chapter);
+            --m_chapterAssemblies;
+            startChapter(chapter, tempFilePath);
+            continue;
         }
+        if (startShardedChapter(preamble, chapter)) {
+            --m_chapterAssemblies;
+            continue;
+        }
+        assembleInBackground(driverRequest(BuildTarget::Chapter, chapter.name, preamble, chapter.files),
+                             [this, chapter](const DriverResult& result) {
+            --m_chapterAssemblies;
+            startChapter(chapter, adoptDriver(BuildTarget::Chapter, result));
+        });
     }
     
-    m_isCompilingChapters = true;
-    
-    // Démarrer le processus de manière asynchrone
-    QMetaObject::invokeMethod(this, "processNextChapter", Qt::QueuedConnection);
+    // Seuls des chapitres en tronçons, tous refusés avant leur lancement
+    if (m_isCompilingChapters && m_chapterAssemblies == 0 && !m_chapterPool->isBusy()) {
+        m_isCompilingChapters = false;
+        emit allChaptersCompiled();
+        finishBuildIfIdle();
+    }
 }
 
-void LatexAssembler::processNextChapter()
+void LatexAssembler::startChapter(const ChapterInfo& chapter, const QString& tempFilePath)
 {
-    // Récupérer le prochain chapitre
-    ChapterInfo chapter;
-    bool hasChapter = false;
-    
-    {
-        QMutexLocker locker(&m_mutex);
-        if (!m_chapterQueue.isEmpty()) {
-            chapter = m_chapterQueue.dequeue();
-            hasChapter = true;
-        } else {
-            m_isCompilingChapters = false;
-            QMetaObject::invokeMethod(this, "allChaptersCompiled", Qt::QueuedConnection);
-            return;
-        }
+    // Pilote et fichiers lus inchangés : le PDF publié est repris (pas en mode
+    // \includeonly, où la numérotation vient des .aux des autres chapitres)
+    QString target = "chapitre/" + chapter.name;
+    QString upToDatePdf;
+    if (tempFilePath.isEmpty()) {
+        // Pilote non écrit : l'erreur est déjà signalée
+    } else if (!m_includeOnlyMode && isUpToDate(target, tempFilePath, &upToDatePdf)) {
+        emit outputMessage(BuildTarget::Chapter, QString("Chapitre %1 à jour (aucune dépendance modifiée) : %2")
+                                                 .arg(chapter.name, upToDatePdf));
+        emit chapterCompilationFinished(chapter.name, true, upToDatePdf);
+        ++m_upToDateTargets;
+    } else {
+        m_chapterTempFilesByName.insert(chapter.name, tempFilePath);
+        trackDependencies(target, chapter.files);
+        startFigureGeneration(BuildTarget::Chapter);
+        
+        CompileJobSpec spec = jobSpec(BuildTarget::Chapter, chapter.name, tempFilePath);
+        m_chapterPool->enqueue(spec);
     }
     
-    if (!hasChapter) return;
+    // Dernier pilote prêt sans compilation en file (chapitres à jour ou pilotes
+    // en échec) : la file ne signalera pas sa fin
+    if (m_chapterAssemblies == 0 && !m_chapterPool->isBusy()) {
+        m_isCompilingChapters = false;
+        emit allChaptersCompiled();
+        finishBuildIfIdle();
+    }
+}
+
+void LatexAssembler::compileChangedTargets(LatexModel* model, const QStringList& changedFiles,
+                                           bool compilePartial, bool compileChapter, bool compileDocument)
+{
+    QSet<QString> changed;
+    for (const QString& filePath : changedFiles) {
+        changed.insert(QFileInfo(filePath).absoluteFilePath());
+    }
     
-    m_currentChapterName = chapter.name;
-    qDebug() << "Traitement du chapitre:" << m_currentChapterName;
+    // Le préambule vient du fichier principal : toutes les cibles en dépendent
+    bool preambleChanged = changed.contains(QFileInfo(m_mainFilePath).absoluteFilePath());
     
-    // Afficher un séparateur pour ce chapitre
-    if (m_chapterOutputWidget) {
-        m_chapterOutputWidget->append("\n\n*******************************************************");
-        m_chapterOutputWidget->append(QString("***********   CHAPITRE : %1       **************").arg(chapter.name));
-        m_chapterOutputWidget->append("*******************************************************\n\n");
+    Tracer::instance().instant("surveillance", "modification détectée", Tracer::mainLane(),
+                               QJsonObject{ { "fichiers", changed.size() }, { "preambule", preambleChanged } });
+    emit outputMessage(BuildTarget::Partial, QString("=== Modification détectée (%1 fichier(s)) ===").arg(changed.size()));
+    for (const QString& filePath : changedFiles) {
+        emit outputMessage(BuildTarget::Partial, "  " + filePath);
     }
     
-    emit chapterCompilationStarted(chapter.name);
-    
-    // Extraire le préambule du document principal
-    QString preamble = extractPreamble(m_mainFilePath);
-    if (preamble.isEmpty()) {
-        emit compilationError("Impossible de lire le préambule pour le chapitre " + chapter.name);
-        QMetaObject::invokeMethod(this, "processNextChapter", Qt::QueuedConnection);
+    // Cibles ayant lu un fichier modifié lors de leur dernière compilation (images, .bib...)
+    QSet<QString> dependents = dependencies().targetsUsing(changed);
+    
+    // Fichiers relus depuis la modification, une seule fois pour toutes les cibles
+    planBuild(model);
+    
+    DeferredTargets targets;
+    targets.model = model;
+    targets.changedFiles = preambleChanged ? QSet<QString>() : changed;
+    targets.compileChapter = compileChapter;
+    targets.compileDocument = compileDocument &&
+                              (preambleChanged || dependents.contains("document") ||
+                               containsAnyFile(buildPlan(model).documentFiles, changed));
+    
+    bool partialAffected = compilePartial &&
+                           (preambleChanged || dependents.contains("partiel") ||
+                            containsAnyFile(buildPlan(model).partialFiles, changed));
+    if (!partialAffected) {
+        if (compilePartial) {
+            emit outputMessage(BuildTarget::Partial, "Sélection non concernée : document partiel inchangé.");
+        }
+        compileDeferredTargets(targets);
         return;
     }
     
-    // Créer le fichier temporaire pour ce chapitre
-    QString tempFilePath = createChapterTempFile(preamble, chapter);
-    if (tempFilePath.isEmpty()) {
-        QMetaObject::invokeMethod(this, "processNextChapter", Qt::QueuedConnection);
+    // Le partiel donne le retour le plus rapide : le reste attend son résultat
+    if (targets.compileChapter || targets.compileDocument) {
+        m_deferredTargets = targets;
+    }
+    prepareBuildRoot();
+    if (!startPartialDocument(model, compileChapter, compileDocument)) {
+        m_deferredTargets = DeferredTargets();
+    }
+}
+
+void LatexAssembler::compileDeferredTargets(const DeferredTargets& targets)
+{
+    if (targets.compileChapter && targets.compileDocument) {
+        compileChaptersAndDocument(targets.model, targets.changedFiles);
         return;
     }
     
-    // Compiler ce chapitre
-    m_currentChapterTempFile = tempFilePath;  // Utiliser la variable dédiée aux chapitres
-    m_chapterCompilationCount = 1;
+    if (targets.compileChapter) {
+        compileChapters(targets.model, targets.changedFiles);
+    }
     
-    QFileInfo tempFileInfo(tempFilePath);
-    QStringList args;
-    args << "-synctex=1"
-         << "-shell-escape"
-         << "-interaction=nonstopmode"
-         << "-file-line-error"
-         << "-max-print-line=10000" // Ajouter cette option
-         << tempFilePath;
-
-    // En cas d'erreur au lancement
-    if (!m_chapterProcessRunner->runCommand("lualatex", args, m_chapterOutputWidget, tempFileInfo.absolutePath())) {
-        emit compilationError("Échec du lancement de la compilation pour le chapitre " + chapter.name);
-        QMetaObject::invokeMethod(this, "processNextChapter", Qt::QueuedConnection);
+    if (targets.compileDocument) {
+        compileFullDocument(targets.model);
     }
 }
 
 QString LatexAssembler::renameChapterPdf(const QString& tempFilePath, const QString& chapterName)
 {
-    // Obtenir les informations sur les fichiers
-    QFileInfo tempFileInfo(tempFilePath);
-    QFileInfo mainFileInfo(m_mainFilePath);
+    TraceScope trace("publication", "publication " + chapterName, chapterName);
     
+    QFileInfo mainFileInfo(m_mainFilePath);
     if (!mainFileInfo.exists()) {
         qDebug() << "Fichier principal non trouvé pour renommer le PDF du chapitre";
         return QString();
@@ -895,53 +1626,105 @@ QString LatexAssembler::renameChapterPdf(const QString& tempFilePath, const QStr
     cleanChapterName.replace("_cours", "");
     cleanChapterName.replace(" ", "_");
     
-    // Récupérer le nom de fichier principal (sans extension)
-    QString baseName = mainFileInfo.completeBaseName();
+    return publishPdf(tempFilePath, mainFileInfo.completeBaseName() + "_" + cleanChapterName, BuildTarget::Chapter);
+}
+
+void LatexAssembler::extractChaptersFromDocument(const QString& pdfPath)
+{
+    if (m_pendingChapterExtracts.isEmpty()) {
+        return;
+    }
     
-    // Générer un timestamp formaté
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy_MM_dd_HH_mm_ss");
+    TraceScope trace("publication", "découpage des chapitres");
+    QSet<QString> pending = m_pendingChapterExtracts;
+    m_pendingChapterExtracts.clear();
     
-    // Chemin du nouveau fichier PDF dans le même répertoire que le document principal
-    QString newPdfName = mainFileInfo.absolutePath() + "/" + baseName + "_" + cleanChapterName + 
-                       "_" + timestamp + ".pdf";
+    // Première page (absolue, à partir de 1) de chaque chapitre marqué, relevée dans
+    // le .aux principal et, en unités \include, dans ceux des unités
+    QFileInfo driverInfo(m_fullDocumentTempFile);
+    QStringList auxFiles = { driverInfo.absolutePath() + "/" + driverInfo.completeBaseName() + ".aux" };
+    for (const IncludeUnit& unit : m_fullDocumentUnits) {
+        auxFiles << driverInfo.absolutePath() + "/" + unit.name + ".aux";
+    }
     
-    // Chemin du PDF original généré
-    QString originalPdf = tempFileInfo.absolutePath() + "/" + tempFileInfo.completeBaseName() + ".pdf";
+    static const QRegularExpression markerPattern("\\\\CompilationSelectiveChapitre\\{(\\d+)\\}\\{(\\d+)\\}");
+    QMap<int, int> firstPages;
+    for (const QString& auxPath : auxFiles) {
+        QFile auxFile(auxPath);
+        if (!auxFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            continue;
+        }
+        QString content = QString::fromUtf8(auxFile.readAll());
+        QRegularExpressionMatchIterator it = markerPattern.globalMatch(content);
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+            firstPages.insert(match.captured(1).toInt(), match.captured(2).toInt() - 1);
+        }
+    }
     
-    qDebug() << "Renommage du PDF du chapitre:" << originalPdf << "->" << newPdfName;
+    PdfDocument document;
+    bool loaded = false;
+    if (!pdfPath.isEmpty()) {
+        loaded = document.load(pdfPath);
+        if (!loaded) {
+            emit outputMessage(BuildTarget::Chapter, "Découpage du document complet impossible : " + document.errorString());
+        }
+    }
+    trace.setArg("pages", document.pageCount());
     
-    if (QFile::exists(originalPdf)) {
-        // Copier le fichier vers sa destination finale
-        if (QFile::copy(originalPdf, newPdfName)) {
-            // Supprimer l'original si la copie a réussi
-            QFile::remove(originalPdf);
-            qDebug() << "PDF du chapitre renommé avec succès";
-            return newPdfName;
-        } else {
-            qDebug() << "Échec de la copie du PDF du chapitre";
+    static const QRegularExpression invalidChars("[^A-Za-z0-9]");
+    for (int i = 0; i < m_documentChapterOrder.size(); ++i) {
+        const QString chapterName = m_documentChapterOrder.at(i);
+        if (!pending.remove(chapterName)) {
+            continue;
         }
-    } else {
-        qDebug() << "PDF original non trouvé:" << originalPdf;
+        emit chapterCompilationStarted(chapterName);
+        
+        QString finalPdfName;
+        if (loaded && firstPages.contains(i)) {
+            // Le chapitre s'arrête avant le début du chapitre marqué suivant
+            int firstPage = firstPages.value(i);
+            auto next = firstPages.upperBound(i);
+            int lastPage = qMin(next != firstPages.end() ? next.value() - 1 : document.pageCount() - 1,
+                                document.pageCount() - 1);
+            
+            // Nom de fichier factice : renameChapterPdf publie le .pdf voisin
+            QString extractBase = chapterTempDir().path() + "/extrait_" + QString(chapterName).replace(invalidChars, "_");
+            PdfWriter writer;
+            QString error;
+            if (writer.addPages(document, firstPage, lastPage) >= 0) {
+                writer.importOutline(document, firstPage, lastPage, 0);
+                if (writer.write(extractBase + ".pdf", &error)) {
+                    finalPdfName = renameChapterPdf(extractBase + ".tex", chapterName);
+                } else {
+                    qWarning() << error;
+                }
+            }
+            emit outputMessage(BuildTarget::Chapter, QString("Chapitre %1 : pages %2 à %3 du document complet")
+                                                     .arg(chapterName).arg(firstPage + 1).arg(lastPage + 1));
+        }
+        
+        emit chapterCompilationFinished(chapterName, !finalPdfName.isEmpty(), finalPdfName);
     }
     
-    return QString();
+    // Chapitres sans marqueur : document en échec ou chapitre absent du document
+    for (const QString& chapterName : pending) {
+        emit chapterCompilationFinished(chapterName, false, "");
+    }
+    emit allChaptersCompiled();
 }
 
-void LatexAssembler::compileFullDocument(LatexModel* model, QTextEdit* outputWidget)
+void LatexAssembler::compileFullDocument(LatexModel* model)
 {
-    // Utiliser une variable de comptage de compilation SÉPARÉE
-    m_fullDocumentCompilationCount = 1;
-    
-    // Configurer la sortie
-    m_fullDocumentOutputWidget = outputWidget;
-    m_fullDocumentOutputWidget->clear();
-    m_fullDocumentOutputWidget->append("=== DÉBUT DE LA COMPILATION DU DOCUMENT COMPLET ===\n");
+    // Annoncer le début dans le flux du document complet
+    emit outputMessage(BuildTarget::Document, "=== DÉBUT DE LA COMPILATION DU DOCUMENT COMPLET ===\n");
+    prepareBuildRoot();
     
     // Collecter tous les fichiers du document
-    QVector<QPair<QString, QString>> documentFiles = collectAllDocumentFiles(model);
+    QVector<QPair<QString, QString>> documentFiles = buildPlan(model).documentFiles;
     
     if (documentFiles.isEmpty()) {
-        m_fullDocumentOutputWidget->append("Aucun fichier à compiler pour le document complet.");
+        emit outputMessage(BuildTarget::Document, "Aucun fichier à compiler pour le document complet.");
         emit compilationError("Aucun fichier à compiler pour le document complet");
         return;
     }
@@ -953,256 +1736,639 @@ void LatexAssembler::compileFullDocument(LatexModel* model, QTextEdit* outputWid
         return;
     }
     
-    // Créer le fichier temporaire pour le document complet
-    QString tempFilePath = createFullDocumentTempFile(preamble, documentFiles);
-    if (tempFilePath.isEmpty()) {
+    // Mode tronçons (le cache \includeonly, lui, vient d'une compilation d'un seul tenant)
+    if (m_shardedDocument && m_includeOnlyMode) {
+        emit outputMessage(BuildTarget::Document, "Mode tronçons sans effet en mode \\includeonly.");
+    } else if (m_shardedDocument && compileShardedDocument(model, preamble, documentFiles)) {
+        return;
+    }
+    
+    // Mode découpage : marquer le début de chaque chapitre attendu
+    m_documentChapterOrder.clear();
+    m_documentChapterByFile.clear();
+    if (m_chaptersFromDocument && !m_pendingChapterExtracts.isEmpty()) {
+        m_documentChapterByFile = buildPlan(model).chapterByFile;
+    }
+    
+    // Créer le fichier temporaire pour le document complet (en unités \include
+    // en mode \includeonly, pour enregistrer leurs .aux)
+    QString tempFilePath;
+    m_fullDocumentUnits.clear();
+    if (m_includeOnlyMode) {
+        if (!passesPreflight(BuildTarget::Document, "du document complet", documentFiles)) {
+            extractChaptersFromDocument(QString());
+            return;
+        }
+        IncludeUnitCache cache(m_mainFilePath);
+        QVector<IncludeUnit> units = IncludeUnitCache::unitsFor(QFileInfo(m_mainFilePath).absolutePath(), documentFiles);
+        QStringList unitNames;
+        for (const IncludeUnit& unit : units) {
+            unitNames.append(unit.name);
+        }
+        
+        // Les .aux précédents, s'ils existent, réduisent le nombre de relances
+        QString jobDir = documentTempDir().path() + "/unites";
+        auto figures = [this, &preamble](const QString& content) { return substituteFigures(content, preamble); };
+        if (documentTempDir().isValid() && cache.prepareJobDir(jobDir, units, unitNames, cache.isReady(), figures)) {
+            tempFilePath = createUnitDriver(jobDir, preamble, units, QStringList());
+            m_fullDocumentUnits = units;
+        }
+    } else {
+        // Pilote écrit en arrière-plan : la compilation démarre dès qu'il est prêt
+        if (!documentTempDir().isValid()) {
+            emit compilationError("Impossible de créer un répertoire temporaire pour le document complet");
+            return;
+        }
+        markBuildStarted();
+        m_isCompilingFullDocument = true;
+        assembleInBackground(driverRequest(BuildTarget::Document, "document", preamble, documentFiles),
+                             [this, documentFiles](const DriverResult& result) {
+            m_isCompilingFullDocument = false;
+            if (!startFullDocument(adoptDriver(BuildTarget::Document, result), documentFiles)) {
+                // Chapitres à extraire en échec, puis fin de la compilation si plus rien n'est actif
+                extractChaptersFromDocument(QString());
+                finishBuildIfIdle();
+            }
+        });
         return;
     }
+    startFullDocument(tempFilePath, documentFiles);
+}
+
+bool LatexAssembler::startFullDocument(const QString& tempFilePath, const QVector<QPair<QString, QString>>& documentFiles)
+{
+    if (tempFilePath.isEmpty()) {
+        return false;
+    }
+    
+    // Pilote et fichiers lus inchangés : le PDF publié est repris (sauf en mode
+    // découpage, où les chapitres attendent les marqueurs d'une compilation)
+    QString upToDatePdf;
+    if (m_pendingChapterExtracts.isEmpty() && isUpToDate("document", tempFilePath, &upToDatePdf)) {
+        emit outputMessage(BuildTarget::Document, "Document complet à jour (aucune dépendance modifiée) : " + upToDatePdf);
+        emit fullDocumentCompilationFinished(true, upToDatePdf);
+        ++m_upToDateTargets;
+        return false;
+    }
     
     // Démarrer la compilation
+    trackDependencies("document", documentFiles);
     m_fullDocumentTempFile = tempFilePath;
-    m_fullDocumentCompilationCount = 1;
+    markBuildStarted();
     m_isCompilingFullDocument = true;
     
     emit fullDocumentCompilationStarted();
     
-    QFileInfo tempFileInfo(tempFilePath);
-    QStringList args;
-    args << "-synctex=1"
-         << "-shell-escape"
-         << "-interaction=nonstopmode"
-         << "-file-line-error"
-         << "-max-print-line=10000" // Ajouter cette option
-         << tempFilePath;
-
-    // Lancer la compilation
-    if (!m_fullDocumentProcessRunner->runCommand("lualatex", args, m_fullDocumentOutputWidget, tempFileInfo.absolutePath())) {
-        emit compilationError("Échec du lancement de la compilation du document complet");
-        m_isCompilingFullDocument = false;
-    }
+    startFigureGeneration(BuildTarget::Document);
+    
+    CompileJobSpec spec = jobSpec(BuildTarget::Document, "document", tempFilePath);
+    m_documentPool->setMaxParallelJobs(1);
+    m_documentPool->enqueue(spec);
+    return true;
 }
 
-QVector<QPair<QString, QString>> LatexAssembler::collectAllDocumentFiles(LatexModel* model)
+void LatexAssembler::compileChaptersAndDocument(LatexModel* model, const QSet<QString>& changedFiles)
 {
-    QVector<QPair<QString, QString>> documentFiles;
+    if (!m_chaptersFromDocument) {
+        compileChapters(model, changedFiles);
+        compileFullDocument(model);
+        return;
+    }
     
-    // Fonction récursive pour parcourir tout le modèle en une seule passe
-    std::function<void(const QModelIndex&)> collectFiles = [&](const QModelIndex& parent) {
-        for (int i = 0; i < model->rowCount(parent); ++i) {
-            QModelIndex index = model->index(i, 0, parent);
-            QString nodeName = model->data(index, Qt::DisplayRole).toString();
-            QString nodePath = model->data(index, Qt::ToolTipRole).toString();
-            
-            qDebug() << "Examen du nœud:" << nodeName << "Chemin:" << nodePath;
-            
-            // Si c'est un nœud de premier niveau qui est un dossier spécial, l'ignorer complètement
-            if (parent == QModelIndex() && (nodeName == "PEDA" || nodeName == "DOCS" || nodeName == "EVALS")) {
-                continue; // On ignore complètement ces dossiers racine
-            }
-            
-            // Si c'est un dossier spécial au sein d'un chapitre, explorer pour trouver les fichiers non-_cours
-            if (nodeName == "PEDA" || nodeName == "DOCS" || nodeName == "EVALS") {
-                qDebug() << "👉 Explorer le contenu du dossier spécial:" << nodeName;
-                // On continue à explorer le dossier, mais on ne l'ajoute pas lui-même
-                collectFiles(index);
-                continue;
-            }
-            
-            // Si c'est un fichier .tex valide
-            if (!nodePath.isEmpty() && QFile::exists(nodePath) && nodePath.endsWith(".tex")) {
-                // Ne pas ajouter les fichiers _cours
-                if (nodePath.contains("_cours")) {
-                    qDebug() << "❌ Fichier _cours exclu:" << nodePath;
-                    
-                    // Explorer récursivement les enfants du _cours pour ne pas les perdre
-                    if (model->hasChildren(index)) {
-                        collectFiles(index);
-                    }
-                } else {
-                    // IMPORTANT: Pour tous les autres fichiers .tex, les ajouter à la collection
-                    documentFiles.append(qMakePair(nodeName, nodePath));
-                    qDebug() << "✅ Ajout du fichier" << nodePath << "au document complet";
-                }
-            } 
-            // Si ce n'est pas un fichier .tex ou s'il n'existe pas, c'est peut-être un dossier
-            else if (model->hasChildren(index)) {
-                qDebug() << "👉 Explorer les enfants de:" << nodeName;
-                collectFiles(index);
-            }
+    // Une seule compilation : les chapitres sont extraits du PDF du document complet
+    emit outputMessage(BuildTarget::Chapter, "=== CHAPITRES EXTRAITS DU DOCUMENT COMPLET ===\n");
+    
+    m_pendingChapterExtracts.clear();
+    const QVector<ChapterInfo> chapters = buildPlan(model).chapters;
+    QSet<QString> dependents = dependencies().targetsUsing(changedFiles);
+    for (const ChapterInfo& chapter : chapters) {
+        if (changedFiles.isEmpty() || containsAnyFile(chapter.files, changedFiles) ||
+            dependents.contains("chapitre/" + chapter.name)) {
+            m_pendingChapterExtracts.insert(chapter.name);
         }
-    };
+    }
+    if (m_pendingChapterExtracts.isEmpty()) {
+        emit outputMessage(BuildTarget::Chapter, "Aucun chapitre à extraire.");
+    }
+    
+    compileFullDocument(model);
     
-    // Démarrer la collecte depuis la racine
-    collectFiles(QModelIndex());
+    // Document non lancé (aucun fichier, préambule illisible) : chapitres en échec
+    if (!m_isCompilingFullDocument) {
+        extractChaptersFromDocument(QString());
+    }
+}
+
+QVector<LatexAssembler::DocumentShard> LatexAssembler::splitDocumentShards(
+    LatexModel* model, const QVector<QPair<QString, QString>>& files)
+{
+    QVector<DocumentShard> shards;
+    const QHash<QString, QString>& chapterByFile = buildPlan(model).chapterByFile;
+    QSet<QString> usedNames;
+    QString currentChapter;
     
-    qDebug() << "=== RÉSUMÉ DES FICHIERS COLLECTÉS ===";
-    qDebug() << "Total des fichiers collectés pour le document complet:" << documentFiles.size();
-    for (const auto& file : documentFiles) {
-        qDebug() << "Fichier à inclure:" << file.first << "-" << file.second;
+    // Un tronçon par suite de fichiers d'un même chapitre, dans l'ordre du document ;
+    // les fichiers hors chapitre restent avec le tronçon courant
+    for (const auto& file : files) {
+        QString chapter = chapterByFile.value(QFileInfo(file.second).absoluteFilePath());
+        if (shards.isEmpty() || (!chapter.isEmpty() && chapter != currentChapter)) {
+            DocumentShard shard;
+            QString baseName = chapter.isEmpty() ? QString("debut") : chapter;
+            shard.name = baseName;
+            for (int suffix = 2; usedNames.contains(shard.name); ++suffix) {
+                shard.name = baseName + "_" + QString::number(suffix);
+            }
+            usedNames.insert(shard.name);
+            shards.append(shard);
+            currentChapter = chapter;
+        }
+        shards.last().files.append(file);
     }
     
-    return documentFiles;
+    return shards;
 }
 
-QString LatexAssembler::createFullDocumentTempFile(const QString& preamble, const QVector<QPair<QString, QString>>& files)
+QString LatexAssembler::createShardTempFile(const QString& preamble, const QVector<DocumentShard>& shards, int index,
+                                            const QString& jobRoot)
 {
-    if (!s_documentTempDir.isValid()) {
-        emit compilationError("Impossible de créer un répertoire temporaire pour le document complet");
+    const DocumentShard& shard = shards.at(index);
+    TraceScope trace("assemblage", "assemblage du tronçon " + shard.name);
+    trace.setArg("fichiers", shard.files.size());
+    
+    // Répertoire conservé d'une compilation à l'autre : le .aux du tronçon limite les relances
+    static const QRegularExpression invalidChars("[^A-Za-z0-9]");
+    QString jobDir = jobRoot + "/" + QString(shard.name).replace(invalidChars, "_");
+    if (!QDir().mkpath(jobDir)) {
+        emit compilationError("Impossible de créer le répertoire du tronçon " + shard.name);
         return QString();
     }
     
-    // Générer un nom unique pour le fichier temporaire
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-    QString tempFileName = s_documentTempDir.path() + "/temp_full_document_" + timestamp + ".tex";
+    DocumentShardCache cache(m_mainFilePath);
     
+    // Compteurs de départ : ceux de la fin du tronçon précédent à la dernière compilation
+    QFile seedFile(jobDir + "/" + DocumentShardCache::seedFileName());
+    if (!seedFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        emit compilationError("Impossible d'écrire les compteurs du tronçon " + shard.name);
+        return QString();
+    }
+    if (index > 0) {
+        seedFile.write(seedCounters(cache.counters(shards.at(index - 1).name)).toUtf8());
+    }
+    seedFile.close();
+    
+    // Étiquettes des autres tronçons : références croisées résolues dès la première passe
+    QFile referencesFile(jobDir + "/" + DocumentShardCache::referencesFileName());
+    if (!referencesFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        emit compilationError("Impossible d'écrire les références du tronçon " + shard.name);
+        return QString();
+    }
+    referencesFile.write("\\makeatletter\n");
+    for (int i = 0; i < shards.size(); ++i) {
+        if (i == index) {
+            continue;
+        }
+        const QStringList labels = cache.labels(shards.at(i).name);
+        for (const QString& label : labels) {
+            referencesFile.write(label.toUtf8() + "\n");
+        }
+    }
+    referencesFile.write("\\makeatother\n");
+    referencesFile.close();
+    
+    QString tempFileName = jobDir + "/" + DocumentShardCache::driverBaseName() + ".tex";
     QFile tempFile(tempFileName);
     if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        emit compilationError("Impossible de créer le fichier temporaire pour le document complet");
+        emit compilationError("Impossible de créer le fichier pilote du tronçon " + shard.name);
         return QString();
     }
     
     QTextStream out(&tempFile);
-    
-    // Écrire le préambule
     out << preamble;
     
-    // Obtenir le chemin absolu du dossier contenant le fichier principal
-    QFileInfo mainFileInfo(m_mainFilePath);
-    QString mainDirPath = mainFileInfo.absolutePath();
-    
-    // Ajouter la configuration des chemins d'images
-    out << "% Configuration des chemins d'images pour le document temporaire\n";
-    out << "\\graphicspath{{"
-        << QDir::toNativeSeparators(mainDirPath + "/images/").replace("\\", "/") << "}{"
-        << QDir::toNativeSeparators(mainDirPath + "/../images/").replace("\\", "/") << "}}\n\n";
-    
-    // Ajouter la configuration des en-têtes et pieds de page
-    out << "% Configuration des en-têtes et pieds de page\n";
-    out << "\\lhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\monetablissement}}}} %haut de page gauche\n";
-    out << "\\chead{} %haut de page centre\n";
-    out << "\\rhead{\\textcolor{gris50}{\\small\\textit{\\hyperlink{debut}{\\maclasse}}}} %haut de page droit\n";
-    out << "\\lfoot{} %pied de page gauche\n";
-    out << "\\cfoot{\\textcolor{gris50}{\\small\\textit{page \\thepage}}} % pied de page centré\n";
-    out << "\\rfoot{} %On personnalisera cette en-tête\n";
-    out << "\\def\\headrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
-    out << "\\def\\footrulewidth{0pt} %Trace un trait de séparation de largeur 0,4 point. Mettre 0pt pour supprimer le trait.\n";
-    out << "\\pagestyle{empty}\n\n";
-    
-    // Début du document
-    out << "\\begin{document}\n\n";
-    
-    // Ajouter la configuration de l'espacement
-    out << "\\singlespacing\\setlength{\\parindent}{0pt}\n\n";
-    
-    // Vérifier que nous avons des fichiers à inclure
-    if (files.isEmpty()) {
-        qDebug() << "ATTENTION: Aucun fichier à inclure dans le document complet!";
-    }
-    
-    // Ajouter le contenu des fichiers sélectionnés
-    int filesProcessed = 0;
-    for (const auto& file : files) {
+    // Départ : compteurs et références lus après le .aux ; fin : tous les compteurs
+    // (ceux que \include sauvegarde) écrits pour le tronçon suivant
+    out << "% Tronçon : compteurs de départ, références des autres tronçons\n";
+    out << "\\makeatletter\n";
+    out << "\\AtBeginDocument{\\InputIfFileExists{" << DocumentShardCache::seedFileName() << "}{}{}"
+        << "\\InputIfFileExists{" << DocumentShardCache::referencesFileName() << "}{}{}}\n";
+    out << "\\newwrite\\CompilationSelectiveCompteurs\n";
+    out << "\\newcommand\\CompilationSelectiveEcrireCompteur[1]{\\immediate\\write\\CompilationSelectiveCompteurs"
+           "{\\string\\setcounter{#1}{\\the\\csname c@#1\\endcsname}}}\n";
+    out << "\\AddToHook{enddocument/afterlastpage}{\\begingroup"
+           "\\immediate\\openout\\CompilationSelectiveCompteurs=\\jobname.compteurs\\relax"
+           "\\let\\@elt\\CompilationSelectiveEcrireCompteur\\cl@@ckpt"
+           "\\immediate\\closeout\\CompilationSelectiveCompteurs\\endgroup}\n";
+    out << "\\makeatother\n\n";
+    
+    // Chemins d'images, en-têtes et pieds de page, début du document
+    DriverWriter::writeDocumentSetup(out, m_mainFilePath);
+    
+    for (const auto& file : shard.files) {
         QFile inputFile(file.second);
         if (inputFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
             out << "% Contenu du fichier: " << file.second << "\n";
-            QString content = inputFile.readAll();
-            out << content << "\n\n";
+            out << substituteFigures(inputFile.readAll(), preamble) << "\n\n";
             inputFile.close();
-            filesProcessed++;
-            qDebug() << "✓ Inclusion réussie du fichier:" << file.second;
-        } else {
-            qDebug() << "⚠️ Impossible d'ouvrir le fichier:" << file.second;
         }
     }
     
-    qDebug() << "Fichiers traités:" << filesProcessed << "sur" << files.size() << "attendus";
-    
-    // Fin du document
     out << "\\end{document}\n";
-    
     tempFile.close();
     
-    qDebug() << "Fichier temporaire du document complet créé:" << tempFileName;
+    return tempFileName;
+}
+
+bool LatexAssembler::compileShardedDocument(LatexModel* model, const QString& preamble,
+                                            const QVector<QPair<QString, QString>>& files)
+{
+    if (!documentTempDir().isValid()) {
+        return false;
+    }
+    
+    QVector<DocumentShard> shards = splitDocumentShards(model, files);
+    if (shards.size() < 2) {
+        emit outputMessage(BuildTarget::Document, "Un seul chapitre : document complet compilé d'un seul tenant.\n");
+        return false;
+    }
     
-    // Ajouter à la liste pour le nettoyage des fichiers temporaires de document
-    m_documentTempFiles.append(tempFileName);
+    // Sources en défaut : aucun tronçon n'est lancé
+    if (!passesPreflight(BuildTarget::Document, "du document complet", files)) {
+        extractChaptersFromDocument(QString());
+        return true;
+    }
     
-    return tempFileName;
+    checkBuildRootCap(BuildTarget::Document);
+    for (int i = 0; i < shards.size(); ++i) {
+        shards[i].texFile = createShardTempFile(preamble, shards, i, documentTempDir().path() + "/troncons");
+        if (shards[i].texFile.isEmpty()) {
+            return false;
+        }
+    }
+    
+    // Le nombre de compilations simultanées des chapitres, sinon un tronçon par cœur
+    int parallelJobs = m_chapterJobs > 0 ? m_chapterJobs : QThread::idealThreadCount();
+    parallelJobs = qBound(1, parallelJobs, int(shards.size()));
+    m_documentPool->setMaxParallelJobs(parallelJobs);
+    emit outputMessage(BuildTarget::Document, QString("Document complet en %1 tronçons, %2 compilations simultanées\n")
+                                              .arg(shards.size()).arg(parallelJobs));
+    
+    m_documentShards = shards;
+    m_documentChapterOrder.clear();
+    m_documentChapterByFile.clear();
+    m_fullDocumentUnits.clear();
+    m_fullDocumentTempFile = documentTempDir().path() + "/troncons/document.tex";
+    markBuildStarted();
+    m_isCompilingFullDocument = true;
+    
+    emit fullDocumentCompilationStarted();
+    startFigureGeneration(BuildTarget::Document);
+    
+    for (const DocumentShard& shard : shards) {
+        m_documentPool->enqueue(jobSpec(BuildTarget::Document, shard.name, shard.texFile));
+    }
+    return true;
 }
 
-QString LatexAssembler::renameFullDocumentPdf(const QString& tempFilePath)
+void LatexAssembler::onShardJobFinished(const QString& shardName, bool success, int exitCode, const QString& pdfPath)
 {
-    // Obtenir les informations sur les fichiers
-    QFileInfo tempFileInfo(tempFilePath);
-    QFileInfo mainFileInfo(m_mainFilePath);
+    qDebug() << "Processus TRONÇON" << shardName << "terminé avec code:" << exitCode;
     
-    // S'assurer qu'on utilise le vrai chemin du document principal
-    if (m_mainFilePath.isEmpty() || !mainFileInfo.exists()) {
-        return QString(); // Impossible de renommer sans chemin valide
+    bool allFinished = true;
+    for (DocumentShard& shard : m_documentShards) {
+        if (shard.name == shardName) {
+            shard.finished = true;
+            shard.success = success && exitCode == 0 && QFile::exists(pdfPath);
+        }
+        allFinished = allFinished && shard.finished;
+    }
+    
+    if (exitCode != 0) {
+        emit outputMessage(BuildTarget::Document, "\n\n*** ERREUR dans la compilation du tronçon " +
+                           shardName + " (code " + QString::number(exitCode) + ") ***\n");
     }
     
-    // Récupérer le nom de fichier principal (sans extension)
-    QString baseName = mainFileInfo.completeBaseName();
+    if (allFinished) {
+        mergeDocumentShards();
+    }
+}
+
+void LatexAssembler::mergeDocumentShards()
+{
+    const QVector<DocumentShard> shards = m_documentShards;
+    m_documentShards.clear();
+    m_isCompilingFullDocument = false;
     
-    // Générer un timestamp formaté
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy_MM_dd_HH_mm_ss");
+    bool allSucceeded = true;
+    for (const DocumentShard& shard : shards) {
+        allSucceeded = allSucceeded && shard.success;
+    }
     
-    // Chemin du nouveau fichier PDF dans le même répertoire que le document principal
-    QString newPdfName = mainFileInfo.absolutePath() + "/" + baseName + "_complet_" + timestamp + ".pdf";
+    QString documentPdf;
+    if (!allSucceeded) {
+        emit compilationError("Erreur LaTeX détectée dans un tronçon du document complet");
+        emit fullDocumentCompilationFinished(false, "");
+    } else {
+        TraceScope trace("publication", "fusion des tronçons", "document");
+        trace.setArg("troncons", shards.size());
+        
+        int pageCount = 0;
+        bool numberingShifted = false;
+        QString mergedPdf = QFileInfo(m_fullDocumentTempFile).absolutePath() + "/" +
+                            QFileInfo(m_fullDocumentTempFile).completeBaseName() + ".pdf";
+        if (mergeShardPdfs(BuildTarget::Document, shards, mergedPdf, &pageCount, &numberingShifted)) {
+            emit outputMessage(BuildTarget::Document, QString("\nDocument complet fusionné : %1 tronçons, %2 pages")
+                                                      .arg(shards.size()).arg(pageCount));
+            if (numberingShifted) {
+                emit outputMessage(BuildTarget::Document, "Numérotation différente de la compilation précédente : "
+                                                          "elle sera exacte à la prochaine compilation.");
+            }
+            documentPdf = renameFullDocumentPdf(m_fullDocumentTempFile);
+        }
+        
+        if (!documentPdf.isEmpty()) {
+            emit fullDocumentCompilationFinished(true, documentPdf);
+            emit pdfAvailable(documentPdf);
+        } else {
+            emit compilationError("Erreur lors de la fusion des tronçons du document complet");
+            emit fullDocumentCompilationFinished(false, "");
+        }
+    }
     
-    // Chemin du PDF original généré
-    QString originalPdf = tempFileInfo.absolutePath() + "/" + tempFileInfo.completeBaseName() + ".pdf";
+    // Mode découpage : chaque chapitre demandé est déjà le PDF de son tronçon
+    bool chaptersPending = !m_pendingChapterExtracts.isEmpty();
+    static const QRegularExpression invalidChars("[^A-Za-z0-9]");
+    for (const DocumentShard& shard : shards) {
+        if (!m_pendingChapterExtracts.remove(shard.name)) {
+            continue;
+        }
+        emit chapterCompilationStarted(shard.name);
+        
+        QString finalPdfName;
+        QFileInfo texInfo(shard.texFile);
+        QString extractBase = chapterTempDir().path() + "/extrait_" + QString(shard.name).replace(invalidChars, "_");
+        QFile::remove(extractBase + ".pdf");
+        if (shard.success && QFile::copy(texInfo.absolutePath() + "/" + texInfo.completeBaseName() + ".pdf",
+                                         extractBase + ".pdf")) {
+            finalPdfName = renameChapterPdf(extractBase + ".tex", shard.name);
+        }
+        emit chapterCompilationFinished(shard.name, !finalPdfName.isEmpty(), finalPdfName);
+    }
+    if (!m_pendingChapterExtracts.isEmpty()) {
+        extractChaptersFromDocument(QString());
+    } else if (chaptersPending) {
+        emit allChaptersCompiled();
+    }
     
-    if (QFile::exists(originalPdf)) {
-        // Copier le fichier vers sa destination finale
-        if (QFile::copy(originalPdf, newPdfName)) {
-            // Supprimer l'original si la copie a réussi
-            QFile::remove(originalPdf);
-            
-            // Stocker le chemin du dernier PDF généré
-            m_lastPdfPath = newPdfName;
-            
-            return newPdfName;
+    finishBuildIfIdle();
+}
+
+bool LatexAssembler::mergeShardPdfs(BuildTarget target, const QVector<DocumentShard>& shards,
+                                    const QString& mergedPdf, int* pageCount, bool* numberingShifted)
+{
+    // Liens nommés conservés : chaque ancre vient du tronçon qui la définit
+    PdfWriter writer;
+    writer.setKeepNamedDestinations(true);
+    DocumentShardCache cache(m_mainFilePath);
+    QVector<PdfDocument> documents(shards.size());
+    *numberingShifted = false;
+    
+    for (int i = 0; i < shards.size(); ++i) {
+        QFileInfo texInfo(shards.at(i).texFile);
+        QString jobDir = texInfo.absolutePath();
+        QString pdfPath = jobDir + "/" + texInfo.completeBaseName() + ".pdf";
+        
+        if (!documents[i].load(pdfPath)) {
+            emit outputMessage(target, "Fusion impossible : " + documents[i].errorString());
+            return false;
+        }
+        writer.appendDocument(documents[i]);
+        writer.importNamedDestinations(documents[i], DocumentShardCache::anchorsFromAux(
+                                           jobDir + "/" + texInfo.completeBaseName() + ".aux"));
+        
+        // Compteurs de fin pour la prochaine compilation ; un départ différent de la
+        // fin actuelle du tronçon précédent signale une numérotation encore décalée
+        cache.store(shards.at(i).name, jobDir);
+        if (i > 0) {
+            QFile seedFile(jobDir + "/" + DocumentShardCache::seedFileName());
+            QString usedSeed = seedFile.open(QIODevice::ReadOnly | QIODevice::Text)
+                               ? QString::fromUtf8(seedFile.readAll()) : QString();
+            if (usedSeed != seedCounters(cache.counters(shards.at(i - 1).name))) {
+                *numberingShifted = true;
+            }
         }
     }
     
-    return QString(); // Retourner une chaîne vide en cas d'échec
+    QString error;
+    if (!writer.write(mergedPdf, &error)) {
+        emit outputMessage(target, "Fusion impossible : " + error);
+        return false;
+    }
+    *pageCount = writer.pageCount();
+    return true;
 }
 
-void LatexAssembler::processFullDocument()
+QVector<LatexAssembler::DocumentShard> LatexAssembler::splitChapterShards(const ChapterInfo& chapter)
 {
-    // Cette méthode est appelée lorsqu'un document complet est prêt à être traité
-    // après avoir été mis en file d'attente
+    QVector<DocumentShard> shards;
+    int fileCount = chapter.files.size();
+    if (m_chapterShardFiles <= 0 || fileCount <= m_chapterShardFiles) {
+        return shards;
+    }
     
-    if (m_isCompilingFullDocument) {
-        qDebug() << "Déjà en train de compiler un document complet, ignoré";
+    // Blocs insécables : fichiers consécutifs d'une même section (ou d'un même
+    // groupe PEDA/DOCS/EVALS), recoupés si la section dépasse le seuil à elle seule.
+    // La taille des sources sert d'estimation du temps de composition
+    struct Block {
+        int first = 0;
+        int count = 0;
+        qint64 bytes = 0;
+    };
+    QVector<Block> blocks;
+    qint64 totalBytes = 0;
+    for (int i = 0; i < fileCount; ++i) {
+        QString section = chapter.sections.value(i);
+        if (blocks.isEmpty() || blocks.last().count >= m_chapterShardFiles ||
+            section != chapter.sections.value(blocks.last().first)) {
+            blocks.append(Block{ i, 0, 0 });
+        }
+        qint64 bytes = qMax<qint64>(1, m_fileStats.stat(chapter.files.at(i).second).size);
+        blocks.last().count++;
+        blocks.last().bytes += bytes;
+        totalBytes += bytes;
+    }
+    
+    // Tronçons consécutifs de tailles voisines : le suivant commence quand le
+    // tronçon courant a atteint sa part du chapitre ou ne peut plus recevoir le bloc
+    int shardCount = qMin(int(blocks.size()), (fileCount + m_chapterShardFiles - 1) / m_chapterShardFiles);
+    qint64 assignedBytes = 0;
+    int shardFiles = 0;
+    for (const Block& block : blocks) {
+        bool full = shardFiles + block.count > m_chapterShardFiles;
+        bool shareReached = !shards.isEmpty() && assignedBytes >= totalBytes * shards.size() / shardCount;
+        if (shards.isEmpty() || full || shareReached) {
+            DocumentShard shard;
+            shard.name = QString("%1_partie%2").arg(chapter.name).arg(shards.size() + 1);
+            shards.append(shard);
+            shardFiles = 0;
+        }
+        shards.last().files.append(chapter.files.mid(block.first, block.count));
+        shardFiles += block.count;
+        assignedBytes += block.bytes;
+    }
+    
+    return shards;
+}
+
+QString LatexAssembler::chapterShardRoot(const QString& chapterName) const
+{
+    static const QRegularExpression invalidChars("[^A-Za-z0-9]");
+    return chapterTempDir().path() + "/troncons_" + QString(chapterName).replace(invalidChars, "_");
+}
+
+bool LatexAssembler::startShardedChapter(const QString& preamble, const ChapterInfo& chapter)
+{
+    QVector<DocumentShard> shards = splitChapterShards(chapter);
+    if (shards.size() < 2) {
+        return false;
+    }
+    
+    emit outputMessage(BuildTarget::Chapter, "\n\n*******************************************************");
+    emit outputMessage(BuildTarget::Chapter, QString("***********   CHAPITRE : %1       **************").arg(chapter.name));
+    emit outputMessage(BuildTarget::Chapter, "*******************************************************\n\n");
+    emit chapterCompilationStarted(chapter.name);
+    
+    // Les sources sont copiées dans les pilotes des tronçons : vérifiées ici
+    if (!passesPreflight(BuildTarget::Chapter, "du chapitre " + chapter.name, chapter.files)) {
+        emit chapterCompilationFinished(chapter.name, false, "");
+        return true;
+    }
+    
+    QString jobRoot = chapterShardRoot(chapter.name);
+    for (int i = 0; i < shards.size(); ++i) {
+        shards[i].texFile = createShardTempFile(preamble, shards, i, jobRoot);
+        if (shards[i].texFile.isEmpty()) {
+            emit chapterCompilationFinished(chapter.name, false, "");
+            return true;
+        }
+    }
+    
+    widenChapterPool();
+    emit outputMessage(BuildTarget::Chapter,
+                       QString("Chapitre %1 en %2 tronçons (%3 fichiers), %4 compilations simultanées\n")
+                       .arg(chapter.name).arg(shards.size()).arg(chapter.files.size())
+                       .arg(m_chapterPool->maxParallelJobs()));
+    
+    // Pas de contrôle de mise à jour : le PDF publié est une fusion, sans pilote unique
+    m_chapterShards.insert(chapter.name, shards);
+    startFigureGeneration(BuildTarget::Chapter);
+    for (const DocumentShard& shard : shards) {
+        m_chapterOfShard.insert(shard.name, chapter.name);
+        m_chapterPool->enqueue(jobSpec(BuildTarget::Chapter, shard.name, shard.texFile));
+    }
+    return true;
+}
+
+void LatexAssembler::onChapterShardFinished(const QString& shardName, bool success, int exitCode, const QString& pdfPath)
+{
+    qDebug() << "Processus TRONÇON DE CHAPITRE" << shardName << "terminé avec code:" << exitCode;
+    QString chapterName = m_chapterOfShard.take(shardName);
+    
+    bool allFinished = true;
+    QVector<DocumentShard>& shards = m_chapterShards[chapterName];
+    for (DocumentShard& shard : shards) {
+        if (shard.name == shardName) {
+            shard.finished = true;
+            shard.success = success && exitCode == 0 && QFile::exists(pdfPath);
+        }
+        allFinished = allFinished && shard.finished;
+    }
+    
+    if (exitCode != 0) {
+        emit outputMessage(BuildTarget::Chapter, "\n\n*** ERREUR dans la compilation du tronçon " +
+                           shardName + " (code " + QString::number(exitCode) + ") ***\n");
+    }
+    
+    if (allFinished) {
+        mergeChapterShards(chapterName, m_chapterShards.take(chapterName));
+    }
+}
+
+void LatexAssembler::mergeChapterShards(const QString& chapterName, const QVector<DocumentShard>& shards)
+{
+    bool allSucceeded = true;
+    for (const DocumentShard& shard : shards) {
+        allSucceeded = allSucceeded && shard.success;
+    }
+    if (!allSucceeded) {
+        emit outputMessage(BuildTarget::Chapter, "\n\n*** ERREUR dans un tronçon du chapitre " + chapterName + " ***\n");
+        emit chapterCompilationFinished(chapterName, false, "");
         return;
     }
     
-    // Démarrer la compilation du document complet
-    m_fullDocumentCompilationCount = 1;
-    m_isCompilingFullDocument = true;
+    TraceScope trace("publication", "fusion des tronçons " + chapterName, chapterName);
+    trace.setArg("troncons", shards.size());
+    
+    // Nom de fichier factice : renameChapterPdf publie le .pdf voisin. Répertoire
+    // pris des tronçons (la racine a pu basculer sur disque depuis leur lancement)
+    QString mergedBase = QFileInfo(QFileInfo(shards.first().texFile).absolutePath()).absolutePath() + "/chapitre";
+    int pageCount = 0;
+    bool numberingShifted = false;
+    QString finalPdfName;
+    if (mergeShardPdfs(BuildTarget::Chapter, shards, mergedBase + ".pdf", &pageCount, &numberingShifted)) {
+        emit outputMessage(BuildTarget::Chapter, QString("\nChapitre %1 fusionné : %2 tronçons, %3 pages")
+                                                 .arg(chapterName).arg(shards.size()).arg(pageCount));
+        if (numberingShifted) {
+            emit outputMessage(BuildTarget::Chapter, "Numérotation différente de la compilation précédente : "
+                                                     "elle sera exacte à la prochaine compilation.");
+        }
+        finalPdfName = renameChapterPdf(mergedBase + ".tex", chapterName);
+    }
+    emit chapterCompilationFinished(chapterName, !finalPdfName.isEmpty(), finalPdfName);
+}
+
+QString LatexAssembler::createFullDocumentTempFile(const QString& preamble, const QVector<QPair<QString, QString>>& files)
+{
+    if (!documentTempDir().isValid()) {
+        emit compilationError("Impossible de créer un répertoire temporaire pour le document complet");
+        return QString();
+    }
+    
+    DriverRequest request = driverRequest(BuildTarget::Document, "document", preamble, files);
+    return adoptDriver(BuildTarget::Document, DriverWriter::write(request));
+}
+
+QString LatexAssembler::renameFullDocumentPdf(const QString& tempFilePath)
+{
+    TraceScope trace("publication", "publication du document", "document");
     
-    // Afficher un message de début dans le widget de sortie
-    if (m_fullDocumentOutputWidget) {
-        m_fullDocumentOutputWidget->append("=== COMPILATION DU DOCUMENT COMPLET ===\n");
+    // S'assurer qu'on utilise le vrai chemin du document principal
+    QFileInfo mainFileInfo(m_mainFilePath);
+    if (m_mainFilePath.isEmpty() || !mainFileInfo.exists()) {
+        return QString(); // Impossible de renommer sans chemin valide
     }
     
-    emit fullDocumentCompilationStarted();
-    emit fullDocumentCompilationProgress(m_fullDocumentCompilationCount, 5);
-    
-    // Lancer le processus de compilation avec lualatex
-    QFileInfo tempFileInfo(m_fullDocumentTempFile);
-    QStringList args;
-    args << "-synctex=1"
-         << "-shell-escape"
-         << "-interaction=nonstopmode"
-         << "-file-line-error"
-         << "-max-print-line=10000" // Ajouter cette option
-         << m_fullDocumentTempFile;
-
-    if (!m_fullDocumentProcessRunner->runCommand("lualatex", args, m_fullDocumentOutputWidget, tempFileInfo.absolutePath())) {
-        emit compilationError("Échec du lancement de la compilation du document complet");
-        m_isCompilingFullDocument = false;
+    QString newPdfName = publishPdf(tempFilePath, mainFileInfo.completeBaseName() + "_complet", BuildTarget::Document);
+    if (!newPdfName.isEmpty()) {
+        // Stocker le chemin du dernier PDF généré
+        m_lastPdfPath = newPdfName;
+    }
+    return newPdfName;
+}
+
+QString LatexAssembler::publishPdf(const QString& tempFilePath, const QString& baseName, BuildTarget target)
+{
+    // PDF généré à côté du fichier pilote, publié à côté du document principal
+    QFileInfo tempFileInfo(tempFilePath);
+    QString originalPdf = tempFileInfo.absolutePath() + "/" + tempFileInfo.completeBaseName() + ".pdf";
+    QString directory = QFileInfo(m_mainFilePath).absolutePath();
+    
+    qDebug() << "Publication du PDF:" << originalPdf << "->" << directory << baseName;
+    
+    bool unchanged = false;
+    QString published = m_publisher.publish(originalPdf, directory, baseName, &unchanged);
+    if (unchanged) {
+        emit outputMessage(target, "PDF identique à la version précédente, conservée : " + published);
     }
-}
\ No newline at end of file
+    return published;
+}
+
@@ -3,47 +3,200 @@
 #include <QString>
 #include <QVector>
 #include <QFileInfo>
-#include <QTextEdit>
-#include <QQueue>
-#include <QMutex>
+#include <QStringList>
+#include <QSet>
+#include <QMap>
 #include <QTemporaryDir>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <functional>
 #include "latexparser.h"
 #include "latexmodel.h"
 #include "processrunner.h"
+#include "jobpool.h"
+#include "buildstats.h"
+#include "compileprofile.h"
+#include "includeunitcache.h"
+#include "documentshardcache.h"
+#include "warmworkerpool.h"
+#include "texcachemanager.h"
+#include "tikzfigurecache.h"
+#include "dependencystore.h"
+#include "artifactpublisher.h"
+#include "buildroot.h"
+#include "buildplanner.h"
+#include "filestatcache.h"
+#include "driverwriter.h"
+#include "culpritfinder.h"
 
 class LatexAssembler : public QObject
 {
     Q_OBJECT
 
 public:
+    // Cibles de compilation, chacune ayant son propre flux de sortie
+    enum class BuildTarget {
+        Partial,
+        Chapter,
+        Document
+    };
+    Q_ENUM(BuildTarget)
+
     explicit LatexAssembler(QObject* parent = nullptr);
     ~LatexAssembler();
-    
+
+    // Fichier principal utilisé par les chapitres et le document complet
+    // (également défini par createPartialDocument)
+    void setMainFilePath(const QString& mainFilePath) { m_mainFilePath = mainFilePath; }
+
     // Crée un fichier temporaire pour la compilation partielle
     QString createPartialDocument(const QString& mainFilePath, LatexModel* model);
-    
+
+    // Assemble le partiel en arrière-plan et le compile dès que son pilote est
+    // écrit, sans figer l'interface ; faux si rien n'est lancé (erreur signalée)
+    bool buildPartialDocument(const QString& mainFilePath, LatexModel* model,
+                              bool compileChapter, bool compileDocument);
+
     // Compile le document partiel
-    void compilePartialDocument(const QString& tempFilePath, QTextEdit* outputWidget, 
-                               bool compileChapter, bool compileDocument);
-    
+    void compilePartialDocument(const QString& tempFilePath, bool compileChapter, bool compileDocument);
+
     // Renomme le fichier PDF généré
     QString renameFinalPdf(const QString& tempFilePath, const QString& mainFilePath);
-    
+
     // Nouvelles méthodes pour la compilation des chapitres
-    void compileChapters(LatexModel* model, QTextEdit* outputWidget);
-    
+    // (si changedFiles n'est pas vide, seuls les chapitres contenant l'un de ces fichiers)
+    void compileChapters(LatexModel* model, const QSet<QString>& changedFiles = QSet<QString>());
+
+    // Exercices séparés : chaque fichier coché des groupes PEDA/DOCS/EVALS est
+    // compilé seul, en parallèle comme les chapitres (même file, même profil,
+    // préambule commun), et publié sous le nom de son nœud
+    void compileExercises(LatexModel* model);
+
     // Nouvelle méthode pour compiler le document complet
-    void compileFullDocument(LatexModel* model, QTextEdit* outputWidget);
+    void compileFullDocument(LatexModel* model);
+
+    // Chapitres et document complet demandés ensemble : en mode découpage, une seule
+    // compilation du document puis extraction des pages de chaque chapitre
+    void compileChaptersAndDocument(LatexModel* model, const QSet<QString>& changedFiles = QSet<QString>());
+
+    // Mode surveillance : recompile uniquement les cibles dont une entrée a changé,
+    // le partiel d'abord puis, s'il réussit, les chapitres et le document concernés
+    void compileChangedTargets(LatexModel* model, const QStringList& changedFiles,
+                               bool compilePartial, bool compileChapter, bool compileDocument);
 
     // Arrête toutes les compilations en cours
     void stopCompilation();
-    
+
     // Indique si une compilation est en cours
     bool isCompiling() const;
 
+    // Indique si au moins une cible (partiel, chapitres, document) est active
+    bool isBusy() const { return m_buildInProgress; }
+    
+    // Recherche du fichier qui fait échouer une cible (partiel, chapitre nommé ou
+    // document complet) : compilations d'essai en parallèle, une par cœur, avec le
+    // préambule commun et le moteur du partiel en une passe ; bilan dans le flux
+    // de la cible puis culpritSearchFinished
+    bool findCulprit(LatexModel* model, BuildTarget target, const QString& chapterName = QString());
+    bool isSearchingCulprit() const { return m_culpritFinder->isRunning(); }
+
+    // Délais de supervision appliqués à chaque processus lancé
+    void setProcessLimits(const ProcessLimits& limits);
+
+    // Nombre de chapitres compilés simultanément ; 0 (par défaut) : un chapitre à
+    // la fois, mais un tronçon ou un exercice par cœur
+    void setMaxParallelJobs(int count);
+
+    // Profil de compilation de chaque cible (moteur, options, passes)
+    void setProfile(BuildTarget target, const CompileProfile& profile);
+    CompileProfile profile(BuildTarget target) const;
+
+    // Choisit les profils par nom pour les cibles "partiel", "chapitre" et "document" ;
+    // retourne faux si une cible ou un profil est inconnu (les autres sont appliqués)
+    bool selectProfiles(const QVector<CompileProfile>& available, const QMap<QString, QString>& targets);
+
+    // Programme imposé à toutes les cibles à la place du moteur de leur profil
+    // (vide par défaut, ou la variable d'environnement COMPILATION_SELECTIVE_ENGINE)
+    void setEngineProgram(const QString& program) { m_engineProgram = program; }
+    QString engineProgram() const { return m_engineProgram; }
+
+    // Mode \includeonly : le document complet est compilé en unités \include dont
+    // les .aux sont conservés ; le partiel et les chapitres ne composent ensuite que
+    // leurs unités, avec la numérotation du document complet, en une seule passe
+    void setIncludeOnlyMode(bool enabled) { m_includeOnlyMode = enabled; }
+    bool includeOnlyMode() const { return m_includeOnlyMode; }
+
+    // Mode découpage : les PDF de chapitres sont des extraits du PDF du document
+    // complet (chaque chapitre y commence alors sur une nouvelle page)
+    void setChaptersFromDocument(bool enabled) { m_chaptersFromDocument = enabled; }
+    bool chaptersFromDocument() const { return m_chaptersFromDocument; }
+
+    // Mode tronçons : le document complet est compilé chapitre par chapitre en parallèle,
+    // avec les compteurs et références de la compilation précédente, puis les PDF
+    // sont fusionnés (signets et liens reconstruits)
+    void setShardedDocument(bool enabled) { m_shardedDocument = enabled; }
+    bool shardedDocument() const { return m_shardedDocument; }
+
+    // Chapitres en tronçons : un chapitre de plus de files fichiers (0 : désactivé)
+    // est compilé en tronçons d'au plus files fichiers, coupés de préférence entre
+    // deux sections ou groupes PEDA/DOCS/EVALS, en parallèle dans la file des
+    // chapitres, puis fusionnés en un seul PDF comme le document en tronçons
+    void setChapterShardFiles(int files) { m_chapterShardFiles = qMax(0, files); }
+    int chapterShardFiles() const { return m_chapterShardFiles; }
+
+    // Processus préchauffés pour le partiel (0 : désactivé) : lancés sur le préambule
+    // du dernier partiel, ils ne composent que le corps du suivant. Réservé aux
+    // profils LuaLaTeX en une passe ; sinon compilation classique
+    void setWarmWorkers(int count);
+    int warmWorkers() const { return m_warmPool->size(); }
+
+    // Cache des figures TikZ : chaque tikzpicture est remplacée par son PDF, pris
+    // dans un cache commun aux cibles ; les figures manquantes sont générées en
+    // parallèle avant la passe principale
+    void setTikzFigureCache(bool enabled) { m_tikzFigureCache = enabled; }
+    bool tikzFigureCache() const { return m_tikzFigureCache; }
+
+    // Dépendances réelles (-recorder) : un chapitre ou un document dont le pilote
+    // et les fichiers lus n'ont pas changé depuis sa dernière compilation réussie
+    // n'est pas recompilé (son PDF publié est repris), sauf compilation forcée
+    void setForceRebuild(bool enabled) { m_forceRebuild = enabled; }
+    bool forceRebuild() const { return m_forceRebuild; }
+    
+    // Vérifications préalables des sources de chaque cible (fichiers, encodage,
+    // accolades, environnements, imports, étiquettes) : une cible en défaut
+    // échoue avec ses diagnostics fichier:ligne, sans lancer le moteur
+    void setPreflightChecks(bool enabled) { m_preflightChecks = enabled; }
+    bool preflightChecks() const { return m_preflightChecks; }
+
+    // Fichiers lus par les compilations réussies (images, .bib...), à surveiller
+    // en plus des sources de l'arborescence
+    QStringList dependencyFiles();
+
+    // Cibles reprises sans compilation depuis la création de l'assembleur
+    int upToDateTargets() const { return m_upToDateTargets; }
+
+    // Racine des fichiers intermédiaires (temporaire, disque choisi ou RAM) ;
+    // appliquée dès qu'aucune compilation n'est en cours
+    void setBuildRoot(const BuildRootSettings& settings);
+
+    // Conservation des PDF publiés dans le répertoire des sources, par cible
+    void setPublishPolicy(const PublishPolicy& policy) { m_publisher.setPolicy(policy); }
+
     // Getter pour le dernier PDF généré
     QString getLastPdfPath() const { return m_lastPdfPath; }
 
+    // Mesures de ressources de la dernière compilation (toutes cibles confondues)
+    const BuildStats& buildStats() const { return m_buildStats; }
+
+    // Étapes de l'assemblage, utilisables séparément (benchmarks)
+    using ChapterInfo = BuildPlan::Chapter;
+
+    QString extractPreamble(const QString& filePath);
+    // Nouveau parcours de l'arbre et nouvel instantané des fichiers
+    BuildPlan planBuild(LatexModel* model);
+    QString createChapterTempFile(const QString& preamble, const ChapterInfo& chapter);
+    QString createFullDocumentTempFile(const QString& preamble, const QVector<QPair<QString, QString>>& files);
+
 signals:
     void compilationStarted();
     void compilationProgress(int current, int total);
@@ -58,72 +211,272 @@ signals:
     void fullDocumentCompilationStarted();
     void fullDocumentCompilationProgress(int current, int total);
     void fullDocumentCompilationFinished(bool success, const QString& pdfPath);
-    
-    // SUPPRIMER ces signaux obsolètes :
-    // void rawPartialOutputReady(const QString& line);
-    // void rawChapterOutputReady(const QString& line);
-    // void rawDocumentOutputReady(const QString& line);
 
-private slots:
-    void processNextChapter();
-    void processFullDocument();
+    // Sortie des processus (lignes brutes) et messages de l'assembleur, par cible
+    void outputLines(LatexAssembler::BuildTarget target, const QStringList& lines);
+    void outputMessage(LatexAssembler::BuildTarget target, const QString& message);
 
-private:
-    QString extractPreamble(const QString& filePath);
-    QVector<QPair<QString, QString>> collectSelectedFiles(LatexModel* model);
-    QString createTempFile(const QString& preamble, const QVector<QPair<QString, QString>>& files);
+    // Émis quand toutes les cibles sont terminées, avec le bilan des ressources
+    void buildStatsReady(const QString& summary);
+
+    // Émis au lancement de la première cible d'une compilation
+    void buildStarted();
+
+    // Émis quand toutes les cibles sont terminées (succès ou échec)
+    void buildFinished();
     
-    // Nouvelles méthodes privées pour la gestion des chapitres
-    struct ChapterInfo {
+    // Fin de la recherche du fichier en cause (culprits vide : échec non reproduit)
+    void culpritSearchFinished(LatexAssembler::BuildTarget target, const QStringList& culprits,
+                               const QString& summary);
+
+private:
+    QString renameChapterPdf(const QString& tempFilePath, const QString& chapterName);
+    QString renameFullDocumentPdf(const QString& tempFilePath);
+
+    // Publie le PDF d'un pilote sous <baseName>_<horodatage>.pdf et <baseName>_latest.pdf
+    QString publishPdf(const QString& tempFilePath, const QString& baseName, BuildTarget target);
+
+    // Fichier pilote listant toutes les unités, limité par \includeonly si includeOnly n'est pas vide
+    QString createUnitDriver(const QString& jobDir, const QString& preamble,
+                             const QVector<IncludeUnit>& units, const QStringList& includeOnly);
+
+    // Pilote \includeonly pour ces fichiers ; vide si le cache ne le permet pas
+    // (l'appelant revient alors à l'assemblage classique)
+    QString createIncludeOnlyDocument(const QString& jobDir, const QString& preamble,
+                                      const QVector<QPair<QString, QString>>& files, BuildTarget target);
+
+    // Découpe le PDF du document complet en PDF de chapitres (pdfPath vide : échec)
+    void extractChaptersFromDocument(const QString& pdfPath);
+
+    // Tronçon du document complet : fichiers consécutifs d'un même chapitre
+    struct DocumentShard {
         QString name;
-        QString path;
+        QString texFile;
         QVector<QPair<QString, QString>> files;
+        bool finished = false;
+        bool success = false;
     };
+    QVector<DocumentShard> splitDocumentShards(LatexModel* model, const QVector<QPair<QString, QString>>& files);
+
+    // Pilote d'un tronçon dans jobRoot/<nom du tronçon> (document ou chapitre)
+    QString createShardTempFile(const QString& preamble, const QVector<DocumentShard>& shards, int index,
+                                const QString& jobRoot);
+
+    // Fusionne les PDF des tronçons dans mergedPdf et range leurs compteurs et
+    // étiquettes pour la compilation suivante ; faux si la fusion échoue (signalé)
+    bool mergeShardPdfs(BuildTarget target, const QVector<DocumentShard>& shards, const QString& mergedPdf,
+                        int* pageCount, bool* numberingShifted);
+
+    // Lance les tronçons ; faux si le document doit être compilé d'un seul tenant
+    bool compileShardedDocument(LatexModel* model, const QString& preamble,
+                                const QVector<QPair<QString, QString>>& files);
+    void onShardJobFinished(const QString& shardName, bool success, int exitCode, const QString& pdfPath);
+    void mergeDocumentShards();
+
+    // Chapitres en tronçons : découpage (vide si le chapitre reste entier),
+    // lancement, fin de chaque tronçon et fusion
+    QVector<DocumentShard> splitChapterShards(const ChapterInfo& chapter);
+    QString chapterShardRoot(const QString& chapterName) const;
+    bool startShardedChapter(const QString& preamble, const ChapterInfo& chapter);
+    void onChapterShardFinished(const QString& shardName, bool success, int exitCode, const QString& pdfPath);
+    void mergeChapterShards(const QString& chapterName, const QVector<DocumentShard>& shards);
+
+    // Corps du partiel pour un processus préchauffé, si le profil le permet
+    bool canUseWarmWorkers() const;
+    void writeWarmPartialBody(const QString& tempFileName, const QString& setup, const QString& body);
+    void prepareWarmWorkers();
+
+    // Commande d'une compilation selon le profil de sa cible
+    CompileJobSpec jobSpec(BuildTarget target, const QString& id, const QString& texFile) const;
+
+    // Fin d'une compilation, par cible
+    void onPartialJobFinished(bool success, int exitCode, const QString& pdfPath);
+    void onChapterJobFinished(const QString& chapterName, bool success, int exitCode, const QString& pdfPath);
+    void onDocumentJobFinished(bool success, int exitCode, const QString& pdfPath);
+
+    // Cibles lancées après le partiel en mode surveillance
+    struct DeferredTargets {
+        LatexModel* model = nullptr;
+        QSet<QString> changedFiles;     // Vide : tous les chapitres sélectionnés
+        bool compileChapter = false;
+        bool compileDocument = false;
+    };
+    DeferredTargets m_deferredTargets;
+    void compileDeferredTargets(const DeferredTargets& targets);
+
+    // Suivi d'une compilation complète (toutes cibles) et de ses mesures
+    void markBuildStarted();
+
+    // Avant d'assembler hors compilation : nouvelle racine demandée, bascule
+    // sur disque si le plafond RAM est dépassé
+    void prepareBuildRoot();
+
+    // Pendant une compilation, avant d'écrire les fichiers d'un chapitre ou de
+    // tronçons : bascule sur disque si le plafond en RAM est dépassé
+    void checkBuildRootCap(BuildTarget target);
+    bool m_buildRootPending = false;
+    BuildRootSettings m_pendingBuildRoot;
+
+    // Cache TeX de l'application : base de polices mise à jour avant la première
+    // compilation LuaLaTeX, les files étant retenues jusque-là
+    void startTexCacheWarmUp();
+    void onTexCacheWarmUpFinished(bool success, const QString& summary, const ProcessResult& result);
+
+    // Files des cibles retenues tant qu'une préparation (cache TeX, figures) est en cours
+    void holdPools();
+    void releasePools();
+    void emitToWaitingTargets(const QString& message);
+
+    // Figures TikZ : substitution dans un fichier assemblé, génération des figures
+    // relevées comme manquantes (appelée avant la mise en file de la cible)
+    QString substituteFigures(const QString& content, const QString& preamble);
+    QString createFigureTempFile(const TikzFigureCache::Figure& figure);
+    void startFigureGeneration(BuildTarget target);
+    void onFigureJobFinished(const QString& id, bool success, int exitCode, const QString& pdfPath);
+    // Dépendances d'une cible : sources assemblées relevées à la mise en file,
+    // complétées à la fin par le journal -recorder du pilote
+    void trackDependencies(const QString& target, const QVector<QPair<QString, QString>>& files);
+    void recordDependencies(const QString& target, const QString& driverPath, const QString& pdfPath);
+    bool isUpToDate(const QString& target, const QString& driverPath, QString* pdfPath);
+
+    // Plan de la compilation en cours, calculé une fois pour toutes les cibles ;
+    // oublié à la fin de la compilation, au début de la suivante et quand le
+    // modèle change
+    const BuildPlan& buildPlan(LatexModel* model);
+    void invalidateBuildPlan();
+
+    // Assemblage des pilotes en arrière-plan (QtConcurrent) : la suite est exécutée
+    // dans le thread principal, sauf si la compilation a été arrêtée entre-temps
+    DriverRequest driverRequest(BuildTarget target, const QString& id, const QString& preamble,
+                                const QVector<QPair<QString, QString>>& files);
+    void assembleInBackground(const DriverRequest& request, const std::function<void(const DriverResult&)>& done);
+    // Pilote écrit : figures manquantes reprises, fichier noté pour le nettoyage
+    // (vide et erreur signalée en cas d'échec)
+    QString adoptDriver(BuildTarget target, const DriverResult& result);
     
-    QVector<ChapterInfo> identifyChaptersToCompile(LatexModel* model);
-    QString createChapterTempFile(const QString& preamble, const ChapterInfo& chapter);
-    void compileChapter(const ChapterInfo& chapter, const QString& tempFilePath);
-    QString renameChapterPdf(const QString& tempFilePath, const QString& chapterName);
-    
-    // Nouvelles méthodes privées pour la gestion du document complet
-    QVector<QPair<QString, QString>> collectAllDocumentFiles(LatexModel* model);
-    QString createFullDocumentTempFile(const QString& preamble, const QVector<QPair<QString, QString>>& files);
-    QString renameFullDocumentPdf(const QString& tempFilePath);
+    // Diagnostics des vérifications préalables dans le flux de la cible
+    void reportPreflightIssues(BuildTarget target, const QString& error, const QVector<PreflightIssue>& issues);
     
-    ProcessRunner* m_processRunner;
-    ProcessRunner* m_chapterProcessRunner;
-    ProcessRunner* m_fullDocumentProcessRunner;
+    // Vérification préalable des cibles assemblées sans DriverWriter (mode
+    // \includeonly, tronçons) ; faux si elle échoue (erreur déjà signalée)
+    bool passesPreflight(BuildTarget target, const QString& label, const QVector<QPair<QString, QString>>& files);
+    int m_assemblyGeneration = 0;
+    int m_chapterAssemblies = 0;   // Pilotes de chapitres en cours d'écriture
+
+    // Lancement de chaque cible une fois son pilote prêt. Partiel : readyDriver
+    // est rempli si le mode \includeonly a déjà écrit le pilote
+    bool preparePartialDriver(LatexModel* model, DriverRequest* request, QString* readyDriver);
+    bool startPartialDocument(LatexModel* model, bool compileChapter, bool compileDocument);
+    // parallel : sans --jobs, une compilation par cœur (exercices séparés)
+    void startChapters(const QVector<ChapterInfo>& chapters, bool parallel = false);
+    // Sans --jobs, une compilation de chapitre par cœur jusqu'au prochain lot
+    void widenChapterPool();
+    void startChapter(const ChapterInfo& chapter, const QString& tempFilePath);
+    bool startFullDocument(const QString& tempFilePath, const QVector<QPair<QString, QString>>& documentFiles);
+    DependencyStore& dependencies();
+
+    void recordPass(const QString& target, const QString& label, const QString& profile,
+                    int pass, const ProcessResult& result);
+    void finishBuildIfIdle();
+
+    // Une file de compilations par cible ; seuls les chapitres sont parallélisés
+    JobPool* m_partialPool;
+    JobPool* m_chapterPool;
+    int m_chapterJobs = 0;   // Compilations simultanées demandées pour les chapitres (0 : non précisé)
+    JobPool* m_documentPool;
+    WarmWorkerPool* m_warmPool;
+    TexCacheManager* m_texCache;
+    JobPool* m_figurePool;
+    CulpritFinder* m_culpritFinder;
+    BuildTarget m_culpritTarget = BuildTarget::Partial;
+    int m_poolHolds = 0;
+
+    // Cache des figures TikZ et génération en cours
+    bool m_tikzFigureCache = false;
+    TikzFigureCache m_figureCache;
+    QSet<QString> m_figuresInProgress;
+    QElapsedTimer m_figureClock;
+    int m_figuresGenerated = 0;
+    int m_figureFailures = 0;
+
+    ArtifactPublisher m_publisher;
+
+    // Dépendances persistées et, par cible en cours, ses sources et l'heure de
+    // son lancement (signatures des fichiers modifiés ensuite non retenues)
+    struct PendingDependencies {
+        QStringList sources;
+        QDateTime startedAt;
+    };
+    DependencyStore m_dependencies;
+    QHash<QString, PendingDependencies> m_pendingDependencies;
+    bool m_forceRebuild = false;
+    bool m_preflightChecks = true;
+    int m_upToDateTargets = 0;
+
+    // Plan de la compilation en cours et instantané des fichiers qu'il partage
+    // avec le contrôle des dépendances
+    FileStatCache m_fileStats;
+    BuildPlan m_buildPlan;
+    LatexModel* m_planModel = nullptr;
+    bool m_buildPlanValid = false;
+
+    // Dernier partiel assemblé : pilote, préambule avec \begin{document} et corps seul
+    struct WarmPartial {
+        QString tempFile;
+        QString setup;
+        QString bodyFile;
+    };
+    WarmPartial m_warmPartial;
 
     // Variables pour la compilation partielle
     QString m_currentTempFile;
     bool m_isCompiling;
-    int m_compilationCount;
-    QTextEdit* m_partialOutputWidget;
-    
+
     // Variables pour la compilation des chapitres
-    QString m_currentChapterTempFile; // Pour les chapitres (variable séparée)
-    QString m_currentChapterName;     // Ajouté : nom du chapitre en cours de traitement
+    QHash<QString, QString> m_chapterTempFilesByName; // Fichier pilote de chaque chapitre en file
     bool m_isCompilingChapters;
-    int m_chapterCompilationCount;
-    QTextEdit* m_chapterOutputWidget;
-    QQueue<ChapterInfo> m_chapterQueue;
-    QMutex m_mutex;
-    
+
     // Variables pour le document complet
     QString m_fullDocumentTempFile;
+    QVector<IncludeUnit> m_fullDocumentUnits;  // Unités compilées (mode \includeonly)
     bool m_isCompilingFullDocument;
-    int m_fullDocumentCompilationCount;
-    QTextEdit* m_fullDocumentOutputWidget;
-    
+
+    // Profils par cible et moteur imposé (vide : celui du profil)
+    QMap<BuildTarget, CompileProfile> m_profiles;
+    QString m_engineProgram;
+
+    bool m_includeOnlyMode = false;
+
+    // Mode découpage : chapitres attendus, chapitre de chaque fichier du document
+    // (vide : pas de marqueurs) et ordre des chapitres marqués
+    bool m_chaptersFromDocument = false;
+    QSet<QString> m_pendingChapterExtracts;
+    QHash<QString, QString> m_documentChapterByFile;
+    QStringList m_documentChapterOrder;
+
+    // Mode tronçons et tronçons en cours (non vide : document complet en tronçons)
+    bool m_shardedDocument = false;
+    QVector<DocumentShard> m_documentShards;
+
+    // Chapitres en tronçons : seuil, tronçons en cours par chapitre et chapitre de
+    // chaque tronçon en file
+    int m_chapterShardFiles = 0;
+    QHash<QString, QVector<DocumentShard>> m_chapterShards;
+    QHash<QString, QString> m_chapterOfShard;
+
     // Chemin du fichier principal et du dernier PDF généré
     QString m_mainFilePath;
     QString m_lastPdfPath;
 
-    // Trois répertoires temporaires distincts
-    static QTemporaryDir s_partielTempDir;  // Pour la compilation partielle
-    static QTemporaryDir s_chapterTempDir;  // Pour la compilation des chapitres
-    static QTemporaryDir s_documentTempDir; // Pour la compilation du document complet
-    
+    // Mesures de la compilation en cours
+    BuildStats m_buildStats;
+    bool m_buildInProgress = false;
+
+    // Trois répertoires temporaires distincts, sous la racine de compilation
+    static QTemporaryDir& partielTempDir() { return BuildRoot::instance().dir(BuildRoot::Partial); }
+    static QTemporaryDir& chapterTempDir() { return BuildRoot::instance().dir(BuildRoot::Chapter); }
+    static QTemporaryDir& documentTempDir() { return BuildRoot::instance().dir(BuildRoot::Document); }
+
     // Listes séparées pour suivre les fichiers temporaires
     QVector<QString> m_partielTempFiles;   // Fichiers temporaires partiels
     QVector<QString> m_chapterTempFiles;   // Fichiers temporaires de chapitres
@@ -1,6 +1,7 @@
 #include "latexmodel.h"
 #include <QUrl>
 #include <QJsonObject>
+#include "tracer.h"
 
 LatexModel::LatexModel(QObject* parent) : QAbstractItemModel(parent) {}
 
@@ -11,6 +12,7 @@ void LatexModel::loadFromFile(const QString& filePath)
         localPath = QUrl(filePath).toLocalFile();
 
     qDebug() << "Chargement du fichier:" << localPath;
+    TraceScope trace("modele", "chargement du modèle");
 
     beginResetModel();
     m_root = LatexParser::parse(localPath);
@@ -22,6 +22,9 @@ public:
     Q_INVOKABLE bool hasChildren(const QModelIndex &index) const;
     bool hasData() const { return m_root != nullptr; }
 
+    // Racine de l'arbre, parcourue directement par le planificateur de compilation
+    const LatexNode* rootNode() const { return m_root.get(); }
+
     // Pour sauvegarder/restaurer l'état des cases à cocher
     QJsonObject saveCheckState() const;
     void restoreCheckState(const QJsonObject& state);
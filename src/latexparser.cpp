@@ -4,9 +4,12 @@
 #include <QRegularExpression>
 #include <QTextStream>
 #include <QDebug>
+#include "tracer.h"
 
 std::shared_ptr<LatexNode> LatexParser::parse(const QString& filePath, const QString& baseDir)
 {
+    TraceScope trace("analyse", "analyse " + QFileInfo(filePath).fileName());
+
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         qDebug() << "Impossible d'ouvrir le fichier:" << filePath;
@@ -0,0 +1,75 @@
+#include "logclassifier.h"
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+
+LogClassifier::LineKind LogClassifier::classify(const QString& taggedLine)
+{
+    if (taggedLine.isEmpty()) {
+        return LineKind::Normal;
+    }
+
+    // Ignorer le préfixe "[chapitre] " ajouté lors des compilations parallèles
+    static const QRegularExpression tagPattern("^\\[[^\\]]*\\] ");
+    QString line = taggedLine;
+    line.remove(tagPattern);
+
+    // Détection du message de succès
+    static const QRegularExpression successPattern("Processus.*termin.*code.*0",
+                                                   QRegularExpression::CaseInsensitiveOption);
+    if (line.contains(successPattern)) {
+        return LineKind::Success;
+    }
+
+    // Patterns pour les erreurs LaTeX (compilés une seule fois)
+    static const QVector<QRegularExpression> errorPatterns = [] {
+        const QStringList patterns = {
+            "^!\\s+",                    // Erreur LaTeX commençant par !
+            "Emergency stop",
+            "Fatal error",
+            "File ended",
+            "Runaway argument",
+            "Double subscript",
+            "Too many \\}",
+            "Illegal unit",
+            "cannot find",
+            "not found"
+        };
+        QVector<QRegularExpression> compiled;
+        for (const QString& pattern : patterns) {
+            compiled.append(QRegularExpression(pattern, QRegularExpression::CaseInsensitiveOption));
+        }
+        return compiled;
+    }();
+
+    // Patterns pour les warnings (y compris undefined)
+    static const QStringList warningPatterns = {
+        "Warning:",
+        "warning:",
+        "LaTeX Font Warning",
+        "Package.*Warning",
+        "Overfull",
+        "Underfull",
+        "undefined",              // Déplacé ici pour être en orange
+        "Undefined",
+        "hbox",
+        "vbox",
+        "Font shape.*undefined"   // Font warnings spécifiques
+    };
+
+    // Vérifier les patterns d'erreur
+    for (const QRegularExpression& re : errorPatterns) {
+        if (line.contains(re)) {
+            return LineKind::Error;
+        }
+    }
+
+    // Si ce n'est pas une erreur, vérifier les warnings
+    for (const QString& pattern : warningPatterns) {
+        if (line.contains(pattern, Qt::CaseInsensitive)) {
+            return LineKind::Warning;
+        }
+    }
+
+    return LineKind::Normal;
+}
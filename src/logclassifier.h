@@ -0,0 +1,17 @@
+#pragma once
+#include <QString>
+
+// Classification des lignes de journal LaTeX (erreurs, avertissements, succès)
+class LogClassifier
+{
+public:
+    enum class LineKind {
+        Normal,
+        Success,
+        Warning,
+        Error
+    };
+
+    // Détermine la nature d'une ligne de sortie
+    static LineKind classify(const QString& line);
+};
@@ -0,0 +1,80 @@
+#include "outputconsole.h"
+#include "logclassifier.h"
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextCharFormat>
+
+OutputConsole::OutputConsole(QTextEdit* outputWidget, QObject* parent)
+    : QObject(parent), m_outputWidget(outputWidget)
+{
+}
+
+void OutputConsole::appendLines(const QStringList& lines)
+{
+    if (!m_outputWidget) return;
+
+    for (const QString& line : lines) {
+        appendFormattedLine(line);
+    }
+
+    scrollToBottom();
+}
+
+void OutputConsole::appendMessage(const QString& message)
+{
+    if (!m_outputWidget) return;
+
+    m_outputWidget->append(message);
+}
+
+void OutputConsole::clear()
+{
+    if (m_outputWidget) {
+        m_outputWidget->clear();
+    }
+}
+
+void OutputConsole::appendFormattedLine(const QString& line)
+{
+    // Ne pas traiter les lignes complètement vides
+    if (line.isEmpty()) {
+        m_outputWidget->append("");
+        return;
+    }
+
+    QTextCursor cursor = m_outputWidget->textCursor();
+    cursor.movePosition(QTextCursor::End);
+
+    QTextCharFormat format;
+    switch (LogClassifier::classify(line)) {
+        case LogClassifier::LineKind::Success:
+            format.setForeground(QBrush(QColor("#00a000")));
+            format.setFontWeight(QFont::Bold);
+            break;
+        case LogClassifier::LineKind::Error:
+            format.setForeground(QBrush(Qt::red));
+            break;
+        case LogClassifier::LineKind::Warning:
+            format.setForeground(QBrush(QColor("#ff8800"))); // Orange
+            break;
+        case LogClassifier::LineKind::Normal:
+            format.setForeground(QBrush(Qt::black));
+            break;
+    }
+
+    cursor.insertText(line + "\n", format);
+
+    // Réinitialiser le format
+    QTextCharFormat defaultFormat;
+    defaultFormat.setForeground(QBrush(Qt::black));
+    defaultFormat.setFontWeight(QFont::Normal);
+    cursor.setCharFormat(defaultFormat);
+    m_outputWidget->setTextCursor(cursor);
+}
+
+void OutputConsole::scrollToBottom()
+{
+    // Auto-scroll
+    QScrollBar* scrollBar = m_outputWidget->verticalScrollBar();
+    scrollBar->setValue(scrollBar->maximum());
+}
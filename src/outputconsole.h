@@ -0,0 +1,35 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QPointer>
+#include <QTextEdit>
+
+// Affiche dans un QTextEdit les lignes produites par ProcessRunner/LatexAssembler,
+// avec la coloration des erreurs, avertissements et messages de succès.
+// C'est un consommateur de sortie parmi d'autres (fichier journal, CLI...).
+class OutputConsole : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OutputConsole(QTextEdit* outputWidget, QObject* parent = nullptr);
+
+    QTextEdit* outputWidget() const { return m_outputWidget; }
+
+public slots:
+    // Ajoute un lot de lignes issues d'un processus (avec coloration)
+    void appendLines(const QStringList& lines);
+
+    // Ajoute un message informatif (séparateurs, bilans...)
+    void appendMessage(const QString& message);
+
+    // Vide la console
+    void clear();
+
+private:
+    QPointer<QTextEdit> m_outputWidget;
+
+    void appendFormattedLine(const QString& line);
+    void scrollToBottom();
+};
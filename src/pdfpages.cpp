@@ -0,0 +1,1603 @@
+#include "pdfpages.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+namespace {
+
+bool isWhitespace(char c)
+{
+    return c == '\0' || c == '\t' || c == '\n' || c == '\f' || c == '\r' || c == ' ';
+}
+
+bool isDelimiter(char c)
+{
+    return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' ||
+           c == '{' || c == '}' || c == '/' || c == '%';
+}
+
+bool isRegular(char c)
+{
+    return !isWhitespace(c) && !isDelimiter(c);
+}
+
+bool isInteger(const QByteArray& token, bool allowSign = true)
+{
+    if (token.isEmpty()) {
+        return false;
+    }
+    int start = (allowSign && (token.at(0) == '+' || token.at(0) == '-')) ? 1 : 0;
+    if (start == token.size()) {
+        return false;
+    }
+    for (int i = start; i < token.size(); ++i) {
+        if (token.at(i) < '0' || token.at(i) > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isNumberToken(const QByteArray& token)
+{
+    bool digits = false;
+    bool dot = false;
+    for (int i = 0; i < token.size(); ++i) {
+        char c = token.at(i);
+        if (c >= '0' && c <= '9') {
+            digits = true;
+        } else if (c == '.' && !dot) {
+            dot = true;
+        } else if ((c == '+' || c == '-') && i == 0) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return digits;
+}
+
+// Analyseur de la syntaxe PDF sur un tampon (fichier ou flux d'objets décodé)
+class PdfParser
+{
+public:
+    PdfParser(const QByteArray& data, qint64 position = 0) : m_data(data), m_pos(position) {}
+
+    qint64 position() const { return m_pos; }
+    void setPosition(qint64 position) { m_pos = position; }
+    bool atEnd() const { return m_pos >= m_data.size(); }
+
+    void skipWhitespace()
+    {
+        while (m_pos < m_data.size()) {
+            char c = m_data.at(m_pos);
+            if (isWhitespace(c)) {
+                m_pos++;
+            } else if (c == '%') {
+                while (m_pos < m_data.size() && m_data.at(m_pos) != '\n' && m_data.at(m_pos) != '\r') {
+                    m_pos++;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+
+    // Mot-clé ou nombre
+    QByteArray readToken()
+    {
+        skipWhitespace();
+        qint64 start = m_pos;
+        while (m_pos < m_data.size() && isRegular(m_data.at(m_pos))) {
+            m_pos++;
+        }
+        return m_data.mid(start, m_pos - start);
+    }
+
+    bool startsWith(const char* keyword) const
+    {
+        qint64 length = qstrlen(keyword);
+        return m_pos + length <= m_data.size() && std::memcmp(m_data.constData() + m_pos, keyword, length) == 0;
+    }
+
+    bool readObject(PdfObject& object, int depth = 0)
+    {
+        if (depth > 256) {
+            return false;
+        }
+        skipWhitespace();
+        if (atEnd()) {
+            return false;
+        }
+
+        object = PdfObject();
+        char c = m_data.at(m_pos);
+
+        if (c == '/') {
+            m_pos++;
+            object.type = PdfObject::Type::Name;
+            object.text = readName();
+            return true;
+        }
+
+        if (c == '(') {
+            m_pos++;
+            object.type = PdfObject::Type::String;
+            return readLiteralString(object.text);
+        }
+
+        if (c == '<' && at(m_pos + 1) == '<') {
+            m_pos += 2;
+            object.type = PdfObject::Type::Dictionary;
+            for (;;) {
+                skipWhitespace();
+                if (atEnd()) {
+                    return false;
+                }
+                if (at(m_pos) == '>' && at(m_pos + 1) == '>') {
+                    m_pos += 2;
+                    return true;
+                }
+                if (at(m_pos) != '/') {
+                    return false;
+                }
+                m_pos++;
+                QByteArray key = readName();
+                PdfObject value;
+                if (!readObject(value, depth + 1)) {
+                    return false;
+                }
+                object.entries.emplace_back(key, value);
+            }
+        }
+
+        if (c == '<') {
+            m_pos++;
+            object.type = PdfObject::Type::HexString;
+            return readHexString(object.text);
+        }
+
+        if (c == '[') {
+            m_pos++;
+            object.type = PdfObject::Type::Array;
+            for (;;) {
+                skipWhitespace();
+                if (atEnd()) {
+                    return false;
+                }
+                if (at(m_pos) == ']') {
+                    m_pos++;
+                    return true;
+                }
+                PdfObject item;
+                if (!readObject(item, depth + 1)) {
+                    return false;
+                }
+                object.items.push_back(item);
+            }
+        }
+
+        qint64 start = m_pos;
+        QByteArray token = readToken();
+        if (token.isEmpty()) {
+            return false;
+        }
+        if (token == "true" || token == "false") {
+            object.type = PdfObject::Type::Boolean;
+            object.text = token;
+            return true;
+        }
+        if (token == "null") {
+            return true;
+        }
+        if (!isNumberToken(token)) {
+            m_pos = start;
+            return false;
+        }
+
+        // "n g R" : référence vers un objet indirect
+        if (isInteger(token, false)) {
+            qint64 afterNumber = m_pos;
+            QByteArray generation = readToken();
+            if (isInteger(generation, false)) {
+                skipWhitespace();
+                if (at(m_pos) == 'R' && (m_pos + 1 >= m_data.size() || !isRegular(at(m_pos + 1)))) {
+                    m_pos++;
+                    object.type = PdfObject::Type::Reference;
+                    object.objectNumber = token.toInt();
+                    object.generation = generation.toInt();
+                    return true;
+                }
+            }
+            m_pos = afterNumber;
+        }
+
+        object.type = PdfObject::Type::Number;
+        object.text = token;
+        return true;
+    }
+
+private:
+    const QByteArray& m_data;
+    qint64 m_pos;
+
+    char at(qint64 index) const { return index < m_data.size() ? m_data.at(index) : '\0'; }
+
+    QByteArray readName()
+    {
+        QByteArray name;
+        while (m_pos < m_data.size() && isRegular(m_data.at(m_pos))) {
+            char c = m_data.at(m_pos++);
+            if (c == '#' && m_pos + 1 < m_data.size()) {
+                bool ok = false;
+                int value = m_data.mid(m_pos, 2).toInt(&ok, 16);
+                if (ok) {
+                    name.append(char(value));
+                    m_pos += 2;
+                    continue;
+                }
+            }
+            name.append(c);
+        }
+        return name;
+    }
+
+    bool readLiteralString(QByteArray& out)
+    {
+        int nesting = 1;
+        while (m_pos < m_data.size()) {
+            char c = m_data.at(m_pos++);
+            if (c == '\\') {
+                if (m_pos >= m_data.size()) {
+                    return false;
+                }
+                char next = m_data.at(m_pos++);
+                switch (next) {
+                    case 'n': out.append('\n'); break;
+                    case 'r': out.append('\r'); break;
+                    case 't': out.append('\t'); break;
+                    case 'b': out.append('\b'); break;
+                    case 'f': out.append('\f'); break;
+                    case '\r':
+                        if (at(m_pos) == '\n') {
+                            m_pos++;
+                        }
+                        break;
+                    case '\n':
+                        break;
+                    default:
+                        if (next >= '0' && next <= '7') {
+                            int value = next - '0';
+                            for (int i = 0; i < 2 && at(m_pos) >= '0' && at(m_pos) <= '7'; ++i) {
+                                value = value * 8 + (m_data.at(m_pos++) - '0');
+                            }
+                            out.append(char(value & 0xFF));
+                        } else {
+                            out.append(next);
+                        }
+                }
+            } else if (c == '(') {
+                nesting++;
+                out.append(c);
+            } else if (c == ')') {
+                if (--nesting == 0) {
+                    return true;
+                }
+                out.append(c);
+            } else {
+                out.append(c);
+            }
+        }
+        return false;
+    }
+
+    bool readHexString(QByteArray& out)
+    {
+        QByteArray digits;
+        while (m_pos < m_data.size()) {
+            char c = m_data.at(m_pos++);
+            if (c == '>') {
+                if (digits.size() % 2) {
+                    digits.append('0');
+                }
+                out = QByteArray::fromHex(digits);
+                return true;
+            }
+            if (!isWhitespace(c)) {
+                digits.append(c);
+            }
+        }
+        return false;
+    }
+};
+
+QByteArray inflateData(const QByteArray& input, bool* ok)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit(&stream) != Z_OK) {
+        *ok = false;
+        return QByteArray();
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    QByteArray output;
+    char buffer[65536];
+    int result = Z_OK;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        result = inflate(&stream, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+            break;
+        }
+        output.append(buffer, int(sizeof(buffer) - stream.avail_out));
+        if (result == Z_BUF_ERROR) {
+            break;   // Entrée épuisée
+        }
+    } while (result != Z_STREAM_END);
+    inflateEnd(&stream);
+
+    // Flux tronqués tolérés (fréquents en fin de flux d'objets)
+    *ok = result == Z_STREAM_END || (!output.isEmpty() && stream.avail_in == 0);
+    return output;
+}
+
+// Prédicteurs PNG (flux xref et flux d'objets de pdfTeX/LuaTeX)
+QByteArray unpredictPng(const QByteArray& input, int columns, int colors, int bitsPerComponent)
+{
+    int bytesPerPixel = qMax(1, colors * bitsPerComponent / 8);
+    int rowLength = (columns * colors * bitsPerComponent + 7) / 8;
+    QByteArray output;
+    QByteArray previous(rowLength, '\0');
+
+    for (int pos = 0; pos + 1 + rowLength <= input.size(); pos += rowLength + 1) {
+        int filter = static_cast<unsigned char>(input.at(pos));
+        QByteArray row = input.mid(pos + 1, rowLength);
+        for (int i = 0; i < rowLength; ++i) {
+            int left = i >= bytesPerPixel ? static_cast<unsigned char>(row.at(i - bytesPerPixel)) : 0;
+            int up = static_cast<unsigned char>(previous.at(i));
+            int upLeft = i >= bytesPerPixel ? static_cast<unsigned char>(previous.at(i - bytesPerPixel)) : 0;
+            int value = static_cast<unsigned char>(row.at(i));
+            switch (filter) {
+                case 1: value += left; break;
+                case 2: value += up; break;
+                case 3: value += (left + up) / 2; break;
+                case 4: {
+                    int p = left + up - upLeft;
+                    int pa = qAbs(p - left);
+                    int pb = qAbs(p - up);
+                    int pc = qAbs(p - upLeft);
+                    value += (pa <= pb && pa <= pc) ? left : (pb <= pc ? up : upLeft);
+                    break;
+                }
+                default: break;
+            }
+            row[i] = char(value & 0xFF);
+        }
+        output.append(row);
+        previous = row;
+    }
+    return output;
+}
+
+// Décode un flux (FlateDecode et prédicteurs PNG uniquement)
+bool decodeStream(const PdfDocument* document, const PdfObject& dictionary, const QByteArray& raw, QByteArray* out)
+{
+    auto resolve = [document](const PdfObject& value) {
+        return document ? document->resolve(value) : value;
+    };
+
+    PdfObject filter = resolve(dictionary.value("Filter"));
+    PdfObject parameters = resolve(dictionary.value("DecodeParms"));
+    if (filter.isArray()) {
+        if (filter.items.size() > 1) {
+            return false;
+        }
+        filter = filter.items.empty() ? PdfObject() : resolve(filter.items.front());
+    }
+    if (parameters.isArray()) {
+        parameters = parameters.items.empty() ? PdfObject() : resolve(parameters.items.front());
+    }
+
+    if (filter.isNull()) {
+        *out = raw;
+        return true;
+    }
+    if (!filter.isName("FlateDecode") && !filter.isName("Fl")) {
+        return false;
+    }
+
+    bool ok = false;
+    QByteArray data = inflateData(raw, &ok);
+    if (!ok) {
+        return false;
+    }
+
+    int predictor = parameters.isDictionary() ? int(resolve(parameters.value("Predictor")).toInteger()) : 1;
+    if (predictor >= 10) {
+        auto parameter = [&](const char* key, int fallback) {
+            PdfObject value = resolve(parameters.value(key));
+            return value.isNumber() ? int(value.toInteger()) : fallback;
+        };
+        data = unpredictPng(data, parameter("Columns", 1), parameter("Colors", 1), parameter("BitsPerComponent", 8));
+    } else if (predictor != 1) {
+        return false;
+    }
+
+    *out = data;
+    return true;
+}
+
+} // namespace
+
+// --- PdfObject ---
+
+const PdfObject* PdfObject::get(const QByteArray& key) const
+{
+    for (const auto& entry : entries) {
+        if (entry.first == key) {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+PdfObject PdfObject::value(const QByteArray& key) const
+{
+    const PdfObject* found = get(key);
+    return found ? *found : PdfObject();
+}
+
+void PdfObject::set(const QByteArray& key, const PdfObject& value)
+{
+    for (auto& entry : entries) {
+        if (entry.first == key) {
+            entry.second = value;
+            return;
+        }
+    }
+    entries.emplace_back(key, value);
+}
+
+void PdfObject::remove(const QByteArray& key)
+{
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&key](const std::pair<QByteArray, PdfObject>& entry) { return entry.first == key; }),
+                  entries.end());
+}
+
+PdfObject PdfObject::number(qint64 value)
+{
+    PdfObject object;
+    object.type = Type::Number;
+    object.text = QByteArray::number(value);
+    return object;
+}
+
+PdfObject PdfObject::name(const QByteArray& value)
+{
+    PdfObject object;
+    object.type = Type::Name;
+    object.text = value;
+    return object;
+}
+
+PdfObject PdfObject::string(const QByteArray& bytes)
+{
+    PdfObject object;
+    object.type = Type::String;
+    object.text = bytes;
+    return object;
+}
+
+PdfObject PdfObject::textString(const QString& text)
+{
+    bool ascii = true;
+    for (QChar c : text) {
+        if (c.unicode() < 32 || c.unicode() > 126) {
+            ascii = false;
+            break;
+        }
+    }
+    if (ascii) {
+        return string(text.toLatin1());
+    }
+
+    // UTF-16BE précédé de l'indicateur d'ordre des octets
+    PdfObject object;
+    object.type = Type::HexString;
+    object.text = QByteArray("\xFE\xFF", 2);
+    for (QChar c : text) {
+        object.text.append(char(c.unicode() >> 8));
+        object.text.append(char(c.unicode() & 0xFF));
+    }
+    return object;
+}
+
+PdfObject PdfObject::reference(int objectNumber)
+{
+    PdfObject object;
+    object.type = Type::Reference;
+    object.objectNumber = objectNumber;
+    return object;
+}
+
+PdfObject PdfObject::array()
+{
+    PdfObject object;
+    object.type = Type::Array;
+    return object;
+}
+
+PdfObject PdfObject::dictionary()
+{
+    PdfObject object;
+    object.type = Type::Dictionary;
+    return object;
+}
+
+QByteArray PdfObject::serialize() const
+{
+    switch (type) {
+        case Type::Null:
+            return "null";
+        case Type::Boolean:
+        case Type::Number:
+            return text;
+        case Type::Name: {
+            QByteArray out = "/";
+            for (char c : text) {
+                unsigned char u = static_cast<unsigned char>(c);
+                if (u < 33 || u > 126 || isDelimiter(c) || c == '#') {
+                    out += '#' + QByteArray::number(u, 16).rightJustified(2, '0').toUpper();
+                } else {
+                    out += c;
+                }
+            }
+            return out;
+        }
+        case Type::String: {
+            QByteArray out = "(";
+            for (char c : text) {
+                unsigned char u = static_cast<unsigned char>(c);
+                if (c == '(' || c == ')' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if (c == '\n') {
+                    out += "\\n";
+                } else if (c == '\r') {
+                    out += "\\r";
+                } else if (u < 32 || u > 126) {
+                    out += '\\' + QByteArray::number(u, 8).rightJustified(3, '0');
+                } else {
+                    out += c;
+                }
+            }
+            return out + ")";
+        }
+        case Type::HexString:
+            return "<" + text.toHex() + ">";
+        case Type::Array: {
+            QByteArray out = "[";
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (i > 0) {
+                    out += ' ';
+                }
+                out += items[i].serialize();
+            }
+            return out + "]";
+        }
+        case Type::Dictionary: {
+            QByteArray out = "<<";
+            for (const auto& entry : entries) {
+                out += name(entry.first).serialize() + ' ' + entry.second.serialize();
+            }
+            return out + ">>";
+        }
+        case Type::Reference:
+            return QByteArray::number(objectNumber) + ' ' + QByteArray::number(generation) + " R";
+    }
+    return "null";
+}
+
+QString PdfObject::decodedText() const
+{
+    if (text.startsWith("\xFE\xFF")) {
+        QString result;
+        for (int i = 2; i + 1 < text.size(); i += 2) {
+            result.append(QChar((static_cast<unsigned char>(text.at(i)) << 8) |
+                                static_cast<unsigned char>(text.at(i + 1))));
+        }
+        return result;
+    }
+    if (text.startsWith("\xEF\xBB\xBF")) {
+        return QString::fromUtf8(text.mid(3));
+    }
+    return QString::fromLatin1(text);
+}
+
+// --- PdfDocument ---
+
+int PdfDocument::s_nextId = 1;
+
+PdfDocument::PdfDocument() : m_id(s_nextId++)
+{
+}
+
+bool PdfDocument::load(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = "Impossible d'ouvrir " + filePath;
+        return false;
+    }
+    m_data = file.readAll();
+    file.close();
+
+    int header = m_data.indexOf("%PDF-");
+    if (header < 0 || header > 1024) {
+        m_error = filePath + " n'est pas un fichier PDF";
+        return false;
+    }
+
+    bool ok = false;
+    qint64 startxref = m_data.lastIndexOf("startxref");
+    if (startxref >= 0) {
+        PdfParser parser(m_data, startxref + 9);
+        bool isNumber = false;
+        qint64 offset = parser.readToken().toLongLong(&isNumber);
+        ok = isNumber && readXrefChain(offset);
+    }
+
+    // Table xref absente ou incohérente : reconstruction par balayage du fichier
+    if (!ok || !catalog().isDictionary()) {
+        m_xref.clear();
+        m_cache.clear();
+        m_objectStreamHeaders.clear();
+        m_objectStreamData.clear();
+        m_trailer = PdfObject();
+        if (!reconstructXref() || !catalog().isDictionary()) {
+            m_error = "Structure PDF illisible : " + filePath;
+            return false;
+        }
+    }
+
+    if (m_trailer.get("Encrypt")) {
+        m_error = "PDF chiffré non pris en charge : " + filePath;
+        return false;
+    }
+
+    if (!readPageTree()) {
+        m_error = "Aucune page trouvée dans " + filePath;
+        return false;
+    }
+    return true;
+}
+
+bool PdfDocument::readXrefChain(qint64 offset)
+{
+    QSet<qint64> visited;
+    while (offset > 0 && offset < m_data.size() && !visited.contains(offset)) {
+        visited.insert(offset);
+
+        PdfParser parser(m_data, offset);
+        parser.skipWhitespace();
+
+        qint64 previous = -1;
+        qint64 xrefStream = -1;
+        bool ok = parser.startsWith("xref")
+                ? readXrefTable(parser.position(), &previous, &xrefStream)
+                : readXrefStream(offset, &previous);
+        if (!ok) {
+            return false;
+        }
+
+        // Fichier hybride : les objets compressés sont décrits par un flux xref annexe
+        if (xrefStream > 0) {
+            qint64 ignored = -1;
+            readXrefStream(xrefStream, &ignored);
+        }
+        offset = previous;
+    }
+    return m_trailer.isDictionary();
+}
+
+bool PdfDocument::readXrefTable(qint64 offset, qint64* previous, qint64* xrefStream)
+{
+    PdfParser parser(m_data, offset + 4);
+    for (;;) {
+        QByteArray token = parser.readToken();
+        if (token == "trailer") {
+            PdfObject trailer;
+            if (!parser.readObject(trailer) || !trailer.isDictionary()) {
+                return false;
+            }
+            if (m_trailer.isNull()) {
+                m_trailer = trailer;
+            }
+            *previous = trailer.value("Prev").isNumber() ? trailer.value("Prev").toInteger() : -1;
+            *xrefStream = trailer.value("XRefStm").isNumber() ? trailer.value("XRefStm").toInteger() : -1;
+            return true;
+        }
+
+        bool ok = false;
+        qint64 start = token.toLongLong(&ok);
+        if (!ok) {
+            return false;
+        }
+        qint64 count = parser.readToken().toLongLong(&ok);
+        if (!ok) {
+            return false;
+        }
+
+        for (qint64 i = 0; i < count; ++i) {
+            qint64 entryOffset = parser.readToken().toLongLong();
+            parser.readToken();   // Génération
+            QByteArray kind = parser.readToken();
+            int number = int(start + i);
+
+            // Les sections les plus récentes sont lues en premier
+            if (m_xref.contains(number)) {
+                continue;
+            }
+            XrefEntry entry;
+            entry.type = (kind == "n" && entryOffset > 0) ? 1 : 0;
+            entry.offset = entryOffset;
+            m_xref.insert(number, entry);
+        }
+    }
+}
+
+bool PdfDocument::readXrefStream(qint64 offset, qint64* previous)
+{
+    bool ok = false;
+    PdfIndirectObject xref = parseIndirectAt(offset, &ok);
+    if (!ok || !xref.hasStream) {
+        return false;
+    }
+
+    QByteArray data;
+    if (!decodeStream(nullptr, xref.value, xref.stream, &data)) {
+        return false;
+    }
+
+    PdfObject widths = xref.value.value("W");
+    if (!widths.isArray() || widths.items.size() != 3) {
+        return false;
+    }
+    int w[3];
+    for (int i = 0; i < 3; ++i) {
+        w[i] = int(widths.items[i].toInteger());
+    }
+    int rowSize = w[0] + w[1] + w[2];
+    if (rowSize <= 0) {
+        return false;
+    }
+
+    PdfObject index = xref.value.value("Index");
+    QVector<qint64> ranges;
+    if (index.isArray()) {
+        for (const PdfObject& value : index.items) {
+            ranges.append(value.toInteger());
+        }
+    } else {
+        ranges << 0 << xref.value.value("Size").toInteger();
+    }
+
+    auto field = [&data](int position, int width, qint64 fallback) {
+        if (width == 0) {
+            return fallback;
+        }
+        qint64 value = 0;
+        for (int i = 0; i < width; ++i) {
+            value = (value << 8) | static_cast<unsigned char>(data.at(position + i));
+        }
+        return value;
+    };
+
+    int position = 0;
+    for (int r = 0; r + 1 < ranges.size(); r += 2) {
+        for (qint64 i = 0; i < ranges[r + 1]; ++i) {
+            if (position + rowSize > data.size()) {
+                break;
+            }
+            int number = int(ranges[r] + i);
+            XrefEntry entry;
+            entry.type = int(field(position, w[0], 1));
+            entry.offset = field(position + w[0], w[1], 0);
+            entry.index = int(field(position + w[0] + w[1], w[2], 0));
+            position += rowSize;
+
+            // Une entrée libre d'une table hybride est complétée par le flux
+            if (!m_xref.contains(number) || (m_xref.value(number).type == 0 && entry.type != 0)) {
+                m_xref.insert(number, entry);
+            }
+        }
+    }
+
+    if (m_trailer.isNull()) {
+        m_trailer = xref.value;
+    }
+    *previous = xref.value.value("Prev").isNumber() ? xref.value.value("Prev").toInteger() : -1;
+    return true;
+}
+
+bool PdfDocument::reconstructXref()
+{
+    // Chaque "n g obj" du fichier ; une définition plus loin remplace la précédente
+    qint64 pos = 0;
+    while ((pos = m_data.indexOf("obj", pos)) >= 0) {
+        qint64 end = pos + 3;
+        qint64 q = pos - 1;
+        pos = end;
+        if (end < m_data.size() && isRegular(m_data.at(end))) {
+            continue;
+        }
+        if (q < 0 || !isWhitespace(m_data.at(q))) {
+            continue;
+        }
+        while (q >= 0 && isWhitespace(m_data.at(q))) q--;
+        qint64 generationEnd = q + 1;
+        while (q >= 0 && m_data.at(q) >= '0' && m_data.at(q) <= '9') q--;
+        if (q + 1 == generationEnd || q < 0 || !isWhitespace(m_data.at(q))) {
+            continue;
+        }
+        while (q >= 0 && isWhitespace(m_data.at(q))) q--;
+        qint64 numberEnd = q + 1;
+        while (q >= 0 && m_data.at(q) >= '0' && m_data.at(q) <= '9') q--;
+        qint64 numberStart = q + 1;
+        if (numberStart == numberEnd || (q >= 0 && isRegular(m_data.at(q)))) {
+            continue;
+        }
+
+        XrefEntry entry;
+        entry.offset = numberStart;
+        m_xref.insert(m_data.mid(numberStart, numberEnd - numberStart).toInt(), entry);
+    }
+
+    qint64 trailerPos = m_data.lastIndexOf("trailer");
+    if (trailerPos >= 0) {
+        PdfParser parser(m_data, trailerPos + 7);
+        PdfObject trailer;
+        if (parser.readObject(trailer) && trailer.isDictionary()) {
+            m_trailer = trailer;
+        }
+    }
+
+    // Objets des flux d'objets, dernier flux xref comme dictionnaire de fin
+    QList<int> numbers = m_xref.keys();
+    std::sort(numbers.begin(), numbers.end());
+    for (int number : numbers) {
+        PdfIndirectObject candidate = object(number);
+        if (candidate.value.value("Type").isName("XRef") && m_trailer.isNull()) {
+            m_trailer = candidate.value;
+        }
+        if (!candidate.value.value("Type").isName("ObjStm")) {
+            continue;
+        }
+        objectFromStream(number, 0, -1);
+        const auto header = m_objectStreamHeaders.value(number);
+        for (int i = 0; i < header.size(); ++i) {
+            if (!m_xref.contains(header[i].first)) {
+                XrefEntry entry;
+                entry.type = 2;
+                entry.offset = number;
+                entry.index = i;
+                m_xref.insert(header[i].first, entry);
+            }
+        }
+    }
+
+    if (!m_trailer.isDictionary() || !resolve(m_trailer.value("Root")).isDictionary()) {
+        if (!m_trailer.isDictionary()) {
+            m_trailer = PdfObject::dictionary();
+        }
+        numbers = m_xref.keys();
+        std::sort(numbers.begin(), numbers.end());
+        for (int number : numbers) {
+            if (object(number).value.value("Type").isName("Catalog")) {
+                m_trailer.set("Root", PdfObject::reference(number));
+                break;
+            }
+        }
+    }
+    return !m_xref.isEmpty() && m_trailer.get("Root");
+}
+
+PdfIndirectObject PdfDocument::parseIndirectAt(qint64 offset, bool* ok) const
+{
+    *ok = false;
+    PdfIndirectObject result;
+
+    PdfParser parser(m_data, offset);
+    PdfObject number;
+    PdfObject generation;
+    if (!parser.readObject(number) || !number.isNumber() ||
+        !parser.readObject(generation) || !generation.isNumber() ||
+        parser.readToken() != "obj") {
+        return result;
+    }
+    if (!parser.readObject(result.value)) {
+        return result;
+    }
+
+    parser.skipWhitespace();
+    if (parser.startsWith("stream")) {
+        qint64 start = parser.position() + 6;
+        if (start < m_data.size() && m_data.at(start) == '\r') start++;
+        if (start < m_data.size() && m_data.at(start) == '\n') start++;
+
+        // Longueur annoncée, vérifiée par la présence de endstream
+        PdfObject lengthValue = resolve(result.value.value("Length"));
+        qint64 length = lengthValue.isNumber() ? lengthValue.toInteger() : -1;
+        bool lengthOk = false;
+        if (length >= 0 && start + length <= m_data.size()) {
+            PdfParser check(m_data, start + length);
+            check.skipWhitespace();
+            lengthOk = check.startsWith("endstream");
+        }
+        if (!lengthOk) {
+            qint64 end = m_data.indexOf("endstream", start);
+            if (end < 0) {
+                return result;
+            }
+            while (end > start && (m_data.at(end - 1) == '\n' || m_data.at(end - 1) == '\r')) {
+                end--;
+            }
+            length = end - start;
+        }
+        result.stream = m_data.mid(start, length);
+        result.hasStream = true;
+    }
+
+    *ok = true;
+    return result;
+}
+
+PdfIndirectObject PdfDocument::objectFromStream(int streamNumber, int index, int objectNumber) const
+{
+    PdfIndirectObject result;
+
+    if (!m_objectStreamData.contains(streamNumber)) {
+        m_objectStreamData.insert(streamNumber, QByteArray());
+        PdfIndirectObject container = object(streamNumber);
+        QByteArray data;
+        if (!container.hasStream || !decodeStream(this, container.value, container.stream, &data)) {
+            qWarning() << "Flux d'objets illisible:" << streamNumber;
+            return result;
+        }
+
+        int count = int(resolve(container.value.value("N")).toInteger());
+        qint64 first = resolve(container.value.value("First")).toInteger();
+        QVector<std::pair<int, qint64>> header;
+        PdfParser parser(data);
+        for (int i = 0; i < count; ++i) {
+            PdfObject number;
+            PdfObject offset;
+            if (!parser.readObject(number) || !parser.readObject(offset)) {
+                break;
+            }
+            header.append(std::make_pair(int(number.toInteger()), first + offset.toInteger()));
+        }
+        m_objectStreamHeaders.insert(streamNumber, header);
+        m_objectStreamData.insert(streamNumber, data);
+    }
+
+    if (objectNumber < 0) {
+        return result;
+    }
+
+    const QVector<std::pair<int, qint64>> header = m_objectStreamHeaders.value(streamNumber);
+    qint64 offset = -1;
+    if (index >= 0 && index < header.size() && header[index].first == objectNumber) {
+        offset = header[index].second;
+    } else {
+        for (const auto& entry : header) {
+            if (entry.first == objectNumber) {
+                offset = entry.second;
+                break;
+            }
+        }
+    }
+    if (offset < 0) {
+        return result;
+    }
+
+    const QByteArray data = m_objectStreamData.value(streamNumber);
+    PdfParser parser(data, offset);
+    parser.readObject(result.value);
+    return result;
+}
+
+PdfIndirectObject PdfDocument::object(int objectNumber) const
+{
+    auto cached = m_cache.constFind(objectNumber);
+    if (cached != m_cache.constEnd()) {
+        return cached.value();
+    }
+
+    auto it = m_xref.constFind(objectNumber);
+    if (it == m_xref.constEnd() || it->type == 0) {
+        return PdfIndirectObject();
+    }
+
+    // Garde contre les références circulaires (longueur d'un flux pointant sur lui-même...)
+    m_cache.insert(objectNumber, PdfIndirectObject());
+
+    PdfIndirectObject result;
+    if (it->type == 1) {
+        bool ok = false;
+        result = parseIndirectAt(it->offset, &ok);
+        if (!ok) {
+            result = PdfIndirectObject();
+        }
+    } else if (it->type == 2) {
+        result = objectFromStream(int(it->offset), it->index, objectNumber);
+    }
+
+    m_cache.insert(objectNumber, result);
+    return result;
+}
+
+PdfObject PdfDocument::resolve(const PdfObject& value) const
+{
+    PdfObject current = value;
+    for (int depth = 0; current.isReference() && depth < 32; ++depth) {
+        current = object(current.objectNumber).value;
+    }
+    return current.isReference() ? PdfObject() : current;
+}
+
+PdfObject PdfDocument::catalog() const
+{
+    return resolve(m_trailer.value("Root"));
+}
+
+bool PdfDocument::readPageTree()
+{
+    m_pages.clear();
+    m_pageDictionaries.clear();
+    m_pageIndexByObject.clear();
+
+    static const QByteArray inheritable[] = { "Resources", "MediaBox", "CropBox", "Rotate" };
+    QSet<int> visited;
+
+    std::function<void(const PdfObject&, PdfObject, int)> walk =
+        [&](const PdfObject& nodeReference, PdfObject inherited, int depth) {
+        if (depth > 64 || !nodeReference.isReference() || visited.contains(nodeReference.objectNumber)) {
+            return;
+        }
+        visited.insert(nodeReference.objectNumber);
+
+        PdfObject node = resolve(nodeReference);
+        if (!node.isDictionary()) {
+            return;
+        }
+        for (const QByteArray& key : inheritable) {
+            if (const PdfObject* value = node.get(key)) {
+                inherited.set(key, *value);
+            }
+        }
+
+        PdfObject kids = resolve(node.value("Kids"));
+        if (node.value("Type").isName("Page") || !kids.isArray()) {
+            for (const auto& entry : inherited.entries) {
+                if (!node.get(entry.first)) {
+                    node.set(entry.first, entry.second);
+                }
+            }
+            m_pageIndexByObject.insert(nodeReference.objectNumber, m_pages.size());
+            m_pages.append(nodeReference.objectNumber);
+            m_pageDictionaries.append(node);
+            return;
+        }
+
+        for (const PdfObject& kid : kids.items) {
+            walk(kid, inherited, depth + 1);
+        }
+    };
+
+    walk(catalog().value("Pages"), PdfObject::dictionary(), 0);
+    return !m_pages.isEmpty();
+}
+
+void PdfDocument::collectNamedDestinations(const PdfObject& node, int depth) const
+{
+    PdfObject resolved = resolve(node);
+    if (depth > 32 || !resolved.isDictionary()) {
+        return;
+    }
+
+    PdfObject names = resolve(resolved.value("Names"));
+    for (size_t i = 0; names.isArray() && i + 1 < names.items.size(); i += 2) {
+        PdfObject key = resolve(names.items[i]);
+        if (key.isString() && !m_namedDestinations.contains(key.text)) {
+            m_namedDestinations.insert(key.text, names.items[i + 1]);
+        }
+    }
+
+    PdfObject kids = resolve(resolved.value("Kids"));
+    for (const PdfObject& kid : kids.items) {
+        collectNamedDestinations(kid, depth + 1);
+    }
+}
+
+void PdfDocument::loadNamedDestinations() const
+{
+    if (m_namedDestinationsLoaded) {
+        return;
+    }
+    m_namedDestinationsLoaded = true;
+    PdfObject root = catalog();
+
+    // PDF 1.1 : dictionnaire /Dests ; ensuite arbre de noms /Names /Dests
+    PdfObject dests = resolve(root.value("Dests"));
+    for (const auto& entry : dests.entries) {
+        m_namedDestinations.insert(entry.first, entry.second);
+    }
+    collectNamedDestinations(resolve(root.value("Names")).value("Dests"), 0);
+}
+
+QList<QByteArray> PdfDocument::destinationNames() const
+{
+    loadNamedDestinations();
+    return m_namedDestinations.keys();
+}
+
+PdfObject PdfDocument::explicitDestination(const PdfObject& destination) const
+{
+    PdfObject resolved = resolve(destination);
+
+    if (resolved.isString() || resolved.isName()) {
+        loadNamedDestinations();
+        resolved = resolve(m_namedDestinations.value(resolved.text));
+    }
+
+    if (resolved.isDictionary()) {
+        resolved = resolve(resolved.value("D"));
+    }
+    return resolved.isArray() ? resolved : PdfObject();
+}
+
+int PdfDocument::destinationPage(const PdfObject& destination) const
+{
+    PdfObject explicitDest = explicitDestination(destination);
+    if (explicitDest.items.empty() || !explicitDest.items.front().isReference()) {
+        return -1;
+    }
+    return pageIndexOfObject(explicitDest.items.front().objectNumber);
+}
+
+QVector<PdfDocument::OutlineEntry> PdfDocument::outline() const
+{
+    QVector<OutlineEntry> entries;
+    PdfObject outlines = resolve(catalog().value("Outlines"));
+    if (!outlines.isDictionary()) {
+        return entries;
+    }
+
+    QSet<int> visited;
+    std::function<void(const PdfObject&, int)> walk = [&](const PdfObject& first, int level) {
+        PdfObject current = first;
+        while (level < 32 && current.isReference() && !visited.contains(current.objectNumber)) {
+            visited.insert(current.objectNumber);
+            PdfObject item = resolve(current);
+            if (!item.isDictionary()) {
+                break;
+            }
+
+            OutlineEntry entry;
+            entry.title = resolve(item.value("Title")).decodedText();
+            entry.level = level;
+
+            PdfObject destination = item.value("Dest");
+            if (destination.isNull()) {
+                PdfObject action = resolve(item.value("A"));
+                if (action.isDictionary() && action.value("S").isName("GoTo")) {
+                    destination = action.value("D");
+                }
+            }
+            entry.pageIndex = destinationPage(destination);
+            entries.append(entry);
+
+            walk(item.value("First"), level + 1);
+            current = item.value("Next");
+        }
+    };
+    walk(outlines.value("First"), 0);
+    return entries;
+}
+
+// --- PdfWriter ---
+
+PdfWriter::PdfWriter()
+{
+    m_pagesRoot = allocate();
+}
+
+int PdfWriter::allocate()
+{
+    m_objects.append(OutputObject());
+    return m_objects.size();
+}
+
+int PdfWriter::addPages(const PdfDocument& document, int firstPage, int lastPage)
+{
+    if (firstPage < 0 || lastPage >= document.pageCount() || firstPage > lastPage) {
+        return -1;
+    }
+
+    ImportContext& context = m_contexts[document.id()];
+    int outputFirst = m_pageObjects.size();
+
+    // Numéros réservés d'abord : les liens entre pages reprises restent valides
+    QVector<int> numbers;
+    for (int page = firstPage; page <= lastPage; ++page) {
+        int number = allocate();
+        int source = document.pageObject(page);
+        if (!context.pages.contains(source)) {
+            context.pages.insert(source, number);
+        }
+        numbers.append(number);
+        m_pageObjects.append(number);
+    }
+
+    for (int i = 0; i < numbers.size(); ++i) {
+        PdfObject page = document.pageDictionary(firstPage + i);
+        PdfObject annotations = document.resolve(page.value("Annots"));
+        page.remove("Parent");
+        page.remove("Annots");
+        page.remove("B");   // Articles : non repris
+
+        OutputObject output;
+        output.value = importValue(document, page, context);
+        output.value.set("Type", PdfObject::name("Page"));
+        output.value.set("Parent", PdfObject::reference(m_pagesRoot));
+
+        PdfObject copiedAnnotations = PdfObject::array();
+        for (const PdfObject& annotation : annotations.items) {
+            PdfObject copy = importAnnotation(document, annotation, context);
+            if (!copy.isNull()) {
+                copiedAnnotations.items.push_back(copy);
+            }
+        }
+        if (!copiedAnnotations.items.empty()) {
+            output.value.set("Annots", copiedAnnotations);
+        }
+
+        m_objects[numbers[i] - 1] = output;
+    }
+
+    return outputFirst;
+}
+
+int PdfWriter::appendDocument(const PdfDocument& document, int levelOffset)
+{
+    int first = addPages(document, 0, document.pageCount() - 1);
+    if (first >= 0) {
+        importOutline(document, 0, document.pageCount() - 1, first, levelOffset);
+    }
+    return first;
+}
+
+void PdfWriter::addOutlineEntry(const QString& title, int pageIndex, int level)
+{
+    OutlineItem item;
+    item.title = title;
+    item.pageIndex = pageIndex;
+    item.level = qMax(0, level);
+    m_outline.append(item);
+}
+
+void PdfWriter::importOutline(const PdfDocument& document, int firstPage, int lastPage,
+                              int outputFirstPage, int levelOffset)
+{
+    const QVector<PdfDocument::OutlineEntry> entries = document.outline();
+    for (const PdfDocument::OutlineEntry& entry : entries) {
+        if (entry.pageIndex < firstPage || entry.pageIndex > lastPage) {
+            continue;
+        }
+        addOutlineEntry(entry.title, outputFirstPage + entry.pageIndex - firstPage, entry.level + levelOffset);
+    }
+}
+
+int PdfWriter::importObject(const PdfDocument& document, int objectNumber, ImportContext& context)
+{
+    auto existing = context.objects.constFind(objectNumber);
+    if (existing != context.objects.constEnd()) {
+        return existing.value();
+    }
+
+    int target = allocate();
+    context.objects.insert(objectNumber, target);
+
+    // La copie peut allouer d'autres objets : m_objects n'est indexé qu'à la fin
+    PdfIndirectObject source = document.object(objectNumber);
+    OutputObject output;
+    output.value = importValue(document, source.value, context);
+    if (source.hasStream) {
+        output.hasStream = true;
+        output.stream = source.stream;
+        output.value.set("Length", PdfObject::number(source.stream.size()));
+    }
+    m_objects[target - 1] = output;
+    return target;
+}
+
+PdfObject PdfWriter::importValue(const PdfDocument& document, const PdfObject& value, ImportContext& context)
+{
+    switch (value.type) {
+        case PdfObject::Type::Reference: {
+            // Une page non reprise n'est jamais copiée : la référence devient null
+            if (document.isPageObject(value.objectNumber)) {
+                auto page = context.pages.constFind(value.objectNumber);
+                return page != context.pages.constEnd() ? PdfObject::reference(page.value()) : PdfObject();
+            }
+            return PdfObject::reference(importObject(document, value.objectNumber, context));
+        }
+        case PdfObject::Type::Array: {
+            PdfObject copy = PdfObject::array();
+            copy.items.reserve(value.items.size());
+            for (const PdfObject& item : value.items) {
+                copy.items.push_back(importValue(document, item, context));
+            }
+            return copy;
+        }
+        case PdfObject::Type::Dictionary: {
+            PdfObject copy = PdfObject::dictionary();
+            copy.entries.reserve(value.entries.size());
+            for (const auto& entry : value.entries) {
+                copy.entries.emplace_back(entry.first, importValue(document, entry.second, context));
+            }
+            return copy;
+        }
+        default:
+            return value;
+    }
+}
+
+PdfObject PdfWriter::importAnnotation(const PdfDocument& document, const PdfObject& annotation, ImportContext& context)
+{
+    if (annotation.isReference()) {
+        auto existing = context.objects.constFind(annotation.objectNumber);
+        if (existing != context.objects.constEnd()) {
+            return PdfObject::reference(existing.value());
+        }
+    }
+
+    PdfObject annotationDict = document.resolve(annotation);
+    if (!annotationDict.isDictionary()) {
+        return PdfObject();
+    }
+
+    // Liens internes : destination rendue explicite, lien supprimé si la page n'est pas reprise
+    auto keepDestination = [&](const PdfObject& destination, PdfObject* explicitDest) {
+        PdfObject resolved = document.resolve(destination);
+        if (m_keepNamedDestinations && (resolved.isString() || resolved.isName())) {
+            *explicitDest = PdfObject::string(resolved.text);
+            return true;
+        }
+        int page = document.destinationPage(destination);
+        if (page < 0 || !context.pages.contains(document.pageObject(page))) {
+            return false;
+        }
+        *explicitDest = document.explicitDestination(destination);
+        return true;
+    };
+
+    PdfObject action = document.resolve(annotationDict.value("A"));
+    if (annotationDict.get("Dest")) {
+        PdfObject explicitDest;
+        if (!keepDestination(annotationDict.value("Dest"), &explicitDest)) {
+            return PdfObject();
+        }
+        annotationDict.set("Dest", explicitDest);
+    } else if (action.isDictionary() && action.value("S").isName("GoTo")) {
+        PdfObject explicitDest;
+        if (!keepDestination(action.value("D"), &explicitDest)) {
+            return PdfObject();
+        }
+        action.set("D", explicitDest);
+        annotationDict.set("A", action);
+    }
+
+    int target = allocate();
+    if (annotation.isReference()) {
+        context.objects.insert(annotation.objectNumber, target);
+    }
+    OutputObject output;
+    output.value = importValue(document, annotationDict, context);
+    m_objects[target - 1] = output;
+    return PdfObject::reference(target);
+}
+
+void PdfWriter::importNamedDestinations(const PdfDocument& document, const QSet<QByteArray>& preferredNames)
+{
+    const ImportContext& context = m_contexts[document.id()];
+    const QList<QByteArray> names = document.destinationNames();
+    for (const QByteArray& name : names) {
+        PdfObject destination = document.explicitDestination(PdfObject::string(name));
+        if (destination.items.empty() || !destination.items.front().isReference()) {
+            continue;
+        }
+        auto page = context.pages.constFind(destination.items.front().objectNumber);
+        if (page == context.pages.constEnd()) {
+            continue;
+        }
+
+        // Un nom défini par plusieurs documents : celui qui le revendique l'emporte
+        bool preferred = preferredNames.contains(name);
+        auto existing = m_namedDestinations.constFind(name);
+        if (existing != m_namedDestinations.constEnd() && (existing->preferred || !preferred)) {
+            continue;
+        }
+
+        NamedDestination named;
+        named.destination = destination;
+        named.destination.items.front() = PdfObject::reference(page.value());
+        named.preferred = preferred;
+        m_namedDestinations.insert(name, named);
+    }
+}
+
+bool PdfWriter::write(const QString& filePath, QString* errorString) const
+{
+    if (m_pageObjects.isEmpty()) {
+        if (errorString) *errorString = "Aucune page à écrire";
+        return false;
+    }
+
+    QVector<OutputObject> objects = m_objects;
+    auto append = [&objects](const PdfObject& value) {
+        OutputObject output;
+        output.value = value;
+        objects.append(output);
+        return objects.size();
+    };
+
+    // Arbre des pages à un seul niveau
+    PdfObject kids = PdfObject::array();
+    for (int number : m_pageObjects) {
+        kids.items.push_back(PdfObject::reference(number));
+    }
+    PdfObject pages = PdfObject::dictionary();
+    pages.set("Type", PdfObject::name("Pages"));
+    pages.set("Kids", kids);
+    pages.set("Count", PdfObject::number(m_pageObjects.size()));
+    objects[m_pagesRoot - 1].value = pages;
+
+    // Signets : arbre reconstruit à partir des niveaux
+    int outlinesRoot = 0;
+    if (!m_outline.isEmpty()) {
+        int count = m_outline.size();
+        outlinesRoot = append(PdfObject());
+        QVector<int> numbers(count);
+        for (int i = 0; i < count; ++i) {
+            numbers[i] = append(PdfObject());
+        }
+
+        QVector<int> parent(count, -1);
+        QVector<int> stack;
+        for (int i = 0; i < count; ++i) {
+            int level = qMin(m_outline[i].level, int(stack.size()));
+            while (stack.size() > level) {
+                stack.removeLast();
+            }
+            parent[i] = stack.isEmpty() ? -1 : stack.last();
+            stack.append(i);
+        }
+
+        QVector<QVector<int>> children(count);
+        QVector<int> topLevel;
+        for (int i = 0; i < count; ++i) {
+            (parent[i] < 0 ? topLevel : children[parent[i]]).append(i);
+        }
+        QVector<int> descendants(count, 0);
+        for (int i = count - 1; i >= 0; --i) {
+            for (int child : children[i]) {
+                descendants[i] += 1 + descendants[child];
+            }
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const QVector<int>& siblings = parent[i] < 0 ? topLevel : children[parent[i]];
+            int position = siblings.indexOf(i);
+
+            PdfObject item = PdfObject::dictionary();
+            item.set("Title", PdfObject::textString(m_outline[i].title));
+            item.set("Parent", PdfObject::reference(parent[i] < 0 ? outlinesRoot : numbers[parent[i]]));
+            if (position > 0) {
+                item.set("Prev", PdfObject::reference(numbers[siblings[position - 1]]));
+            }
+            if (position + 1 < siblings.size()) {
+                item.set("Next", PdfObject::reference(numbers[siblings[position + 1]]));
+            }
+            if (!children[i].isEmpty()) {
+                item.set("First", PdfObject::reference(numbers[children[i].first()]));
+                item.set("Last", PdfObject::reference(numbers[children[i].last()]));
+                item.set("Count", PdfObject::number(descendants[i]));
+            }
+
+            int page = qBound(0, m_outline[i].pageIndex, int(m_pageObjects.size()) - 1);
+            PdfObject destination = PdfObject::array();
+            destination.items.push_back(PdfObject::reference(m_pageObjects[page]));
+            destination.items.push_back(PdfObject::name("Fit"));
+            item.set("Dest", destination);
+
+            objects[numbers[i] - 1].value = item;
+        }
+
+        PdfObject root = PdfObject::dictionary();
+        root.set("Type", PdfObject::name("Outlines"));
+        root.set("First", PdfObject::reference(numbers[topLevel.first()]));
+        root.set("Last", PdfObject::reference(numbers[topLevel.last()]));
+        root.set("Count", PdfObject::number(count));
+        objects[outlinesRoot - 1].value = root;
+    }
+
+    PdfObject catalog = PdfObject::dictionary();
+    catalog.set("Type", PdfObject::name("Catalog"));
+    catalog.set("Pages", PdfObject::reference(m_pagesRoot));
+    if (outlinesRoot) {
+        catalog.set("Outlines", PdfObject::reference(outlinesRoot));
+        catalog.set("PageMode", PdfObject::name("UseOutlines"));
+    }
+    if (!m_namedDestinations.isEmpty()) {
+        // Arbre de noms à une seule feuille, noms triés
+        PdfObject names = PdfObject::array();
+        for (auto it = m_namedDestinations.constBegin(); it != m_namedDestinations.constEnd(); ++it) {
+            names.items.push_back(PdfObject::string(it.key()));
+            names.items.push_back(it->destination);
+        }
+        PdfObject tree = PdfObject::dictionary();
+        tree.set("Names", names);
+        PdfObject nameDictionary = PdfObject::dictionary();
+        nameDictionary.set("Dests", PdfObject::reference(append(tree)));
+        catalog.set("Names", nameDictionary);
+    }
+    int catalogNumber = append(catalog);
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorString) *errorString = "Impossible d'écrire " + filePath;
+        return false;
+    }
+
+    QByteArray header("%PDF-1.7\n%\xE2\xE3\xCF\xD3\n");
+    file.write(header);
+    qint64 offset = header.size();
+
+    QVector<qint64> offsets(objects.size());
+    for (int i = 0; i < objects.size(); ++i) {
+        offsets[i] = offset;
+        QByteArray chunk = QByteArray::number(i + 1) + " 0 obj\n" + objects[i].value.serialize();
+        if (objects[i].hasStream) {
+            chunk += "\nstream\n" + objects[i].stream + "\nendstream";
+        }
+        chunk += "\nendobj\n";
+        file.write(chunk);
+        offset += chunk.size();
+    }
+
+    QByteArray xref = "xref\n0 " + QByteArray::number(objects.size() + 1) + "\n0000000000 65535 f \n";
+    for (qint64 objectOffset : offsets) {
+        xref += QByteArray::number(objectOffset).rightJustified(10, '0') + " 00000 n \n";
+    }
+    xref += "trailer\n<</Size " + QByteArray::number(objects.size() + 1) +
+            " /Root " + QByteArray::number(catalogNumber) + " 0 R>>\nstartxref\n" +
+            QByteArray::number(offset) + "\n%%EOF\n";
+    file.write(xref);
+
+    if (!file.commit()) {
+        if (errorString) *errorString = "Impossible d'écrire " + filePath;
+        return false;
+    }
+    return true;
+}
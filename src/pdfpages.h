@@ -0,0 +1,222 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QSet>
+#include <utility>
+#include <vector>
+
+// Lecture et réécriture de pages PDF, sans bibliothèque externe (hors zlib).
+// Suffisant pour les PDF produits par LuaLaTeX, pdfLaTeX et XeLaTeX : tables
+// xref classiques ou en flux, flux d'objets, arbre des pages, signets et liens
+// internes. Les flux de contenu sont recopiés tels quels, sans être décodés.
+
+// Valeur PDF (objet direct ou référence vers un objet indirect)
+struct PdfObject
+{
+    enum class Type { Null, Boolean, Number, String, HexString, Name, Array, Dictionary, Reference };
+
+    Type type = Type::Null;
+    QByteArray text;          // Booléen et nombre tels qu'écrits, octets d'une chaîne, nom sans "/"
+    int objectNumber = 0;     // Référence
+    int generation = 0;
+    std::vector<PdfObject> items;                           // Tableau
+    std::vector<std::pair<QByteArray, PdfObject>> entries;  // Dictionnaire
+
+    bool isNull() const { return type == Type::Null; }
+    bool isNumber() const { return type == Type::Number; }
+    bool isName() const { return type == Type::Name; }
+    bool isString() const { return type == Type::String || type == Type::HexString; }
+    bool isArray() const { return type == Type::Array; }
+    bool isDictionary() const { return type == Type::Dictionary; }
+    bool isReference() const { return type == Type::Reference; }
+
+    qint64 toInteger() const { return static_cast<qint64>(text.toDouble()); }
+    bool isName(const char* name) const { return type == Type::Name && text == name; }
+
+    // Dictionnaire : accès par clé (nullptr si absente)
+    const PdfObject* get(const QByteArray& key) const;
+    PdfObject value(const QByteArray& key) const;
+    void set(const QByteArray& key, const PdfObject& value);
+    void remove(const QByteArray& key);
+
+    static PdfObject number(qint64 value);
+    static PdfObject name(const QByteArray& value);
+    static PdfObject string(const QByteArray& bytes);
+    static PdfObject textString(const QString& text);   // PDFDocEncoding ou UTF-16BE
+    static PdfObject reference(int objectNumber);
+    static PdfObject array();
+    static PdfObject dictionary();
+
+    // Écriture en syntaxe PDF
+    QByteArray serialize() const;
+
+    // Chaîne de texte (titre de signet...) décodée
+    QString decodedText() const;
+};
+
+// Objet indirect : sa valeur et, pour un flux, ses données encore encodées
+struct PdfIndirectObject
+{
+    PdfObject value;
+    QByteArray stream;
+    bool hasStream = false;
+};
+
+// Document PDF en lecture
+class PdfDocument
+{
+public:
+    PdfDocument();
+
+    bool load(const QString& filePath);
+    QString errorString() const { return m_error; }
+
+    // Identifiant unique de l'instance (les adresses peuvent être réutilisées)
+    int id() const { return m_id; }
+
+    int pageCount() const { return m_pages.size(); }
+
+    // Numéro d'objet de chaque page, dans l'ordre de lecture
+    int pageObject(int pageIndex) const { return m_pages.value(pageIndex); }
+
+    // Dictionnaire de la page avec les attributs hérités de l'arbre (Resources, MediaBox...)
+    PdfObject pageDictionary(int pageIndex) const { return m_pageDictionaries.value(pageIndex); }
+
+    // Indice de la page d'un objet page (-1 si ce n'en est pas une)
+    int pageIndexOfObject(int objectNumber) const { return m_pageIndexByObject.value(objectNumber, -1); }
+    bool isPageObject(int objectNumber) const { return m_pageIndexByObject.contains(objectNumber); }
+
+    PdfIndirectObject object(int objectNumber) const;
+
+    // Suit les références jusqu'à une valeur directe
+    PdfObject resolve(const PdfObject& value) const;
+
+    const PdfObject& trailer() const { return m_trailer; }
+    PdfObject catalog() const;
+
+    // Destination explicite ([page /XYZ ...]) d'une destination nommée ou explicite
+    PdfObject explicitDestination(const PdfObject& destination) const;
+
+    // Page visée par une destination, -1 si hors document
+    int destinationPage(const PdfObject& destination) const;
+
+    // Noms des destinations nommées du document
+    QList<QByteArray> destinationNames() const;
+
+    // Signets dans l'ordre du document, avec leur profondeur (0 = premier niveau)
+    struct OutlineEntry {
+        QString title;
+        int level = 0;
+        int pageIndex = -1;
+    };
+    QVector<OutlineEntry> outline() const;
+
+private:
+    struct XrefEntry {
+        int type = 1;        // 1 : position dans le fichier, 2 : dans un flux d'objets
+        qint64 offset = 0;   // Position, ou numéro du flux d'objets
+        int index = 0;       // Rang dans le flux d'objets
+    };
+
+    bool readXrefChain(qint64 offset);
+    bool readXrefTable(qint64 offset, qint64* previous, qint64* xrefStream);
+    bool readXrefStream(qint64 offset, qint64* previous);
+    bool reconstructXref();
+    bool readPageTree();
+    PdfIndirectObject parseIndirectAt(qint64 offset, bool* ok) const;
+    PdfIndirectObject objectFromStream(int streamNumber, int index, int objectNumber) const;
+    void collectNamedDestinations(const PdfObject& node, int depth) const;
+    void loadNamedDestinations() const;
+
+    static int s_nextId;
+    int m_id;
+    QByteArray m_data;
+    QString m_error;
+    QHash<int, XrefEntry> m_xref;
+    PdfObject m_trailer;
+    mutable QHash<int, PdfIndirectObject> m_cache;
+    mutable QHash<int, QVector<std::pair<int, qint64>>> m_objectStreamHeaders;
+    mutable QHash<int, QByteArray> m_objectStreamData;
+    mutable QHash<QByteArray, PdfObject> m_namedDestinations;
+    mutable bool m_namedDestinationsLoaded = false;
+
+    QVector<int> m_pages;
+    QVector<PdfObject> m_pageDictionaries;
+    QHash<int, int> m_pageIndexByObject;
+};
+
+// Nouveau PDF assemblé à partir de pages d'un ou plusieurs documents
+class PdfWriter
+{
+public:
+    PdfWriter();
+
+    // Ajoute les pages first..last (incluses, à partir de 0) ; retourne l'indice
+    // de la première page ajoutée dans le nouveau document, -1 en cas d'erreur.
+    // Les liens vers des pages non reprises sont supprimés.
+    int addPages(const PdfDocument& document, int firstPage, int lastPage);
+
+    // Ajoute toutes les pages et reprend les signets du document
+    int appendDocument(const PdfDocument& document, int levelOffset = 0);
+
+    int pageCount() const { return m_pageObjects.size(); }
+
+    // Signets du nouveau document (page dans le nouveau document)
+    void addOutlineEntry(const QString& title, int pageIndex, int level);
+
+    // Reprend les signets du document source pointant vers les pages first..last,
+    // décalés vers la page outputFirstPage du nouveau document
+    void importOutline(const PdfDocument& document, int firstPage, int lastPage,
+                       int outputFirstPage, int levelOffset = 0);
+
+    // Fusion de documents : les liens vers une destination nommée sont gardés tels
+    // quels, la destination venant de l'un des documents ajoutés
+    void setKeepNamedDestinations(bool keep) { m_keepNamedDestinations = keep; }
+
+    // Reprend les destinations nommées du document visant une page déjà ajoutée ;
+    // un nom de preferredNames remplace la destination de même nom d'un autre document
+    void importNamedDestinations(const PdfDocument& document,
+                                 const QSet<QByteArray>& preferredNames = QSet<QByteArray>());
+
+    bool write(const QString& filePath, QString* errorString = nullptr) const;
+
+private:
+    struct OutputObject {
+        PdfObject value;
+        QByteArray stream;
+        bool hasStream = false;
+    };
+
+    struct ImportContext {
+        QHash<int, int> objects;   // Numéro source -> numéro dans le nouveau document
+        QHash<int, int> pages;     // Page source reprise -> numéro de son objet
+    };
+
+    struct OutlineItem {
+        QString title;
+        int pageIndex = 0;
+        int level = 0;
+    };
+
+    struct NamedDestination {
+        PdfObject destination;
+        bool preferred = false;
+    };
+
+    int allocate();
+    int importObject(const PdfDocument& document, int objectNumber, ImportContext& context);
+    PdfObject importValue(const PdfDocument& document, const PdfObject& value, ImportContext& context);
+    PdfObject importAnnotation(const PdfDocument& document, const PdfObject& annotation, ImportContext& context);
+
+    QVector<OutputObject> m_objects;   // Indice = numéro d'objet - 1
+    QVector<int> m_pageObjects;
+    int m_pagesRoot = 0;
+    QHash<int, ImportContext> m_contexts;   // Par identifiant de document
+    QVector<OutlineItem> m_outline;
+    bool m_keepNamedDestinations = false;
+    QMap<QByteArray, NamedDestination> m_namedDestinations;   // Triées : arbre de noms
+};
@@ -0,0 +1,318 @@
+#include "preflightchecker.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QHash>
+#include <QSet>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+// Environnements dont le contenu n'est pas analysé (accolades et \begin libres)
+const QSet<QString> s_verbatimEnvironments = {
+    "verbatim", "verbatim*", "Verbatim", "lstlisting", "minted", "comment",
+    "filecontents", "filecontents*", "luacode", "luacode*"
+};
+
+// \import{répertoire}{fichier} et variantes du paquet import
+const QSet<QString> s_importCommands = {
+    "import", "subimport", "inputfrom", "subinputfrom", "includefrom", "subincludefrom"
+};
+
+// Argument entre accolades sur la même ligne, à partir de position (espaces
+// sautés) ; position est placée après l'accolade fermante
+bool readArgument(const QString& text, int* position, QString* argument)
+{
+    int i = *position;
+    while (i < text.size() && (text.at(i) == ' ' || text.at(i) == '\t')) {
+        ++i;
+    }
+    if (i >= text.size() || text.at(i) != '{') {
+        return false;
+    }
+    int close = text.indexOf('}', i + 1);
+    int newline = text.indexOf('\n', i + 1);
+    if (close < 0 || (newline >= 0 && newline < close)) {
+        return false;
+    }
+    *argument = text.mid(i + 1, close - i - 1).trimmed();
+    *position = close + 1;
+    return true;
+}
+
+// Argument écrit en dur : ni macro ni paramètre (définitions de commandes)
+bool isLiteral(const QString& argument)
+{
+    return !argument.contains('\\') && !argument.contains('#');
+}
+
+// Fichier présent tel quel ou avec l'extension .tex
+bool texFileExists(const QString& path)
+{
+    return QFileInfo::exists(path) || QFileInfo::exists(path + ".tex");
+}
+
+} // namespace
+
+QString PreflightIssue::toString() const
+{
+    if (line <= 0) {
+        return file + ": " + message;
+    }
+    return file + ":" + QString::number(line) + ": " + message;
+}
+
+QVector<PreflightChecker::Source> PreflightChecker::readSources(const QVector<QPair<QString, QString>>& files,
+                                                                const QString& mainDirPath,
+                                                                QVector<PreflightIssue>* issues)
+{
+    struct Report {
+        Source source;
+        QVector<PreflightIssue> issues;
+        QVector<Label> labels;
+    };
+
+    bool validate = issues != nullptr;
+    const QVector<Report> reports = QtConcurrent::blockingMapped<QVector<Report>>(
+        files, [&mainDirPath, validate](const QPair<QString, QString>& file) {
+        Report report;
+        report.source.path = file.second;
+        QFile inputFile(file.second);
+        if (!inputFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            if (validate) {
+                report.issues.append(PreflightIssue{ file.second, 0, QFileInfo::exists(file.second)
+                                                                     ? "fichier illisible"
+                                                                     : "fichier introuvable" });
+            }
+            return report;
+        }
+        QByteArray bytes = inputFile.readAll();
+        report.source.readable = true;
+        if (validate) {
+            report.issues = checkSource(file.second, bytes, mainDirPath, &report.source.content, &report.labels);
+        } else {
+            report.source.content = QString::fromUtf8(bytes);
+        }
+        return report;
+    });
+
+    // Étiquettes : la première définition de la cible fait foi
+    QVector<Source> sources;
+    sources.reserve(reports.size());
+    QHash<QString, QPair<QString, int>> firstLabels;
+    for (const Report& report : reports) {
+        sources.append(report.source);
+        if (!validate) {
+            continue;
+        }
+        issues->append(report.issues);
+        for (const Label& label : report.labels) {
+            auto first = firstLabels.constFind(label.name);
+            if (first == firstLabels.constEnd()) {
+                firstLabels.insert(label.name, { report.source.path, label.line });
+                continue;
+            }
+            issues->append(PreflightIssue{ report.source.path, label.line,
+                                           QString("étiquette « %1 » déjà définie en %2:%3")
+                                               .arg(label.name, first->first).arg(first->second) });
+        }
+    }
+    return sources;
+}
+
+QVector<PreflightIssue> PreflightChecker::check(const QVector<QPair<QString, QString>>& files,
+                                                const QString& mainDirPath)
+{
+    QVector<PreflightIssue> issues;
+    readSources(files, mainDirPath, &issues);
+    return issues;
+}
+
+QVector<PreflightIssue> PreflightChecker::checkSource(const QString& path, const QByteArray& bytes,
+                                                      const QString& mainDirPath, QString* content,
+                                                      QVector<Label>* labels)
+{
+    QVector<PreflightIssue> issues;
+    auto report = [&issues, &path](int line, const QString& message) {
+        issues.append(PreflightIssue{ path, line, message });
+    };
+
+    if (int line = invalidUtf8Line(bytes)) {
+        report(line, "encodage invalide, le fichier doit être en UTF-8");
+    }
+    *content = QString::fromUtf8(bytes);
+    const QString& text = *content;
+    QString fileDir = QFileInfo(path).absolutePath();
+
+    // Après un premier déséquilibre, la suite du fichier n'est plus vérifiée
+    // (un oubli produirait sinon une erreur par ligne)
+    QVector<int> braces;                          // Ligne de chaque accolade ouverte
+    QVector<QPair<QString, int>> environments;    // Environnement ouvert et sa ligne
+    bool bracesBroken = false;
+    bool environmentsBroken = false;
+
+    int line = 1;
+    int i = 0;
+    while (i < text.size()) {
+        QChar c = text.at(i);
+        if (c == '\n') {
+            ++line;
+            ++i;
+            continue;
+        }
+        if (c == '%') {
+            int end = text.indexOf('\n', i);
+            i = end < 0 ? text.size() : end;
+            continue;
+        }
+        if (c == '{') {
+            braces.append(line);
+            ++i;
+            continue;
+        }
+        if (c == '}') {
+            if (!braces.isEmpty()) {
+                braces.removeLast();
+            } else if (!bracesBroken) {
+                report(line, "accolade fermante « } » sans accolade ouvrante");
+                bracesBroken = true;
+            }
+            ++i;
+            continue;
+        }
+        if (c != '\\') {
+            ++i;
+            continue;
+        }
+
+        // Nom de commande : lettres, sinon un seul caractère (\{, \%, \\...)
+        int nameStart = ++i;
+        while (i < text.size() && text.at(i).isLetter()) {
+            ++i;
+        }
+        if (i == nameStart) {
+            if (i < text.size() && text.at(i) == '\n') {
+                ++line;
+            }
+            ++i;
+            continue;
+        }
+        QString command = text.mid(nameStart, i - nameStart);
+
+        if (command == "verb") {
+            if (i < text.size() && text.at(i) == '*') {
+                ++i;
+            }
+            if (i < text.size()) {
+                int end = text.indexOf(text.at(i), i + 1);
+                int newline = text.indexOf('\n', i + 1);
+                if (end >= 0 && (newline < 0 || end < newline)) {
+                    i = end + 1;
+                }
+            }
+            continue;
+        }
+
+        // Les autres arguments sont seulement lus : leurs accolades sont comptées
+        // au passage suivant
+        int argumentEnd = i;
+        QString argument;
+        if (command == "begin" || command == "end") {
+            if (!readArgument(text, &argumentEnd, &argument) || argument.isEmpty() || !isLiteral(argument)) {
+                continue;
+            }
+            i = argumentEnd;
+            if (command == "begin" && s_verbatimEnvironments.contains(argument)) {
+                QString endTag = "\\end{" + argument + "}";
+                int end = text.indexOf(endTag, i);
+                if (end < 0) {
+                    if (!environmentsBroken) {
+                        report(line, "\\begin{" + argument + "} sans \\end{" + argument + "}");
+                        environmentsBroken = true;
+                    }
+                    break;
+                }
+                line += QStringView(text).mid(i, end - i).count(u'\n');
+                i = end + endTag.size();
+            } else if (command == "begin") {
+                environments.append({ argument, line });
+            } else if (environmentsBroken) {
+                // Déjà signalé
+            } else if (environments.isEmpty()) {
+                report(line, "\\end{" + argument + "} sans \\begin{" + argument + "}");
+                environmentsBroken = true;
+            } else if (environments.last().first != argument) {
+                report(line, QString("\\end{%1} ferme \\begin{%2} ouvert ligne %3")
+                                 .arg(argument, environments.last().first).arg(environments.last().second));
+                environmentsBroken = true;
+            } else {
+                environments.removeLast();
+            }
+        } else if (command == "label") {
+            if (labels && readArgument(text, &argumentEnd, &argument) && !argument.isEmpty() && isLiteral(argument)) {
+                labels->append(Label{ argument, line });
+            }
+        } else if (s_importCommands.contains(command)) {
+            if (argumentEnd < text.size() && text.at(argumentEnd) == '*') {
+                ++argumentEnd;
+            }
+            QString directory;
+            if (readArgument(text, &argumentEnd, &directory) && readArgument(text, &argumentEnd, &argument) &&
+                !argument.isEmpty() && isLiteral(directory) && isLiteral(argument)) {
+                // Comme LatexParser : répertoire relatif au fichier qui importe
+                QString importPath = QDir::cleanPath(QDir(fileDir).filePath(directory + "/" + argument));
+                if (!texFileExists(importPath)) {
+                    report(line, "fichier importé introuvable : " + importPath);
+                }
+            }
+        } else if (command == "input" || command == "include") {
+            // Seuls les chemins vers un répertoire désignent sûrement un fichier du
+            // projet (les autres peuvent venir de la distribution TeX)
+            if (readArgument(text, &argumentEnd, &argument) && argument.contains('/') && isLiteral(argument) &&
+                !texFileExists(QDir(fileDir).filePath(argument)) &&
+                !texFileExists(QDir(mainDirPath).filePath(argument))) {
+                report(line, "fichier inclus introuvable : " + argument);
+            }
+        }
+    }
+
+    if (!bracesBroken && !braces.isEmpty()) {
+        report(braces.last(), "accolade ouvrante « { » jamais fermée");
+    }
+    if (!environmentsBroken && !environments.isEmpty()) {
+        const QString& name = environments.last().first;
+        report(environments.last().second, "\\begin{" + name + "} sans \\end{" + name + "}");
+    }
+
+    std::stable_sort(issues.begin(), issues.end(), [](const PreflightIssue& a, const PreflightIssue& b) {
+        return a.line < b.line;
+    });
+    return issues;
+}
+
+int PreflightChecker::invalidUtf8Line(const QByteArray& bytes)
+{
+    int line = 1;
+    qsizetype i = 0;
+    const qsizetype size = bytes.size();
+    while (i < size) {
+        uchar c = uchar(bytes.at(i));
+        if (c == '\n') {
+            ++line;
+        }
+
+        // Longueur annoncée par le premier octet (0 : octet de suite ou invalide)
+        int length = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+        if (length == 0 || c == 0xC0 || c == 0xC1 || c > 0xF4 || i + length > size) {
+            return line;
+        }
+        for (int k = 1; k < length; ++k) {
+            if ((uchar(bytes.at(i + k)) & 0xC0) != 0x80) {
+                return line;
+            }
+        }
+        i += length;
+    }
+    return 0;
+}
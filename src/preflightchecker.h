@@ -0,0 +1,55 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QByteArray>
+
+// Problème relevé avant la compilation, rattaché à une ligne d'une source
+struct PreflightIssue {
+    QString file;
+    int line = 0;                             // 0 : le fichier entier
+    QString message;
+
+    // « fichier:ligne: message », comme les diagnostics des compilateurs
+    QString toString() const;
+};
+
+// Vérifications préalables des sources d'une cible, faites pendant leur lecture
+// et avant tout lancement du moteur : fichier présent et lisible, encodage
+// UTF-8, accolades et environnements \begin/\end équilibrés dans chaque
+// fichier, fichiers de \import/\subimport (et de \input/\include avec un
+// chemin) présents, étiquettes \label définies une seule fois dans la cible.
+// Les fichiers sont lus et vérifiés en parallèle ; les méthodes sont sans état
+// et utilisables depuis n'importe quel thread.
+class PreflightChecker
+{
+public:
+    struct Source {
+        QString path;
+        QString content;
+        bool readable = false;
+    };
+
+    // Lit les fichiers (nom, chemin) en parallèle, dans l'ordre donné ; si
+    // issues est fourni, les vérifie aussi. mainDirPath : répertoire du fichier
+    // principal, second point de départ des chemins de \input et \include
+    static QVector<Source> readSources(const QVector<QPair<QString, QString>>& files, const QString& mainDirPath,
+                                       QVector<PreflightIssue>* issues = nullptr);
+
+    // Vérification seule (cibles dont les sources sont copiées ailleurs)
+    static QVector<PreflightIssue> check(const QVector<QPair<QString, QString>>& files, const QString& mainDirPath);
+
+    // Problèmes d'une source déjà lue (étiquettes relevées dans labels)
+    struct Label {
+        QString name;
+        int line = 0;
+    };
+    static QVector<PreflightIssue> checkSource(const QString& path, const QByteArray& bytes,
+                                               const QString& mainDirPath, QString* content,
+                                               QVector<Label>* labels);
+
+private:
+    // Ligne du premier octet qui n'est pas de l'UTF-8 valide, 0 si aucun
+    static int invalidUtf8Line(const QByteArray& bytes);
+};
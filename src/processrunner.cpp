@@ -1,51 +1,164 @@
 #include "processrunner.h"
 #include <QDateTime>
-#include <QScrollBar>
-#include <QRegularExpression>
+#include <QDebug>
+
+#include <QSet>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/prctl.h>
+#endif
+
+namespace {
+
+// Groupes lancés et pas encore terminés (les runners vivent dans le thread principal)
+QSet<qint64>& liveGroups()
+{
+    static QSet<qint64> groups;
+    return groups;
+}
+
+} // namespace
 
 ProcessRunner::ProcessRunner(QObject* parent)
     : QObject(parent)
 {
+    qRegisterMetaType<ProcessResult>("ProcessResult");
+
+    m_usageTimer = new QTimer(this);
+    m_usageTimer->setInterval(100);
+    connect(m_usageTimer, &QTimer::timeout, this, &ProcessRunner::sampleUsage);
+
+    m_watchdogTimer = new QTimer(this);
+    m_watchdogTimer->setInterval(1000);
+    connect(m_watchdogTimer, &QTimer::timeout, this, &ProcessRunner::checkWatchdog);
+
+    m_killTimer = new QTimer(this);
+    m_killTimer->setSingleShot(true);
+    connect(m_killTimer, &QTimer::timeout, this, &ProcessRunner::killProcessGroup);
+}
+
+ProcessRunner::~ProcessRunner()
+{
+    // Application qui se termine en pleine compilation : pas d'enfants orphelins
+    if (isRunning()) {
+        signalProcessGroup(true);
+    }
+    liveGroups().remove(m_pid);
+}
+
+int ProcessRunner::liveProcessGroupCount()
+{
+    return liveGroups().size();
+}
+
+void ProcessRunner::killAllProcessGroups()
+{
+#ifdef Q_OS_UNIX
+    for (qint64 group : liveGroups()) {
+        ::kill(-static_cast<pid_t>(group), SIGKILL);
+    }
+#endif
 }
 
-bool ProcessRunner::runCommand(const QString& program, const QStringList& arguments, 
-                               QTextEdit* outputWidget, const QString& workingDir)
+bool ProcessRunner::runCommand(const QString& program, const QStringList& arguments,
+                               const QString& workingDir)
 {
-    // Nettoyer le processus précédent s'il existe
+    // Nettoyer le processus précédent s'il existe (encore en cours : son groupe
+    // est tué et retiré du recensement avant d'être remplacé)
     if (m_process) {
+        m_process->disconnect(this);
+        if (isRunning()) {
+            signalProcessGroup(true);
+        }
+        liveGroups().remove(m_pid);
         m_process->deleteLater();
         m_process = nullptr;
     }
-    
-    m_outputWidget = outputWidget;
+
     m_fullOutput.clear();
-    
+    m_lastResult = ProcessResult();
+    m_usage = ProcessUsage();
+    m_lastSampleMs = 0;
+    m_pid = 0;
+    m_terminating = false;
+    m_timedOut = false;
+    m_killed = false;
+    m_killTimer->stop();
+
     // IMPORTANT: Vider les buffers au début
     m_outputBuffer.clear();
     m_errorBuffer.clear();
-    
-    // Créer un nouveau processus
+
+    // Créer un nouveau processus (dans le thread de ce runner)
     m_process = new QProcess(this);
-    
+
     if (!workingDir.isEmpty()) {
         m_process->setWorkingDirectory(workingDir);
     }
-   
+
+    if (!m_environment.isEmpty()) {
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        for (auto it = m_environment.constBegin(); it != m_environment.constEnd(); ++it) {
+            environment.insert(it.key(), it.value());
+        }
+        m_process->setProcessEnvironment(environment);
+    }
+
+    // Pas de terminal : un moteur qui attend une saisie reçoit EOF au lieu de bloquer
+    if (!m_inputPiped) {
+        m_process->setStandardInputFile(QProcess::nullDevice());
+    }
+
+#ifdef Q_OS_UNIX
+    // Nouveau groupe de processus : les enfants (-shell-escape) pourront être arrêtés avec lui.
+    // Sous Linux, SIGTERM au moteur si l'application disparaît sans avoir pu arrêter le groupe
+    pid_t parentPid = ::getpid();
+    m_process->setChildProcessModifier([parentPid]() {
+        ::setpgid(0, 0);
+#ifdef Q_OS_LINUX
+        ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (::getppid() != parentPid) {
+            ::_exit(1);
+        }
+#else
+        Q_UNUSED(parentPid);
+#endif
+    });
+#endif
+
     // Connecter les signaux pour capturer la sortie en temps réel
     connect(m_process, &QProcess::readyReadStandardOutput, this, &ProcessRunner::onReadyReadStandardOutput);
     connect(m_process, &QProcess::readyReadStandardError, this, &ProcessRunner::onReadyReadStandardError);
-    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), 
+    // Sortie fermée : le processus se termine, souvent encore lisible dans /proc
+    connect(m_process, &QProcess::readChannelFinished, this, &ProcessRunner::sampleUsage);
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &ProcessRunner::onProcessFinished);
-    
+
     // Démarrer le processus
+    m_wallTimer.start();
     m_process->start(program, arguments);
-    return m_process->waitForStarted();
+    if (!m_process->waitForStarted()) {
+        return false;
+    }
+
+    m_pid = m_process->processId();
+    liveGroups().insert(m_pid);
+    sampleUsage();
+    m_usageTimer->start();
+
+    m_idleTimer.start();
+    m_watchdogTimer->start();
+    return true;
 }
 
 bool ProcessRunner::needsRerun(const QString& output) const
 {
     // Mots-clés indiquant qu'une recompilation est nécessaire
-    return output.contains("Rerun to get", Qt::CaseInsensitive) || 
+    return output.contains("Rerun to get", Qt::CaseInsensitive) ||
            output.contains("Please rerun LaTeX", Qt::CaseInsensitive) ||
            output.contains("Rerun LaTeX", Qt::CaseInsensitive);
 }
@@ -53,8 +166,87 @@ bool ProcessRunner::needsRerun(const QString& output) const
 void ProcessRunner::stopProcess()
 {
     if (m_process && m_process->state() != QProcess::NotRunning) {
+        terminateProcessGroup();
+    }
+}
+
+bool ProcessRunner::writeInput(const QByteArray& data)
+{
+    if (!m_inputPiped || !isRunning()) {
+        return false;
+    }
+    return m_process->write(data) == data.size();
+}
+
+void ProcessRunner::restartWatchdog()
+{
+    m_wallTimer.restart();
+    m_idleTimer.restart();
+}
+
+void ProcessRunner::checkWatchdog()
+{
+    if (!isRunning() || m_terminating) return;
+
+    QString reason;
+    if (m_limits.wallTimeoutSec > 0 && m_wallTimer.elapsed() > m_limits.wallTimeoutSec * 1000LL) {
+        reason = QString("durée maximale de %1 s dépassée").arg(m_limits.wallTimeoutSec);
+    } else if (m_limits.idleTimeoutSec > 0 && m_idleTimer.elapsed() > m_limits.idleTimeoutSec * 1000LL) {
+        reason = QString("aucune sortie depuis %1 s").arg(m_limits.idleTimeoutSec);
+    }
+
+    if (reason.isEmpty()) return;
+
+    qWarning() << "Processus" << m_pid << "bloqué :" << reason;
+    m_timedOut = true;
+    emit outputLines({ QString(), QString("*** Processus arrêté : %1 ***").arg(reason) });
+    emit timedOut(reason);
+    terminateProcessGroup();
+}
+
+void ProcessRunner::terminateProcessGroup()
+{
+    if (m_terminating) return;
+    m_terminating = true;
+
+    // SIGTERM d'abord, SIGKILL après le délai de grâce si le groupe résiste
+    if (!signalProcessGroup(false)) {
         m_process->terminate();
     }
+    m_killTimer->start(qMax(0, m_limits.killGraceMs));
+}
+
+void ProcessRunner::killProcessGroup()
+{
+    if (!m_pid) return;
+
+    if (signalProcessGroup(true)) {
+        m_killed = true;
+    } else if (isRunning()) {
+        m_process->kill();
+        m_killed = true;
+    }
+}
+
+bool ProcessRunner::signalProcessGroup(bool force)
+{
+#ifdef Q_OS_UNIX
+    if (m_pid <= 0) return false;
+    // Le groupe porte l'identifiant du processus lancé (setpgid(0, 0) dans l'enfant)
+    return ::kill(-static_cast<pid_t>(m_pid), force ? SIGKILL : SIGTERM) == 0;
+#else
+    Q_UNUSED(force);
+    return false;
+#endif
+}
+
+void ProcessRunner::sampleUsage()
+{
+    ProcessUsage current = ProcessUsageProbe::sample(m_pid);
+    if (current.valid) {
+        m_lastSampleMs = m_wallTimer.elapsed();
+    }
+    m_usage = ProcessUsageProbe::merge(m_usage, current);
 }
 
 int ProcessRunner::exitCode() const
@@ -67,191 +259,103 @@ bool ProcessRunner::isRunning() const
     return m_process && m_process->state() != QProcess::NotRunning;
 }
 
-void ProcessRunner::onReadyReadStandardOutput()
+QStringList ProcessRunner::takeCompleteLines(QString& buffer, const QString& data)
 {
-    if (!m_process || !m_outputWidget) return;
-    
-    QByteArray data = m_process->readAllStandardOutput();
-    QString output = QString::fromUtf8(data);
-    m_fullOutput.append(output);
-    
     // Ajouter au buffer
-    m_outputBuffer.append(output);
-    
+    buffer.append(data);
+
     // Traiter les lignes complètes (séparées par \n)
-    QStringList lines = m_outputBuffer.split('\n');
-    
+    QStringList lines = buffer.split('\n');
+
     // Garder la dernière partie (potentiellement incomplète) dans le buffer
-    if (!m_outputBuffer.endsWith('\n')) {
-        m_outputBuffer = lines.takeLast();
+    if (!buffer.endsWith('\n')) {
+        buffer = lines.takeLast();
     } else {
-        m_outputBuffer.clear();
+        buffer.clear();
+        lines.removeLast();
     }
-    
-    // Traiter chaque ligne complète
-    for (const QString& line : lines) {
-        processAndDisplayLine(line);
+
+    return lines;
+}
+
+void ProcessRunner::onReadyReadStandardOutput()
+{
+    if (!m_process) return;
+
+    QString output = QString::fromUtf8(m_process->readAllStandardOutput());
+    m_fullOutput.append(output);
+
+    m_idleTimer.restart();
+
+    QStringList lines = takeCompleteLines(m_outputBuffer, output);
+    if (!lines.isEmpty()) {
+        emit outputLines(lines);
     }
 }
 
 void ProcessRunner::onReadyReadStandardError()
 {
-    if (!m_process || !m_outputWidget) return;
-    
-    QByteArray data = m_process->readAllStandardError();
-    QString output = QString::fromUtf8(data);
-    m_fullOutput.append(output);
-    
+    if (!m_process) return;
+
     // Même traitement pour stderr
-    m_errorBuffer.append(output);
-    
-    QStringList lines = m_errorBuffer.split('\n');
-    
-    if (!m_errorBuffer.endsWith('\n')) {
-        m_errorBuffer = lines.takeLast();
-    } else {
-        m_errorBuffer.clear();
-    }
-    
-    for (const QString& line : lines) {
-        processAndDisplayLine(line);
+    QString output = QString::fromUtf8(m_process->readAllStandardError());
+    m_fullOutput.append(output);
+
+    m_idleTimer.restart();
+
+    QStringList lines = takeCompleteLines(m_errorBuffer, output);
+    if (!lines.isEmpty()) {
+        emit outputLines(lines);
     }
 }
 
 void ProcessRunner::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    m_usageTimer->stop();
+    m_watchdogTimer->stop();
+    m_killTimer->stop();
+
+    // Le processus principal est terminé : ne pas laisser d'enfants orphelins
+    // (gnuplot, inkscape...) occuper des cœurs et des fichiers temporaires
+    if (signalProcessGroup(true) && m_terminating) {
+        m_killed = true;
+    }
+    liveGroups().remove(m_pid);
+
+    QStringList lines;
+
     // Traiter ce qui reste dans les buffers
     if (!m_outputBuffer.isEmpty()) {
-        processAndDisplayLine(m_outputBuffer);
+        lines << m_outputBuffer;
         m_outputBuffer.clear();
     }
-    
+
     if (!m_errorBuffer.isEmpty()) {
-        processAndDisplayLine(m_errorBuffer);
+        lines << m_errorBuffer;
         m_errorBuffer.clear();
     }
-    
+
     // Message de fin
-    QString statusMessage;
+    lines << QString();
     if (exitCode == 0) {
-        statusMessage = QString("\nProcessus terminé avec code : %1").arg(exitCode);
+        lines << QString("Processus terminé avec code : %1").arg(exitCode);
     } else {
-        statusMessage = QString("\nProcessus terminé avec ERREUR (code : %1)").arg(exitCode);
+        lines << QString("Processus terminé avec ERREUR (code : %1)").arg(exitCode);
     }
-    
-    processAndDisplayLine(statusMessage);
-    
-    m_lastExitCode = exitCode;
-    emit processFinished(exitCode, exitStatus);
-}
 
-void ProcessRunner::processAndDisplayLine(const QString& line)
-{
-    if (!m_outputWidget) return;
-    
-    // Ne pas traiter les lignes complètement vides
-    if (line.isEmpty()) {
-        m_outputWidget->append("");
-        return;
-    }
-    
-    // Détection du message de succès
-    QRegularExpression successPattern("Processus.*termin.*code.*0", 
-                                     QRegularExpression::CaseInsensitiveOption);
-    if (line.contains(successPattern)) {
-        QTextCursor cursor = m_outputWidget->textCursor();
-        cursor.movePosition(QTextCursor::End);
-        
-        QTextCharFormat successFormat;
-        successFormat.setForeground(QBrush(QColor("#00a000")));
-        successFormat.setFontWeight(QFont::Bold);
-        cursor.insertText(line + "\n", successFormat);
-        
-        QTextCharFormat defaultFormat;
-        defaultFormat.setForeground(QBrush(Qt::black));
-        defaultFormat.setFontWeight(QFont::Normal);
-        cursor.setCharFormat(defaultFormat);
-        m_outputWidget->setTextCursor(cursor);
-        
-        QScrollBar* scrollBar = m_outputWidget->verticalScrollBar();
-        scrollBar->setValue(scrollBar->maximum());
-        return;
-    }
-    
-    // Détection des erreurs et warnings avec des patterns améliorés
-    bool isError = false;
-    bool isWarning = false;
-    
-    // Patterns pour les erreurs LaTeX
-    static const QStringList errorPatterns = {
-        "^!\\s+",                    // Erreur LaTeX commençant par !
-        "Emergency stop",
-        "Fatal error",
-        "File ended",
-        "Runaway argument",
-        "Double subscript",
-        "Too many \\}",
-        "Illegal unit",
-        "cannot find",
-        "not found"
-    };
-    
-    // Patterns pour les warnings (y compris undefined)
-    static const QStringList warningPatterns = {
-        "Warning:",
-        "warning:",
-        "LaTeX Font Warning",
-        "Package.*Warning",
-        "Overfull",
-        "Underfull",
-        "undefined",              // Déplacé ici pour être en orange
-        "Undefined",
-        "hbox",
-        "vbox",
-        "Font shape.*undefined"   // Font warnings spécifiques
-    };
-    
-    // Vérifier les patterns d'erreur
-    for (const QString& pattern : errorPatterns) {
-        QRegularExpression re(pattern, QRegularExpression::CaseInsensitiveOption);
-        if (line.contains(re)) {
-            isError = true;
-            break;
-        }
-    }
-    
-    // Si ce n'est pas une erreur, vérifier les warnings
-    if (!isError) {
-        for (const QString& pattern : warningPatterns) {
-            if (line.contains(pattern, Qt::CaseInsensitive)) {
-                isWarning = true;
-                break;
-            }
-        }
-    }
-    
-    // Appliquer le formatage
-    QTextCursor cursor = m_outputWidget->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    
-    QTextCharFormat format;
-    if (isError) {
-        format.setForeground(QBrush(Qt::red));
-    } else if (isWarning) {
-        format.setForeground(QBrush(QColor("#ff8800"))); // Orange
-    } else {
-        format.setForeground(QBrush(Qt::black));
+    emit outputLines(lines);
+
+    m_lastExitCode = exitCode;
+    m_lastResult.exitCode = exitCode;
+    m_lastResult.exitStatus = exitStatus;
+    m_lastResult.wallTimeMs = m_wallTimer.elapsed();
+    m_lastResult.usage = m_usage;
+    if (m_usage.valid) {
+        m_lastResult.usage.sampleAgeMs = m_lastResult.wallTimeMs - m_lastSampleMs;
     }
-    
-    cursor.insertText(line + "\n", format);
-    
-    // Réinitialiser le format
-    QTextCharFormat defaultFormat;
-    defaultFormat.setForeground(QBrush(Qt::black));
-    cursor.setCharFormat(defaultFormat);
-    m_outputWidget->setTextCursor(cursor);
-    
-    // Auto-scroll
-    QScrollBar* scrollBar = m_outputWidget->verticalScrollBar();
-    scrollBar->setValue(scrollBar->maximum());
+    m_lastResult.timedOut = m_timedOut;
+    m_lastResult.killed = m_killed;
+
+    emit processResultReady(m_lastResult);
+    emit processFinished(exitCode, exitStatus);
 }
\ No newline at end of file
@@ -2,59 +2,151 @@
 #include <QObject>
 #include <QProcess>
 #include <QString>
-#include <QTextEdit>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QMap>
+#include "processusage.h"
 
+// Informations de fin d'un processus (code, statut, durée, ressources)
+struct ProcessResult {
+    int exitCode = -1;
+    QProcess::ExitStatus exitStatus = QProcess::NormalExit;
+    qint64 wallTimeMs = 0;
+    ProcessUsage usage;
+    bool timedOut = false;      // Arrêté par le chien de garde (délai dépassé)
+    bool killed = false;        // Le groupe a dû être tué par SIGKILL
+};
+Q_DECLARE_METATYPE(ProcessResult)
+
+// Limites de supervision d'un processus (0 = pas de limite)
+struct ProcessLimits {
+    int wallTimeoutSec = 3600;  // Durée totale maximale
+    int idleTimeoutSec = 600;   // Durée maximale sans aucune sortie
+    int killGraceMs = 3000;     // Délai entre SIGTERM et SIGKILL
+};
+
+// Exécute une commande sans aucune dépendance à un widget : la sortie est
+// publiée par lots de lignes via des signaux. Les runners vivent dans le thread
+// principal (recensement des groupes non protégé ; sous Linux, PR_SET_PDEATHSIG
+// suit le thread qui a lancé le processus, pas l'application : un runner dans
+// un thread de travail arrêterait son moteur à la fin de ce thread).
+// Sous Unix, chaque commande est lancée dans son propre groupe de processus :
+// l'arrêt (demandé ou sur délai dépassé) vise tout le groupe, y compris les
+// enfants lancés via -shell-escape, en passant de SIGTERM à SIGKILL.
+// Hors du groupe du terminal, ces processus ne reçoivent plus Ctrl+C : les
+// groupes vivants sont recensés pour être arrêtés à la sortie de
+// l'application, et sous Linux le moteur reçoit SIGTERM si l'application
+// meurt brutalement.
 class ProcessRunner : public QObject
 {
     Q_OBJECT
 
 public:
     explicit ProcessRunner(QObject* parent = nullptr);
-    
-    // Lance une commande et connecte sa sortie à un QTextEdit
-    bool runCommand(const QString& program, const QStringList& arguments, 
-                    QTextEdit* outputWidget, const QString& workingDir = QString());
-    
+    ~ProcessRunner();
+
+    // Groupes de processus encore en vie, tous runners confondus
+    static int liveProcessGroupCount();
+
+    // Tue (SIGKILL) tous les groupes encore en vie : sortie de l'application
+    static void killAllProcessGroups();
+
     // Vérifie si la compilation nécessite d'être relancée
     bool needsRerun(const QString& output) const;
-    
-    // Stoppe le processus en cours
-    void stopProcess();
-    
+
     // Retourne le code de sortie du dernier processus
     int exitCode() const;
-    
+
     // Retourne si le processus est en cours d'exécution
     bool isRunning() const;
 
     // Retourne la sortie complète du processus
     QString fullOutput() const { return m_fullOutput; }
-    
-    // Retourne le widget de sortie associé
-    QTextEdit* outputWidget() const { return m_outputWidget; }
+
+    // Retourne les informations du dernier processus terminé
+    ProcessResult lastResult() const { return m_lastResult; }
+
+    // Limites appliquées aux prochaines commandes
+    void setLimits(const ProcessLimits& limits) { m_limits = limits; }
+    ProcessLimits limits() const { return m_limits; }
+
+    // Variables ajoutées à l'environnement du système pour les prochaines commandes
+    void setEnvironment(const QMap<QString, QString>& variables) { m_environment = variables; }
+
+    // Entrée standard gardée ouverte pour writeInput() (par défaut : /dev/null)
+    void setInputPiped(bool piped) { m_inputPiped = piped; }
+
+public slots:
+    // Lance une commande ; sa sortie est émise via outputLines()
+    bool runCommand(const QString& program, const QStringList& arguments,
+                    const QString& workingDir = QString());
+
+    // Stoppe le processus en cours et tout son groupe
+    void stopProcess();
+
+    // Écrit sur l'entrée standard du processus (setInputPiped)
+    bool writeInput(const QByteArray& data);
+
+    // Repart de zéro pour la durée totale et la durée sans sortie (processus
+    // lancé à l'avance qui ne commence son travail qu'à la réception d'une entrée)
+    void restartWatchdog();
 
 signals:
     // Signal émis lorsque le processus se termine
     void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
-    
-    // Signal émis lorsqu'une nouvelle ligne est disponible
-    void newOutputLine(const QString& line);
+
+    // Signal émis lorsque le processus se termine, avec les informations détaillées
+    void processResultReady(const ProcessResult& result);
+
+    // Signal émis pour chaque lot de lignes complètes (stdout et stderr)
+    void outputLines(const QStringList& lines);
+
+    // Signal émis lorsque le chien de garde arrête un processus bloqué
+    void timedOut(const QString& reason);
 
 private slots:
     void onReadyReadStandardOutput();
     void onReadyReadStandardError();
     void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void sampleUsage();
+    void checkWatchdog();
+    void killProcessGroup();
 
 private:
     QProcess* m_process = nullptr;
-    QTextEdit* m_outputWidget = nullptr;
     QString m_fullOutput;
     int m_lastExitCode = -1;
-    
+    ProcessResult m_lastResult;
+    QElapsedTimer m_wallTimer;
+
+    // Échantillonnage périodique de /proc, et à la fermeture de la sortie du
+    // processus : le dernier relevé sert de bilan, QProcess récupérant lui-même
+    // le processus terminé (pas de wait4). Son ancienneté est jointe au bilan
+    QTimer* m_usageTimer = nullptr;
+    qint64 m_pid = 0;
+    ProcessUsage m_usage;
+    qint64 m_lastSampleMs = 0;
+
+    QMap<QString, QString> m_environment;
+    bool m_inputPiped = false;
+
+    // Supervision : délais, dernier signe de vie et escalade SIGTERM -> SIGKILL
+    ProcessLimits m_limits;
+    QTimer* m_watchdogTimer = nullptr;
+    QTimer* m_killTimer = nullptr;
+    QElapsedTimer m_idleTimer;
+    bool m_terminating = false;
+    bool m_timedOut = false;
+    bool m_killed = false;
+
+    void terminateProcessGroup();
+    bool signalProcessGroup(bool force);
+
     // Ajout des buffers pour reconstituer les lignes
     QString m_outputBuffer;
     QString m_errorBuffer;
-    
-    // Méthode pour traiter et afficher les lignes
-    void processAndDisplayLine(const QString& line);
+
+    // Découpe le buffer en lignes complètes et garde la fin incomplète
+    QStringList takeCompleteLines(QString& buffer, const QString& data);
 };
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "processusage.h"
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+QByteArray readProcFile(qint64 pid, const char* name)
+{
+    QFile file(QString("/proc/%1/%2").arg(pid).arg(QLatin1String(name)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+// Cherche "Clé: valeur" dans un fichier /proc au format clé/valeur
+qint64 readKeyValue(const QByteArray& content, const QByteArray& key)
+{
+    const QList<QByteArray> lines = content.split('\n');
+    for (const QByteArray& line : lines) {
+        if (line.startsWith(key)) {
+            QByteArray value = line.mid(key.size()).trimmed();
+            int space = value.indexOf(' ');
+            if (space > 0) {
+                value.truncate(space);
+            }
+            return value.toLongLong();
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+ProcessUsage ProcessUsageProbe::sample(qint64 pid)
+{
+    ProcessUsage usage;
+
+#ifdef Q_OS_LINUX
+    if (pid <= 0) return usage;
+
+    // /proc/<pid>/stat : le nom du processus est entre parenthèses et peut contenir des espaces
+    QByteArray stat = readProcFile(pid, "stat");
+    int closing = stat.lastIndexOf(')');
+    if (closing < 0) return usage;
+
+    const QList<QByteArray> fields = stat.mid(closing + 2).split(' ');
+    // Après ")", le champ 0 est l'état (champ 3 de proc(5)) : utime=14, stime=15, cutime=16, cstime=17
+    if (fields.size() < 15) return usage;
+
+    static const qint64 ticksPerSecond = qMax<long>(1, sysconf(_SC_CLK_TCK));
+    qint64 utime = fields[11].toLongLong() + fields[13].toLongLong();
+    qint64 stime = fields[12].toLongLong() + fields[14].toLongLong();
+    usage.userCpuMs = utime * 1000 / ticksPerSecond;
+    usage.systemCpuMs = stime * 1000 / ticksPerSecond;
+
+    usage.peakRssKb = readKeyValue(readProcFile(pid, "status"), "VmHWM:");
+
+    QByteArray io = readProcFile(pid, "io");
+    usage.bytesRead = readKeyValue(io, "rchar:");
+    usage.bytesWritten = readKeyValue(io, "wchar:");
+
+    usage.valid = true;
+#else
+    Q_UNUSED(pid);
+#endif
+
+    return usage;
+}
+
+ProcessUsage ProcessUsageProbe::merge(const ProcessUsage& previous, const ProcessUsage& current)
+{
+    if (!current.valid) return previous;
+    if (!previous.valid) return current;
+
+    ProcessUsage merged = current;
+    merged.userCpuMs = qMax(previous.userCpuMs, current.userCpuMs);
+    merged.systemCpuMs = qMax(previous.systemCpuMs, current.systemCpuMs);
+    merged.peakRssKb = qMax(previous.peakRssKb, current.peakRssKb);
+    merged.bytesRead = qMax(previous.bytesRead, current.bytesRead);
+    merged.bytesWritten = qMax(previous.bytesWritten, current.bytesWritten);
+    return merged;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <QtGlobal>
+
+// Consommation de ressources d'un processus, relevée dans /proc (Linux)
+struct ProcessUsage {
+    qint64 userCpuMs = 0;      // Temps CPU utilisateur (enfants attendus inclus)
+    qint64 systemCpuMs = 0;    // Temps CPU système (enfants attendus inclus)
+    qint64 peakRssKb = 0;      // Pic de mémoire résidente (VmHWM)
+    qint64 bytesRead = 0;      // Octets lus (rchar)
+    qint64 bytesWritten = 0;   // Octets écrits (wchar)
+    bool valid = false;        // Faux si /proc n'est pas disponible
+
+    // Ancienneté du dernier relevé à la fin du processus (-1 : inconnue). Les
+    // valeurs sont échantillonnées : ce qui suit ce relevé n'est pas compté
+    qint64 sampleAgeMs = -1;
+};
+
+class ProcessUsageProbe
+{
+public:
+    // Lit l'état courant du processus ; retourne un relevé invalide s'il a disparu
+    static ProcessUsage sample(qint64 pid);
+
+    // Fusionne deux relevés : maxima pour la mémoire, dernières valeurs pour les compteurs
+    static ProcessUsage merge(const ProcessUsage& previous, const ProcessUsage& current);
+};
@@ -0,0 +1,141 @@
+#include "texcachemanager.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QTimer>
+#include <QStandardPaths>
+#include <QDebug>
+#include "tracer.h"
+
+TexCacheManager::TexCacheManager(QObject* parent)
+    : QObject(parent), m_runner(new ProcessRunner(this)), m_lockTimer(new QTimer(this))
+{
+    // Autre instance en train de reconstruire la base : on réessaie régulièrement
+    m_lockTimer->setInterval(500);
+    connect(m_lockTimer, &QTimer::timeout, this, &TexCacheManager::tryLock);
+    connect(m_runner, &ProcessRunner::processFinished, this, &TexCacheManager::onProcessFinished,
+            Qt::QueuedConnection);
+}
+
+TexCacheManager::~TexCacheManager()
+{
+    delete m_lock;
+}
+
+QString TexCacheManager::cacheRoot()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/texmf-var";
+}
+
+QMap<QString, QString> TexCacheManager::environment()
+{
+    // luaotfload écrit dans TEXMFCACHE s'il est défini, sinon dans TEXMFVAR
+    QString root = cacheRoot();
+    return { { "TEXMFVAR", root }, { "TEXMFCACHE", root } };
+}
+
+bool TexCacheManager::usesLuaotfload(const QString& program)
+{
+    return QFileInfo(program).fileName().startsWith("lua");
+}
+
+QString TexCacheManager::findTool(const QString& engineProgram)
+{
+    // Moteur désigné par un chemin : outil de la même installation uniquement
+    QFileInfo engineInfo(engineProgram);
+    if (engineProgram.contains('/')) {
+        return QStandardPaths::findExecutable("luaotfload-tool", { engineInfo.absolutePath() });
+    }
+    return QStandardPaths::findExecutable("luaotfload-tool");
+}
+
+bool TexCacheManager::warmUp(const QString& engineProgram)
+{
+    if (m_warm || m_warmingUp) {
+        return false;
+    }
+
+    m_tool = findTool(engineProgram);
+    if (m_tool.isEmpty()) {
+        qWarning() << "luaotfload-tool introuvable pour" << engineProgram << ": pas de préchauffage des polices";
+        m_warm = true;
+        return false;
+    }
+
+    if (!QDir().mkpath(cacheRoot())) {
+        qWarning() << "Impossible de créer le cache TeX" << cacheRoot();
+        m_warm = true;
+        return false;
+    }
+
+    delete m_lock;
+    m_lock = new QLockFile(cacheRoot() + "/prechauffage.lock");
+    // Verrou laissé par une instance arrêtée brutalement
+    m_lock->setStaleLockTime(15 * 60 * 1000);
+
+    m_warmingUp = true;
+    m_lockWaitMs = 0;
+    m_clock.start();
+    m_startUs = Tracer::instance().now();
+    tryLock();
+    return true;
+}
+
+void TexCacheManager::tryLock()
+{
+    if (!m_lock->tryLock(0)) {
+        if (!m_lockTimer->isActive()) {
+            qDebug() << "Cache des polices en cours de préchauffage par une autre instance, attente du verrou";
+            m_lockTimer->start();
+        }
+        return;
+    }
+    m_lockTimer->stop();
+    m_lockWaitMs = m_clock.elapsed();
+
+    m_runner->setEnvironment(environment());
+    if (!m_runner->runCommand(m_tool, { "--update" })) {
+        finish(false, "lancement impossible de " + m_tool, ProcessResult());
+    }
+}
+
+void TexCacheManager::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    if (!m_warmingUp) return;
+
+    bool success = exitStatus == QProcess::NormalExit && exitCode == 0;
+    QString detail;
+    if (!success) {
+        QStringList lines = m_runner->fullOutput().trimmed().split('\n');
+        detail = QString("code %1 : %2").arg(exitCode).arg(lines.last().trimmed());
+    }
+    finish(success, detail, m_runner->lastResult());
+}
+
+void TexCacheManager::finish(bool success, const QString& detail, const ProcessResult& result)
+{
+    m_lock->unlock();
+
+    // Une seule tentative par session : en cas d'échec, chaque compilation
+    // reconstruit la base comme auparavant
+    m_warm = true;
+    m_warmingUp = false;
+
+    qint64 totalMs = m_clock.elapsed();
+    Tracer& tracer = Tracer::instance();
+    tracer.complete("cache", "luaotfload-tool --update", Tracer::mainLane(), m_startUs, tracer.now() - m_startUs,
+                    QJsonObject{ { "attenteVerrouMs", m_lockWaitMs }, { "succes", success } });
+
+    QString summary = QString("Préchauffage du cache des polices (%1) : %2 s")
+                          .arg(cacheRoot())
+                          .arg(totalMs / 1000.0, 0, 'f', 1);
+    if (m_lockWaitMs >= 1000) {
+        summary += QString(", dont %1 s d'attente d'une autre instance").arg(m_lockWaitMs / 1000.0, 0, 'f', 1);
+    }
+    if (!success) {
+        summary += " — échec (" + detail + ")";
+    }
+    qDebug().noquote() << summary;
+
+    emit warmUpFinished(success, summary, result);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QMap>
+#include <QElapsedTimer>
+#include "processrunner.h"
+
+class QLockFile;
+class QTimer;
+
+// Cache TeX propre à l'application : TEXMFVAR et TEXMFCACHE pointent vers un
+// répertoire du cache de l'application, commun à toutes les compilations.
+// Avant la première compilation LuaLaTeX de la session, la base de polices de
+// luaotfload y est mise à jour une seule fois (luaotfload-tool --update), sous
+// un verrou partagé entre instances : les compilations parallèles ne la
+// reconstruisent plus chacune de leur côté.
+class TexCacheManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TexCacheManager(QObject* parent = nullptr);
+    ~TexCacheManager();
+
+    // Répertoire TEXMFVAR/TEXMFCACHE de l'application
+    static QString cacheRoot();
+
+    // Variables à ajouter à l'environnement des moteurs
+    static QMap<QString, QString> environment();
+
+    // Vrai pour les moteurs qui chargent leurs polices avec luaotfload
+    static bool usesLuaotfload(const QString& program);
+
+    // Lance la mise à jour de la base de polices si elle n'a pas encore été faite
+    // dans cette session ; faux si rien n'est lancé (warmUpFinished n'est pas émis)
+    bool warmUp(const QString& engineProgram);
+
+    bool isWarmingUp() const { return m_warmingUp; }
+
+signals:
+    // Fin du préchauffage : bilan lisible (durée, attente du verrou) et mesures
+    void warmUpFinished(bool success, const QString& summary, const ProcessResult& result);
+
+private slots:
+    void tryLock();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    ProcessRunner* m_runner;
+    QLockFile* m_lock = nullptr;
+    QTimer* m_lockTimer;
+    QString m_tool;
+    bool m_warm = false;
+    bool m_warmingUp = false;
+    QElapsedTimer m_clock;      // Depuis la demande (attente du verrou comprise)
+    qint64 m_lockWaitMs = 0;
+    qint64 m_startUs = 0;       // Début du préchauffage (trace)
+
+    // luaotfload-tool de la même installation que le moteur
+    static QString findTool(const QString& engineProgram);
+    void finish(bool success, const QString& detail, const ProcessResult& result);
+};
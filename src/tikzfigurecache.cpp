@@ -0,0 +1,156 @@
+#include "tikzfigurecache.h"
+#include <QFile>
+#include <QDir>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDebug>
+
+namespace {
+
+const QString s_beginTag = QStringLiteral("\\begin{tikzpicture}");
+const QString s_endTag = QStringLiteral("\\end{tikzpicture}");
+
+// Fin de l'environnement commençant à begin (environnements imbriqués compris), -1 si absente
+int matchingEnd(const QString& content, int begin)
+{
+    int depth = 0;
+    int cursor = begin;
+    while (cursor < content.size()) {
+        int nextBegin = content.indexOf(s_beginTag, cursor);
+        int nextEnd = content.indexOf(s_endTag, cursor);
+        if (nextEnd < 0) {
+            return -1;
+        }
+        if (nextBegin >= 0 && nextBegin < nextEnd) {
+            ++depth;
+            cursor = nextBegin + s_beginTag.size();
+        } else {
+            cursor = nextEnd + s_endTag.size();
+            if (--depth == 0) {
+                return cursor;
+            }
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+QString TikzFigureCache::cacheDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/figures";
+}
+
+QString TikzFigureCache::figurePath(const QString& key)
+{
+    return cacheDir() + "/" + key + ".pdf";
+}
+
+void TikzFigureCache::setPreamble(const QString& preamble)
+{
+    if (preamble == m_preamble && !m_preambleHash.isEmpty()) {
+        return;
+    }
+    m_preamble = preamble;
+    m_preambleHash = QCryptographicHash::hash(preamble.toUtf8(), QCryptographicHash::Sha1);
+}
+
+bool TikzFigureCache::isExternalizable(const QString& source)
+{
+    static const QStringList blockers = {
+        "remember picture", "overlay", "baseline", "\\label", "\\ref", "\\pageref",
+        "\\cite", "\\verb", "#"
+    };
+    for (const QString& blocker : blockers) {
+        if (source.contains(blocker)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TikzFigureCache::isCommentedOut(const QString& content, int position)
+{
+    int lineStart = content.lastIndexOf('\n', position - 1) + 1;
+    for (int i = lineStart; i < position; ++i) {
+        if (content.at(i) == '\\') {
+            ++i;
+        } else if (content.at(i) == '%') {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString TikzFigureCache::substitute(const QString& content)
+{
+    if (!content.contains(s_beginTag)) {
+        return content;
+    }
+
+    QString result;
+    result.reserve(content.size());
+    int position = 0;
+    while (true) {
+        int begin = content.indexOf(s_beginTag, position);
+        int end = begin < 0 ? -1 : matchingEnd(content, begin);
+        if (end < 0) {
+            break;
+        }
+
+        result += QStringView(content).mid(position, begin - position);
+        QString source = content.mid(begin, end - begin);
+        position = end;
+
+        if (isCommentedOut(content, begin) || !isExternalizable(source)) {
+            result += source;
+            continue;
+        }
+
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(m_preambleHash);
+        hash.addData(source.toUtf8());
+        QString key = QString::fromLatin1(hash.result().toHex().left(20));
+        QString path = figurePath(key);
+
+        result += "\\IfFileExists{" + path + "}{\\includegraphics{" + path + "}}{" + source + "}";
+        if (!QFile::exists(path)) {
+            m_missing.insert(key, Figure{ key, source });
+        }
+    }
+    result += QStringView(content).mid(position);
+    return result;
+}
+
+QVector<TikzFigureCache::Figure> TikzFigureCache::takeMissingFigures()
+{
+    QVector<Figure> figures = m_missing.values().toVector();
+    m_missing.clear();
+    return figures;
+}
+
+void TikzFigureCache::addMissingFigures(const QVector<Figure>& figures)
+{
+    for (const Figure& figure : figures) {
+        m_missing.insert(figure.key, figure);
+    }
+}
+
+bool TikzFigureCache::store(const QString& key, const QString& pdfPath)
+{
+    if (!QDir().mkpath(cacheDir())) {
+        qWarning() << "Impossible de créer le cache des figures" << cacheDir();
+        return false;
+    }
+
+    // Renommage dans le même système de fichiers : une autre instance ne voit
+    // jamais de PDF incomplet
+    QString target = figurePath(key);
+    QString staging = target + ".part";
+    QFile::remove(staging);
+    if (!QFile::copy(pdfPath, staging)) {
+        return false;
+    }
+    QFile::remove(target);
+    return QFile::rename(staging, target);
+}
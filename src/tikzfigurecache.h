@@ -0,0 +1,52 @@
+#pragma once
+#include <QString>
+#include <QByteArray>
+#include <QMap>
+#include <QVector>
+
+// Cache persistant des figures TikZ, partagé par toutes les cibles (partiel,
+// chapitres, document) et d'une compilation à l'autre. Chaque environnement
+// tikzpicture est identifié par l'empreinte de sa source et du préambule : il
+// est remplacé dans les fichiers assemblés par le PDF de la figure, inclus par
+// \IfFileExists (la figure est composée normalement si son PDF manque).
+// Les figures absentes du cache sont relevées pour être générées avant la passe
+// principale.
+class TikzFigureCache
+{
+public:
+    struct Figure {
+        QString key;       // Empreinte : nom du PDF dans le cache
+        QString source;    // Environnement tikzpicture complet
+    };
+
+    // Répertoire du cache et PDF d'une figure
+    static QString cacheDir();
+    static QString figurePath(const QString& key);
+
+    // Préambule des fichiers assemblés ensuite (entre dans l'empreinte des figures)
+    void setPreamble(const QString& preamble);
+    QString preamble() const { return m_preamble; }
+
+    // Remplace les figures externalisables par leur PDF du cache et relève celles
+    // qui n'y sont pas encore
+    QString substitute(const QString& content);
+
+    // Figures absentes du cache relevées depuis le dernier appel
+    QVector<Figure> takeMissingFigures();
+
+    // Reprend les figures manquantes relevées par un autre cache (assemblage en arrière-plan)
+    void addMissingFigures(const QVector<Figure>& figures);
+
+    // Range le PDF d'une figure générée dans le cache (renommage atomique)
+    static bool store(const QString& key, const QString& pdfPath);
+
+private:
+    QString m_preamble;
+    QByteArray m_preambleHash;
+    QMap<QString, Figure> m_missing;
+
+    // Figures qui ne peuvent pas être composées seules : superposition, références,
+    // alignement sur la ligne de base, paramètres de macro
+    static bool isExternalizable(const QString& source);
+    static bool isCommentedOut(const QString& content, int position);
+};
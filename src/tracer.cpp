@@ -0,0 +1,166 @@
+#include "tracer.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QDebug>
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::configureFromArguments(int argc, char* argv[])
+{
+    QString outputPath;
+    for (int i = 1; i < argc; ++i) {
+        QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--trace" && i + 1 < argc) {
+            outputPath = QString::fromLocal8Bit(argv[i + 1]);
+        } else if (arg.startsWith("--trace=")) {
+            outputPath = arg.mid(QStringLiteral("--trace=").size());
+        }
+    }
+
+    if (outputPath.isEmpty()) {
+        outputPath = qEnvironmentVariable("COMPILATION_SELECTIVE_TRACE");
+    }
+
+    if (!outputPath.isEmpty()) {
+        instance().enable(QFileInfo(outputPath).absoluteFilePath());
+    }
+}
+
+void Tracer::enable(const QString& outputPath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = true;
+    m_outputPath = outputPath;
+    m_clock.start();
+
+    QJsonObject processName;
+    processName["name"] = "process_name";
+    processName["ph"] = "M";
+    processName["pid"] = 1;
+    processName["args"] = QJsonObject{ { "name", "CompilationSelective" } };
+    m_events.append(processName);
+
+    qDebug() << "Trace des compilations activée :" << m_outputPath;
+}
+
+qint64 Tracer::now() const
+{
+    return m_enabled ? m_clock.nsecsElapsed() / 1000 : 0;
+}
+
+int Tracer::laneId(const QString& lane)
+{
+    auto it = m_lanes.constFind(lane);
+    if (it != m_lanes.constEnd()) {
+        return it.value();
+    }
+
+    // Nouvelle ligne : la nommer et la placer après les précédentes
+    int id = m_lanes.size() + 1;
+    m_lanes.insert(lane, id);
+
+    QJsonObject threadName;
+    threadName["name"] = "thread_name";
+    threadName["ph"] = "M";
+    threadName["pid"] = 1;
+    threadName["tid"] = id;
+    threadName["args"] = QJsonObject{ { "name", lane } };
+    m_events.append(threadName);
+
+    QJsonObject sortIndex;
+    sortIndex["name"] = "thread_sort_index";
+    sortIndex["ph"] = "M";
+    sortIndex["pid"] = 1;
+    sortIndex["tid"] = id;
+    sortIndex["args"] = QJsonObject{ { "sort_index", id } };
+    m_events.append(sortIndex);
+
+    return id;
+}
+
+void Tracer::complete(const QString& category, const QString& name, const QString& lane,
+                      qint64 startUs, qint64 durationUs, const QJsonObject& args)
+{
+    if (!m_enabled) return;
+
+    QMutexLocker locker(&m_mutex);
+    QJsonObject event;
+    event["name"] = name;
+    event["cat"] = category;
+    event["ph"] = "X";
+    event["ts"] = startUs;
+    event["dur"] = qMax<qint64>(0, durationUs);
+    event["pid"] = 1;
+    event["tid"] = laneId(lane);
+    if (!args.isEmpty()) {
+        event["args"] = args;
+    }
+    m_events.append(event);
+}
+
+void Tracer::instant(const QString& category, const QString& name, const QString& lane,
+                     const QJsonObject& args)
+{
+    if (!m_enabled) return;
+
+    qint64 timestamp = now();
+    QMutexLocker locker(&m_mutex);
+    QJsonObject event;
+    event["name"] = name;
+    event["cat"] = category;
+    event["ph"] = "i";
+    event["s"] = "t";
+    event["ts"] = timestamp;
+    event["pid"] = 1;
+    event["tid"] = laneId(lane);
+    if (!args.isEmpty()) {
+        event["args"] = args;
+    }
+    m_events.append(event);
+}
+
+bool Tracer::write()
+{
+    if (!m_enabled) return false;
+
+    QMutexLocker locker(&m_mutex);
+    QDir().mkpath(QFileInfo(m_outputPath).absolutePath());
+
+    QFile file(m_outputPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Impossible d'écrire la trace dans" << m_outputPath;
+        return false;
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = m_events;
+    root["displayTimeUnit"] = "ms";
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.close();
+    return true;
+}
+
+TraceScope::TraceScope(const QString& category, const QString& name, const QString& lane)
+{
+    if (!Tracer::instance().isEnabled()) return;
+
+    m_category = category;
+    m_name = name;
+    m_lane = lane;
+    m_startUs = Tracer::instance().now();
+}
+
+TraceScope::~TraceScope()
+{
+    if (m_startUs < 0) return;
+
+    Tracer& tracer = Tracer::instance();
+    tracer.complete(m_category, m_name, m_lane, m_startUs, tracer.now() - m_startUs, m_args);
+}
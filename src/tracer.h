@@ -0,0 +1,75 @@
+#pragma once
+#include <QString>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+
+// Journal d'événements au format Chrome trace-event (chrome://tracing, Perfetto).
+// Désactivé par défaut ; activé par --trace fichier.json ou par la variable
+// d'environnement COMPILATION_SELECTIVE_TRACE. Chaque compilation (partiel,
+// chapitre, document) a sa propre ligne, ce qui fait apparaître le chemin
+// critique et les temps morts des compilations parallèles.
+class Tracer
+{
+public:
+    static Tracer& instance();
+
+    // Lit --trace / --trace=fichier puis la variable d'environnement
+    static void configureFromArguments(int argc, char* argv[]);
+
+    void enable(const QString& outputPath);
+    bool isEnabled() const { return m_enabled; }
+    QString outputPath() const { return m_outputPath; }
+
+    // Microsecondes écoulées depuis l'activation
+    qint64 now() const;
+
+    // Intervalle [startUs, startUs + durationUs] sur la ligne indiquée
+    void complete(const QString& category, const QString& name, const QString& lane,
+                  qint64 startUs, qint64 durationUs, const QJsonObject& args = QJsonObject());
+
+    // Événement ponctuel (décision de relance...)
+    void instant(const QString& category, const QString& name, const QString& lane,
+                 const QJsonObject& args = QJsonObject());
+
+    // Réécrit le fichier avec tous les événements enregistrés
+    bool write();
+
+    // Ligne des opérations du thread principal (analyse, assemblage...)
+    static QString mainLane() { return QStringLiteral("principal"); }
+
+private:
+    Tracer() = default;
+
+    int laneId(const QString& lane);
+
+    bool m_enabled = false;
+    QString m_outputPath;
+    QElapsedTimer m_clock;
+    QJsonArray m_events;
+    QHash<QString, int> m_lanes;
+    mutable QMutex m_mutex;
+};
+
+// Mesure la durée d'un bloc (analyse, extraction du préambule...) sur une ligne
+class TraceScope
+{
+public:
+    TraceScope(const QString& category, const QString& name, const QString& lane = Tracer::mainLane());
+    ~TraceScope();
+
+    // Informations ajoutées à l'événement (fichier, nombre de fichiers...)
+    void setArg(const QString& key, const QJsonValue& value) { m_args.insert(key, value); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    QString m_category;
+    QString m_name;
+    QString m_lane;
+    qint64 m_startUs = -1;
+    QJsonObject m_args;
+};
@@ -0,0 +1,266 @@
+#include "warmworkerpool.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+// Boucle de contrôle exécutée par \directlua juste après \begin{document}
+const char* const s_controlLoop = R"(-- Processus préchauffé : le préambule est exécuté, le document est ouvert.
+-- "corps <fichier>" compose le fichier puis termine le document, "fin" arrête.
+texio.write_nl("term and log", "CompilationSelective : processus préchauffé prêt")
+io.stdout:flush()
+while true do
+  local ligne = io.read("*l")
+  if ligne == nil or ligne == "fin" then
+    os.exit(0)
+  end
+  local fichier = ligne:match("^corps (.+)$")
+  if fichier then
+    tex.print("\\input{" .. fichier .. "}")
+    break
+  end
+end
+)";
+
+const char* const s_controlFileName = "chaud.lua";
+
+} // namespace
+
+WarmWorkerPool::WarmWorkerPool(QObject* parent)
+    : QObject(parent)
+{
+}
+
+WarmWorkerPool::~WarmWorkerPool()
+{
+    // Les ProcessRunner, enfants du pool, arrêtent leur processus avec lui
+    qDeleteAll(m_workers);
+}
+
+void WarmWorkerPool::setSize(int count)
+{
+    m_size = qMax(0, count);
+
+    // Processus en attente en trop : arrêtés
+    int idle = 0;
+    const QVector<Worker*> workers = m_workers;
+    for (Worker* worker : workers) {
+        if (worker->id.isEmpty() && ++idle > m_size) {
+            discard(worker);
+        }
+    }
+}
+
+bool WarmWorkerPool::supportsEngine(const QString& program)
+{
+    return QFileInfo(program).fileName().startsWith("lua");
+}
+
+QByteArray WarmWorkerPool::workerKey(const CompileJobSpec& spec, const QString& setup)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(spec.program.toUtf8() + '\n');
+    hash.addData(spec.arguments.join('\n').toUtf8() + '\n');
+    for (auto it = spec.environment.constBegin(); it != spec.environment.constEnd(); ++it) {
+        hash.addData((it.key() + '=' + it.value() + '\n').toUtf8());
+    }
+    hash.addData(setup.toUtf8());
+    return hash.result();
+}
+
+void WarmWorkerPool::prepare(const CompileJobSpec& spec, const QString& setup, const QString& workDir)
+{
+    if (m_size <= 0 || !supportsEngine(spec.program)) {
+        return;
+    }
+
+    // Les processus préchauffés sur un autre préambule ne serviront plus
+    QByteArray key = workerKey(spec, setup);
+    int ready = 0;
+    const QVector<Worker*> workers = m_workers;
+    for (Worker* worker : workers) {
+        if (!worker->id.isEmpty()) {
+            continue;
+        }
+        if (worker->key == key) {
+            ++ready;
+        } else {
+            discard(worker);
+        }
+    }
+
+    while (ready < m_size && spawn(spec, setup, workDir)) {
+        ++ready;
+    }
+}
+
+WarmWorkerPool::Worker* WarmWorkerPool::spawn(const CompileJobSpec& spec, const QString& setup, const QString& workDir)
+{
+    QFile controlFile(workDir + "/" + s_controlFileName);
+    if (!controlFile.exists()) {
+        if (!controlFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning() << "Impossible d'écrire la boucle de contrôle" << controlFile.fileName();
+            return nullptr;
+        }
+        controlFile.write(s_controlLoop);
+        controlFile.close();
+    }
+
+    QString texFile = workDir + QString("/chaud_%1.tex").arg(++m_nextWorker);
+    QFile driver(texFile);
+    if (!driver.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Impossible de créer le pilote préchauffé" << texFile;
+        return nullptr;
+    }
+    QTextStream out(&driver);
+    out << setup;
+    out << "\\directlua{dofile(\"" << s_controlFileName << "\")}\n";
+    out << "\\end{document}\n";
+    driver.close();
+
+    Worker* worker = new Worker;
+    worker->number = m_nextWorker;
+    worker->key = workerKey(spec, setup);
+    worker->texFile = texFile;
+    worker->runner = new ProcessRunner(this);
+    worker->runner->setEnvironment(spec.environment);
+    worker->runner->setInputPiped(true);
+
+    // Aucun délai pendant l'attente : les limites s'appliquent à la composition
+    ProcessLimits parked;
+    parked.wallTimeoutSec = 0;
+    parked.idleTimeoutSec = 0;
+    parked.killGraceMs = m_limits.killGraceMs;
+    worker->runner->setLimits(parked);
+
+    connect(worker->runner, &ProcessRunner::outputLines, this, [this, worker](const QStringList& lines) {
+        if (worker->id.isEmpty()) {
+            worker->pendingLines << lines;
+        } else {
+            emit jobOutput(worker->id, lines);
+        }
+    });
+    connect(worker->runner, &ProcessRunner::processResultReady, this, [this, worker](const ProcessResult& result) {
+        if (!worker->id.isEmpty()) {
+            emit jobPassFinished(worker->id, 1, result);
+        }
+    });
+    // Fin relayée en différé : le processus est retrouvé par son numéro, le
+    // Worker ayant pu être écarté entre-temps
+    int number = worker->number;
+    connect(worker->runner, &ProcessRunner::processFinished, this, [this, number]() {
+        onWorkerFinished(number);
+    }, Qt::QueuedConnection);
+
+    QStringList arguments = spec.arguments;
+    arguments << texFile;
+    if (!worker->runner->runCommand(spec.program, arguments, workDir)) {
+        qWarning() << "Impossible de lancer le processus préchauffé" << spec.program;
+        worker->runner->deleteLater();
+        delete worker;
+        return nullptr;
+    }
+
+    qDebug() << "Processus préchauffé lancé:" << texFile;
+    m_workers.append(worker);
+    return worker;
+}
+
+QString WarmWorkerPool::dispatch(const CompileJobSpec& spec, const QString& setup, const QString& bodyFile)
+{
+    QByteArray key = workerKey(spec, setup);
+    for (Worker* worker : m_workers) {
+        if (!worker->id.isEmpty() || worker->key != key || !worker->runner->isRunning()) {
+            continue;
+        }
+
+        // Le processus peut encore être en train de charger le préambule :
+        // la commande attend alors dans le tube
+        worker->runner->setLimits(m_limits);
+        worker->runner->restartWatchdog();
+        if (!worker->runner->writeInput(QString("corps %1\n").arg(bodyFile).toUtf8())) {
+            discard(worker);
+            return QString();
+        }
+
+        worker->id = spec.id;
+        if (!worker->pendingLines.isEmpty()) {
+            emit jobOutput(worker->id, worker->pendingLines);
+            worker->pendingLines.clear();
+        }
+        return worker->texFile;
+    }
+    return QString();
+}
+
+void WarmWorkerPool::stop()
+{
+    for (Worker* worker : m_workers) {
+        if (!worker->id.isEmpty()) {
+            worker->runner->stopProcess();
+        }
+    }
+}
+
+bool WarmWorkerPool::isBusy() const
+{
+    for (const Worker* worker : m_workers) {
+        if (!worker->id.isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WarmWorkerPool::discard(Worker* worker)
+{
+    m_workers.removeOne(worker);
+
+    // Fin demandée par la boucle de contrôle, l'arrêt forcé en dernier recours
+    ProcessRunner* runner = worker->runner;
+    runner->disconnect(this);
+    connect(runner, &ProcessRunner::processFinished, runner, &QObject::deleteLater);
+    if (!runner->writeInput("fin\n")) {
+        runner->stopProcess();
+    }
+    if (!runner->isRunning()) {
+        runner->deleteLater();
+    }
+    delete worker;
+}
+
+void WarmWorkerPool::onWorkerFinished(int number)
+{
+    // Fin déjà en file lorsque le processus a été écarté
+    auto it = std::find_if(m_workers.begin(), m_workers.end(),
+                           [number](const Worker* worker) { return worker->number == number; });
+    if (it == m_workers.end()) {
+        return;
+    }
+    Worker* worker = *it;
+    m_workers.erase(it);
+
+    int exitCode = worker->runner->exitCode();
+    if (worker->id.isEmpty()) {
+        // Préambule en erreur ou moteur sans boucle de contrôle : le partiel
+        // reviendra à la compilation classique
+        qWarning() << "Processus préchauffé terminé avant usage (code" << exitCode << "):" << worker->texFile;
+        for (const QString& line : worker->pendingLines.mid(qMax(0, worker->pendingLines.size() - 20))) {
+            qDebug().noquote() << line;
+        }
+    } else {
+        QFileInfo texInfo(worker->texFile);
+        QString pdfPath = texInfo.absolutePath() + "/" + texInfo.completeBaseName() + ".pdf";
+        bool success = exitCode == 0 && QFile::exists(pdfPath);
+        emit jobFinished(worker->id, success, exitCode, success ? pdfPath : QString());
+    }
+
+    // Les autres relais du processus capturent le Worker supprimé ici
+    worker->runner->disconnect(this);
+    worker->runner->deleteLater();
+    delete worker;
+}
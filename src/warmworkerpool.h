@@ -0,0 +1,72 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include "compilejob.h"
+
+// Processus LuaLaTeX préchauffés pour le partiel : chaque processus est lancé à
+// l'avance sur un pilote contenant le préambule et \begin{document}, puis attend
+// sur son entrée standard, dans une petite boucle Lua, le chemin du corps à
+// composer. Le chargement du format, des polices et du préambule est ainsi payé
+// avant la demande de compilation.
+// Un processus ne compose qu'un document (TeX ne peut pas en recommencer un
+// second) : il est remplacé par un nouveau processus préchauffé après usage.
+class WarmWorkerPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WarmWorkerPool(QObject* parent = nullptr);
+    ~WarmWorkerPool();
+
+    // Nombre de processus préchauffés (0 : désactivé)
+    void setSize(int count);
+    int size() const { return m_size; }
+
+    // Limites appliquées à partir de la réception du corps (aucune pendant l'attente)
+    void setLimits(const ProcessLimits& limits) { m_limits = limits; }
+
+    // Indique si ce moteur peut être préchauffé (LuaTeX : boucle \directlua)
+    static bool supportsEngine(const QString& program);
+
+    // Garde size() processus préchauffés sur ce préambule (setup : préambule et
+    // \begin{document}) ; les processus d'un autre préambule sont arrêtés
+    void prepare(const CompileJobSpec& spec, const QString& setup, const QString& workDir);
+
+    // Compose bodyFile dans un processus préchauffé sur ce préambule ; retourne son
+    // fichier pilote (le PDF est écrit à côté) ou une chaîne vide si aucun n'est prêt
+    QString dispatch(const CompileJobSpec& spec, const QString& setup, const QString& bodyFile);
+
+    // Arrête les compositions en cours (les processus en attente sont conservés)
+    void stop();
+
+    bool isBusy() const;
+
+signals:
+    // Mêmes signaux que JobPool, une seule passe par composition
+    void jobOutput(const QString& id, const QStringList& lines);
+    void jobPassFinished(const QString& id, int pass, const ProcessResult& result);
+    void jobFinished(const QString& id, bool success, int exitCode, const QString& pdfPath);
+
+private:
+    struct Worker {
+        int number = 0;          // Numéro unique (l'adresse d'un Worker supprimé peut être réutilisée)
+        ProcessRunner* runner = nullptr;
+        QByteArray key;          // Empreinte du moteur, de ses options et du préambule
+        QString texFile;         // Pilote préchauffé
+        QString id;              // Identifiant de la composition (vide : en attente)
+        QStringList pendingLines;   // Sortie du préchauffage, relayée à la composition
+    };
+
+    int m_size = 0;
+    int m_nextWorker = 0;    // Dernier numéro de processus attribué
+    ProcessLimits m_limits;
+    QVector<Worker*> m_workers;
+
+    static QByteArray workerKey(const CompileJobSpec& spec, const QString& setup);
+    Worker* spawn(const CompileJobSpec& spec, const QString& setup, const QString& workDir);
+    void discard(Worker* worker);
+    void onWorkerFinished(int number);
+};